@@ -191,7 +191,7 @@ bbl_print_version (void)
         printf("  REF: %s\n", GIT_REF);
         printf("  SHA: %s\n", GIT_SHA);
     }
-    printf("IO Modes: packet_mmap_raw (default), packet_mmap, raw");
+    printf("IO Modes: packet_mmap_raw (default), packet_mmap, raw, af_xdp");
 #ifdef BNGBLASTER_DPDK
     printf(", dpdk");
 #endif
@@ -292,7 +292,7 @@ bbl_ctrl_job(timer_s *timer)
             while(!CIRCLEQ_EMPTY(&g_ctx->sessions_teardown_qhead)) {
                 session = CIRCLEQ_FIRST(&g_ctx->sessions_teardown_qhead);
                 if(rate > 0) {
-                    if(session->session_state != BBL_IDLE) rate--;
+                    if(session->hot->session_state != BBL_IDLE) rate--;
                     bbl_session_clear(session);
                     /* Remove from teardown queue. */
                     CIRCLEQ_REMOVE(&g_ctx->sessions_teardown_qhead, session, session_teardown_qnode);
@@ -328,15 +328,15 @@ bbl_ctrl_job(timer_s *timer)
                     if(session->cfm_cc) {
                         bbl_cfm_cc_start(session);
                     }
-                    switch(session->access_type) {
+                    switch(session->hot->access_type) {
                         case ACCESS_TYPE_PPPOE:
                             /* PPP over Ethernet (PPPoE) */
-                            session->session_state = BBL_PPPOE_INIT;
+                            session->hot->session_state = BBL_PPPOE_INIT;
                             session->send_requests = BBL_SEND_DISCOVERY;
                             break;
                         case ACCESS_TYPE_IPOE:
                             /* IP over Ethernet (IPoE) */
-                            session->session_state = BBL_IPOE_SETUP;
+                            session->hot->session_state = BBL_IPOE_SETUP;
                             session->send_requests = 0;
                             if(session->access_config->ipv4_enable) {
                                 if(session->dhcp_state > BBL_DHCP_DISABLED) {
@@ -513,6 +513,14 @@ main(int argc, char *argv[])
     }
     g_monkey = g_ctx->config.monkey_autostart;
 
+    /* Select timer backend before the first timer is added. */
+    if(g_ctx->config.timer_wheel) {
+        timer_init_root_wheel(&g_ctx->timer_root);
+    } else {
+        timer_init_root(&g_ctx->timer_root);
+        g_ctx->timer_root.wheel = false;
+    }
+
     if(username) g_ctx->config.username = username;
     if(password) g_ctx->config.password = password;
     if(sessions) g_ctx->config.sessions = atoi(sessions);
@@ -556,7 +564,10 @@ main(int argc, char *argv[])
     }
 
     /* Init TCP. */
-    bbl_tcp_init();
+    if(!bbl_tcp_init()) {
+        fprintf(stderr, "Error: Failed to init TCP\n");
+        goto CLEANUP;
+    }
 
     /* Init interfaces. */
     if(!bbl_interface_init()) {
@@ -619,6 +630,11 @@ main(int argc, char *argv[])
     /* Smear all stream buckets. */
     io_stream_smear_all();
 
+    /* Start asynchronous logging before threads are started. */
+    if(!log_async_start(interactive)) {
+        fprintf(stderr, "Warning: Failed to start asynchronous logging\n");
+    }
+
     /* Start threads. */
     io_thread_start_all();
 
@@ -660,6 +676,7 @@ main(int argc, char *argv[])
 
     /* Stop threads. */
     io_thread_stop_all();
+    log_async_stop();
 
     /* Stop curses. Do this before the final reports. */
     if(g_interactive) {
@@ -676,6 +693,7 @@ main(int argc, char *argv[])
 
     /* Cleanup resources. */
 CLEANUP:
+    bbl_interface_close_all();
     bbl_interface_unlock_all();
     if(g_ctx->ctrl_socket_path) {
         bbl_ctrl_socket_close();
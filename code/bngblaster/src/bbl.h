@@ -54,6 +54,7 @@
 #include "bbl_http_client.h"
 #include "bbl_http_server.h"
 #include "bbl_fragment.h"
+#include "bbl_subscribe.h"
 
 #include "io/io.h"
 #include "bgp/bgp.h"
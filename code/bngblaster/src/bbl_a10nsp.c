@@ -691,20 +691,16 @@ bbl_a10nsp_rx_handler(bbl_a10nsp_interface_s *interface,
                       bbl_ethernet_header_s *eth)
 {
     bbl_session_s *session;
-    uint32_t session_id = 0;
 
     interface->stats.packets_rx++;
     interface->stats.bytes_rx += eth->length;
 
-    /* The session-id is mapped into the last 3 bytes of
-     * the client MAC address. The original approach using
-     * VLAN identifiers was not working reliable as some NIC
+    /* The session-id is mapped into the client MAC 
+     * address. The original approach using VLAN 
+     * identifiers was not working reliable as some NIC
      * drivers strip outer VLAN and it is also possible to have
      * multiple session per VLAN (N:1). */
-    session_id |= eth->src[5];
-    session_id |= eth->src[4] << 8;
-    session_id |= eth->src[3] << 16;
-    session = bbl_session_get(session_id);
+    session = bbl_session_get_by_mac(NULL, eth->src);
     if(session) {
         bbl_a10nsp_rx(interface, session, eth);
     }
@@ -122,10 +122,10 @@ bbl_access_update_eth(bbl_session_s *session,
     eth->dst = eth->src;
     eth->src = dst;
     eth->mpls = NULL;
-    eth->src = session->client_mac;
+    eth->src = session->hot->client_mac;
     eth->qinq = session->access_config->qinq;
-    eth->vlan_outer = session->vlan_key.outer_vlan_id;
-    eth->vlan_inner = session->vlan_key.inner_vlan_id;
+    eth->vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth->vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth->vlan_three = session->access_third_vlan;
 }
 
@@ -141,7 +141,7 @@ bbl_access_icmp_reply(bbl_session_s *session,
     ipv4->src = dst;
     ipv4->ttl = 64;
     icmp->type = ICMP_TYPE_ECHO_REPLY;
-    return bbl_txq_to_buffer(session->access_interface->txq, eth);
+    return bbl_txq_to_buffer(session->hot->access_interface->txq, eth);
 }
 
 static bbl_txq_result_t
@@ -155,13 +155,13 @@ bbl_access_icmpv6_na(bbl_session_s *session,
     ipv6->src = icmpv6->prefix.address;
     ipv6->ttl = 255;
     icmpv6->type = IPV6_ICMPV6_NEIGHBOR_ADVERTISEMENT;
-    icmpv6->mac = session->client_mac;
+    icmpv6->mac = session->hot->client_mac;
     icmpv6->flags = 0;
     icmpv6->data = NULL;
     icmpv6->data_len = 0;
     icmpv6->dns1 = NULL;
     icmpv6->dns2 = NULL;
-    return bbl_txq_to_buffer(session->access_interface->txq, eth);
+    return bbl_txq_to_buffer(session->hot->access_interface->txq, eth);
 }
 
 static bbl_txq_result_t
@@ -176,15 +176,17 @@ bbl_access_icmpv6_echo_reply(bbl_session_s *session,
     ipv6->src = dst;
     ipv6->ttl = 255;
     icmpv6->type = IPV6_ICMPV6_ECHO_REPLY;
-    return bbl_txq_to_buffer(session->access_interface->txq, eth);
+    return bbl_txq_to_buffer(session->hot->access_interface->txq, eth);
 }
 
 void
 bbl_access_igmp_zapping(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
+    bbl_igmp_session_s *igmp = session->igmp;
 
     uint32_t next_group;
+    uint32_t last_group;
     bbl_igmp_group_s *group;
 
     uint32_t join_delay = 0;
@@ -194,34 +196,34 @@ bbl_access_igmp_zapping(timer_s *timer)
 
     uint32_t ms;
 
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
-        if(session->session_state != BBL_ESTABLISHED ||
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
+        if(session->hot->session_state != BBL_ESTABLISHED ||
             session->ipcp_state != BBL_PPP_OPENED) {
             return;
         }
     } else {
-        if(session->session_state != BBL_ESTABLISHED) {
+        if(session->hot->session_state != BBL_ESTABLISHED) {
             return;
         }
     }
 
-    if(!session->zapping_joined_group || !session->zapping_leaved_group) {
+    if(!igmp || !igmp->zapping_joined_group || !igmp->zapping_leaved_group) {
         return;
     }
 
-    if(session->zapping_view_start_time.tv_sec) {
+    if(igmp->zapping_view_start_time.tv_sec) {
         clock_gettime(CLOCK_MONOTONIC, &time_now);
-        timespec_sub(&time_diff, &time_now, &session->zapping_view_start_time);
+        timespec_sub(&time_diff, &time_now, &igmp->zapping_view_start_time);
         if(time_diff.tv_sec >= g_ctx->config.igmp_zap_view_duration) {
-            session->zapping_view_start_time.tv_sec = 0;
-            session->zapping_count = 0;
+            igmp->zapping_view_start_time.tv_sec = 0;
+            igmp->zapping_count = 0;
         } else {
             return;
         }
     }
 
     /* Calculate last join delay... */
-    group = session->zapping_joined_group;
+    group = igmp->zapping_joined_group;
     if(group->first_mc_rx_time.tv_sec) {
         if(!group->zapping_result) {
             group->zapping_result = true;
@@ -230,15 +232,15 @@ bbl_access_igmp_zapping(timer_s *timer)
             if(time_diff.tv_nsec % 1000000) ms++; /* simple roundup function */
             join_delay = (time_diff.tv_sec * 1000) + ms;
             if(!join_delay) join_delay = 1; /* join delay must be at least one millisecond */
-            session->zapping_join_delay_sum += join_delay;
-            session->zapping_join_count++;
+            igmp->zapping_join_delay_sum += join_delay;
+            igmp->zapping_join_count++;
             if(join_delay > session->stats.max_join_delay) session->stats.max_join_delay = join_delay;
             if(session->stats.min_join_delay) {
                 if(join_delay < session->stats.min_join_delay) session->stats.min_join_delay = join_delay;
             } else {
                 session->stats.min_join_delay = join_delay;
             }
-            session->stats.avg_join_delay = session->zapping_join_delay_sum / session->zapping_join_count;
+            session->stats.avg_join_delay = igmp->zapping_join_delay_sum / igmp->zapping_join_count;
             
             if(g_ctx->config.igmp_max_join_delay && join_delay > g_ctx->config.igmp_max_join_delay) {
                 session->stats.join_delay_violations++;
@@ -276,8 +278,9 @@ bbl_access_igmp_zapping(timer_s *timer)
     }
 
     /* Select next group to be joined ... */
+    last_group = be32toh(g_ctx->config.igmp_group) + ((g_ctx->config.igmp_group_count - 1) * be32toh(g_ctx->config.igmp_group_iter));
     next_group = be32toh(group->group) + be32toh(g_ctx->config.igmp_group_iter);
-    if(next_group > session->zapping_group_max) {
+    if(next_group > last_group) {
         next_group = g_ctx->config.igmp_group;
     } else {
         next_group = htobe32(next_group);
@@ -293,22 +296,22 @@ bbl_access_igmp_zapping(timer_s *timer)
     group->last_mc_rx_time.tv_nsec = 0;
 
     /* Calculate last leave delay ... */
-    group = session->zapping_leaved_group;
+    group = igmp->zapping_leaved_group;
     if(group->group && group->last_mc_rx_time.tv_sec && group->leave_tx_time.tv_sec) {
         timespec_sub(&time_diff, &group->last_mc_rx_time, &group->leave_tx_time);
         ms = time_diff.tv_nsec / 1000000; /* convert nanoseconds to milliseconds */
         if(time_diff.tv_nsec % 1000000) ms++; /* simple roundup function */
         leave_delay = (time_diff.tv_sec * 1000) + ms;
         if(!leave_delay) leave_delay = 1; /* leave delay must be at least one millisecond */
-        session->zapping_leave_delay_sum += leave_delay;
-        session->zapping_leave_count++;
+        igmp->zapping_leave_delay_sum += leave_delay;
+        igmp->zapping_leave_count++;
         if(leave_delay > session->stats.max_leave_delay) session->stats.max_leave_delay = leave_delay;
         if(session->stats.min_leave_delay) {
             if(leave_delay < session->stats.min_leave_delay) session->stats.min_leave_delay = leave_delay;
         } else {
             session->stats.min_leave_delay = leave_delay;
         }
-        session->stats.avg_leave_delay = session->zapping_leave_delay_sum / session->zapping_leave_count;
+        session->stats.avg_leave_delay = igmp->zapping_leave_delay_sum / igmp->zapping_leave_count;
 
         LOG(IGMP, "IGMP (ID: %u) ZAPPING %u ms leave delay for group %s\n",
             session->session_id, leave_delay, format_ipv4_address(&group->group));
@@ -333,20 +336,20 @@ bbl_access_igmp_zapping(timer_s *timer)
         group->zapping_result = false;
 
         /* Swap join/leave */
-        session->zapping_leaved_group = session->zapping_joined_group;
-        session->zapping_joined_group = group;
+        igmp->zapping_leaved_group = igmp->zapping_joined_group;
+        igmp->zapping_joined_group = group;
 
         LOG(IGMP, "IGMP (ID: %u) ZAPPING leave %s join %s\n",
             session->session_id,
-            format_ipv4_address(&session->zapping_leaved_group->group),
-            format_ipv4_address(&session->zapping_joined_group->group));
+            format_ipv4_address(&igmp->zapping_leaved_group->group),
+            format_ipv4_address(&igmp->zapping_joined_group->group));
     } else {
         /* Zapping has stopped */
         group->last_mc_rx_time.tv_sec = 0;
         group->leave_tx_time.tv_sec = 0;
         LOG(IGMP, "IGMP (ID: %u) ZAPPING leave %s\n",
             session->session_id,
-            format_ipv4_address(&session->zapping_joined_group->group));
+            format_ipv4_address(&igmp->zapping_joined_group->group));
     }
 
     session->send_requests |= BBL_SEND_IGMP;
@@ -354,10 +357,10 @@ bbl_access_igmp_zapping(timer_s *timer)
 
 
     /* Handle viewing profile */
-    session->zapping_count++;
+    igmp->zapping_count++;
     if(g_ctx->config.igmp_zap_count && g_ctx->config.igmp_zap_view_duration) {
-        if(session->zapping_count >= g_ctx->config.igmp_zap_count) {
-            clock_gettime(CLOCK_MONOTONIC, &session->zapping_view_start_time);
+        if(igmp->zapping_count >= g_ctx->config.igmp_zap_count) {
+            clock_gettime(CLOCK_MONOTONIC, &igmp->zapping_view_start_time);
         }
     }
 }
@@ -366,13 +369,14 @@ void
 bbl_access_igmp_initial_join(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
+    bbl_igmp_session_s *igmp;
     uint32_t initial_group;
     bbl_igmp_group_s *group;
 
     int group_start_index = 0;
 
-    if(session->session_state != BBL_ESTABLISHED ||
-       (session->access_type == ACCESS_TYPE_PPPOE && 
+    if(session->hot->session_state != BBL_ESTABLISHED ||
+       (session->hot->access_type == ACCESS_TYPE_PPPOE && 
         session->ipcp_state != BBL_PPP_OPENED)) {
         return;
     }
@@ -383,14 +387,20 @@ bbl_access_igmp_initial_join(timer_s *timer)
     }
     initial_group = htobe32(be32toh(g_ctx->config.igmp_group) + (group_start_index * be32toh(g_ctx->config.igmp_group_iter)));
 
-    group = &session->igmp_groups[0];
+    igmp = bbl_igmp_session(session);
+    if(!igmp) {
+        LOG(ERROR, "IGMP (ID: %u) failed to allocate IGMP session\n", session->session_id);
+        return;
+    }
+
+    group = &igmp->groups[0];
     memset(group, 0x0, sizeof(bbl_igmp_group_s));
     group->group = initial_group;
     group->source[0] = g_ctx->config.igmp_source;
     group->robustness_count = session->igmp_robustness;
     group->state = IGMP_GROUP_JOINING;
     group->send = true;
-    session->zapping_count = 1;
+    igmp->zapping_count = 1;
     session->send_requests |= BBL_SEND_IGMP;
     bbl_session_tx_qnode_insert(session);
 
@@ -400,15 +410,15 @@ bbl_access_igmp_initial_join(timer_s *timer)
     if(g_ctx->config.igmp_group_count > 1 && g_ctx->config.igmp_zap_interval > 0) {
         /* Start/Init Zapping Logic ... */
         group->zapping = true;
-        session->zapping_joined_group = group;
-        group = &session->igmp_groups[1];
-        session->zapping_leaved_group = group;
+        igmp->zapping_joined_group = group;
+        group = &igmp->groups[1];
+        igmp->zapping_leaved_group = group;
         memset(group, 0x0, sizeof(bbl_igmp_group_s));
         group->zapping = true;
         group->source[0] = g_ctx->config.igmp_source;
 
         if(g_ctx->config.igmp_zap_count && g_ctx->config.igmp_zap_view_duration) {
-            session->zapping_count = rand() % g_ctx->config.igmp_zap_count;
+            igmp->zapping_count = rand() % g_ctx->config.igmp_zap_count;
         }
 
         /* Adding 2 nanoseconds to enforce a dedicated timer bucket for zapping. */
@@ -480,9 +490,10 @@ bbl_access_rx_established_ipoe(bbl_access_interface_s *interface,
             }
         }
     }
+    bbl_stream_session_update(session);
 
     if(ipv4 && ipv6) {
-        if(session->session_state != BBL_ESTABLISHED) {
+        if(session->hot->session_state != BBL_ESTABLISHED) {
             if(g_ctx->sessions_established_max < g_ctx->sessions) {
                 g_ctx->stats.last_session_established.tv_sec = eth->timestamp.tv_sec;
                 g_ctx->stats.last_session_established.tv_nsec = eth->timestamp.tv_nsec;
@@ -505,7 +516,7 @@ bbl_access_rx_icmpv6(bbl_access_interface_s *interface,
 {
     bbl_icmpv6_s *icmpv6 = (bbl_icmpv6_s*)ipv6->next;
 
-    if(session->access_type == ACCESS_TYPE_PPPOE &&
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE &&
        session->ip6cp_state != BBL_PPP_OPENED) {
         return false;
     }
@@ -518,10 +529,10 @@ bbl_access_rx_icmpv6(bbl_access_interface_s *interface,
                 memcpy(&session->ipv6_prefix, &icmpv6->prefix, sizeof(ipv6_prefix));
                 *(uint64_t*)&session->ipv6_address[0] = *(uint64_t*)session->ipv6_prefix.address;
                 *(uint64_t*)&session->ipv6_address[8] = session->ip6cp_ipv6_identifier;
-                if(session->access_type == ACCESS_TYPE_PPPOE) {
+                if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                     ACTIVATE_ENDPOINT(session->endpoint.ipv6);
                 }
-                session->version++;
+                bbl_session_version_update(session);
                 LOG(IP, "IPv6 (ID: %u) ICMPv6 RA prefix %s/%d\n",
                     session->session_id, format_ipv6_address(&session->ipv6_prefix.address), session->ipv6_prefix.len);
                 if(icmpv6->dns1) {
@@ -531,9 +542,9 @@ bbl_access_rx_icmpv6(bbl_access_interface_s *interface,
                     }
                 }
             }
-            if(session->access_type == ACCESS_TYPE_IPOE) {
+            if(session->hot->access_type == ACCESS_TYPE_IPOE) {
                 if(!session->arp_resolved) {
-                    memcpy(session->server_mac, eth->src, ETH_ADDR_LEN);
+                    memcpy(session->hot->server_mac, eth->src, ETH_ADDR_LEN);
                 }
                 bbl_access_rx_established_ipoe(interface, session, eth);
             } else if(session->dhcpv6_state > BBL_DHCP_DISABLED) {
@@ -572,7 +583,7 @@ bbl_access_rx_icmp(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_ipv4_
             /* Send ICMP reply... */
             if(bbl_access_icmp_reply(session, eth, ipv4, icmp) == BBL_TXQ_OK) {
                 session->stats.icmp_tx++;
-                session->access_interface->stats.icmp_tx++;
+                session->hot->access_interface->stats.icmp_tx++;
                 return true;
             }
         } else {
@@ -588,12 +599,17 @@ bbl_access_rx_ipv4_mc(bbl_access_interface_s *interface,
                       bbl_ethernet_header_s *eth, bbl_ipv4_s *ipv4)
 {
     bbl_bbl_s *bbl = eth->bbl;
+    bbl_igmp_session_s *igmp = session->igmp;
     bbl_igmp_group_s *group = NULL;
     uint64_t loss;
     int i;
 
+    if(!igmp) {
+        return;
+    }
+
     for(i=0; i < IGMP_MAX_GROUPS; i++) {
-        group = &session->igmp_groups[i];
+        group = &igmp->groups[i];
         if(ipv4->dst == group->group) {
             group->packets++;
             group->last_mc_rx_time.tv_sec = eth->timestamp.tv_sec;
@@ -603,22 +619,22 @@ bbl_access_rx_ipv4_mc(bbl_access_interface_s *interface,
                     group->first_mc_rx_time.tv_sec = eth->timestamp.tv_sec;
                     group->first_mc_rx_time.tv_nsec = eth->timestamp.tv_nsec;
                     if(bbl) {
-                        session->mc_rx_last_seq = bbl->flow_seq;
+                        igmp->mc_rx_last_seq = bbl->flow_seq;
                     }
                 } else if(bbl) {
-                    if((session->mc_rx_last_seq +1) < bbl->flow_seq) {
-                        loss = bbl->flow_seq - (session->mc_rx_last_seq +1);
+                    if((igmp->mc_rx_last_seq +1) < bbl->flow_seq) {
+                        loss = bbl->flow_seq - (igmp->mc_rx_last_seq +1);
                         interface->stats.mc_loss += loss;
                         session->stats.mc_loss += loss;
                         group->loss += loss;
                         LOG(LOSS, "LOSS (ID: %u) Multicast flow: %lu seq: %lu last: %lu\n",
-                            session->session_id, bbl->flow_id, bbl->flow_seq, session->mc_rx_last_seq);
+                            session->session_id, bbl->flow_id, bbl->flow_seq, igmp->mc_rx_last_seq);
                     }
-                    session->mc_rx_last_seq = bbl->flow_seq;
+                    igmp->mc_rx_last_seq = bbl->flow_seq;
                 }
             } else {
-                if(session->zapping_joined_group && (session->zapping_leaved_group == group)) {
-                    if(session->zapping_joined_group->first_mc_rx_time.tv_sec) {
+                if(igmp->zapping_joined_group && (igmp->zapping_leaved_group == group)) {
+                    if(igmp->zapping_joined_group->first_mc_rx_time.tv_sec) {
                         session->stats.mc_old_rx_after_first_new++;
                     }
                 }
@@ -788,7 +804,7 @@ bbl_access_rx_pap(bbl_access_interface_s *interface,
 
     UNUSED(interface);
 
-    if(session->session_state == BBL_PPP_AUTH) {
+    if(session->hot->session_state == BBL_PPP_AUTH) {
         switch(pap->code) {
             case PAP_CODE_ACK:
                 if(pap->reply_message_len > 23) {
@@ -840,13 +856,15 @@ bbl_access_rx_chap(bbl_access_interface_s *interface,
     bbl_chap_s *chap;
 
     MD5_CTX md5_ctx;
+    char password[SUB_STR_LEN];
+    char *s;
 
     UNUSED(interface);
 
     pppoes = (bbl_pppoe_session_s*)eth->next;
     chap = (bbl_chap_s*)pppoes->next;
 
-    if(session->session_state == BBL_PPP_AUTH) {
+    if(session->hot->session_state == BBL_PPP_AUTH) {
         switch(chap->code) {
             case CHAP_CODE_CHALLENGE:
                 if(chap->challenge_len == 0) {
@@ -861,7 +879,8 @@ bbl_access_rx_chap(bbl_access_interface_s *interface,
                 } else {
                     MD5_Init(&md5_ctx);
                     MD5_Update(&md5_ctx, &chap->identifier, 1);
-                    MD5_Update(&md5_ctx, session->password, strlen(session->password));
+                    s = bbl_session_string(session, SESSION_STRING_PASSWORD, password);
+                    MD5_Update(&md5_ctx, s, strlen(s));
                     MD5_Update(&md5_ctx, chap->challenge, chap->challenge_len);
                     MD5_Final(session->chap_response, &md5_ctx);
                     session->chap_identifier = chap->identifier;
@@ -914,7 +933,7 @@ void
 bbl_access_session_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_ESTABLISHED) {
+    if(session->hot->session_state == BBL_ESTABLISHED) {
         bbl_session_clear(session);
     }
 }
@@ -950,7 +969,7 @@ bbl_access_rx_established_pppoe(bbl_access_interface_s *interface,
     bool ip6cp = bbl_access_ncp_success(session->ip6cp_state);
 
     if(ipcp && ip6cp) {
-        if(session->session_state != BBL_ESTABLISHED) {
+        if(session->hot->session_state != BBL_ESTABLISHED) {
             if(g_ctx->sessions_established_max < g_ctx->sessions) {
                 g_ctx->stats.last_session_established.tv_sec = eth->timestamp.tv_sec;
                 g_ctx->stats.last_session_established.tv_nsec = eth->timestamp.tv_nsec;
@@ -1159,7 +1178,7 @@ bbl_access_rx_ipcp(bbl_access_interface_s *interface,
                     session->ipcp_state = BBL_PPP_OPENED;
                     bbl_access_rx_established_pppoe(interface, session, eth);
                     ACTIVATE_ENDPOINT(session->endpoint.ipv4);
-                    session->version++;
+                    bbl_session_version_update(session);
                     LOG(IP, "IPv4 (ID: %u) address %s\n", session->session_id, 
                         format_ipv4_address(&session->ip_address));
                     break;
@@ -1218,7 +1237,7 @@ bbl_access_rx_ipcp(bbl_access_interface_s *interface,
                     session->ipcp_state = BBL_PPP_OPENED;
                     bbl_access_rx_established_pppoe(interface, session, eth);
                     ACTIVATE_ENDPOINT(session->endpoint.ipv4);
-                    session->version++;
+                    bbl_session_version_update(session);
                     LOG(IP, "IPv4 (ID: %u) address %s\n", session->session_id,
                         format_ipv4_address(&session->ip_address));
                     break;
@@ -1287,9 +1306,9 @@ void
 bbl_access_lcp_echo(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    bbl_access_interface_s *interface = session->access_interface;
+    bbl_access_interface_s *interface = session->hot->access_interface;
 
-    if(session->session_state == BBL_ESTABLISHED) {
+    if(session->hot->session_state == BBL_ESTABLISHED) {
         if(session->lcp_retries) {
             interface->stats.lcp_echo_timeout++;
         }
@@ -1369,11 +1388,11 @@ bbl_access_rx_lcp(bbl_access_interface_s *interface,
     pppoes = (bbl_pppoe_session_s*)eth->next;
     lcp = (bbl_lcp_s*)pppoes->next;
 
-    if(session->session_state < BBL_PPP_LINK) {
+    if(session->hot->session_state < BBL_PPP_LINK) {
         return;
     }
 
-    if(session->session_state == BBL_PPP_TERMINATING && 
+    if(session->hot->session_state == BBL_PPP_TERMINATING && 
        !(lcp->code == PPP_CODE_TERM_REQUEST || lcp->code == PPP_CODE_TERM_ACK)) {
         /* Only term-request/ack is accepted in terminating phase */
         return;
@@ -1521,7 +1540,7 @@ bbl_access_rx_lcp(bbl_access_interface_s *interface,
             session->lcp_options_len = 0;
             session->lcp_state = BBL_PPP_TERMINATE;
             session->send_requests = BBL_SEND_LCP_RESPONSE;
-            if(session->session_state != BBL_PPP_TERMINATING) {
+            if(session->hot->session_state != BBL_PPP_TERMINATING) {
                 session->lcp_request_code = PPP_CODE_TERM_REQUEST;
                 session->send_requests |= BBL_SEND_LCP_REQUEST;
             }
@@ -1631,9 +1650,9 @@ bbl_access_rx_discovery(bbl_access_interface_s *interface,
     switch(pppoed->code) {
         case PPPOE_PADO:
             interface->stats.pado_rx++;
-            if(session->session_state == BBL_PPPOE_INIT) {
+            if(session->hot->session_state == BBL_PPPOE_INIT) {
                 /* Store server MAC address */
-                memcpy(session->server_mac, eth->src, ETH_ADDR_LEN);
+                memcpy(session->hot->server_mac, eth->src, ETH_ADDR_LEN);
                 if(pppoed->ac_cookie_len) {
                     /* Store AC cookie */
                     if(session->pppoe_ac_cookie) free(session->pppoe_ac_cookie);
@@ -1676,7 +1695,7 @@ bbl_access_rx_discovery(bbl_access_interface_s *interface,
             break;
         case PPPOE_PADS:
             interface->stats.pads_rx++;
-            if(session->session_state == BBL_PPPOE_REQUEST) {
+            if(session->hot->session_state == BBL_PPPOE_REQUEST) {
                 if(pppoed->session_id) {
                     if(session->pppoe_host_uniq) {
                         if(pppoed->host_uniq_len != sizeof(uint64_t) ||
@@ -1744,7 +1763,7 @@ bbl_access_rx_arp(bbl_access_interface_s *interface,
         } else if(arp->code == ARP_REPLY) {
             if(!session->arp_resolved) {
                 session->arp_resolved = true;
-                memcpy(session->server_mac, arp->sender, ETH_ADDR_LEN);
+                memcpy(session->hot->server_mac, arp->sender, ETH_ADDR_LEN);
                 bbl_access_rx_established_ipoe(interface, session, eth);
                 if(g_ctx->config.arp_interval) {
                     timer_add(&g_ctx->timer_root, &session->timer_arp, "ARP timeout", g_ctx->config.arp_interval, 0, session, &bbl_arp_timeout);
@@ -1757,32 +1776,23 @@ bbl_access_rx_arp(bbl_access_interface_s *interface,
     bbl_arp_client_rx(session, arp);
 }
 
-static uint32_t
-bbl_access_session_id_from_vlan(bbl_access_interface_s *interface, 
-                                bbl_ethernet_header_s *eth)
+static bbl_session_s *
+bbl_access_session_from_vlan(bbl_access_interface_s *interface, 
+                             bbl_ethernet_header_s *eth)
 {
-    uint32_t session_id = 0;
     vlan_session_key_t key = {0};
-    bbl_session_s *session;
-    void **search;
 
     key.ifindex = interface->ifindex;
     key.outer_vlan_id = eth->vlan_outer;
     key.inner_vlan_id = eth->vlan_inner;
-
-    search = dict_search(g_ctx->vlan_session_dict, &key);
-    if(search && *search) {
-        session = *search;
-        session_id = session->session_id;
-    }
-    return session_id;
+    return bbl_session_get_by_vlan(&key);
 }
 
-static uint32_t
-bbl_access_session_id_from_broadcast(bbl_access_interface_s *interface,
-                                     bbl_ethernet_header_s *eth)
+static bbl_session_s *
+bbl_access_session_from_broadcast(bbl_access_interface_s *interface,
+                                  bbl_ethernet_header_s *eth)
 {
-    uint32_t session_id = 0;
+    bbl_session_s *session = NULL;
     bbl_ipv4_s *ipv4;
     bbl_udp_s *udp;
     bbl_dhcp_s *dhcp;
@@ -1793,16 +1803,14 @@ bbl_access_session_id_from_broadcast(bbl_access_interface_s *interface,
             udp = (bbl_udp_s*)ipv4->next;
             if(udp->protocol == UDP_PROTOCOL_DHCP) {
                 dhcp = (bbl_dhcp_s*)udp->next;
-                session_id |= ((uint8_t*)(dhcp->header->chaddr))[5];
-                session_id |= ((uint8_t*)(dhcp->header->chaddr))[4] << 8;
-                session_id |= ((uint8_t*)(dhcp->header->chaddr))[3] << 16;
+                session = bbl_session_get_by_mac(interface, (uint8_t*)dhcp->header->chaddr);
             }
         }
     }
-    if(!session_id) {
-        return(bbl_access_session_id_from_vlan(interface, eth));
+    if(!session) {
+        return bbl_access_session_from_vlan(interface, eth);
     }
-    return session_id;
+    return session;
 }
 
 static void
@@ -1810,20 +1818,24 @@ bbl_access_rx_handler_multicast(bbl_access_interface_s *interface,
                                 bbl_ethernet_header_s *eth)
 {
     bbl_session_s *session;
+    bbl_session_hot_s *hot;
     uint32_t session_index;
 
+    /* Scan the compact session array and touch 
+     * the session record only if matching. */
     for(session_index = 0; session_index < g_ctx->sessions; session_index++) {
-        session = &g_ctx->session_list[session_index];
+        hot = &g_ctx->session_hot[session_index];
 
-        if(session->access_interface != interface) {
+        if(hot->access_interface != interface) {
             continue;
         }
 
-        if(session->access_type == ACCESS_TYPE_IPOE) {
-            if(session->session_state != BBL_TERMINATED &&
-               session->session_state != BBL_IDLE) {
-                session->stats.packets_rx++;
-                session->stats.bytes_rx += eth->length;
+        if(hot->access_type == ACCESS_TYPE_IPOE) {
+            if(hot->session_state != BBL_TERMINATED &&
+               hot->session_state != BBL_IDLE) {
+                hot->packets_rx++;
+                hot->bytes_rx += eth->length;
+                session = &g_ctx->session_list[session_index];
                 switch(eth->type) {
                     case ETH_TYPE_IPV4:
                         bbl_access_rx_ipv4(interface, session, eth, (bbl_ipv4_s*)eth->next);
@@ -1845,20 +1857,22 @@ bbl_access_rx_handler_broadcast(bbl_access_interface_s *interface,
                                 bbl_ethernet_header_s *eth)
 {
     bbl_session_s *session;
+    bbl_session_hot_s *hot;
     uint32_t session_index;
 
     for(session_index = 0; session_index < g_ctx->sessions; session_index++) {
-        session = &g_ctx->session_list[session_index];
+        hot = &g_ctx->session_hot[session_index];
 
-        if(session->access_interface != interface) {
+        if(hot->access_interface != interface) {
             continue;
         }
 
-        if(session->access_type == ACCESS_TYPE_IPOE) {
-            if(session->session_state != BBL_TERMINATED &&
-               session->session_state != BBL_IDLE) {
-                session->stats.packets_rx++;
-                session->stats.bytes_rx += eth->length;
+        if(hot->access_type == ACCESS_TYPE_IPOE) {
+            if(hot->session_state != BBL_TERMINATED &&
+               hot->session_state != BBL_IDLE) {
+                hot->packets_rx++;
+                hot->bytes_rx += eth->length;
+                session = &g_ctx->session_list[session_index];
                 switch(eth->type) {
                     case ETH_TYPE_ARP:
                         interface->stats.arp_rx++;
@@ -1889,15 +1903,14 @@ bbl_access_rx_handler(bbl_access_interface_s *interface,
                       bbl_ethernet_header_s *eth)
 {
     bbl_session_s *session;
-    uint32_t session_id = 0;
 
     interface->stats.packets_rx++;
     interface->stats.bytes_rx += eth->length;
 
     if(memcmp(eth->dst, broadcast_mac, ETH_ADDR_LEN) == 0) {
         /* Broadcast destination MAC address (ff:ff:ff:ff:ff:ff) */
-        session_id = bbl_access_session_id_from_broadcast(interface, eth);
-        if(!session_id) {
+        session = bbl_access_session_from_broadcast(interface, eth);
+        if(!session) {
             bbl_access_rx_handler_broadcast(interface, eth);
             return;
         }
@@ -1905,29 +1918,26 @@ bbl_access_rx_handler(bbl_access_interface_s *interface,
         /* Ethernet frames with a value of 1 in the least-significant bit
          * of the first octet of the destination MAC address are treated
          * as multicast frames. */
-        session_id = bbl_access_session_id_from_vlan(interface, eth);
-        if(!session_id) {
+        session = bbl_access_session_from_vlan(interface, eth);
+        if(!session) {
             bbl_access_rx_handler_multicast(interface, eth);
             return;
         }
     } else {
-        /* The session-id is mapped into the last 3 bytes of
-         * the client MAC address. The original approach using
-         * VLAN identifiers was not working reliable as some NIC
+        /* The session-id is mapped into the client MAC 
+         * address. The original approach using VLAN 
+         * identifiers was not working reliable as some NIC
          * drivers strip outer VLAN and it is also possible to have
          * multiple session per VLAN (N:1). */
-        session_id |= eth->dst[5];
-        session_id |= eth->dst[4] << 8;
-        session_id |= eth->dst[3] << 16;
+        session = bbl_session_get_by_mac(interface, eth->dst);
     }
 
-    session = bbl_session_get(session_id);
     if(session) {
-        if(session->session_state != BBL_TERMINATED &&
-           session->session_state != BBL_IDLE) {
-            session->stats.packets_rx++;
-            session->stats.bytes_rx += eth->length;
-            switch (session->access_type) {
+        if(session->hot->session_state != BBL_TERMINATED &&
+           session->hot->session_state != BBL_IDLE) {
+            session->hot->packets_rx++;
+            session->hot->bytes_rx += eth->length;
+            switch (session->hot->access_type) {
                 case ACCESS_TYPE_PPPOE:
                     switch(eth->type) {
                         case ETH_TYPE_PPPOE_DISCOVERY:
@@ -116,6 +116,12 @@ typedef struct bbl_access_interface_
 
     struct timer_ *rate_job;
 
+    /* Interface session-id space (session-id scope interface) */
+    uint8_t index; /* client MAC byte 1 */
+    uint32_t sessions;
+    uint32_t session_list_size;
+    bbl_session_s **session_list;
+
     CIRCLEQ_ENTRY(bbl_access_interface_) access_interface_qnode;
     CIRCLEQ_HEAD(session_tx_access_, bbl_session_ ) session_tx_qhead; /* list of sessions that want to transmit */
 
@@ -25,14 +25,14 @@ bbl_arp_client_tx(bbl_arp_client_s *client)
     eth.next = &arp;
     arp.code = ARP_REQUEST;
     arp.target_ip = client->target_ip;
-    eth.src = session->client_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
-    arp.sender = session->client_mac;
+    arp.sender = session->hot->client_mac;
     arp.sender_ip = session->ip_address;    
-    return bbl_txq_to_buffer(session->access_interface->txq, &eth);
+    return bbl_txq_to_buffer(session->hot->access_interface->txq, &eth);
 }
 
 void
@@ -76,7 +76,7 @@ bbl_arp_client_session_init(bbl_session_s *session)
     bbl_arp_client_config_s *config;
     uint16_t arp_client_group_id = session->access_config->arp_client_group_id;
 
-    if(session->access_type != ACCESS_TYPE_IPOE) return true;
+    if(session->hot->access_type != ACCESS_TYPE_IPOE) return true;
 
     /** Add clients of corresponding arp-client-group-id */
     if(arp_client_group_id) {
@@ -126,7 +126,7 @@ bbl_arp_client_json(bbl_arp_client_s *client)
     return json_pack("{sI ss* ss* ss* ss* sI sI}",
         "session-id", client->session->session_id,
         "sender-ip", format_ipv4_address(&client->session->ip_address),
-        "sender-mac", format_mac_address(client->session->client_mac),
+        "sender-mac", format_mac_address(client->session->hot->client_mac),
         "target-ip", format_ipv4_address(&client->target_ip),
         "target-mac", format_mac_address(client->target_mac),
         "tx", client->tx,
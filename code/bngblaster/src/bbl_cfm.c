@@ -12,7 +12,7 @@ void
 bbl_cfm_cc_job(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->cfm_cc && (session->session_state != BBL_TERMINATED)) {
+    if(session->cfm_cc && (session->hot->session_state != BBL_TERMINATED)) {
         session->send_requests |= BBL_SEND_CFM_CC;
         bbl_session_tx_qnode_insert(session);
     }
@@ -10,6 +10,7 @@
 #include "bbl.h"
 #include "bbl_config.h"
 #include "bbl_stream.h"
+#include "bbl_pcap.h"
 #include <sys/stat.h>
 
 const char g_default_user[] = "user{session-global}@rtbrick.com";
@@ -472,7 +473,10 @@ link_add(char *interface_name)
     link_config->io_burst = g_ctx->config.io_burst;
     link_config->io_slots_rx = g_ctx->config.io_slots;
     link_config->io_slots_tx = g_ctx->config.io_slots;
+    link_config->io_tpacket_v3 = g_ctx->config.io_tpacket_v3;
     link_config->qdisc_bypass = g_ctx->config.qdisc_bypass;
+    link_config->rx_flow_steering = g_ctx->config.rx_flow_steering;
+    link_config->rx_timestamp = g_ctx->config.rx_timestamp;
     link_config->tx_interval = g_ctx->config.tx_interval;
     link_config->rx_interval = g_ctx->config.rx_interval;
     link_config->tx_threads = g_ctx->config.tx_threads;
@@ -492,9 +496,10 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
         "interface", "description", "mac",
         "io-mode", "io-slots", "io-burst", 
         "io-slots-tx", "io-slots-rx", 
-        "qdisc-bypass", 
+        "io-tpacket-v3", "qdisc-bypass", 
         "tx-interval","rx-interval", 
         "tx-threads", "rx-threads",
+        "rx-flow-steering", "rx-timestamp",
         "rx-cpuset", "tx-cpuset", 
         "lag-interface", "lacp-priority"
     };
@@ -529,15 +534,31 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
             return false;
         }
     }
+    JSON_OBJ_GET_BOOL(link, value, "links", "io-tpacket-v3");
+    if(value) {
+        link_config->io_tpacket_v3 = json_boolean_value(value);
+    } else {
+        link_config->io_tpacket_v3 = g_ctx->config.io_tpacket_v3;
+    }
     if(json_unpack(link, "{s:s}", "io-mode", &s) == 0) {
         if(strcmp(s, "packet_mmap_raw") == 0) {
             link_config->io_mode = IO_MODE_PACKET_MMAP_RAW;
-            io_packet_mmap_set_max_stream_len();
+            if(!link_config->io_tpacket_v3) {
+                /* TPACKET_V3 RX blocks are not limited to page size. */
+                io_packet_mmap_set_max_stream_len();
+            }
         } else if(strcmp(s, "packet_mmap") == 0) {
             link_config->io_mode = IO_MODE_PACKET_MMAP;
-            io_packet_mmap_set_max_stream_len();
+            if(!link_config->io_tpacket_v3) {
+                /* TPACKET_V3 RX blocks are not limited to page size
+                 * and TX ring frames are sized for max stream length. */
+                io_packet_mmap_set_max_stream_len();
+            }
         } else if(strcmp(s, "raw") == 0) {
             link_config->io_mode = IO_MODE_RAW;
+        } else if(strcmp(s, "af_xdp") == 0) {
+            link_config->io_mode = IO_MODE_AF_XDP;
+            io_af_xdp_set_max_stream_len();
 #if BNGBLASTER_DPDK
         } else if(strcmp(s, "dpdk") == 0) {
             link_config->io_mode = IO_MODE_DPDK;
@@ -604,6 +625,26 @@ json_parse_link(json_t *link, bbl_link_config_s *link_config)
     } else {
         link_config->rx_threads = g_ctx->config.rx_threads;
     }
+    JSON_OBJ_GET_BOOL(link, value, "links", "rx-flow-steering");
+    if(value) {
+        link_config->rx_flow_steering = json_boolean_value(value);
+    } else {
+        link_config->rx_flow_steering = g_ctx->config.rx_flow_steering;
+    }
+    if(json_unpack(link, "{s:s}", "rx-timestamp", &s) == 0) {
+        if(strcmp(s, "user") == 0) {
+            link_config->rx_timestamp = IO_TIMESTAMP_USER;
+        } else if(strcmp(s, "software") == 0) {
+            link_config->rx_timestamp = IO_TIMESTAMP_SOFTWARE;
+        } else if(strcmp(s, "hardware") == 0) {
+            link_config->rx_timestamp = IO_TIMESTAMP_HARDWARE;
+        } else {
+            fprintf(stderr, "JSON config error: Invalid value for links->rx-timestamp\n");
+            return false;
+        }
+    } else {
+        link_config->rx_timestamp = g_ctx->config.rx_timestamp;
+    }
 
     value = json_object_get(link, "rx-cpuset");
     if(json_is_array(value)) {
@@ -3125,13 +3166,13 @@ json_parse_config(json_t *root)
         const char *sessions_schema[] = {
             "count", "max-outstanding", "start-rate", "stop-rate", 
             "iterate-vlan-outer", "start-delay", "autostart", 
-            "reconnect", "monkey-autostart"
+            "reconnect", "monkey-autostart", "id-bits", "id-scope"
         };
         if(!schema_validate(section, "sessions", sessions_schema, 
            sizeof(sessions_schema)/sizeof(sessions_schema[0]))) {
             return false;
         }
-        JSON_OBJ_GET_NUMBER(section, value, "sessions", "count", 0, 10000000);
+        JSON_OBJ_GET_NUMBER(section, value, "sessions", "count", 0, 4294967294);
         if(value) {
             g_ctx->config.sessions = json_number_value(value);
         }
@@ -3167,6 +3208,20 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.monkey_autostart = json_boolean_value(value);
         }
+        JSON_OBJ_GET_NUMBER(section, value, "sessions", "id-bits", 24, 32);
+        if(value) {
+            g_ctx->config.session_id_bits = json_number_value(value);
+        }
+        if(json_unpack(section, "{s:s}", "id-scope", &s) == 0) {
+            if(strcmp(s, "global") == 0) {
+                g_ctx->config.session_id_interface = false;
+            } else if(strcmp(s, "interface") == 0) {
+                g_ctx->config.session_id_interface = true;
+            } else {
+                fprintf(stderr, "JSON config error: Invalid value for sessions->id-scope\n");
+                return false;
+            }
+        }
     }
 
     /* IPoE Configuration */
@@ -3719,10 +3774,12 @@ json_parse_config(json_t *root)
             "stream-autostart",
             "stream-rate-calculation",
             "stream-delay-calculation",
+            "stream-delay-histogram",
             "stream-burst-ms",
             "reassemble-fragments",
             "multicast-autostart",
-            "udp-checksum"
+            "udp-checksum",
+            "stream-tx-template"
         };
         if(!schema_validate(section, "traffic", schema, 
         sizeof(schema)/sizeof(schema[0]))) {
@@ -3749,6 +3806,10 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.stream_delay_calc = json_boolean_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "traffic", "stream-delay-histogram");
+        if(value) {
+            g_ctx->config.stream_delay_hist = json_boolean_value(value);
+        }
         JSON_OBJ_GET_NUMBER(section, value, "traffic", "stream-burst-ms", 1, 1000);
         if(value) {
             g_ctx->config.stream_burst_ms = json_number_value(value) * MSEC;
@@ -3765,6 +3826,10 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.stream_udp_checksum = json_boolean_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "traffic", "stream-tx-template");
+        if(value) {
+            g_ctx->config.stream_tx_template = json_boolean_value(value);
+        }
     }
 
     /* Session Traffic Configuration */
@@ -3965,25 +4030,40 @@ json_parse_config(json_t *root)
     if(json_is_object(section)) {
 
         const char *schema[] = {
-            "io-mode", "io-slots", "io-burst", "qdisc-bypass",
+            "io-mode", "io-slots", "io-burst", "io-tpacket-v3", "qdisc-bypass",
             "tx-interval", "rx-interval", "tx-threads",
-            "rx-threads", "capture-include-streams", "mac-modifier",
-            "lag", "network", "access", "a10nsp", "links"
+            "rx-threads", "rx-flow-steering", "rx-timestamp", "capture-include-streams", 
+            "capture-snaplen", "capture-interfaces", "capture-protocols", "mac-modifier",
+            "timer-wheel", "lag", "network", "access", "a10nsp", "links"
         };
         if(!schema_validate(section, "interfaces", schema, 
         sizeof(schema)/sizeof(schema[0]))) {
             return false;
         }
         
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "io-tpacket-v3");
+        if(value) {
+            g_ctx->config.io_tpacket_v3 = json_boolean_value(value);
+        }
         if(json_unpack(section, "{s:s}", "io-mode", &s) == 0) {
             if(strcmp(s, "packet_mmap_raw") == 0) {
                 g_ctx->config.io_mode = IO_MODE_PACKET_MMAP_RAW;
-                io_packet_mmap_set_max_stream_len();
+                if(!g_ctx->config.io_tpacket_v3) {
+                    /* TPACKET_V3 RX blocks are not limited to page size. */
+                    io_packet_mmap_set_max_stream_len();
+                }
             } else if(strcmp(s, "packet_mmap") == 0) {
                 g_ctx->config.io_mode = IO_MODE_PACKET_MMAP;
-                io_packet_mmap_set_max_stream_len();
+                if(!g_ctx->config.io_tpacket_v3) {
+                    /* TPACKET_V3 RX blocks are not limited to page size
+                     * and TX ring frames are sized for max stream length. */
+                    io_packet_mmap_set_max_stream_len();
+                }
             } else if(strcmp(s, "raw") == 0) {
                 g_ctx->config.io_mode = IO_MODE_RAW;
+            } else if(strcmp(s, "af_xdp") == 0) {
+                g_ctx->config.io_mode = IO_MODE_AF_XDP;
+                io_af_xdp_set_max_stream_len();
 #if BNGBLASTER_DPDK
             } else if(strcmp(s, "dpdk") == 0) {
                 g_ctx->config.io_mode = IO_MODE_DPDK;
@@ -3995,7 +4075,9 @@ json_parse_config(json_t *root)
             }
         } else {
             g_ctx->config.io_mode = IO_MODE_PACKET_MMAP_RAW;
-            io_packet_mmap_set_max_stream_len();
+            if(!g_ctx->config.io_tpacket_v3) {
+                io_packet_mmap_set_max_stream_len();
+            }
         }
         value = json_object_get(section, "io-slots");
         JSON_OBJ_GET_NUMBER(section, value, "interfaces", "io-slots", 32, 65535);
@@ -4027,10 +4109,67 @@ json_parse_config(json_t *root)
         if(value) {
             g_ctx->config.rx_threads = json_number_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "rx-flow-steering");
+        if(value) {
+            g_ctx->config.rx_flow_steering = json_boolean_value(value);
+        }
+        if(json_unpack(section, "{s:s}", "rx-timestamp", &s) == 0) {
+            if(strcmp(s, "user") == 0) {
+                g_ctx->config.rx_timestamp = IO_TIMESTAMP_USER;
+            } else if(strcmp(s, "software") == 0) {
+                g_ctx->config.rx_timestamp = IO_TIMESTAMP_SOFTWARE;
+            } else if(strcmp(s, "hardware") == 0) {
+                g_ctx->config.rx_timestamp = IO_TIMESTAMP_HARDWARE;
+            } else {
+                fprintf(stderr, "JSON config error: Invalid value for interfaces->rx-timestamp\n");
+                return false;
+            }
+        }
         JSON_OBJ_GET_BOOL(section, value, "interfaces", "capture-include-streams");
         if(value) {
             g_ctx->pcap.include_streams = json_boolean_value(value);
         }
+        JSON_OBJ_GET_BOOL(section, value, "interfaces", "timer-wheel");
+        if(value) {
+            g_ctx->config.timer_wheel = json_boolean_value(value);
+        }
+        JSON_OBJ_GET_NUMBER(section, value, "interfaces", "capture-snaplen", 64, 9216);
+        if(value) {
+            g_ctx->pcap.snaplen = json_number_value(value);
+        }
+        value = json_object_get(section, "capture-interfaces");
+        if(json_is_array(value)) {
+            size = json_array_size(value);
+            g_ctx->pcap.interfaces = calloc(size, sizeof(char*));
+            g_ctx->pcap.interfaces_count = size;
+            for(i = 0; i < size; i++) {
+                sub = json_array_get(value, i);
+                if(json_is_string(sub)) {
+                    g_ctx->pcap.interfaces[i] = strdup(json_string_value(sub));
+                } else {
+                    fprintf(stderr, "JSON config error: Invalid value for interfaces->capture-interfaces\n");
+                    return false;
+                }
+            }
+        } else if(value) {
+            fprintf(stderr, "JSON config error: Invalid value for interfaces->capture-interfaces\n");
+            return false;
+        }
+        value = json_object_get(section, "capture-protocols");
+        if(json_is_array(value)) {
+            size = json_array_size(value);
+            for(i = 0; i < size; i++) {
+                sub = json_array_get(value, i);
+                if(!(json_is_string(sub) && pcapng_protocol(json_string_value(sub)))) {
+                    fprintf(stderr, "JSON config error: Invalid value for interfaces->capture-protocols\n");
+                    return false;
+                }
+                g_ctx->pcap.protocols |= pcapng_protocol(json_string_value(sub));
+            }
+        } else if(value) {
+            fprintf(stderr, "JSON config error: Invalid value for interfaces->capture-protocols\n");
+            return false;
+        }
         JSON_OBJ_GET_NUMBER(section, value, "interfaces", "mac-modifier", 0, 255);
         if(value) {
             g_ctx->config.mac_modifier = json_number_value(value);
@@ -4505,7 +4644,9 @@ bbl_config_init_defaults()
     g_ctx->config.io_burst = 256;
     g_ctx->config.io_max_stream_len = 9000;
     g_ctx->config.qdisc_bypass = true;
+    g_ctx->config.timer_wheel = g_ctx->timer_root.wheel; /* build default */
     g_ctx->config.sessions = 1;
+    g_ctx->config.session_id_bits = BBL_SESSION_ID_BITS;
     g_ctx->config.sessions_max_outstanding = 800;
     g_ctx->config.sessions_start_rate = 400;
     g_ctx->config.sessions_stop_rate = 400;
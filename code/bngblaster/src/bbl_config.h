@@ -21,6 +21,23 @@ typedef struct bbl_secondary_ip6_
     void *next;
 } bbl_secondary_ip6_s;
 
+typedef struct bbl_session_template_token_
+{
+    session_var_t var;
+    uint16_t len; /* literal length */
+    const char *literal; /* literal within template source */
+} bbl_session_template_token_s;
+
+/* Session string template compiled once
+ * per access configuration. */
+typedef struct bbl_session_template_
+{
+    const char *source;
+    bool literal; /* source without variables */
+    uint16_t tokens;
+    bbl_session_template_token_s *token;
+} bbl_session_template_s;
+
 typedef struct bbl_access_config_
 {
     bool exhausted;
@@ -106,6 +123,9 @@ typedef struct bbl_access_config_
 
     uint16_t ppp_mru;
 
+    /* Session string templates */
+    bbl_session_template_s string[SESSION_STRING_MAX];
+
     void *next; /* pointer to next access config element */
     bbl_access_interface_s *access_interface;
 } bbl_access_config_s;
@@ -176,7 +196,10 @@ typedef struct bbl_link_config_
     uint16_t io_slots_rx;
     uint16_t io_burst;
 
+    bool io_tpacket_v3;
     bool qdisc_bypass;
+    bool rx_flow_steering;
+    io_timestamp_t rx_timestamp;
 
     uint64_t tx_interval; /* TX interval in nsec */
     uint64_t rx_interval; /* RX interval in nsec */
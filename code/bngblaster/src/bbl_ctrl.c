@@ -6,6 +6,9 @@
  * Copyright (C) 2020-2025, RtBrick, Inc.
  * SPDX-License-Identifier: BSD-3-Clause
  */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* memfd_create */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -17,6 +20,12 @@
 #include <signal.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <ctype.h>
+#include <time.h>
 
 #include "bbl.h"
 #include "bbl_ctrl.h"
@@ -43,6 +52,7 @@ const char *schema_all_args[] = {
     "disconnect-direction", "disconnect-message",
     "ldp-instance-id", "tcp-flags", "debug", "detail",
     "verified-only", "bidirectional-verified-only",
+    "topics", "interval",
     NULL
 };
 
@@ -142,6 +152,7 @@ int
 bbl_ctrl_multicast_traffic_start(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
 {
     g_ctx->multicast_endpoint = ENDPOINT_ACTIVE;
+    bbl_stream_multicast_update();
     return bbl_ctrl_status(fd, "ok", 200, NULL);
 }
 
@@ -149,6 +160,7 @@ int
 bbl_ctrl_multicast_traffic_stop(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)))
 {
     g_ctx->multicast_endpoint = ENDPOINT_ENABLED;
+    bbl_stream_multicast_update();
     return bbl_ctrl_status(fd, "ok", 200, NULL);
 }
 
@@ -213,6 +225,8 @@ struct action actions[] = {
     {"stream-stats", bbl_stream_ctrl_stats, schema_all_args, true},
     {"stream-reset", bbl_stream_ctrl_reset, schema_all_args, false},
     {"stream-summary", bbl_stream_ctrl_summary, schema_all_args, true},
+    {"stream-delay", bbl_stream_ctrl_delay, schema_all_args, true},
+    {"stream-export", bbl_stream_ctrl_export, schema_all_args, true},
     {"streams-pending", bbl_stream_ctrl_pending, schema_no_args, true},
     {"session-traffic", bbl_session_ctrl_traffic_stats, schema_all_args, true},
     {"session-traffic-reset", bbl_session_ctrl_traffic_reset, schema_all_args, false},
@@ -291,6 +305,7 @@ struct action actions[] = {
     {"cfm-cc-rdi-off", bbl_cfm_ctrl_cc_rdi_off, schema_all_args, false},
     {"lcp-echo-request-ignore", bbl_session_ctrl_lcp_echo_request_ignore, schema_all_args, true},
     {"lcp-echo-request-accept", bbl_session_ctrl_lcp_echo_request_accept, schema_all_args, true},
+    {"subscribe", bbl_subscribe_ctrl, schema_all_args, false},
     /* DEPRECATED */
     {"session-traffic-enabled", bbl_session_ctrl_traffic_start, schema_all_args, true},
     {"session-traffic-disabled", bbl_session_ctrl_traffic_stop, schema_all_args, true},
@@ -305,15 +320,50 @@ struct action actions[] = {
 static void
 bbl_ctrl_socket_main(bbl_ctrl_thread_s *ctrl)
 {
-    if(ctrl->main.fd) {
-        pthread_mutex_lock(&ctrl->mutex);
-        actions[ctrl->main.action].fn(ctrl->main.fd, ctrl->main.session_id, (json_t*)ctrl->main.arguments);
-        ctrl->main.action = 0;
-        ctrl->main.fd = 0;
-        ctrl->main.session_id = 0;
-        ctrl->main.arguments = NULL;
-        pthread_cond_signal(&ctrl->cond);
+    bbl_ctrl_request_s *head;
+    bbl_ctrl_request_s *tail;
+    bbl_ctrl_request_s *request;
+    bbl_ctrl_client_s *client;
+    size_t batch = 1;
+    uint64_t wakeup = 1;
+
+    /* Detach a batch of requests from the queue, such
+     * that the ctrl thread is not blocked while those
+     * commands are executed. */
+    pthread_mutex_lock(&ctrl->mutex);
+    head = ctrl->main.head;
+    if(!head) {
         pthread_mutex_unlock(&ctrl->mutex);
+        return;
+    }
+    tail = head;
+    while(tail->next && batch < BBL_CTRL_MAIN_BATCH) {
+        tail = tail->next;
+        batch++;
+    }
+    ctrl->main.head = tail->next;
+    if(!ctrl->main.head) {
+        ctrl->main.tail = NULL;
+    }
+    tail->next = NULL;
+    pthread_mutex_unlock(&ctrl->mutex);
+
+    /* Responses are written to the output buffer of the
+     * client, which is sent by the ctrl thread. Only the
+     * subscription takes over the connection itself. */
+    for(request = head; request; request = request->next) {
+        client = request->client;
+        actions[request->action].fn(client->detach ? client->fd : client->out,
+                                    request->session_id, request->arguments);
+    }
+
+    /* Hand back to ctrl thread. */
+    pthread_mutex_lock(&ctrl->mutex);
+    tail->next = ctrl->done;
+    ctrl->done = head;
+    pthread_mutex_unlock(&ctrl->mutex);
+    if(write(ctrl->event, &wakeup, sizeof(wakeup)) < 0) {
+        LOG(ERROR, "Failed to wakeup ctrl thread (error %d)\n", errno);
     }
 }
 
@@ -323,171 +373,527 @@ bbl_ctrl_socket_main_job(timer_s *timer)
     bbl_ctrl_socket_main(timer->data);
 }
 
-void *
-bbl_ctrl_socket_thread(void *thread_data)
+static void
+bbl_ctrl_client_close(bbl_ctrl_thread_s *ctrl, bbl_ctrl_client_s *client)
 {
-    bbl_ctrl_thread_s *ctrl = thread_data;
+    bbl_ctrl_client_s **prev = &ctrl->clients;
+    while(*prev) {
+        if(*prev == client) {
+            *prev = client->next;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+    epoll_ctl(ctrl->epoll, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    close(client->out);
+    free(client->buf);
+    free(client);
+    ctrl->client_count--;
+}
+
+static bool
+bbl_ctrl_client_busy(bbl_ctrl_client_s *client)
+{
+    return client->out_offset < client->out_len;
+}
+
+/**
+ * bbl_ctrl_client_flush
+ *
+ * Send the output buffer without blocking. The
+ * send is continued at the offset where a partial
+ * send stopped on EPOLLOUT, such that responses
+ * and their newline framing are never interleaved.
+ * A failed connection is marked to be closed.
+ */
+static void
+bbl_ctrl_client_flush(bbl_ctrl_client_s *client)
+{
+    ssize_t rc;
+    off_t len;
 
+    len = lseek(client->out, 0, SEEK_CUR);
+    if(len > client->out_len) {
+        client->out_len = len;
+        client->out_time = time(NULL);
+    }
+    while(client->out_offset < client->out_len) {
+        rc = sendfile(client->fd, client->out, &client->out_offset,
+                      client->out_len - client->out_offset);
+        if(rc > 0) {
+            client->out_time = time(NULL);
+        } else if(rc < 0 && errno == EINTR) {
+            continue;
+        } else if(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            goto FAILED;
+        }
+    }
+    if(client->out_len) {
+        /* Reuse output buffer for the next response. */
+        if(ftruncate(client->out, 0) != 0 || lseek(client->out, 0, SEEK_SET) != 0) {
+            goto FAILED;
+        }
+        client->out_offset = 0;
+        client->out_len = 0;
+    }
+    if(client->closing && !client->closing_time) {
+        client->closing_time = time(NULL);
+        shutdown(client->fd, SHUT_WR);
+    }
+    return;
+FAILED:
+    client->out_offset = client->out_len;
+    client->eof = true;
+    client->closing = true;
+}
+
+/**
+ * bbl_ctrl_client_finish
+ *
+ * Called after the response of a request is written.
+ * Keep-alive requests leave the connection open for
+ * further requests, with each response followed by a
+ * newline. All other connections are shut down once
+ * the response is sent.
+ */
+static void
+bbl_ctrl_client_finish(bbl_ctrl_client_s *client)
+{
+    if(client->keepalive) {
+        if(write(client->out, "\n", 1) == 1) {
+            return;
+        }
+    }
+    client->closing = true;
+    client->len = 0;
+}
+
+/**
+ * bbl_ctrl_client_update
+ *
+ * Close the connection if done or update the epoll
+ * events, which are EPOLLOUT while the output buffer
+ * is not completely sent, EPOLLIN otherwise and none
+ * while a request is queued to the main thread.
+ */
+static void
+bbl_ctrl_client_update(bbl_ctrl_thread_s *ctrl, bbl_ctrl_client_s *client)
+{
+    struct epoll_event event = {0};
+    uint32_t events = 0;
+    int op;
+
+    if(!client->pending) {
+        if(bbl_ctrl_client_busy(client)) {
+            events = EPOLLOUT;
+        } else if(client->eof) {
+            bbl_ctrl_client_close(ctrl, client);
+            return;
+        } else {
+            events = EPOLLIN;
+        }
+    }
+    if(events == client->events) {
+        return;
+    }
+    if(!client->events) {
+        op = EPOLL_CTL_ADD;
+    } else if(!events) {
+        op = EPOLL_CTL_DEL;
+    } else {
+        op = EPOLL_CTL_MOD;
+    }
+    event.events = events;
+    event.data.ptr = client;
+    if(epoll_ctl(ctrl->epoll, op, client->fd, &event) != 0 && events) {
+        bbl_ctrl_client_close(ctrl, client);
+        return;
+    }
+    client->events = events;
+}
+
+static void
+bbl_ctrl_request(bbl_ctrl_thread_s *ctrl, bbl_ctrl_client_s *client, json_t *root)
+{
+    int fd = client->out;
     size_t i;
-    size_t flags = JSON_DISABLE_EOF_CHECK;
-    json_error_t error;
-    json_t *root = NULL;
     json_t* arguments = NULL;
     json_t* value = NULL;
     const char *command = NULL;
     uint32_t session_id = 0;
 
-    fd_set read_fds;
-
     bbl_access_interface_s *access_interface;
+    bbl_ctrl_request_s *request;
 
     vlan_session_key_t key = {0};
     bbl_session_s *session;
-    void **search;
 
-    /* ToDo: Add connection manager!
-     * This is just a temporary workaround! Finally we need
-     * to create a connection manager. */
-    static int fd = 0;
+    /* Each command request should be formatted as shown in the example below
+     * with a mandatory command element and optional arguments.
+     * {
+     *    "command": "session-info",
+     *    "arguments": {
+     *        "outer-vlan": 1,
+     *        "inner-vlan": 2
+     *    }
+     * }
+     *
+     * The optional element "keep-alive" set to true keeps the
+     * connection open for further requests after the response.
+     */
+    value = json_object_get(root, "keep-alive");
+    client->keepalive = value && json_is_true(value);
+    if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
+        LOG_NOARG(ERROR, "Invalid command via ctrl socket\n");
+        bbl_ctrl_status(fd, "error", 400, "invalid request");
+        goto DONE;
+    }
+    if(arguments) {
+        value = json_object_get(arguments, "session-id");
+        if(value) {
+            if(json_is_number(value)) {
+                session_id = json_number_value(value);
+            } else {
+                bbl_ctrl_status(fd, "error", 400, "invalid session-id");
+                goto DONE;
+            }
+        } else {
+            /* Deprecated!
+             * For backward compatibility with version 0.4.X, we still
+             * support per session commands using VLAN index instead of
+             * new session-id. */
+            value = json_object_get(arguments, "ifindex");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.ifindex = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid ifindex");
+                    goto DONE;
+                }
+            } else {
+                value = json_object_get(arguments, "interface");
+                if(value && json_is_string(value)) {
+                    access_interface = bbl_access_interface_get((char*)json_string_value(value));
+                } else {
+                    /* Use first interface as default. */
+                    access_interface = bbl_access_interface_get(NULL);
+                }
+                if(access_interface) {
+                    key.ifindex = access_interface->ifindex;
+                }
+            }
+            value = json_object_get(arguments, "outer-vlan");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.outer_vlan_id = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid outer-vlan");
+                    goto DONE;
+                }
+            }
+            value = json_object_get(arguments, "inner-vlan");
+            if(value) {
+                if(json_is_number(value)) {
+                    key.inner_vlan_id = json_number_value(value);
+                } else {
+                    bbl_ctrl_status(fd, "error", 400, "invalid inner-vlan");
+                    goto DONE;
+                }
+            }
+            if(key.outer_vlan_id) {
+                session = bbl_session_get_by_vlan(&key);
+                if(session) {
+                    session_id = session->session_id;
+                } else {
+                    bbl_ctrl_status(fd, "warning", 404, "session not found");
+                    goto DONE;
+                }
+            }
+        }
+    }
+    for(i = 0; true; i++) {
+        if(actions[i].name == NULL) {
+            bbl_ctrl_status(fd, "error", 400, "unknown command");
+            break;
+        } else if(strcmp(actions[i].name, command) == 0) {
+            if(actions[i].schema && !bbl_ctrl_schema(arguments, actions[i].schema)) {
+                bbl_ctrl_status(fd, "error", 400, "invalid argument");
+                break;
+            }
+            if(actions[i].thread_safe) {
+                actions[i].fn(fd, session_id, arguments);
+                break;
+            }
+            /* Queue request to be executed in main thread. Further
+             * requests of this client are not processed until the
+             * response is written, but other clients are served. */
+            request = calloc(1, sizeof(bbl_ctrl_request_s));
+            if(!request) {
+                bbl_ctrl_status(fd, "error", 500, "out of memory");
+                break;
+            }
+            request->client = client;
+            request->action = i;
+            request->session_id = session_id;
+            request->root = root;
+            request->arguments = arguments;
+            pthread_mutex_lock(&ctrl->mutex);
+            if(ctrl->main.tail) {
+                ctrl->main.tail->next = request;
+            } else {
+                ctrl->main.head = request;
+            }
+            ctrl->main.tail = request;
+            pthread_mutex_unlock(&ctrl->mutex);
+            client->pending = true;
+            if(actions[i].fn == bbl_subscribe_ctrl) {
+                /* The connection is handed over to the subscription. */
+                client->detach = true;
+            }
+            return;
+        }
+    }
+DONE:
+    json_decref(root);
+    bbl_ctrl_client_finish(client);
+}
 
-    // Set timeout for 1s
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
+static void
+bbl_ctrl_client_process(bbl_ctrl_thread_s *ctrl, bbl_ctrl_client_s *client)
+{
+    json_error_t error;
+    json_t *root;
+    size_t offset = 0;
+    size_t len;
 
-    struct timespec sleep, rem;
-    sleep.tv_sec = 0;
-    sleep.tv_nsec = 10 * MSEC;
+    while(!client->pending && !client->closing && !bbl_ctrl_client_busy(client)) {
+        while(offset < client->len && isspace((unsigned char)client->buf[offset])) {
+            offset++;
+        }
+        if(offset >= client->len) {
+            break;
+        }
+        len = client->len - offset;
+        root = json_loadb(client->buf+offset, len, JSON_DISABLE_EOF_CHECK, &error);
+        if(!root) {
+            if(error.position >= (int)len && !client->eof && client->len < BBL_CTRL_BUFFER_MAX) {
+                /* Incomplete request, wait for more data. */
+                break;
+            }
+            LOG(ERROR, "Invalid json via ctrl socket: line %d: %s\n", error.line, error.text);
+            bbl_ctrl_status(client->out, "error", 400, "invalid json");
+            client->keepalive = false;
+            bbl_ctrl_client_finish(client);
+            bbl_ctrl_client_flush(client);
+            return;
+        }
+        /* The position is also set if there was no error. */
+        offset += error.position;
+        bbl_ctrl_request(ctrl, client, root);
+        if(!client->pending) {
+            bbl_ctrl_client_flush(client);
+        }
+    }
+    if(offset && !client->closing) {
+        client->len -= offset;
+        memmove(client->buf, client->buf+offset, client->len);
+    }
+}
 
-    ctrl->active = true;
-    while(ctrl->active) {
-        fd = accept(ctrl->socket, 0, 0);
-        if(fd > 0) {
-            /* New connection. */
-            FD_ZERO(&read_fds);
-            FD_SET(fd, &read_fds);
-            root = json_loadfd(fd, flags, &error);
-            if(!root) {
-                LOG(ERROR, "Invalid json via ctrl socket: line %d: %s\n", error.line, error.text);
-                bbl_ctrl_status(fd, "error", 400, "invalid json");
-            } else {
-                    /* Each command request should be formatted as shown in the example below
-                    * with a mandatory command element and optional arguments.
-                    * {
-                    *    "command": "session-info",
-                    *    "arguments": {
-                    *        "outer-vlan": 1,
-                    *        "inner-vlan": 2
-                    *    }
-                    * }
-                    */
-                command = NULL;
-                arguments = NULL;
-                session_id = 0;
-                key.ifindex = 0;
-                key.inner_vlan_id = 0;
-                key.outer_vlan_id = 0;
-                if(json_unpack(root, "{s:s, s?o}", "command", &command, "arguments", &arguments) != 0) {
-                    LOG_NOARG(ERROR, "Invalid command via ctrl socket\n");
-                    bbl_ctrl_status(fd, "error", 400, "invalid request");
-                } else {
-                    if(arguments) {
-                        value = json_object_get(arguments, "session-id");
-                        if(value) {
-                            if(json_is_number(value)) {
-                                session_id = json_number_value(value);
-                            } else {
-                                bbl_ctrl_status(fd, "error", 400, "invalid session-id");
-                                goto CLOSE;
-                            }
-                        } else {
-                            /* Deprecated!
-                             * For backward compatibility with version 0.4.X, we still
-                             * support per session commands using VLAN index instead of
-                             * new session-id. */
-                            value = json_object_get(arguments, "ifindex");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.ifindex = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid ifindex");
-                                    goto CLOSE;
-                                }
-                            } else {
-                                value = json_object_get(arguments, "interface");
-                                if(value && json_is_string(value)) {
-                                    access_interface = bbl_access_interface_get((char*)json_string_value(value));
-                                } else {
-                                    /* Use first interface as default. */
-                                    access_interface = bbl_access_interface_get(NULL);
-                                }
-                                if(access_interface) {
-                                    key.ifindex = access_interface->ifindex;
-                                }
-                            }
-                            value = json_object_get(arguments, "outer-vlan");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.outer_vlan_id = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid outer-vlan");
-                                    goto CLOSE;
-                                }
-                            }
-                            value = json_object_get(arguments, "inner-vlan");
-                            if(value) {
-                                if(json_is_number(value)) {
-                                    key.inner_vlan_id = json_number_value(value);
-                                } else {
-                                    bbl_ctrl_status(fd, "error", 400, "invalid inner-vlan");
-                                    goto CLOSE;
-                                }
-                            }
-                            if(key.outer_vlan_id) {
-                                search = dict_search(g_ctx->vlan_session_dict, &key);
-                                if(search && *search) {
-                                    session = *search;
-                                    session_id = session->session_id;
-                                } else {
-                                    bbl_ctrl_status(fd, "warning", 404, "session not found");
-                                    goto CLOSE;
-                                }
-                            }
-                        }
-                    }
-                    for(i = 0; true; i++) {
-                        if(actions[i].name == NULL) {
-                            bbl_ctrl_status(fd, "error", 400, "unknown command");
-                            break;
-                        } else if(strcmp(actions[i].name, command) == 0) {
-                            if(actions[i].schema && !bbl_ctrl_schema(arguments, actions[i].schema)) {
-                                bbl_ctrl_status(fd, "error", 400, "invalid argument");
-                                break;
-                            }
-                            if(actions[i].thread_safe) {
-                                actions[i].fn(fd, session_id, arguments);
-                            } else {
-                                pthread_mutex_lock(&ctrl->mutex);
-                                ctrl->main.fd = fd;
-                                ctrl->main.action = i;
-                                ctrl->main.session_id = session_id;
-                                ctrl->main.arguments = (void*)arguments;
-                                pthread_cond_wait(&ctrl->cond, &ctrl->mutex);
-                                pthread_mutex_unlock(&ctrl->mutex);
-                            }
-                            break;
-                        }
-                    }
+static void
+bbl_ctrl_client_read(bbl_ctrl_client_s *client)
+{
+    char discard[256];
+    char *buf;
+    ssize_t len;
+
+    while(true) {
+        if(client->closing) {
+            len = recv(client->fd, discard, sizeof(discard), MSG_DONTWAIT);
+        } else {
+            if(client->len == client->size) {
+                if(client->size >= BBL_CTRL_BUFFER_MAX) {
+                    break;
                 }
-CLOSE:
-                json_decref(root);
-                root = NULL;
+                buf = realloc(client->buf, client->size * 2);
+                if(!buf) {
+                    break;
+                }
+                client->buf = buf;
+                client->size *= 2;
+            }
+            len = recv(client->fd, client->buf+client->len, client->size-client->len, MSG_DONTWAIT);
+        }
+        if(len > 0) {
+            if(!client->closing) {
+                client->len += len;
             }
-            shutdown(fd, SHUT_WR);
-            select(fd + 1, &read_fds, NULL, NULL, &timeout);
+        } else if(len == 0) {
+            client->eof = true;
+            break;
+        } else if(errno != EINTR) {
+            if(errno != EAGAIN && errno != EWOULDBLOCK) {
+                client->eof = true;
+            }
+            break;
+        }
+    }
+}
+
+static void
+bbl_ctrl_client_event(bbl_ctrl_thread_s *ctrl, bbl_ctrl_client_s *client, uint32_t events)
+{
+    if(events & EPOLLOUT) {
+        bbl_ctrl_client_flush(client);
+    }
+    if(events & (EPOLLIN|EPOLLHUP|EPOLLERR)) {
+        bbl_ctrl_client_read(client);
+    }
+    bbl_ctrl_client_process(ctrl, client);
+    bbl_ctrl_client_update(ctrl, client);
+}
+
+static void
+bbl_ctrl_client_accept(bbl_ctrl_thread_s *ctrl)
+{
+    bbl_ctrl_client_s *client;
+    struct epoll_event event = {0};
+    int fd;
+
+    while(true) {
+        fd = accept(ctrl->socket, 0, 0);
+        if(fd < 0) {
+            break;
+        }
+        if(ctrl->client_count >= BBL_CTRL_CLIENTS_MAX) {
+            LOG(ERROR, "Failed to accept ctrl socket connection (limit of %u connections reached)\n",
+                BBL_CTRL_CLIENTS_MAX);
             close(fd);
-        } else {
-            nanosleep(&sleep, &rem);
+            continue;
+        }
+        client = calloc(1, sizeof(bbl_ctrl_client_s));
+        if(!client) {
+            close(fd);
+            continue;
+        }
+        client->size = 4096;
+        client->buf = malloc(client->size);
+        if(!client->buf) {
+            free(client);
+            close(fd);
+            continue;
+        }
+        /* The ctrl thread must never block on a slow
+         * client, responses are therefore buffered. */
+        client->out = memfd_create("bbl-ctrl", MFD_CLOEXEC);
+        if(client->out < 0) {
+            free(client->buf);
+            free(client);
+            close(fd);
+            continue;
+        }
+        client->fd = fd;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        event.events = EPOLLIN;
+        event.data.ptr = client;
+        if(epoll_ctl(ctrl->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(client->out);
+            free(client->buf);
+            free(client);
+            close(fd);
+            continue;
+        }
+        client->events = EPOLLIN;
+        client->next = ctrl->clients;
+        ctrl->clients = client;
+        ctrl->client_count++;
+    }
+}
+
+static void
+bbl_ctrl_client_done(bbl_ctrl_thread_s *ctrl)
+{
+    bbl_ctrl_request_s *request;
+    bbl_ctrl_request_s *next;
+    bbl_ctrl_client_s *client;
+    uint64_t wakeup;
+
+    if(read(ctrl->event, &wakeup, sizeof(wakeup)) < 0) {
+        /* Nothing to do. */
+    }
+    pthread_mutex_lock(&ctrl->mutex);
+    request = ctrl->done;
+    ctrl->done = NULL;
+    pthread_mutex_unlock(&ctrl->mutex);
+
+    while(request) {
+        next = request->next;
+        client = request->client;
+        json_decref(request->root);
+        free(request);
+        request = next;
+
+        client->pending = false;
+        if(client->detach) {
+            /* Close without shutdown as the subscription
+             * holds its own reference to this connection. */
+            bbl_ctrl_client_close(ctrl, client);
+            continue;
+        }
+        bbl_ctrl_client_finish(client);
+        bbl_ctrl_client_flush(client);
+        bbl_ctrl_client_process(ctrl, client);
+        bbl_ctrl_client_update(ctrl, client);
+    }
+}
+
+void *
+bbl_ctrl_socket_thread(void *thread_data)
+{
+    bbl_ctrl_thread_s *ctrl = thread_data;
+    bbl_ctrl_client_s *client;
+    bbl_ctrl_client_s *next;
+    struct epoll_event events[BBL_CTRL_CLIENTS_MAX];
+    bool done;
+    time_t now;
+    int i, n;
+
+    while(ctrl->active) {
+        n = epoll_wait(ctrl->epoll, events, BBL_CTRL_CLIENTS_MAX, 100);
+        done = false;
+        for(i = 0; i < n; i++) {
+            if(events[i].data.ptr == NULL) {
+                bbl_ctrl_client_accept(ctrl);
+            } else if(events[i].data.ptr == &ctrl->event) {
+                done = true;
+            } else {
+                bbl_ctrl_client_event(ctrl, events[i].data.ptr, events[i].events);
+            }
+        }
+        /* Handle responses from main thread after all events
+         * are processed as clients might be closed here. */
+        if(done) {
+            bbl_ctrl_client_done(ctrl);
+        }
+        /* Close connections if client does not close
+         * within a few seconds after final response or
+         * does not read the pending response anymore. */
+        now = time(NULL);
+        client = ctrl->clients;
+        while(client) {
+            next = client->next;
+            if(client->pending) {
+                /* Owned by main thread. */
+            } else if(client->closing_time && now - client->closing_time > 1) {
+                bbl_ctrl_client_close(ctrl, client);
+            } else if(bbl_ctrl_client_busy(client) && now - client->out_time > BBL_CTRL_SEND_TIMEOUT) {
+                LOG_NOARG(DEBUG, "Close ctrl socket connection (send timeout)\n");
+                bbl_ctrl_client_close(ctrl, client);
+            }
+            client = next;
         }
     }
     return NULL;
@@ -498,6 +904,7 @@ bbl_ctrl_socket_init()
 {
     bbl_ctrl_thread_s *ctrl;
     struct sockaddr_un addr = {0};
+    struct epoll_event event = {0};
 
     if(!g_ctx->ctrl_socket_path) {
         return true;
@@ -530,22 +937,43 @@ bbl_ctrl_socket_init()
     /* Change socket to non-blocking */
     fcntl(ctrl->socket, F_SETFL, O_NONBLOCK);
 
+    ctrl->epoll = epoll_create1(0);
+    if(ctrl->epoll < 0) {
+        fprintf(stderr, "Error: Failed to create ctrl socket epoll (error %d)\n", errno);
+        return false;
+    }
+    ctrl->event = eventfd(0, EFD_NONBLOCK);
+    if(ctrl->event < 0) {
+        fprintf(stderr, "Error: Failed to create ctrl socket eventfd (error %d)\n", errno);
+        return false;
+    }
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if(epoll_ctl(ctrl->epoll, EPOLL_CTL_ADD, ctrl->socket, &event) != 0) {
+        fprintf(stderr, "Error: Failed to add ctrl socket to epoll (error %d)\n", errno);
+        return false;
+    }
+    event.data.ptr = &ctrl->event;
+    if(epoll_ctl(ctrl->epoll, EPOLL_CTL_ADD, ctrl->event, &event) != 0) {
+        fprintf(stderr, "Error: Failed to add ctrl socket eventfd to epoll (error %d)\n", errno);
+        return false;
+    }
+
     /* Create ctrl thread */
     if(pthread_mutex_init(&ctrl->mutex, NULL) != 0) {
         LOG_NOARG(ERROR, "Failed to init ctrl mutex\n");
         return false;
     }
-    if(pthread_cond_init(&ctrl->cond, NULL) != 0) {
-        LOG_NOARG(ERROR, "Failed to init ctrl condition\n");
-        return false;
-    }
+    ctrl->active = true;
     if(pthread_create(&ctrl->thread, NULL, bbl_ctrl_socket_thread, (void *)ctrl) != 0) {
         LOG_NOARG(ERROR, "Failed to create ctrl thread\n");
+        ctrl->active = false;
+        pthread_mutex_destroy(&ctrl->mutex);
         return false;
     }
 
     /* Start ctrl main job */
-    timer_add_periodic(&g_ctx->timer_root, &ctrl->main.timer, "CTRL Socket Main Timer", 0, 1000 * MSEC, ctrl, &bbl_ctrl_socket_main_job);
+    timer_add_periodic(&g_ctx->timer_root, &ctrl->main.timer, "CTRL Socket Main Timer", 0, 100 * MSEC, ctrl, &bbl_ctrl_socket_main_job);
 
     LOG(INFO, "Opened control socket %s\n", g_ctx->ctrl_socket_path);
 
@@ -558,14 +986,37 @@ bool
 bbl_ctrl_socket_close()
 {
     bbl_ctrl_thread_s *ctrl;
+    bbl_ctrl_request_s *request;
+
     if(g_ctx->ctrl_thread) {
         ctrl = g_ctx->ctrl_thread;
+        bbl_subscribe_close_all();
         if(ctrl->active) {
             ctrl->active = false;
-            bbl_ctrl_socket_main(ctrl);
             pthread_join(ctrl->thread, NULL);
             pthread_mutex_destroy(&ctrl->mutex);
-            pthread_cond_destroy(&ctrl->cond);
+        }
+        /* Drop requests not executed anymore. */
+        while(ctrl->main.head) {
+            request = ctrl->main.head;
+            ctrl->main.head = request->next;
+            json_decref(request->root);
+            free(request);
+        }
+        while(ctrl->done) {
+            request = ctrl->done;
+            ctrl->done = request->next;
+            json_decref(request->root);
+            free(request);
+        }
+        while(ctrl->clients) {
+            bbl_ctrl_client_close(ctrl, ctrl->clients);
+        }
+        if(ctrl->event > 0) {
+            close(ctrl->event);
+        }
+        if(ctrl->epoll > 0) {
+            close(ctrl->epoll);
         }
         if(ctrl->socket) {
             close(ctrl->socket);
@@ -575,4 +1026,4 @@ bbl_ctrl_socket_close()
         g_ctx->ctrl_thread = NULL;
     }
     return true;
-}
\ No newline at end of file
+}
@@ -10,23 +10,66 @@
 #ifndef __BBL_CTRL_H__
 #define __BBL_CTRL_H__
 
+#define BBL_CTRL_CLIENTS_MAX    64
+#define BBL_CTRL_BUFFER_MAX     (1024*1024)
+#define BBL_CTRL_MAIN_BATCH     64
+#define BBL_CTRL_SEND_TIMEOUT   10
+
+typedef struct bbl_ctrl_client_ {
+    int fd;
+    char *buf;
+    size_t len;
+    size_t size;
+
+    /* Responses are written to the memory file out
+     * and sent from there by the ctrl thread. */
+    int out;
+    off_t out_offset; /* bytes of out already sent */
+    off_t out_len;
+    time_t out_time; /* last send progress */
+    uint32_t events; /* registered epoll events */
+
+    bool keepalive;
+    bool pending; /* request queued to main thread */
+    bool eof;
+    bool closing;
+    bool detach; /* connection taken over by subscription */
+    time_t closing_time;
+
+    struct bbl_ctrl_client_ *next;
+} bbl_ctrl_client_s;
+
+typedef struct bbl_ctrl_request_ {
+    bbl_ctrl_client_s *client;
+    size_t action;
+    uint32_t session_id;
+    json_t *root;
+    json_t *arguments;
+    struct bbl_ctrl_request_ *next;
+} bbl_ctrl_request_s;
+
 typedef struct bbl_ctrl_thread_ {
     int socket;
+    int epoll;
+    int event; /* eventfd to wakeup ctrl thread */
 
     pthread_t thread;
     pthread_mutex_t mutex;
-    pthread_cond_t cond;
 
     volatile bool active;
 
+    bbl_ctrl_client_s *clients;
+    uint32_t client_count;
+
     /** Commands to be executed in main thread */
     struct {
         struct timer_ *timer;
-        volatile size_t action;
-        volatile int fd;
-        volatile uint32_t session_id;
-        volatile json_t *arguments;
+        bbl_ctrl_request_s *head;
+        bbl_ctrl_request_s *tail;
     } main;
+
+    /** Commands executed by main thread */
+    bbl_ctrl_request_s *done;
 } bbl_ctrl_thread_s;
 
 int
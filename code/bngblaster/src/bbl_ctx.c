@@ -8,6 +8,7 @@
  */
 #include "bbl.h"
 #include "bbl_pcap.h"
+#include "bbl_dhcpv6.h"
 
 extern volatile bool g_teardown;
 
@@ -27,24 +28,6 @@ bbl_key32_hash(const void* k)
     return hash;
 }
 
-int
-bbl_compare_key64(void *key1, void *key2)
-{
-    const uint64_t a = *(const uint64_t*)key1;
-    const uint64_t b = *(const uint64_t*)key2;
-    return (a > b) - (a < b);
-}
-
-uint32_t
-bbl_key64_hash(const void* k)
-{
-    uint32_t hash = 2166136261U;
-    hash ^= *(uint32_t *)k;
-    hash ^= *(uint16_t *)((uint8_t*)k+4) << 12;
-    hash ^= *(uint16_t *)((uint8_t*)k+6);
-    return hash;
-}
-
 /**
  * bbl_ctx_add
  *
@@ -72,12 +55,20 @@ bbl_ctx_add()
     CIRCLEQ_INIT(&g_ctx->network_interface_qhead);
     CIRCLEQ_INIT(&g_ctx->a10nsp_interface_qhead);
 
+    /* Initialize slabs for session state allocated on demand. */
+    slab_init(&g_ctx->igmp_session_slab, "igmp-session", sizeof(bbl_igmp_session_s));
+    slab_init(&g_ctx->dhcpv6_session_slab, "dhcpv6-session", sizeof(bbl_dhcpv6_session_s));
+
     g_ctx->flow_id = 1;
     g_ctx->multicast_endpoint = ENDPOINT_ACTIVE;
     g_ctx->zapping = true;
 
+    /* Initialize VLAN session table which grows with sessions. */
+    if(!hash64_init(&g_ctx->vlan_session_table, 0)) {
+        return false;
+    }
+
     /* Initialize hash table dictionaries. */
-    g_ctx->vlan_session_dict = hashtable_dict_new((dict_compare_func)bbl_compare_key64, bbl_key64_hash, BBL_SESSION_HASHTABLE_SIZE);
     g_ctx->l2tp_session_dict = hashtable_dict_new((dict_compare_func)bbl_compare_key32, bbl_key32_hash, BBL_SESSION_HASHTABLE_SIZE);
     g_ctx->li_flow_dict = hashtable_dict_new((dict_compare_func)bbl_compare_key32, bbl_key32_hash, BBL_LI_HASHTABLE_SIZE);
 
@@ -98,32 +89,43 @@ bbl_ctx_del() {
     if(!g_ctx) return;
 
     timer_flush_root(&g_ctx->timer_root);
-    
+
+    /* Free session memory before access configurations,
+     * which own the session string templates. */
+    for(i = 0; i < g_ctx->sessions; i++) {
+        p = &g_ctx->session_list[i];
+        if(p) {
+            bbl_session_free(p);
+        }
+    }
+
+    if(g_ctx->session_list) free(g_ctx->session_list);
+    if(g_ctx->session_hot) free(g_ctx->session_hot);
+    if(g_ctx->access_interface_index) {
+        for(i = 0; i < g_ctx->access_interfaces; i++) {
+            free(g_ctx->access_interface_index[i]->session_list);
+        }
+        free(g_ctx->access_interface_index);
+    }
+    slab_destroy(&g_ctx->igmp_session_slab);
+    slab_destroy(&g_ctx->dhcpv6_session_slab);
+
     /* Free access configuration memory. */
     access_config = g_ctx->config.access_config;
     while(access_config) {
         p = access_config;
         access_config = access_config->next;
+        bbl_session_templates_free(p);
         free(p);
     }
 
     if(g_ctx->sp) {
         free(g_ctx->sp);
     }
-
-    /* Free session memory. */
-    for(i = 0; i < g_ctx->sessions; i++) {
-        p = &g_ctx->session_list[i];
-        if(p) {
-            bbl_session_free(p);
-        }
-    }
-
-    if(g_ctx->session_list) free(g_ctx->session_list);
     if(g_ctx->stream_index) free(g_ctx->stream_index);
 
     /* Free hash table dictionaries. */
-    dict_free(g_ctx->vlan_session_dict, NULL);
+    hash64_destroy(&g_ctx->vlan_session_table);
     dict_free(g_ctx->l2tp_session_dict, NULL);
     dict_free(g_ctx->li_flow_dict, NULL);
 
@@ -63,8 +63,14 @@ typedef struct bbl_ctx_
     CIRCLEQ_HEAD(a10nsp_interface_, bbl_a10nsp_interface_ ) a10nsp_interface_qhead; /* list of interfaces */
 
     bbl_session_s *session_list; /* list of sessions */
-
-    dict *vlan_session_dict; /* hashtable for 1:1 vlan sessions */
+    bbl_session_hot_s *session_hot; /* RX hot fields of sessions */
+    uint32_t session_id_mask; /* session-id bits of client MAC bytes 2-5 */
+    uint32_t access_interfaces; /* access interfaces with sessions */
+    bbl_access_interface_s **access_interface_index; /* indexed by client MAC byte 1 */
+    slab_s igmp_session_slab; /* session IGMP state */
+    slab_s dhcpv6_session_slab; /* session DHCPv6 state */
+
+    hash64_s vlan_session_table; /* open addressing table for vlan sessions */
     dict *l2tp_session_dict; /* hashtable for L2TP sessions */
     dict *li_flow_dict; /* hashtable for LI flows */
 
@@ -74,6 +80,12 @@ typedef struct bbl_ctx_
     uint64_t streams;
 
     bbl_stream_group_s *stream_groups;
+    bbl_stream_s *stream_tx_ctrl; /* threaded streams with pending TX control check */
+    bbl_stream_s *stream_ldp; /* streams with LDP lookup */
+    bool stream_ldp_update; /* LDP database has changed */
+    struct timer_ *stream_tx_ctrl_job;
+    bbl_stream_stats_s *stream_stats; /* stream stats of main thread */
+    struct timer_ *stream_stats_job;
 
     uint16_t next_tunnel_id;
 
@@ -107,8 +119,14 @@ typedef struct bbl_ctx_
         char *filename;
         uint8_t *write_buf;
         uint32_t write_idx;
-        bool wrote_header;
         bool include_streams;
+        uint32_t snaplen;
+        uint32_t protocols; /* protocol filter */
+        char **interfaces; /* interface filter (names) */
+        uint32_t interfaces_count;
+        bool *interface_filter; /* interface filter (ifindex) */
+        uint32_t interface_filter_len;
+        bbl_pcap_writer_s *writer;
     } pcap;
 
     /* Global Stats */
@@ -147,7 +165,10 @@ typedef struct bbl_ctx_
         uint16_t io_burst;
         uint16_t io_max_stream_len;
 
+        bool io_tpacket_v3;
         bool qdisc_bypass;
+        bool rx_flow_steering;
+        io_timestamp_t rx_timestamp;
 
         uint64_t tx_interval; /* TX interval in nsec */
         uint64_t rx_interval; /* RX interval in nsec */
@@ -155,6 +176,8 @@ typedef struct bbl_ctx_
         uint8_t tx_threads;
         uint8_t rx_threads;
 
+        bool timer_wheel;
+
         char *json_report_filename;
         bool json_report_sessions; /* Include sessions */
         bool json_report_streams; /* Include streams */
@@ -219,6 +242,8 @@ typedef struct bbl_ctx_
         bool sessions_autostart;
         bool monkey_autostart;
         bool iterate_outer_vlan;
+        uint8_t session_id_bits; /* client MAC bits carrying the session-id */
+        bool session_id_interface; /* session-id per access interface */
 
         /* Static */
         uint32_t static_ip;
@@ -346,7 +371,9 @@ typedef struct bbl_ctx_
         bool stream_autostart;
         bool stream_rate_calc; /* Enable/disable stream rate calculation */
         bool stream_delay_calc; /* Enable/disable stream delay calculation */
+        bool stream_delay_hist; /* Enable/disable stream delay histograms */
         bool stream_udp_checksum; /* Enable/disable stream UDP checksum calculation */
+        bool stream_tx_template; /* Keep stream packet templates in TX ring frames */
         uint64_t stream_burst_ms; /* Max bust size per stream in milliseconds */
 
         /* Session Traffic */
@@ -370,12 +397,6 @@ bbl_compare_key32 (void *key1, void *key2);
 uint32_t
 bbl_key32_hash(const void* k);
 
-int
-bbl_compare_key64(void *key1, void *key2);
-
-uint32_t
-bbl_key64_hash(const void* k);
-
 bool
 bbl_ctx_add();
 
@@ -54,6 +54,8 @@
 
 #define BBL_SESSION_HASHTABLE_SIZE 128993 /* is a prime number */
 #define BBL_LI_HASHTABLE_SIZE 32771 /* is a prime number */
+#define BBL_SESSION_ID_BITS         24  /* default client MAC bits for session-id */
+#define BBL_SESSION_ID_INTERFACES   256 /* access interfaces with session-id scope interface */
 
 #define BBL_DEFAULT_TTL             64
 
@@ -170,6 +172,30 @@ typedef enum {
     LACP_CURRENT
 } __attribute__ ((__packed__)) lacp_state_t;
 
+/*
+ * Session strings rendered from access configuration templates
+ */
+typedef enum {
+    SESSION_STRING_USERNAME = 0,
+    SESSION_STRING_PASSWORD,
+    SESSION_STRING_ACI,             /* Agent Circuit ID */
+    SESSION_STRING_ARI,             /* Agent Remote ID */
+    SESSION_STRING_AACI,            /* Access Aggregation Circuit ID */
+    SESSION_STRING_VENDOR_CLASS_ID,
+    SESSION_STRING_CFM_MA_NAME,
+    SESSION_STRING_MAX
+} __attribute__ ((__packed__)) session_string_t;
+
+typedef enum {
+    SESSION_VAR_LITERAL = 0,
+    SESSION_VAR_SESSION_GLOBAL,     /* {session-global} */
+    SESSION_VAR_SESSION,            /* {session} */
+    SESSION_VAR_I1,                 /* {i1} */
+    SESSION_VAR_I2,                 /* {i2} */
+    SESSION_VAR_OUTER_VLAN,         /* {outer-vlan} */
+    SESSION_VAR_INNER_VLAN,         /* {inner-vlan} */
+} __attribute__ ((__packed__)) session_var_t;
+
 /*
  * Session state
  */
@@ -228,6 +254,8 @@ typedef struct bbl_txq_ bbl_txq_s;
 typedef struct bbl_lag_ bbl_lag_s;
 typedef struct bbl_lag_member_ bbl_lag_member_s;
 typedef struct bbl_igmp_group_ bbl_igmp_group_s;
+typedef struct bbl_igmp_session_ bbl_igmp_session_s;
+typedef struct bbl_dhcpv6_session_ bbl_dhcpv6_session_s;
 typedef struct bbl_interface_ bbl_interface_s;
 typedef struct bbl_access_interface_ bbl_access_interface_s;
 typedef struct bbl_network_interface_ bbl_network_interface_s;
@@ -237,6 +265,8 @@ typedef struct bbl_session_ bbl_session_s;
 typedef struct bbl_stream_thread_ bbl_stream_thread_s;
 typedef struct bbl_stream_config_ bbl_stream_config_s;
 typedef struct bbl_stream_group_ bbl_stream_group_s;
+typedef struct bbl_stream_stats_ bbl_stream_stats_s;
+typedef struct bbl_stream_packet_ bbl_stream_packet_s;
 typedef struct bbl_stream_ bbl_stream_s;
 typedef struct bbl_tcp_ctx_ bbl_tcp_ctx_s;
 typedef struct bbl_ctrl_thread_ bbl_ctrl_thread_s;
@@ -250,5 +280,6 @@ typedef struct bbl_http_server_config_ bbl_http_server_config_s;
 typedef struct bbl_http_server_ bbl_http_server_s;
 typedef struct bbl_http_server_connection_ bbl_http_server_connection_s;
 typedef struct bbl_fragment_ bbl_fragment_s;
+typedef struct bbl_pcap_writer_ bbl_pcap_writer_s;
 
 #endif
\ No newline at end of file
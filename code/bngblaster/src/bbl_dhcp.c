@@ -24,7 +24,7 @@ bbl_dhcp_stop(bbl_session_s *session)
 
     /* Reset session IP configuration */
     ENABLE_ENDPOINT(session->endpoint.ipv4);
-    session->version++;
+    bbl_session_version_update(session);
     session->arp_resolved = false;
     session->ip_address = 0;
     session->ip_netmask = 0;
@@ -35,11 +35,13 @@ bbl_dhcp_stop(bbl_session_s *session)
     /* Stop multicast ... */
     timer_del(session->timer_igmp);
     timer_del(session->timer_zapping);
-    session->zapping_joined_group = NULL;
-    session->zapping_leaved_group = NULL;
-    session->zapping_count = 0;
-    session->zapping_view_start_time.tv_sec = 0;
-    session->zapping_view_start_time.tv_nsec = 0;
+    if(session->igmp) {
+        session->igmp->zapping_joined_group = NULL;
+        session->igmp->zapping_leaved_group = NULL;
+        session->igmp->zapping_count = 0;
+        session->igmp->zapping_view_start_time.tv_sec = 0;
+        session->igmp->zapping_view_start_time.tv_nsec = 0;
+    }
 
     /* Reset DHCP */
     timer_del(session->timer_dhcp_retry);
@@ -218,7 +220,7 @@ bbl_dhcp_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcp_s *dhcp
                 }
                 /* Update session ... */
                 if(session->dhcp_address != session->ip_address) {
-                    session->version++;
+                    bbl_session_version_update(session);
                     LOG(IP, "IPv4 (ID: %u) address %s\n", session->session_id,
                         format_ipv4_address(&session->dhcp_address));
                 }
@@ -312,7 +314,7 @@ bbl_dhcp_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcp_s *dhcp
             break;
         case BBL_DHCP_RELEASE:
             session->dhcp_state = BBL_DHCP_INIT;
-            if(session->session_state == BBL_TERMINATING) {
+            if(session->hot->session_state == BBL_TERMINATING) {
                 bbl_session_clear(session);
             }
         default:
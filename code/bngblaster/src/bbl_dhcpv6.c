@@ -43,7 +43,7 @@ bbl_dhcpv6_stop(bbl_session_s *session)
     LOG(DHCP, "DHCP (ID: %u) Stop DHCPv6\n", session->session_id);
 
     /* Reset session IP configuration */
-    if(session->access_type == ACCESS_TYPE_IPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_IPOE) {
         session->ipv6_prefix.len = 0;
         memset(session->ipv6_address, 0x0, IPV6_ADDR_LEN);
         ENABLE_ENDPOINT(session->endpoint.ipv6);
@@ -55,16 +55,18 @@ bbl_dhcpv6_stop(bbl_session_s *session)
     timer_del(session->timer_dhcpv6);
     timer_del(session->timer_dhcpv6_t1);
     timer_del(session->timer_dhcpv6_t2);
-    session->version++;
+    bbl_session_version_update(session);
     session->dhcpv6_state = BBL_DHCP_INIT;
-    session->dhcpv6_ia_na_option_len = 0;
-    session->dhcpv6_ia_pd_option_len = 0;
+    if(session->dhcpv6) {
+        session->dhcpv6->ia_na_option_len = 0;
+        session->dhcpv6->ia_pd_option_len = 0;
+        memset(session->dhcpv6->server_duid, 0x0, DHCPV6_BUFFER);
+        session->dhcpv6->server_duid_len = 0;
+    }
     session->dhcpv6_t1 = 0;
     session->dhcpv6_t2 = 0;
     memset(session->dhcpv6_dns1, 0x0, IPV6_ADDR_LEN);
     memset(session->dhcpv6_dns2, 0x0, IPV6_ADDR_LEN);
-    memset(session->dhcpv6_server_duid, 0x0, DHCPV6_BUFFER);
-    session->dhcpv6_server_duid_len = 0;
     session->dhcpv6_lease_time = 0;
     session->dhcpv6_lease_timestamp.tv_sec = 0;
     session->dhcpv6_lease_timestamp.tv_nsec = 0;
@@ -80,6 +82,15 @@ bbl_dhcpv6_stop(bbl_session_s *session)
     session->dhcpv6_requested = false;
 }
 
+void
+bbl_dhcpv6_session_free(bbl_session_s *session)
+{
+    if(session->dhcpv6) {
+        slab_free(&g_ctx->dhcpv6_session_slab, session->dhcpv6);
+        session->dhcpv6 = NULL;
+    }
+}
+
 /**
  * bbl_dhcpv6_start
  *
@@ -95,6 +106,18 @@ bbl_dhcpv6_start(bbl_session_s *session)
         g_dhcpv6_iaid = 1;
     }
 
+    if(!session->dhcpv6) {
+        session->dhcpv6 = slab_alloc(&g_ctx->dhcpv6_session_slab);
+        if(!session->dhcpv6) {
+            LOG(ERROR, "DHCPv6 (ID: %u) failed to allocate DHCPv6 session\n", session->session_id);
+            return;
+        }
+        /* Set DHCPv6 DUID */
+        session->dhcpv6->duid[1] = 3;
+        session->dhcpv6->duid[3] = 1;
+        memcpy(&session->dhcpv6->duid[4], session->hot->client_mac, ETH_ADDR_LEN);
+    }
+
     if(!session->dhcpv6_requested) {
         session->dhcpv6_requested = true;
         g_ctx->dhcpv6_requested++;
@@ -104,7 +127,7 @@ bbl_dhcpv6_start(bbl_session_s *session)
         session->dhcpv6_xid = rand() & 0xffffff;
 
         if(g_ctx->config.dhcpv6_ia_na && 
-           session->access_type == ACCESS_TYPE_IPOE) {
+           session->hot->access_type == ACCESS_TYPE_IPOE) {
             session->dhcpv6_ia_na_iaid = g_dhcpv6_iaid++;
         }
         if(g_ctx->config.dhcpv6_ia_pd) {
@@ -198,10 +221,10 @@ bbl_dhcpv6_validate_ia(bbl_session_s *session, bbl_dhcpv6_s *dhcpv6)
 void
 bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *dhcpv6)
 {
-    bbl_access_interface_s *interface = session->access_interface;
+    bbl_access_interface_s *interface = session->hot->access_interface;
 
     /* Ignore packets received in wrong state */
-    if(session->dhcpv6_state <= BBL_DHCP_INIT) {
+    if(session->dhcpv6_state <= BBL_DHCP_INIT || !session->dhcpv6) {
         return;
     }
 
@@ -219,16 +242,16 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
     }
 
     if(dhcpv6->server_duid_len && dhcpv6->server_duid_len < DHCPV6_BUFFER) {
-        memcpy(session->dhcpv6_server_duid, dhcpv6->server_duid, dhcpv6->server_duid_len);
-        session->dhcpv6_server_duid_len = dhcpv6->server_duid_len;
+        memcpy(session->dhcpv6->server_duid, dhcpv6->server_duid, dhcpv6->server_duid_len);
+        session->dhcpv6->server_duid_len = dhcpv6->server_duid_len;
     }
     if(dhcpv6->ia_na_address && dhcpv6->ia_na_option_len && dhcpv6->ia_na_option_len < DHCPV6_BUFFER) {
-        memcpy(session->dhcpv6_ia_na_option, dhcpv6->ia_na_option, dhcpv6->ia_na_option_len);
-        session->dhcpv6_ia_na_option_len = dhcpv6->ia_na_option_len;
+        memcpy(session->dhcpv6->ia_na_option, dhcpv6->ia_na_option, dhcpv6->ia_na_option_len);
+        session->dhcpv6->ia_na_option_len = dhcpv6->ia_na_option_len;
     }
     if(dhcpv6->ia_pd_prefix && dhcpv6->ia_pd_prefix->len && dhcpv6->ia_pd_option_len && dhcpv6->ia_pd_option_len < DHCPV6_BUFFER) {
-        memcpy(session->dhcpv6_ia_pd_option, dhcpv6->ia_pd_option, dhcpv6->ia_pd_option_len);
-        session->dhcpv6_ia_pd_option_len = dhcpv6->ia_pd_option_len;
+        memcpy(session->dhcpv6->ia_pd_option, dhcpv6->ia_pd_option, dhcpv6->ia_pd_option_len);
+        session->dhcpv6->ia_pd_option_len = dhcpv6->ia_pd_option_len;
     }
 
     if(dhcpv6->type == DHCPV6_MESSAGE_REPLY) {
@@ -238,7 +261,7 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
         /* Handle DHCPv6 teardown */
         if(session->dhcpv6_state == BBL_DHCP_RELEASE) {
             session->dhcpv6_state = BBL_DHCP_INIT;
-            if(session->session_state == BBL_TERMINATING) {
+            if(session->hot->session_state == BBL_TERMINATING) {
                 bbl_session_clear(session);
             }
             return;
@@ -262,7 +285,7 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
                     memcpy(&session->dhcpv6_dns2, dhcpv6->dns2, IPV6_ADDR_LEN);
                 }
             }
-            if(session->access_type == ACCESS_TYPE_IPOE && dhcpv6->ia_na_address) {
+            if(session->hot->access_type == ACCESS_TYPE_IPOE && dhcpv6->ia_na_address) {
                 /* IA_NA */
                 if(dhcpv6->ia_na_valid_lifetime) session->dhcpv6_lease_time = dhcpv6->ia_na_valid_lifetime;
                 if(dhcpv6->ia_na_t1) session->dhcpv6_t1 = dhcpv6->ia_na_t1;
@@ -270,7 +293,7 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
                 memcpy(&session->ipv6_address, dhcpv6->ia_na_address, sizeof(ipv6addr_t));
                 memcpy(&session->ipv6_prefix.address, dhcpv6->ia_na_address, sizeof(ipv6addr_t));
                 session->ipv6_prefix.len = 128;
-                session->version++;
+                bbl_session_version_update(session);
                 LOG(IP, "IPv6 (ID: %u) DHCPv6 IA_NA address %s/128\n", session->session_id,
                     format_ipv6_address(&session->ipv6_address));
             }
@@ -282,10 +305,10 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
                 memcpy(&session->delegated_ipv6_prefix, dhcpv6->ia_pd_prefix, sizeof(ipv6_prefix));
                 *(uint64_t*)&session->delegated_ipv6_address[0] = *(uint64_t*)session->delegated_ipv6_prefix.address;
                 session->delegated_ipv6_address[15] = 0x01;
-                if(session->access_type == ACCESS_TYPE_PPPOE) {
+                if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                     ACTIVATE_ENDPOINT(session->endpoint.ipv6pd);
                 }
-                session->version++;
+                bbl_session_version_update(session);
                 LOG(IP, "IPv6 (ID: %u) DHCPv6 IA_PD prefix %s/%d\n", session->session_id,
                     format_ipv6_address(&session->delegated_ipv6_prefix.address), session->delegated_ipv6_prefix.len);
             }
@@ -302,7 +325,7 @@ bbl_dhcpv6_rx(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_dhcpv6_s *
             timer_add(&g_ctx->timer_root, &session->timer_dhcpv6_t2, "DHCPv6 T2", 
                       session->dhcpv6_t2, 0, session, &bbl_dhcpv6_s2);
         }
-        if(session->access_type == ACCESS_TYPE_IPOE) {
+        if(session->hot->access_type == ACCESS_TYPE_IPOE) {
             bbl_access_rx_established_ipoe(interface, session, eth);
             session->send_requests |= BBL_SEND_ICMPV6_RS;
             bbl_session_tx_qnode_insert(session);
@@ -10,6 +10,24 @@
 #ifndef __BBL_DHCPV6_H__
 #define __BBL_DHCPV6_H__
 
+/*
+ * DHCPv6 identifiers and options of a session, allocated
+ * from the DHCPv6 session slab when DHCPv6 is started.
+ */
+typedef struct bbl_dhcpv6_session_
+{
+    uint8_t duid[DUID_LEN];
+    uint8_t server_duid[DHCPV6_BUFFER];
+    uint8_t server_duid_len;
+    uint8_t ia_na_option[DHCPV6_BUFFER];
+    uint8_t ia_na_option_len;
+    uint8_t ia_pd_option[DHCPV6_BUFFER];
+    uint8_t ia_pd_option_len;
+} bbl_dhcpv6_session_s;
+
+void
+bbl_dhcpv6_session_free(bbl_session_s *session);
+
 void
 bbl_dhcpv6_stop(bbl_session_s *session);
 
@@ -150,6 +150,7 @@ bbl_fragment_rx(bbl_access_interface_s *access_interface,
                 if(fragment->max_offset > stream->rx_fragment_offset) {
                     stream->rx_fragment_offset = fragment->max_offset;
                 }
+                bbl_stream_rx_account(stream, &g_ctx->stream_stats);
             }
         }
         bbl_fragment_free(fragment);
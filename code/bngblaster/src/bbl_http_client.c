@@ -182,7 +182,7 @@ bbl_http_client_disconnect(bbl_http_client_s *client)
     client->tcpc = NULL;
 
     /* Update client state */
-    if(session->session_state == BBL_ESTABLISHED) {
+    if(session->hot->session_state == BBL_ESTABLISHED) {
         client->state = HTTP_CLIENT_CLOSED;
     } else {
         client->state = HTTP_CLIENT_SESSION_DOWN;
@@ -197,7 +197,7 @@ bbl_http_client_job(timer_s *timer)
 
     bbl_session_s *session = client->session;
 
-    if(session->session_state == BBL_ESTABLISHED) {
+    if(session->hot->session_state == BBL_ESTABLISHED) {
         if(client->state == HTTP_CLIENT_SESSION_DOWN) {
             if(config->autostart) {
                 client->state = HTTP_CLIENT_IDLE;
@@ -264,7 +264,7 @@ bbl_http_client_add(bbl_http_client_config_s *config, bbl_session_s *session)
 {
     bbl_http_client_s *client;
 
-    if(!session->netif.state) {
+    if(!session->tcp) {
         return false;
     }
 
@@ -49,11 +49,11 @@ bbl_icmp_client_tx(bbl_icmp_client_s *client, bbl_icmp_s *icmp)
     bbl_ipv4_s ipv4 = {0};
 
     if(session) {
-        eth.dst = session->server_mac;
-        eth.src = session->client_mac;
+        eth.dst = session->hot->server_mac;
+        eth.src = session->hot->client_mac;
         eth.qinq = session->access_config->qinq;
-        eth.vlan_outer = session->vlan_key.outer_vlan_id;
-        eth.vlan_inner = session->vlan_key.inner_vlan_id;
+        eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+        eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
         eth.vlan_three = session->access_third_vlan;
         if(config->src) {
             ipv4.src = client->src;
@@ -69,7 +69,7 @@ bbl_icmp_client_tx(bbl_icmp_client_s *client, bbl_icmp_s *icmp)
         ipv4.src = client->src;
     }
 
-    if(session && session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session && session->hot->access_type == ACCESS_TYPE_PPPOE) {
         eth.type = ETH_TYPE_PPPOE_SESSION;
         eth.next = &pppoe;
         pppoe.session_id = session->pppoe_session_id;
@@ -89,7 +89,7 @@ bbl_icmp_client_tx(bbl_icmp_client_s *client, bbl_icmp_s *icmp)
     }
 
     if(session) {
-        return bbl_txq_to_buffer(session->access_interface->txq, &eth);
+        return bbl_txq_to_buffer(session->hot->access_interface->txq, &eth);
     } else {
         return bbl_txq_to_buffer(network_interface->txq, &eth);
     }
@@ -133,7 +133,7 @@ bbl_icmp_client_send_job_ping(timer_s *timer)
         if(!client->last_result) client->last_result = ICMP_RESULT_WAIT;
         if(session) {
             session->stats.icmp_tx++;
-            session->access_interface->stats.icmp_tx++;
+            session->hot->access_interface->stats.icmp_tx++;
             LOG(ICMP, "ICMP (ID: %u) send echo-request addr=%s id=%u seq=%u\n",
                 session->session_id, format_ipv4_address(&client->dst), client->id, result->seq);
         } else {
@@ -17,6 +17,33 @@ struct keyval_ igmp_msg_names[] = {
     { 0, NULL}
 };
 
+/**
+ * bbl_igmp_session
+ *
+ * Return the IGMP state of the session, which
+ * is allocated with the first call.
+ *
+ * @param session session
+ * @return IGMP session or NULL if allocation failed
+ */
+bbl_igmp_session_s *
+bbl_igmp_session(bbl_session_s *session)
+{
+    if(!session->igmp) {
+        session->igmp = slab_alloc(&g_ctx->igmp_session_slab);
+    }
+    return session->igmp;
+}
+
+void
+bbl_igmp_session_free(bbl_session_s *session)
+{
+    if(session->igmp) {
+        slab_free(&g_ctx->igmp_session_slab, session->igmp);
+        session->igmp = NULL;
+    }
+}
+
 void
 bbl_igmp_rx(bbl_session_s *session, bbl_ipv4_s *ipv4)
 {
@@ -37,11 +64,15 @@ bbl_igmp_rx(bbl_session_s *session, bbl_ipv4_s *ipv4)
         if(igmp->robustness) {
             session->igmp_robustness = igmp->robustness;
         }
+        if(!session->igmp) {
+            /* No groups joined. */
+            return;
+        }
 
         if(igmp->group) {
             /* Group Specific Query */
             for(i=0; i < IGMP_MAX_GROUPS; i++) {
-                group = &session->igmp_groups[i];
+                group = &session->igmp->groups[i];
                 if(group->group == igmp->group &&
                    group->state == IGMP_GROUP_ACTIVE) {
                     group->send = true;
@@ -51,7 +82,7 @@ bbl_igmp_rx(bbl_session_s *session, bbl_ipv4_s *ipv4)
         } else {
             /* General Query */
             for(i=0; i < IGMP_MAX_GROUPS; i++) {
-                group = &session->igmp_groups[i];
+                group = &session->igmp->groups[i];
                 if(group->state == IGMP_GROUP_ACTIVE) {
                     group->send = true;
                     send = true;
@@ -111,18 +142,21 @@ bbl_igmp_ctrl_join(int fd, uint32_t session_id, json_t *arguments)
     /* Search session */
     session = bbl_session_get(session_id);
     if(session) {
+        if(!bbl_igmp_session(session)) {
+            return bbl_ctrl_status(fd, "error", 500, "failed to allocate igmp session");
+        }
         /* Search for free slot ... */
         for(i=0; i < IGMP_MAX_GROUPS; i++) {
-            if(!session->igmp_groups[i].zapping) {
-                if(session->igmp_groups[i].group == group_address) {
-                    group = &session->igmp_groups[i];
+            if(!session->igmp->groups[i].zapping) {
+                if(session->igmp->groups[i].group == group_address) {
+                    group = &session->igmp->groups[i];
                     if(group->state == IGMP_GROUP_IDLE) {
                         break;
                     } else {
                         return bbl_ctrl_status(fd, "error", 409, "group already exists");
                     }
-                } else if(session->igmp_groups[i].state == IGMP_GROUP_IDLE) {
-                    group = &session->igmp_groups[i];
+                } else if(session->igmp->groups[i].state == IGMP_GROUP_IDLE) {
+                    group = &session->igmp->groups[i];
                 }
             }
         }
@@ -202,10 +236,10 @@ bbl_igmp_ctrl_join_iter(int fd, uint32_t session_id __attribute__((unused)), jso
         join_count = 0;
         for(i = 0; i < g_ctx->sessions; i++) {
             session = &g_ctx->session_list[i];
-            if(session) {
+            if(session && bbl_igmp_session(session)) {
                 /* Search for free slot ... */
                 for(i2=0; i2 < IGMP_MAX_GROUPS; i2++) {
-                    group = &session->igmp_groups[i2];
+                    group = &session->igmp->groups[i2];
                     if(group->zapping) {
                         continue;
                     }
@@ -272,9 +306,9 @@ bbl_igmp_ctrl_leave(int fd, uint32_t session_id, json_t *arguments)
     session = bbl_session_get(session_id);
     if(session) {
         /* Search for group ... */
-        for(i=0; i < IGMP_MAX_GROUPS; i++) {
-            if(session->igmp_groups[i].group == group_address) {
-                group = &session->igmp_groups[i];
+        for(i=0; session->igmp && i < IGMP_MAX_GROUPS; i++) {
+            if(session->igmp->groups[i].group == group_address) {
+                group = &session->igmp->groups[i];
                 break;
             }
         }
@@ -314,10 +348,10 @@ bbl_igmp_ctrl_leave_all(int fd, uint32_t session_id __attribute__((unused)), jso
     /* Iterate over all sessions */
     for(i = 0; i < g_ctx->sessions; i++) {
         session = &g_ctx->session_list[i];
-        if(session) {
+        if(session && session->igmp) {
             /* Search for group ... */
             for(i2=0; i2 < IGMP_MAX_GROUPS; i2++) {
-                group = &session->igmp_groups[i2];
+                group = &session->igmp->groups[i2];
                 if(group->zapping || group->state <= IGMP_GROUP_LEAVING) {
                     continue;
                 }
@@ -360,8 +394,8 @@ bbl_igmp_ctrl_info(int fd, uint32_t session_id, json_t *arguments __attribute__(
     if(session) {
         groups = json_array();
         /* Add group informations */
-        for(i=0; i < IGMP_MAX_GROUPS; i++) {
-            group = &session->igmp_groups[i];
+        for(i=0; session->igmp && i < IGMP_MAX_GROUPS; i++) {
+            group = &session->igmp->groups[i];
             if(group->group) {
                 sources = json_array();
                 for(i2=0; i2 < IGMP_MAX_SOURCES; i2++) {
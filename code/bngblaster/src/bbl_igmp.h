@@ -27,6 +27,34 @@ typedef struct bbl_igmp_group_
     struct timespec last_mc_rx_time;
 } bbl_igmp_group_s;
 
+/*
+ * IGMP groups and zapping state of a session, allocated
+ * from the IGMP session slab with the first join.
+ */
+typedef struct bbl_igmp_session_
+{
+    bbl_igmp_group_s groups[IGMP_MAX_GROUPS];
+
+    /* IGMP Zapping */
+    bbl_igmp_group_s *zapping_joined_group;
+    bbl_igmp_group_s *zapping_leaved_group;
+    uint8_t  zapping_count;
+    uint64_t zapping_join_delay_sum;
+    uint32_t zapping_join_count;
+    uint64_t zapping_leave_delay_sum;
+    uint32_t zapping_leave_count;
+    struct timespec zapping_view_start_time;
+
+    /* Multicast Traffic */
+    uint64_t mc_rx_last_seq;
+} bbl_igmp_session_s;
+
+bbl_igmp_session_s *
+bbl_igmp_session(bbl_session_s *session);
+
+void
+bbl_igmp_session_free(bbl_session_s *session);
+
 void
 bbl_igmp_rx(bbl_session_s *session, bbl_ipv4_s *ipv4);
 
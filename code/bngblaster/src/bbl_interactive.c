@@ -100,6 +100,24 @@ bbl_interactive_log_buf_free()
     g_log_buf = NULL;
 }
 
+static void
+bbl_interactive_log_line(const char *line)
+{
+    wprintw(log_win, "%s", line);
+}
+
+/*
+ * Display log messages written by the asynchronous
+ * logging thread since the last call.
+ */
+static void
+bbl_interactive_log_async()
+{
+    if(log_async_console_read(bbl_interactive_log_line)) {
+        wrefresh(log_win);
+    }
+}
+
 /*
  * Format a progress bar.
  */
@@ -279,6 +297,8 @@ bbl_interactive_window_job(timer_s *timer)
     struct timespec time_established = {0};
 
     char strsp[STRING_SP_SIZE];
+    char str[SUB_STR_LEN];
+    char *s;
 
     bbl_session_s *session;
     int i;
@@ -287,6 +307,8 @@ bbl_interactive_window_job(timer_s *timer)
     int pos = 1; /* position */
     bool visible = false;
 
+    bbl_interactive_log_async();
+
     if(g_banner) {
         wmove(stats_win, 14, 0);
     } else {
@@ -639,18 +661,22 @@ bbl_interactive_window_job(timer_s *timer)
         wprintw(stats_win, " )\n");
         session = bbl_session_get(g_session_selected);
         if(session) {
-            wprintw(stats_win, "\n     State: %s \n", session_state_string(session->session_state));
-            if(session->username) {
-                wprintw(stats_win, "  Username: %s \n", session->username);
+            wprintw(stats_win, "\n     State: %s \n", session_state_string(session->hot->session_state));
+            s = bbl_session_string(session, SESSION_STRING_USERNAME, str);
+            if(s) {
+                wprintw(stats_win, "  Username: %s \n", s);
             }
-            if(session->agent_remote_id) {
-                wprintw(stats_win, "       ARI: %s \n", session->agent_remote_id);
+            s = bbl_session_string(session, SESSION_STRING_ARI, str);
+            if(s) {
+                wprintw(stats_win, "       ARI: %s \n", s);
             }
-            if(session->agent_circuit_id) {
-                wprintw(stats_win, "       ACI: %s \n", session->agent_circuit_id);
+            s = bbl_session_string(session, SESSION_STRING_ACI, str);
+            if(s) {
+                wprintw(stats_win, "       ACI: %s \n", s);
             }
-            if(session->vendor_class_id) {
-                wprintw(stats_win, " Vendor ID: %s \n", session->vendor_class_id);
+            s = bbl_session_string(session, SESSION_STRING_VENDOR_CLASS_ID, str);
+            if(s) {
+                wprintw(stats_win, " Vendor ID: %s \n", s);
             }
             if(session->ip_address) {
                 wprintw(stats_win, "      IPv4: %s \n", format_ipv4_address(&session->ip_address));
@@ -675,7 +701,7 @@ bbl_interactive_window_job(timer_s *timer)
                 session->stats.packets_tx, session->stats.rate_packets_tx.avg,
                 session->stats.rate_bytes_tx.avg * 8 / 1000);
             wprintw(stats_win, "    RX Packets %10lu | %7lu PPS | %10lu Kbps\n",
-                session->stats.packets_rx, session->stats.rate_packets_rx.avg,
+                session->hot->packets_rx, session->stats.rate_packets_rx.avg,
                 session->stats.rate_bytes_rx.avg * 8 / 1000);
 
             if(session->streams.head) {
@@ -698,7 +724,7 @@ bbl_interactive_window_job(timer_s *timer)
                 bbl_stream_s *stream = session->streams.head;
                 i = 0;
                 while(stream) {
-                    tx_kbps = stream->rate_packets_tx.avg * stream->tx_len * 8 / 1000;
+                    tx_kbps = stream->rate_packets_tx.avg * stream->tx_ctrl_len * 8 / 1000;
                     if(stream->rate_packets_tx.avg && tx_kbps == 0) {
                         tx_kbps = 1;
                     }
@@ -774,6 +800,8 @@ bbl_interactive_init()
     wrefresh(stats_win);
 
     bbl_interactive_log_buf_free();
+    log_async_console(true);
+    bbl_interactive_log_async();
     g_interactive = true;
 }
 
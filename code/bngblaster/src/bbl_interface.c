@@ -103,6 +103,21 @@ bbl_interface_unlock_all()
     }
 }
 
+/**
+ * bbl_interface_close_all
+ *
+ * @brief This functions releases the IO resources
+ * of all interfaces after IO threads are stopped.
+ */
+void
+bbl_interface_close_all()
+{
+    struct bbl_interface_ *interface;
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        io_interface_close(interface);
+    }
+}
+
 /**
  * bbl_add_interface
  *
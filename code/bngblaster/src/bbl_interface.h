@@ -53,6 +53,9 @@ interface_state_string(interface_state_t state);
 void
 bbl_interface_unlock_all();
 
+void
+bbl_interface_close_all();
+
 bool
 bbl_interface_init();
 
@@ -28,115 +28,295 @@ void
 pcapng_open()
 {
     /*
-     * Open the file.
+     * Open the file. FIFOs are opened non-blocking to not wait for a
+     * reader, but all writes are done blocking by the writer thread.
      */
     g_ctx->pcap.fd = open(g_ctx->pcap.filename, O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, PCAPNG_PERMS);
     if(g_ctx->pcap.fd == -1) {
         switch (errno) {
+            case ENXIO:
+                /* FIFO without reader. */
+                return;
             default:
                 LOG(ERROR, "failed to open pcap file %s with error %s (%d)\n", 
                     g_ctx->pcap.filename, strerror(errno), errno);
                 return;
         }
     } else {
+        fcntl(g_ctx->pcap.fd, F_SETFL, fcntl(g_ctx->pcap.fd, F_GETFL) & ~O_NONBLOCK);
+        if(g_ctx->pcap.writer) {
+            g_ctx->pcap.writer->header_pending = true;
+        }
         LOG(INFO, "pcap file %s opened\n", g_ctx->pcap.filename);
     }
 }
 
+static bool
+pcapng_write(uint8_t *buf, uint32_t len)
+{
+    ssize_t res;
+
+    while(len) {
+        res = write(g_ctx->pcap.fd, buf, len);
+        if(res < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno == EPIPE) {
+                /* Our listener just went away. Reopen the 
+                 * FIFO and write a PCAP header for the next 
+                 * listener. */
+                LOG(PCAP, "pcap file %s closed by reader\n", g_ctx->pcap.filename);
+            } else {
+                LOG(ERROR, "failed to write pcap file %s with error %s (%d)\n", 
+                    g_ctx->pcap.filename, strerror(errno), errno);
+            }
+            close(g_ctx->pcap.fd);
+            g_ctx->pcap.fd = -1;
+            return false;
+        }
+        buf += res;
+        len -= res;
+    }
+    return true;
+}
+
 /*
- * Initialize a fresh pcap fifo writing context.
+ * Writer thread draining buffers handed over by the main thread.
  */
-void
-pcapng_init()
+static void *
+pcapng_writer_thread(void *thread_data)
 {
-    if(!(g_ctx && g_ctx->pcap.filename)) {
-        return;
+    bbl_pcap_writer_s *writer = thread_data;
+    uint64_t head, tail;
+    uint32_t idx;
+
+    struct timespec sleep, rem;
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = MSEC;
+
+    while(true) {
+        tail = atomic_load_explicit(&writer->tail, memory_order_relaxed);
+        head = atomic_load_explicit(&writer->head, memory_order_acquire);
+        if(tail == head) {
+            if(!writer->active) {
+                break;
+            }
+            nanosleep(&sleep, &rem);
+            continue;
+        }
+        idx = tail % PCAPNG_BUFFERS;
+        if(g_ctx->pcap.fd == -1) {
+            pcapng_open();
+        }
+        if(g_ctx->pcap.fd == -1) {
+            writer->packets_lost += writer->packets[idx];
+        } else {
+            if(writer->header_pending) {
+                if(pcapng_write(writer->header, writer->header_len)) {
+                    writer->header_pending = false;
+                }
+            }
+            if(g_ctx->pcap.fd == -1 || !pcapng_write(writer->buf[idx], writer->len[idx])) {
+                writer->packets_lost += writer->packets[idx];
+            } else {
+                LOG(PCAP, "drained %u bytes buffer to pcap file %s\n",
+                    writer->len[idx], g_ctx->pcap.filename);
+            }
+        }
+        atomic_store_explicit(&writer->tail, tail+1, memory_order_release);
     }
+    return NULL;
+}
 
-    /*
-     * Write buffer for I/O.
-     */
-    if(!g_ctx->pcap.write_buf) {
-        g_ctx->pcap.write_buf = calloc(1, PCAPNG_WRITEBUFSIZE);
-    } else {
-        g_ctx->pcap.write_idx = 0;
+/*
+ * Hand over the current buffer to the writer thread.
+ */
+static void
+pcapng_publish(bbl_pcap_writer_s *writer)
+{
+    uint64_t head = atomic_load_explicit(&writer->head, memory_order_relaxed);
+    uint32_t idx = head % PCAPNG_BUFFERS;
+
+    writer->len[idx] = g_ctx->pcap.write_idx;
+    writer->packets[idx] = writer->write_packets;
+    atomic_store_explicit(&writer->head, head+1, memory_order_release);
+
+    g_ctx->pcap.write_buf = writer->buf[(head+1) % PCAPNG_BUFFERS];
+    g_ctx->pcap.write_idx = 0;
+    writer->write_packets = 0;
+}
+
+static void
+pcapng_flush_job(timer_s *timer)
+{
+    bbl_pcap_writer_s *writer = timer->data;
+    if(g_ctx->pcap.write_idx) {
+        pcapng_publish(writer);
     }
+}
 
-    /*
-     * Open the file.
-     */
-    pcapng_open();
+/*
+ * Protocol name to filter bit.
+ */
+uint32_t
+pcapng_protocol(const char *name)
+{
+    if(strcmp(name, "arp") == 0) return PCAPNG_PROTOCOL_ARP;
+    if(strcmp(name, "ipv4") == 0) return PCAPNG_PROTOCOL_IPV4;
+    if(strcmp(name, "ipv6") == 0) return PCAPNG_PROTOCOL_IPV6;
+    if(strcmp(name, "pppoe-discovery") == 0) return PCAPNG_PROTOCOL_PPPOE_DISC;
+    if(strcmp(name, "pppoe-session") == 0) return PCAPNG_PROTOCOL_PPPOE_SESS;
+    if(strcmp(name, "mpls") == 0) return PCAPNG_PROTOCOL_MPLS;
+    if(strcmp(name, "lacp") == 0) return PCAPNG_PROTOCOL_LACP;
+    if(strcmp(name, "cfm") == 0) return PCAPNG_PROTOCOL_CFM;
+    if(strcmp(name, "isis") == 0) return PCAPNG_PROTOCOL_LLC;
+    if(strcmp(name, "other") == 0) return PCAPNG_PROTOCOL_OTHER;
+    return 0;
+}
+
+static uint32_t
+pcapng_packet_protocol(uint8_t *data, uint32_t length)
+{
+    uint32_t offset = ETH_ADDR_LEN*2;
+    uint16_t type;
+
+    if(length < offset + 2) {
+        return PCAPNG_PROTOCOL_OTHER;
+    }
+    type = read_be_uint(data+offset, 2);
+    while(type == ETH_TYPE_VLAN || type == ETH_TYPE_QINQ || type == 0x9100) {
+        offset += 4;
+        if(length < offset + 2) {
+            return PCAPNG_PROTOCOL_OTHER;
+        }
+        type = read_be_uint(data+offset, 2);
+    }
+    switch(type) {
+        case ETH_TYPE_ARP: return PCAPNG_PROTOCOL_ARP;
+        case ETH_TYPE_IPV4: return PCAPNG_PROTOCOL_IPV4;
+        case ETH_TYPE_IPV6: return PCAPNG_PROTOCOL_IPV6;
+        case ETH_TYPE_PPPOE_DISCOVERY: return PCAPNG_PROTOCOL_PPPOE_DISC;
+        case ETH_TYPE_PPPOE_SESSION: return PCAPNG_PROTOCOL_PPPOE_SESS;
+        case ETH_TYPE_MPLS: return PCAPNG_PROTOCOL_MPLS;
+        case ETH_TYPE_LACP: return PCAPNG_PROTOCOL_LACP;
+        case ETH_TYPE_CFM: return PCAPNG_PROTOCOL_CFM;
+        default:
+            if(type <= ETH_IEEE_802_3_MAX_LEN) {
+                return PCAPNG_PROTOCOL_LLC;
+            }
+            return PCAPNG_PROTOCOL_OTHER;
+    }
 }
 
+static void
+pcapng_push_section_header();
+
+static void
+pcapng_push_interface_header(uint32_t dlt, const char *if_name);
+
 /*
- * Flush the write buffer.
+ * Initialize the pcap writer thread and buffers.
  */
 void
-pcapng_fflush()
+pcapng_init()
 {
-    int res;
+    bbl_pcap_writer_s *writer;
+    bbl_interface_s *interface;
+    uint32_t i;
 
-    if(!(g_ctx && g_ctx->pcap.write_buf && g_ctx->pcap.write_idx)) {
+    if(!(g_ctx && g_ctx->pcap.filename)) {
         return;
     }
 
-    if(g_ctx->pcap.fd == -1) {
-        /*
-         * File is not yet opened, try to open it.
-         */
-        pcapng_open();
-        if(g_ctx->pcap.fd == -1) {
-            /*
-             * Darn, still closed.
-             */
-
-            /*
-             * We may have buffered for too long.
-             * Reset the buffer before it is running full.
-             */
-            if(g_ctx->pcap.write_idx >= (PCAPNG_WRITEBUFSIZE/16)*15) {
-                g_ctx->pcap.write_idx = 0;
-                g_ctx->pcap.wrote_header = false;
-            }
-            return;
+    writer = calloc(1, sizeof(bbl_pcap_writer_s));
+    if(!writer) {
+        LOG_NOARG(ERROR, "Failed to init pcap writer\n");
+        return;
+    }
+    for(i = 0; i < PCAPNG_BUFFERS; i++) {
+        writer->buf[i] = malloc(PCAPNG_WRITEBUFSIZE);
+        if(!writer->buf[i]) {
+            LOG_NOARG(ERROR, "Failed to init pcap writer buffers\n");
+            goto ERROR;
         }
     }
+    writer->header = malloc(PCAPNG_WRITEBUFSIZE);
+    if(!writer->header) {
+        goto ERROR;
+    }
 
-    res = write(g_ctx->pcap.fd, g_ctx->pcap.write_buf, g_ctx->pcap.write_idx);
-
-    /* Blocked? */
-    if(res == -1) {
-        switch(errno) {
-            case EPIPE:
-                /* Our listener just went away.
-                 * Restart the fifo and write a PCAP header for the next listener. */
-                close(g_ctx->pcap.fd);
-                pcapng_init();
-                break;
-            default:
-                /* Reset the buffer for unresponsive callers. */
-                pcapng_init();
-                break;
+    /* Interface filter by ifindex. */
+    if(g_ctx->pcap.interfaces_count) {
+        CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+            if(interface->ifindex >= g_ctx->pcap.interface_filter_len) {
+                g_ctx->pcap.interface_filter_len = interface->ifindex + 1;
+            }
+        }
+        g_ctx->pcap.interface_filter = calloc(g_ctx->pcap.interface_filter_len+1, sizeof(bool));
+        for(i = 0; i < g_ctx->pcap.interfaces_count; i++) {
+            interface = bbl_interface_get(g_ctx->pcap.interfaces[i]);
+            if(interface) {
+                g_ctx->pcap.interface_filter[interface->ifindex] = true;
+            } else {
+                LOG(ERROR, "pcap interface filter %s not found\n", g_ctx->pcap.interfaces[i]);
+            }
         }
-        return;
     }
 
-    /* Full write? */
-    if(res == (int)g_ctx->pcap.write_idx) {
-        LOG(PCAP, "drained %u bytes buffer to pcap file %s\n",
-            g_ctx->pcap.write_idx, g_ctx->pcap.filename);
-        g_ctx->pcap.write_idx = 0;
-        return;
+    /* Section and interface headers. */
+    g_ctx->pcap.write_buf = writer->header;
+    g_ctx->pcap.write_idx = 0;
+    pcapng_push_section_header();
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        pcapng_push_interface_header(DLT_EN10MB, interface->name);
     }
+    writer->header_len = g_ctx->pcap.write_idx;
+    writer->header_pending = true;
+
+    g_ctx->pcap.write_buf = writer->buf[0];
+    g_ctx->pcap.write_idx = 0;
+    g_ctx->pcap.writer = writer;
 
-    /* Partial write? */
-    if(res && res < (int)g_ctx->pcap.write_idx) {
-        /* Rebase the buffer.*/
-        memmove(g_ctx->pcap.write_buf, g_ctx->pcap.write_buf+res, g_ctx->pcap.write_idx - res);
-        g_ctx->pcap.write_idx -= res;
+    /* Open the file. */
+    pcapng_open();
+
+    writer->active = true;
+    if(pthread_create(&writer->thread, NULL, pcapng_writer_thread, (void *)writer) != 0) {
+        LOG_NOARG(ERROR, "Failed to create pcap writer thread\n");
+        writer->active = false;
+        g_ctx->pcap.writer = NULL;
+        g_ctx->pcap.write_buf = NULL;
+        goto ERROR;
+    }
+    timer_add_periodic(&g_ctx->timer_root, &writer->flush_timer, "PCAP Flush", 
+                       0, 100 * MSEC, writer, &pcapng_flush_job);
+    return;
+
+ERROR:
+    for(i = 0; i < PCAPNG_BUFFERS; i++) {
+        if(writer->buf[i]) free(writer->buf[i]);
     }
+    if(writer->header) free(writer->header);
+    free(writer);
 }
 
+/*
+ * Hand over the write buffer to the writer thread if filled
+ * at least a quarter. Remaining packets are handed over by
+ * the flush job, such that small buffers are not written
+ * with every RX/TX job.
+ */
+void
+pcapng_fflush()
+{
+    if(!g_ctx->pcap.writer) {
+        return;
+    }
+    if(g_ctx->pcap.write_idx >= PCAPNG_WRITEBUFSIZE/4) {
+        pcapng_publish(g_ctx->pcap.writer);
+    }
+}
 
 /*
  * Free pcap related resources.
@@ -144,21 +324,50 @@ pcapng_fflush()
 void
 pcapng_free()
 {
-    if(!g_ctx) {
+    bbl_pcap_writer_s *writer;
+    struct timespec timeout;
+    uint32_t i;
+
+    if(!(g_ctx && g_ctx->pcap.writer)) {
         return;
     }
+    writer = g_ctx->pcap.writer;
 
-    pcapng_fflush();
+    /* Drain all buffers. */
+    if(g_ctx->pcap.write_idx && 
+       atomic_load(&writer->head) - atomic_load(&writer->tail) < PCAPNG_BUFFERS) {
+        pcapng_publish(writer);
+    }
+    writer->active = false;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec += 5;
+    if(pthread_timedjoin_np(writer->thread, NULL, &timeout) != 0) {
+        /* Reader of FIFO stalled. */
+        pthread_cancel(writer->thread);
+        pthread_join(writer->thread, NULL);
+    }
+    timer_del(writer->flush_timer);
 
+    if(writer->packets_dropped || writer->packets_lost) {
+        LOG(INFO, "pcap file %s dropped %lu packets (%lu not written)\n", 
+            g_ctx->pcap.filename, writer->packets_dropped + writer->packets_lost,
+            writer->packets_lost);
+    }
     if(g_ctx->pcap.fd != -1) {
         close(g_ctx->pcap.fd);
         g_ctx->pcap.fd = -1;
-        return;
     }
-
-    if(g_ctx->pcap.write_buf) {
-        free(g_ctx->pcap.write_buf);
-        g_ctx->pcap.write_buf = NULL;
+    for(i = 0; i < PCAPNG_BUFFERS; i++) {
+        free(writer->buf[i]);
+    }
+    free(writer->header);
+    free(writer);
+    g_ctx->pcap.writer = NULL;
+    g_ctx->pcap.write_buf = NULL;
+    g_ctx->pcap.write_idx = 0;
+    if(g_ctx->pcap.interface_filter) {
+        free(g_ctx->pcap.interface_filter);
+        g_ctx->pcap.interface_filter = NULL;
     }
 }
 
@@ -249,7 +458,7 @@ pcapng_push_interface_header(uint32_t dlt, const char *if_name)
     bbl_pcap_push_le_uint(4, 0); /* block total_length */
     bbl_pcap_push_le_uint(2, dlt); /* link_type */
     bbl_pcap_push_le_uint(2, 0); /* reserved */
-    bbl_pcap_push_le_uint(4, 9*1024); /* snaplen */
+    bbl_pcap_push_le_uint(4, g_ctx->pcap.snaplen ? g_ctx->pcap.snaplen : 9*1024); /* snaplen */
 
     /* Write idb_ifname option. */
     bbl_pcap_push_le_uint(2, PCAPNG_IDB_IFNAME_OPTION); /* option_type */
@@ -273,53 +482,75 @@ void
 pcapng_push_packet_header(struct timespec *ts, uint8_t *data, uint32_t packet_length,
                           uint32_t ifindex, uint32_t direction)
 {
-    bbl_interface_s *interface;
-    uint32_t start_idx, total_length;
+    bbl_pcap_writer_s *writer = g_ctx->pcap.writer;
+    uint32_t start_idx, total_length, capture_length;
     uint64_t ts_usec;
 
-    if(!g_ctx->pcap.wrote_header) {
-        pcapng_push_section_header();
+    if(!writer) {
+        return;
+    }
 
-        /* Push a list of interfaces. */
-        CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
-            pcapng_push_interface_header(DLT_EN10MB, interface->name);
+    /* Apply capture filters. */
+    if(g_ctx->pcap.interface_filter) {
+        if(ifindex >= g_ctx->pcap.interface_filter_len || !g_ctx->pcap.interface_filter[ifindex]) {
+            return;
+        }
+    }
+    if(g_ctx->pcap.protocols) {
+        if(!(g_ctx->pcap.protocols & pcapng_packet_protocol(data, packet_length))) {
+            return;
+        }
+    }
+
+    capture_length = packet_length;
+    if(g_ctx->pcap.snaplen && capture_length > g_ctx->pcap.snaplen) {
+        capture_length = g_ctx->pcap.snaplen;
+    }
+    total_length = 40 + capture_length + calc_pad(capture_length);
+
+    /* Buffer about to be overrun? */
+    if(g_ctx->pcap.write_idx + total_length >= PCAPNG_WRITEBUFSIZE) {
+        if(g_ctx->pcap.write_idx) {
+            pcapng_publish(writer);
+        }
+    }
+    if(g_ctx->pcap.write_idx == 0) {
+        /* Current buffer still queued for writing? */
+        if(atomic_load_explicit(&writer->head, memory_order_relaxed) - 
+           atomic_load_explicit(&writer->tail, memory_order_acquire) >= PCAPNG_BUFFERS ||
+           total_length >= PCAPNG_WRITEBUFSIZE) {
+            writer->packets_dropped++;
+            return;
         }
-        g_ctx->pcap.wrote_header = true;
     }
 
     start_idx = g_ctx->pcap.write_idx;
 
     bbl_pcap_push_le_uint(4, PCAPNG_EPB); /* block type */
-    bbl_pcap_push_le_uint(4, 0); /* block total_length */
+    bbl_pcap_push_le_uint(4, total_length); /* block total_length */
     bbl_pcap_push_le_uint(4, ifindex); /* interface_id */
 
     ts_usec = ts->tv_sec * 1000000 + ts->tv_nsec/1000;
     bbl_pcap_push_le_uint(4, ts_usec>>32); /* timestamp usec msb */
     bbl_pcap_push_le_uint(4, ts_usec & 0xffffffff); /* timestamp usec lsb */
 
-    bbl_pcap_push_le_uint(4, packet_length); /* captured packet length */
+    bbl_pcap_push_le_uint(4, capture_length); /* captured packet length */
     bbl_pcap_push_le_uint(4, packet_length); /* original packet length */
 
     /* Copy packet. */
-    memcpy(&g_ctx->pcap.write_buf[g_ctx->pcap.write_idx], data, packet_length);
-    g_ctx->pcap.write_idx += packet_length;
-    bbl_pcap_push_le_uint(calc_pad(packet_length), 0); /* write pad bytes */
+    memcpy(&g_ctx->pcap.write_buf[g_ctx->pcap.write_idx], data, capture_length);
+    g_ctx->pcap.write_idx += capture_length;
+    bbl_pcap_push_le_uint(calc_pad(capture_length), 0); /* write pad bytes */
 
     /* Write epb_flags option for storing packet direction. */
     bbl_pcap_push_le_uint(2, PCAPNG_EPB_FLAGS_OPTION); /* option_type */
     bbl_pcap_push_le_uint(2, 4); /* option_length */
     bbl_pcap_push_le_uint(4, direction & 0x3); /* direction */
 
-    /* Calculate total length field. It occurs twice. Overwrite and append. */
-    total_length = g_ctx->pcap.write_idx - start_idx + 4;
-    write_le_uint(g_ctx->pcap.write_buf+start_idx+4, 4, total_length); /* block total_length */
     bbl_pcap_push_le_uint(4, total_length); /* block total_length */
+    assert(g_ctx->pcap.write_idx - start_idx == total_length);
+    writer->write_packets++;
 
     LOG(PCAP, "wrote %u bytes pcap packet data, buffer fill %u/%u\n",
-        packet_length, g_ctx->pcap.write_idx, PCAPNG_WRITEBUFSIZE);
-
-    /* Buffer about to be overrun? */
-    if(g_ctx->pcap.write_idx >= (PCAPNG_WRITEBUFSIZE/16)*15) {
-        pcapng_fflush();
-    }
-}
\ No newline at end of file
+        capture_length, g_ctx->pcap.write_idx, PCAPNG_WRITEBUFSIZE);
+}
@@ -11,8 +11,10 @@
 #ifndef __BBL_PCAP_H__
 #define __BBL_PCAP_H__
 
-#define PCAPNG_WRITEBUFSIZE 65536
+#define PCAPNG_WRITEBUFSIZE (1024*1024)
+#define PCAPNG_BUFFERS 8
 #define PCAPNG_PERMS 0644
+#define PCAPNG_SNAPLEN (9*1024)
 
 #define PCAPNG_SHB 0x0a0d0d0a
 #define PCAPNG_SHB_USERAPPL_OPTION 4
@@ -26,11 +28,57 @@
 #define PCAPNG_EPB_FLAGS_INBOUND  0x1
 #define PCAPNG_EPB_FLAGS_OUTBOUND 0x2
 
+/* Capture protocol filter */
+#define PCAPNG_PROTOCOL_ARP         0x0001
+#define PCAPNG_PROTOCOL_IPV4        0x0002
+#define PCAPNG_PROTOCOL_IPV6        0x0004
+#define PCAPNG_PROTOCOL_PPPOE_DISC  0x0008
+#define PCAPNG_PROTOCOL_PPPOE_SESS  0x0010
+#define PCAPNG_PROTOCOL_MPLS        0x0020
+#define PCAPNG_PROTOCOL_LACP        0x0040
+#define PCAPNG_PROTOCOL_CFM         0x0080
+#define PCAPNG_PROTOCOL_LLC         0x0100 /* ISIS */
+#define PCAPNG_PROTOCOL_OTHER       0x8000
+
 /* Ethernet (10Mb, 100Mb, 1000Mb, and up);
  * the 10MB in the DLT_ name is historical. */
 #define DLT_EN10MB        1 /* Ethernet (10Mb) */
 #define DLT_NULL          0 /* RAW IP */
 
+/*
+ * Packets are written by the main thread into the current buffer,
+ * which is handed over to the writer thread if full or by the flush
+ * job. If all buffers are still queued for writing, packets are
+ * dropped and counted instead of blocking the main loop.
+ */
+typedef struct bbl_pcap_writer_ {
+    pthread_t thread;
+    volatile bool active;
+
+    uint8_t *buf[PCAPNG_BUFFERS];
+    uint32_t len[PCAPNG_BUFFERS];
+    uint32_t packets[PCAPNG_BUFFERS];
+    uint32_t write_packets; /* packets in current buffer */
+
+    /* Buffers are indexed by head/tail modulo PCAPNG_BUFFERS. */
+    atomic_uint_fast64_t head; /* buffers handed over by main thread */
+    atomic_uint_fast64_t tail; /* buffers written by writer thread */
+
+    /* Section and interface headers written 
+     * with every (re)opened file or FIFO. */
+    uint8_t *header;
+    uint32_t header_len;
+    bool header_pending;
+
+    struct timer_ *flush_timer;
+
+    uint64_t packets_dropped; /* main thread */
+    uint64_t packets_lost; /* writer thread */
+} bbl_pcap_writer_s;
+
+uint32_t
+pcapng_protocol(const char *name);
+
 void
 pcapng_open();
 
@@ -8,6 +8,7 @@
  */
 #include "bbl_def.h"
 #include "bbl_protocols.h"
+#include <checksum.h>
 #include "bbl_access_line.h"
 #include "isis/isis_def.h"
 #include "ospf/ospf_def.h"
@@ -41,20 +42,13 @@ packet_is_bbl(uint8_t *buf, uint16_t len)
  * CHECKSUM
  * ------------------------------------------------------------------------*/
 
-static uint32_t
+static inline uint32_t
 _checksum(void *buf, ssize_t len)
 {
-    uint32_t result = 0;
-    uint16_t *cur = buf;
-    while (len > 1) {
-        result += *cur++;
-        len -= 2;
-    }
-    /*  Add left-over byte, if any */
-    if(len) {
-        result += *(uint8_t*)cur;
+    if(len <= 0) {
+        return 0;
     }
-    return result;
+    return checksum_sum(buf, len);
 }
 
 static uint32_t
@@ -72,6 +66,21 @@ bbl_checksum(uint8_t *buf, uint16_t len)
     return ~_fold(_checksum(buf, len));
 }
 
+/**
+ * Incremental checksum update (RFC 1624 eqn. 3) 
+ * replacing old with new data of the same length, 
+ * aligned to 16 bit words of the checksummed data.
+ */
+uint16_t
+bbl_checksum_update(uint16_t checksum, uint8_t *old, uint8_t *new, uint16_t len)
+{
+    uint32_t result;
+    result  = (uint16_t)~checksum;
+    result += (uint16_t)~_fold(_checksum(old, len));
+    result += _checksum(new, len);
+    return ~_fold(result);
+}
+
 uint16_t
 bbl_ipv4_udp_checksum(uint32_t src, uint32_t dst, uint8_t *udp, uint16_t udp_len)
 {
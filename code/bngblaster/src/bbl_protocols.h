@@ -1041,6 +1041,9 @@ packet_is_bbl(uint8_t *buf, uint16_t len);
 uint16_t
 bbl_checksum(uint8_t *buf, uint16_t len);
 
+uint16_t
+bbl_checksum_update(uint16_t checksum, uint8_t *old, uint8_t *new, uint16_t len);
+
 uint16_t
 bbl_ipv4_udp_checksum(uint32_t src, uint32_t dst, uint8_t *udp, uint16_t udp_len);
 
@@ -11,7 +11,8 @@
 
 static bool
 bbl_rx_stream_network(bbl_network_interface_s *interface, 
-                      bbl_ethernet_header_s *eth) 
+                      bbl_ethernet_header_s *eth,
+                      bbl_stream_stats_s **stats) 
 {
     bbl_stream_s *stream;
     if(!eth->bbl) return false;
@@ -25,6 +26,7 @@ bbl_rx_stream_network(bbl_network_interface_s *interface,
             }
             stream->rx_network_interface = interface;
         }
+        bbl_stream_rx_account(stream, stats);
         return true;
     }
     return false;
@@ -32,7 +34,8 @@ bbl_rx_stream_network(bbl_network_interface_s *interface,
 
 static bool
 bbl_rx_stream_access(bbl_access_interface_s *interface, 
-                     bbl_ethernet_header_s *eth) 
+                     bbl_ethernet_header_s *eth,
+                     bbl_stream_stats_s **stats) 
 {
     bbl_stream_s *stream;
     if(!eth->bbl) return false;
@@ -41,6 +44,7 @@ bbl_rx_stream_access(bbl_access_interface_s *interface,
         if(stream->rx_access_interface == NULL) {
             stream->rx_access_interface = interface;
         }
+        bbl_stream_rx_account(stream, stats);
         return true;
     }
     return false;
@@ -48,7 +52,8 @@ bbl_rx_stream_access(bbl_access_interface_s *interface,
 
 static bool
 bbl_rx_stream_a10nsp(bbl_a10nsp_interface_s *interface, 
-                     bbl_ethernet_header_s *eth) 
+                     bbl_ethernet_header_s *eth,
+                     bbl_stream_stats_s **stats) 
 {
     bbl_stream_s *stream;
     if(!eth->bbl) return false;
@@ -57,6 +62,7 @@ bbl_rx_stream_a10nsp(bbl_a10nsp_interface_s *interface,
         if(stream->rx_a10nsp_interface == NULL) {
             stream->rx_a10nsp_interface = interface;
         }
+        bbl_stream_rx_account(stream, stats);
         return true;
     }
     return false;
@@ -64,7 +70,8 @@ bbl_rx_stream_a10nsp(bbl_a10nsp_interface_s *interface,
 
 bool
 bbl_rx_thread(bbl_interface_s *interface, 
-              bbl_ethernet_header_s *eth)
+              bbl_ethernet_header_s *eth,
+              bbl_stream_stats_s **stats)
 {
     bbl_network_interface_s *network_interface;
     if(interface->state == INTERFACE_DISABLED) {
@@ -72,11 +79,11 @@ bbl_rx_thread(bbl_interface_s *interface,
     }
     network_interface = interface->network_vlan[eth->vlan_outer];
     if(network_interface) {
-        return bbl_rx_stream_network(network_interface, eth);
+        return bbl_rx_stream_network(network_interface, eth, stats);
     } else if(interface->access) {
-        return bbl_rx_stream_access(interface->access, eth);
+        return bbl_rx_stream_access(interface->access, eth, stats);
     } else if(interface->a10nsp) {
-        return bbl_rx_stream_a10nsp(interface->a10nsp, eth);
+        return bbl_rx_stream_a10nsp(interface->a10nsp, eth, stats);
     }
     return false;
 }
@@ -107,15 +114,15 @@ bbl_rx_handler(bbl_interface_s *interface,
 
     network_interface = interface->network_vlan[eth->vlan_outer];
     if(network_interface) {
-        if(!bbl_rx_stream_network(network_interface, eth)) {
+        if(!bbl_rx_stream_network(network_interface, eth, &g_ctx->stream_stats)) {
             bbl_network_rx_handler(network_interface, eth);
         }
     } else if(interface->access) {
-        if(!bbl_rx_stream_access(interface->access, eth)) {
+        if(!bbl_rx_stream_access(interface->access, eth, &g_ctx->stream_stats)) {
             bbl_access_rx_handler(interface->access, eth);
         }
     } else if(interface->a10nsp) {
-        if(!bbl_rx_stream_a10nsp(interface->a10nsp, eth)) {
+        if(!bbl_rx_stream_a10nsp(interface->a10nsp, eth, &g_ctx->stream_stats)) {
             bbl_a10nsp_rx_handler(interface->a10nsp, eth);
         }
     }
@@ -13,7 +13,8 @@
 
 bool
 bbl_rx_thread(bbl_interface_s *interface, 
-              bbl_ethernet_header_s *eth);
+              bbl_ethernet_header_s *eth,
+              bbl_stream_stats_s **stats);
 
 void
 bbl_rx_handler(bbl_interface_s *interface, 
@@ -81,7 +81,7 @@ dhcp_state_string(uint32_t state)
 void
 bbl_session_tx_qnode_insert(bbl_session_s *session)
 {
-    bbl_access_interface_s *interface = session->access_interface;
+    bbl_access_interface_s *interface = session->hot->access_interface;
     if(CIRCLEQ_NEXT(session, session_tx_qnode)) {
         return;
     }
@@ -91,7 +91,7 @@ bbl_session_tx_qnode_insert(bbl_session_s *session)
 void
 bbl_session_tx_qnode_remove(bbl_session_s *session)
 {
-    bbl_access_interface_s *interface = session->access_interface;
+    bbl_access_interface_s *interface = session->hot->access_interface;
     CIRCLEQ_REMOVE(&interface->session_tx_qhead, session, session_tx_qnode);
     CIRCLEQ_NEXT(session, session_tx_qnode) = NULL;
     CIRCLEQ_PREV(session, session_tx_qnode) = NULL;
@@ -99,8 +99,8 @@ bbl_session_tx_qnode_remove(bbl_session_s *session)
 
 void
 bbl_session_ncp_open(bbl_session_s *session, bool ipcp) {
-    if(session->session_state == BBL_ESTABLISHED ||
-       session->session_state == BBL_PPP_NETWORK) {
+    if(session->hot->session_state == BBL_ESTABLISHED ||
+       session->hot->session_state == BBL_PPP_NETWORK) {
         if(ipcp) {
             if(session->ipcp_state == BBL_PPP_CLOSED) {
                 session->ipcp_state = BBL_PPP_INIT;
@@ -122,8 +122,8 @@ bbl_session_ncp_open(bbl_session_s *session, bool ipcp) {
 
 void
 bbl_session_ncp_close(bbl_session_s *session, bool ipcp) {
-    if(session->session_state == BBL_ESTABLISHED ||
-       session->session_state == BBL_PPP_NETWORK) {
+    if(session->hot->session_state == BBL_ESTABLISHED ||
+       session->hot->session_state == BBL_PPP_NETWORK) {
         if(ipcp) {
             if(session->ipcp_state == BBL_PPP_OPENED) {
                 session->ipcp_state = BBL_PPP_TERMINATE;
@@ -157,9 +157,9 @@ void
 bbl_session_rate_job(timer_s *timer) {
     bbl_session_s *session = timer->data;
     bbl_compute_avg_rate(&session->stats.rate_packets_tx, session->stats.packets_tx);
-    bbl_compute_avg_rate(&session->stats.rate_packets_rx, session->stats.packets_rx);
+    bbl_compute_avg_rate(&session->stats.rate_packets_rx, session->hot->packets_rx);
     bbl_compute_avg_rate(&session->stats.rate_bytes_tx, session->stats.bytes_tx);
-    bbl_compute_avg_rate(&session->stats.rate_bytes_rx, session->stats.bytes_rx);
+    bbl_compute_avg_rate(&session->stats.rate_bytes_rx, session->hot->bytes_rx);
 }
 
 static void
@@ -273,7 +273,7 @@ bbl_session_monkey_job(timer_s *timer) {
         return;
     }
 
-    switch(session->session_state) {
+    switch(session->hot->session_state) {
         case BBL_IDLE:
         case BBL_TERMINATED:
             return;
@@ -281,59 +281,39 @@ bbl_session_monkey_job(timer_s *timer) {
             break;
     }
 
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         bbl_session_monkey_pppoe(session);
-    } else if(session->access_type == ACCESS_TYPE_IPOE) {
+    } else if(session->hot->access_type == ACCESS_TYPE_IPOE) {
         bbl_session_monkey_ipoe(session);
     }
 }
 
 /**
- * bbl_session_get
+ * bbl_session_get_by_vlan
  *
- * @param session_id session-id
+ * @param key VLAN session key
  * @return session or NULL if session not found
+ * or VLAN is shared by multiple sessions (N:1)
  */
 bbl_session_s *
-bbl_session_get(uint32_t session_id)
+bbl_session_get_by_vlan(vlan_session_key_t *key)
 {
-    if(session_id > g_ctx->sessions || session_id < 1) {
-        return NULL;
+    uint64_t vlan_key;
+    void **search;
+
+    memcpy(&vlan_key, key, sizeof(vlan_key));
+    search = hash64_search(&g_ctx->vlan_session_table, vlan_key);
+    if(search) {
+        return *search;
     }
-    return &g_ctx->session_list[session_id-1];
+    return NULL;
 }
 
 void
 bbl_session_free(bbl_session_s *session) 
 {
-    if(session->username) {
-        free(session->username);
-        session->username = NULL;
-    }
-    if(session->password) {
-        free(session->password);
-        session->password = NULL;
-    }
-    if(session->agent_circuit_id) {
-        free(session->agent_circuit_id);
-        session->agent_circuit_id = NULL;
-    }
-    if(session->agent_remote_id) {
-        free(session->agent_remote_id);
-        session->agent_remote_id = NULL;
-    }
-    if(session->access_aggregation_circuit_id) {
-        free(session->access_aggregation_circuit_id);
-        session->access_aggregation_circuit_id = NULL;
-    }
-    if(session->vendor_class_id) {
-        free(session->vendor_class_id);
-        session->vendor_class_id = NULL;
-    }
-    if(session->cfm_ma_name) {
-        free(session->cfm_ma_name);
-        session->cfm_ma_name = NULL;
-    }
+    bbl_igmp_session_free(session);
+    bbl_dhcpv6_session_free(session);
 
     if(session->pppoe_ac_cookie) {
         free(session->pppoe_ac_cookie);
@@ -360,6 +340,22 @@ bbl_session_free(bbl_session_s *session)
     }
 }
 
+/**
+ * bbl_session_version_update
+ * 
+ * Increment the session version after session 
+ * addresses or endpoints have changed, which 
+ * triggers a rebuild of all session streams. 
+ * 
+ * @param session session
+ */
+void
+bbl_session_version_update(bbl_session_s *session)
+{
+    session->version++;
+    bbl_stream_session_update(session);
+}
+
 /**
  * bbl_session_reset
  * 
@@ -369,8 +365,8 @@ bbl_session_free(bbl_session_s *session)
  */
 static void
 bbl_session_reset(bbl_session_s *session) {    
-    memset(&session->server_mac, 0xff, ETH_ADDR_LEN); /* init with broadcast MAC */
-    session->version++;
+    memset(&session->hot->server_mac, 0xff, ETH_ADDR_LEN); /* init with broadcast MAC */
+    bbl_session_version_update(session);
 
     session->reconnect_delay = 0;
     session->reconnect_disabled = false;
@@ -417,19 +413,23 @@ bbl_session_reset(bbl_session_s *session) {
     }
     session->dhcpv6_requested = false;
     session->dhcpv6_established = false;
-    session->dhcpv6_ia_na_option_len = 0;
-    session->dhcpv6_ia_pd_option_len = 0;
+    if(session->dhcpv6) {
+        session->dhcpv6->ia_na_option_len = 0;
+        session->dhcpv6->ia_pd_option_len = 0;
+    }
     memset(session->ipv6_address, 0x0, IPV6_ADDR_LEN);
     memset(session->delegated_ipv6_address, 0x0, IPV6_ADDR_LEN);
     memset(session->ipv6_dns1, 0x0, IPV6_ADDR_LEN);
     memset(session->ipv6_dns2, 0x0, IPV6_ADDR_LEN);
     memset(session->dhcpv6_dns1, 0x0, IPV6_ADDR_LEN);
     memset(session->dhcpv6_dns2, 0x0, IPV6_ADDR_LEN);
-    session->zapping_joined_group = NULL;
-    session->zapping_leaved_group = NULL;
-    session->zapping_count = 0;
-    session->zapping_view_start_time.tv_sec = 0;
-    session->zapping_view_start_time.tv_nsec = 0;
+    if(session->igmp) {
+        session->igmp->zapping_joined_group = NULL;
+        session->igmp->zapping_leaved_group = NULL;
+        session->igmp->zapping_count = 0;
+        session->igmp->zapping_view_start_time.tv_sec = 0;
+        session->igmp->zapping_view_start_time.tv_nsec = 0;
+    }
 
     if(session->reply_message) {
         free(session->reply_message);
@@ -487,12 +487,12 @@ bbl_session_reset(bbl_session_s *session) {
 static bool
 bbl_session_start(bbl_session_s *session)
 {
-    if(g_teardown || session->session_state != BBL_TERMINATED) {
+    if(g_teardown || session->hot->session_state != BBL_TERMINATED) {
         return false;
     }
 
     /* Reset session */    
-    session->session_state = BBL_IDLE;
+    session->hot->session_state = BBL_IDLE;
     bbl_session_reset(session);
     if(g_ctx->sessions_terminated) {
         g_ctx->sessions_terminated--;
@@ -521,13 +521,14 @@ bbl_session_reconnect_job(timer_s *timer) {
 void
 bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
 {
-    session_state_t old_state = session->session_state;
+    session_state_t old_state = session->hot->session_state;
 
     if(old_state != new_state) {
         /* State has changed ... */
-        session->session_state = new_state;
-        session->version++;
-        assert(session->session_state > BBL_IDLE && session->session_state < BBL_MAX);
+        session->hot->session_state = new_state;
+        bbl_session_version_update(session);
+        bbl_subscribe_session_state(session);
+        assert(session->hot->session_state > BBL_IDLE && session->hot->session_state < BBL_MAX);
 
         if(old_state == BBL_ESTABLISHED) {
             /* Decrement sessions established if old state is established. */
@@ -609,7 +610,7 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
             timer_del(session->timer_reconnect);
 
             /* Reset all states */
-            if(session->access_type == ACCESS_TYPE_PPPOE) {
+            if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                 session->lcp_state = BBL_PPP_CLOSED;
                 if(session->ipcp_state > BBL_PPP_DISABLED) {
                     session->ipcp_state = BBL_PPP_CLOSED;
@@ -636,8 +637,8 @@ bbl_session_update_state(bbl_session_s *session, session_state_t new_state)
 
                 /* Reconnect */
                 if(!session->reconnect_disabled && 
-                   ((session->access_type == ACCESS_TYPE_PPPOE && g_ctx->config.pppoe_reconnect) || 
-                    (session->access_type == ACCESS_TYPE_IPOE && g_ctx->config.sessions_reconnect))) {
+                   ((session->hot->access_type == ACCESS_TYPE_PPPOE && g_ctx->config.pppoe_reconnect) || 
+                    (session->hot->access_type == ACCESS_TYPE_IPOE && g_ctx->config.sessions_reconnect))) {
                     if(!session->reconnect_delay) {
                         session->reconnect_delay = 1;
                     }
@@ -661,8 +662,8 @@ bbl_session_clear(bbl_session_s *session)
 {
     session_state_t new_state = BBL_TERMINATED;
 
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
-        switch(session->session_state) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
+        switch(session->hot->session_state) {
             case BBL_IDLE:
             case BBL_PPPOE_INIT:
                 bbl_session_update_state(session, BBL_TERMINATED);
@@ -747,48 +748,15 @@ bbl_session_clear(bbl_session_s *session)
     }
 }
 
-static void
-update_strings(char **target, const char *source, uint32_t *i, bbl_access_config_s *access_config)
-{
-    static char snum1[32];
-    static char snum2[32];
-    static char si1[32];
-    static char si2[32];
-    static char vlan1[32];
-    static char vlan2[32];
-
-    char *s;
-
-    if(i && access_config) {
-        /* Init iterator */
-        snprintf(snum1, sizeof(snum1), "%d", *i);
-        snprintf(snum2, sizeof(snum2), "%d", access_config->sessions);
-        snprintf(si1, sizeof(si1), "%d", access_config->i1);
-        access_config->i1 += access_config->i1_step;
-        snprintf(si2, sizeof(si2), "%d", access_config->i2);
-        access_config->i2 += access_config->i2_step;
-        snprintf(vlan1, sizeof(si2), "%d", access_config->access_outer_vlan);
-        snprintf(vlan2, sizeof(si2), "%d", access_config->access_inner_vlan);
-    }
-    if(target && source) {
-        s = replace_substring(source, "{session-global}", snum1);
-        s = replace_substring(s, "{session}", snum2);
-        s = replace_substring(s, "{i1}", si1);
-        s = replace_substring(s, "{i2}", si2);
-        s = replace_substring(s, "{outer-vlan}", vlan1);
-        s = replace_substring(s, "{inner-vlan}", vlan2);
-        if(s) *target = strdup(s);
-    }
-}
-
 bool
 bbl_sessions_init()
 {
     bbl_session_s *session;
     bbl_access_config_s *access_config;
     bbl_access_line_profile_s *access_line_profile;
-    dict_insert_result result;
+    uint64_t vlan_key;
     void **search;
+    bool inserted;
 
     uint32_t i = 1;  /* BNG Blaster internal session identifier */
 
@@ -799,8 +767,28 @@ bbl_sessions_init()
      * that all VLAN ranges are exhausted. */
     int t = 0;
 
-    /* Init list of sessions */
+    if(!bbl_session_id_init()) {
+        return false;
+    }
+
+    /* Compile session string templates */
+    access_config = g_ctx->config.access_config;
+    while(access_config) {
+        if(!bbl_session_templates_compile(access_config)) {
+            LOG_NOARG(ERROR, "Failed to compile session string templates!\n");
+            return false;
+        }
+        access_config = access_config->next;
+    }
+
+    /* Init list of sessions and RX hot fields */
     g_ctx->session_list = calloc(g_ctx->config.sessions, sizeof(bbl_session_s));
+    g_ctx->session_hot = aligned_alloc(CACHE_LINE_SIZE, g_ctx->config.sessions * sizeof(bbl_session_hot_s));
+    if(!(g_ctx->session_list && g_ctx->session_hot)) {
+        LOG_NOARG(ERROR, "Failed to allocate sessions!\n");
+        return false;
+    }
+    memset(g_ctx->session_hot, 0x0, g_ctx->config.sessions * sizeof(bbl_session_hot_s));
     access_config = g_ctx->config.access_config;
 
     /* For equal distribution of sessions over access configurations
@@ -863,37 +851,33 @@ bbl_sessions_init()
         t++;
         access_config->sessions++;
         session = &g_ctx->session_list[i-1];
-        memset(&session->server_mac, 0xff, ETH_ADDR_LEN); /* init with broadcast MAC */
+        session->hot = &g_ctx->session_hot[i-1];
+        memset(&session->hot->server_mac, 0xff, ETH_ADDR_LEN); /* init with broadcast MAC */
         memset(&session->dhcp_server_mac, 0xff, ETH_ADDR_LEN); /* init with broadcast MAC */
         session->session_id = i; /* BNG Blaster internal session identifier */
         session->session_group_id = access_config->session_group_id;
-        session->access_type = access_config->access_type;
-        session->access_interface = access_config->access_interface;
+        session->hot->access_type = access_config->access_type;
+        session->hot->access_interface = access_config->access_interface;
         session->network_interface = bbl_network_interface_get(access_config->network_interface);
-        session->vlan_key.ifindex = access_config->access_interface->ifindex;
-        session->vlan_key.outer_vlan_id= access_config->access_outer_vlan;
-        session->vlan_key.inner_vlan_id = access_config->access_inner_vlan;
+        session->hot->vlan_key.ifindex = access_config->access_interface->ifindex;
+        session->hot->vlan_key.outer_vlan_id= access_config->access_outer_vlan;
+        session->hot->vlan_key.inner_vlan_id = access_config->access_inner_vlan;
         session->access_third_vlan = access_config->access_third_vlan;
         session->access_config = access_config;
 
-        /* Set client OUI to locally administered */
-        session->client_mac[0] = 0x02;
-        session->client_mac[1] = 0x00;
-        session->client_mac[2] = g_ctx->config.mac_modifier;
-        /* Use session identifier for remaining bytes */
-        session->client_mac[3] = i>>16;
-        session->client_mac[4] = i>>8;
-        session->client_mac[5] = i;
+        if(!bbl_session_id_add(session)) {
+            return false;
+        }
 
         /* Derive IP6CP interface identifier from MAC (EUI-64) */
-        ((uint8_t *)&session->ip6cp_ipv6_identifier)[0] = session->client_mac[0];
-        ((uint8_t *)&session->ip6cp_ipv6_identifier)[1] = session->client_mac[1];
-        ((uint8_t *)&session->ip6cp_ipv6_identifier)[2] = session->client_mac[2];
+        ((uint8_t *)&session->ip6cp_ipv6_identifier)[0] = session->hot->client_mac[0];
+        ((uint8_t *)&session->ip6cp_ipv6_identifier)[1] = session->hot->client_mac[1];
+        ((uint8_t *)&session->ip6cp_ipv6_identifier)[2] = session->hot->client_mac[2];
         ((uint8_t *)&session->ip6cp_ipv6_identifier)[3] = 0xFF;
         ((uint8_t *)&session->ip6cp_ipv6_identifier)[4] = 0xFE;
-        ((uint8_t *)&session->ip6cp_ipv6_identifier)[5] = session->client_mac[3];
-        ((uint8_t *)&session->ip6cp_ipv6_identifier)[6] = session->client_mac[4];
-        ((uint8_t *)&session->ip6cp_ipv6_identifier)[7] = session->client_mac[5];
+        ((uint8_t *)&session->ip6cp_ipv6_identifier)[5] = session->hot->client_mac[3];
+        ((uint8_t *)&session->ip6cp_ipv6_identifier)[6] = session->hot->client_mac[4];
+        ((uint8_t *)&session->ip6cp_ipv6_identifier)[7] = session->hot->client_mac[5];
 
         /* Init link-local IPv6 address */
         session->link_local_ipv6_address[0] = 0xfe;
@@ -903,42 +887,23 @@ bbl_sessions_init()
         session->link_local_ipv6_address[10] = 0xff;
         session->link_local_ipv6_address[11] = 0xff;
         session->link_local_ipv6_address[12] = 0xff;
-        session->link_local_ipv6_address[13] = session->client_mac[3];
-        session->link_local_ipv6_address[14] = session->client_mac[4];
-        session->link_local_ipv6_address[15] = session->client_mac[5];
-
-        /* Set DHCPv6 DUID */
-        session->dhcpv6_duid[1] = 3;
-        session->dhcpv6_duid[3] = 1;
-        memcpy(&session->dhcpv6_duid[4], session->client_mac, ETH_ADDR_LEN);
-
-        /* Init string variables/iterators */
-        update_strings(NULL, NULL, &i, access_config);
-
-        /* Update username */
-        update_strings(&session->username, access_config->username, NULL, NULL);
-
-        /* Update password */
-        update_strings(&session->password, access_config->password, NULL, NULL);
-
-        /* Update ACI */
-        update_strings(&session->agent_circuit_id, access_config->agent_circuit_id, NULL, NULL);
-
-        /* Update ARI */
-        update_strings(&session->agent_remote_id, access_config->agent_remote_id, NULL, NULL);
-
-        /* Update Access-Aggregation-Circuit-ID */
-        update_strings(&session->access_aggregation_circuit_id, access_config->access_aggregation_circuit_id, NULL, NULL);
+        session->link_local_ipv6_address[13] = session->hot->client_mac[3];
+        session->link_local_ipv6_address[14] = session->hot->client_mac[4];
+        session->link_local_ipv6_address[15] = session->hot->client_mac[5];
+        if(g_ctx->config.session_id_bits > BBL_SESSION_ID_BITS) {
+            session->link_local_ipv6_address[12] = session->hot->client_mac[2];
+        }
 
-        /* Update Vendor Class ID */
-        update_strings(&session->vendor_class_id, access_config->vendor_class_id, NULL, NULL);
+        /* Session strings (username, ACI, ...) are rendered 
+         * on demand from the access configuration templates
+         * using the per access config session identifier. */
+        session->access_config_session_id = access_config->sessions;
 
         /* Update CFM */
         if(access_config->cfm_cc) {
             session->cfm_cc = true;
             session->cfm_level = access_config->cfm_level;
             session->cfm_ma_id = access_config->cfm_ma_id;
-            update_strings(&session->cfm_ma_name, access_config->cfm_ma_name, NULL, NULL);
         }
 
         /* Update access rates ... */
@@ -969,10 +934,9 @@ bbl_sessions_init()
         session->igmp_autostart = access_config->igmp_autostart;
         session->igmp_version = access_config->igmp_version;
         session->igmp_robustness = 2; /* init robustness with 2 */
-        session->zapping_group_max = be32toh(g_ctx->config.igmp_group) + ((g_ctx->config.igmp_group_count - 1) * be32toh(g_ctx->config.igmp_group_iter));
 
         /* Set access type specific values */
-        if(session->access_type == ACCESS_TYPE_PPPOE) {
+        if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
             session->mru = access_config->ppp_mru;
             session->magic_number = htobe32(i);
             session->lcp_state = BBL_PPP_CLOSED;
@@ -997,7 +961,7 @@ bbl_sessions_init()
             if(g_ctx->config.pppoe_host_uniq) {
                 session->pppoe_host_uniq = htobe64(i);
             }
-        } else if(session->access_type == ACCESS_TYPE_IPOE) {
+        } else if(session->hot->access_type == ACCESS_TYPE_IPOE) {
             if(access_config->ipv4_enable) {
                 session->endpoint.ipv4 = ENDPOINT_ENABLED;
                 if(access_config->static_ip && access_config->static_gateway) {
@@ -1022,45 +986,42 @@ bbl_sessions_init()
                 }
             }
         }
-        session->access_interface = access_config->access_interface;
+        session->hot->access_interface = access_config->access_interface;
         session->network_interface = bbl_network_interface_get(access_config->network_interface);
         
         if(g_ctx->config.sessions_autostart) {
-            session->session_state = BBL_IDLE;
+            session->hot->session_state = BBL_IDLE;
             CIRCLEQ_INSERT_TAIL(&g_ctx->sessions_idle_qhead, session, session_idle_qnode);
         } else {
-            session->session_state = BBL_TERMINATED;
+            session->hot->session_state = BBL_TERMINATED;
             g_ctx->sessions_terminated++;
         }
 
         g_ctx->sessions++;
-        if(session->access_type == ACCESS_TYPE_PPPOE) {
+        if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
             g_ctx->sessions_pppoe++;
         } else {
             g_ctx->sessions_ipoe++;
         }
 
+        /* N:1 VLAN are added without session to 
+         * detect conflicts with 1:1 VLAN sessions. */
+        memcpy(&vlan_key, &session->hot->vlan_key, sizeof(vlan_key));
+        search = hash64_insert(&g_ctx->vlan_session_table, vlan_key, &inserted);
+        if(!search) {
+            LOG(ERROR, "Failed to create session %u due to VLAN table allocation failure!\n", i);
+            return false;
+        }
         if(access_config->vlan_mode == VLAN_MODE_11) {
-            result = dict_insert(g_ctx->vlan_session_dict, &session->vlan_key);
-            if(result.inserted) {
-                *result.datum_ptr = session;
+            if(inserted) {
+                *search = session;
             } else {
                 LOG(ERROR, "Failed to create session %u due to VLAN conflict!\n", i);
                 return false;
             }
-        } else {
-            search = dict_search(g_ctx->vlan_session_dict, &session->vlan_key);
-            if(search) {
-                if(*search) {
-                    LOG(ERROR, "Failed to create session %u due to VLAN conflict!\n", i);
-                    return false;
-                }
-            } else {
-                result = dict_insert(g_ctx->vlan_session_dict, &session->vlan_key);
-                if(result.inserted) {
-                    *result.datum_ptr = NULL;
-                }
-            }
+        } else if(*search) {
+            LOG(ERROR, "Failed to create session %u due to VLAN conflict!\n", i);
+            return false;
         }
 
         /* Streams */
@@ -1179,6 +1140,11 @@ bbl_session_json(bbl_session_s *session)
     const char *dhcpv6_dns1 = NULL;
     const char *dhcpv6_dns2 = NULL;
 
+    char username[SUB_STR_LEN];
+    char aci[SUB_STR_LEN];
+    char ari[SUB_STR_LEN];
+    char vendor_class_id[SUB_STR_LEN];
+
     uint32_t seconds = 0;
     uint32_t dhcp_lease_expire = 0;
     uint32_t dhcp_lease_expire_t1 = 0;
@@ -1303,21 +1269,21 @@ bbl_session_json(bbl_session_s *session)
         l2tp_session = l2tp_session_json(session->l2tp_session);
     }
 
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         root = json_pack("{ss si ss ss* si si ss si si ss ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* sI sI si sI sI sI sI sI sI si si si si si si so* so* so*}",
             "type", "pppoe",
             "session-id", session->session_id,
-            "session-state", session_state_string(session->session_state),
+            "session-state", session_state_string(session->hot->session_state),
             "session-substate", bbl_session_substate_pppoe(session),
             "session-version", session->version,
             "flapped", session->stats.flapped,
-            "interface", session->access_interface->name,
-            "outer-vlan", session->vlan_key.outer_vlan_id,
-            "inner-vlan", session->vlan_key.inner_vlan_id,
-            "mac", format_mac_address(session->client_mac),
-            "username", session->username,
-            "agent-circuit-id", session->agent_circuit_id,
-            "agent-remote-id", session->agent_remote_id,
+            "interface", session->hot->access_interface->name,
+            "outer-vlan", session->hot->vlan_key.outer_vlan_id,
+            "inner-vlan", session->hot->vlan_key.inner_vlan_id,
+            "mac", format_mac_address(session->hot->client_mac),
+            "username", bbl_session_string(session, SESSION_STRING_USERNAME, username),
+            "agent-circuit-id", bbl_session_string(session, SESSION_STRING_ACI, aci),
+            "agent-remote-id", bbl_session_string(session, SESSION_STRING_ARI, ari),
             "reply-message", session->reply_message,
             "connection-status-message", session->connections_status_message,
             "lcp-state", ppp_state_string(session->lcp_state),
@@ -1334,10 +1300,10 @@ bbl_session_json(bbl_session_s *session)
             "dhcpv6-dns1", dhcpv6_dns1,
             "dhcpv6-dns2", dhcpv6_dns2,
             "tx-packets", session->stats.packets_tx,
-            "rx-packets", session->stats.packets_rx,
+            "rx-packets", session->hot->packets_rx,
             "rx-fragmented-packets", session->stats.ipv4_fragmented_rx,
             "tx-bytes", session->stats.bytes_tx,
-            "rx-bytes", session->stats.bytes_rx,
+            "rx-bytes", session->hot->bytes_rx,
             "tx-accounting-packets", session->stats.accounting_packets_tx,
             "rx-accounting-packets", session->stats.accounting_packets_rx,
             "tx-accounting-bytes", session->stats.accounting_bytes_tx,
@@ -1371,17 +1337,17 @@ bbl_session_json(bbl_session_s *session)
         root = json_pack("{ss si ss ss* si si ss si si ss ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* ss* si si si si si si si si si si si si ss* si si si si si si si si si si si si ss* ss* sI sI si sI sI sI sI sI sI si si si si si si si si so* so*}",
             "type", "ipoe",
             "session-id", session->session_id,
-            "session-state", session_state_string(session->session_state),
+            "session-state", session_state_string(session->hot->session_state),
             "session-substate", bbl_session_substate_ipoe(session),
             "session-version", session->version,
             "flapped", session->stats.flapped,
-            "interface", session->access_interface->name,
-            "outer-vlan", session->vlan_key.outer_vlan_id,
-            "inner-vlan", session->vlan_key.inner_vlan_id,
-            "mac", format_mac_address(session->client_mac),
-            "agent-circuit-id", session->agent_circuit_id,
-            "agent-remote-id", session->agent_remote_id,
-            "vendor-class-id", session->vendor_class_id,
+            "interface", session->hot->access_interface->name,
+            "outer-vlan", session->hot->vlan_key.outer_vlan_id,
+            "inner-vlan", session->hot->vlan_key.inner_vlan_id,
+            "mac", format_mac_address(session->hot->client_mac),
+            "agent-circuit-id", bbl_session_string(session, SESSION_STRING_ACI, aci),
+            "agent-remote-id", bbl_session_string(session, SESSION_STRING_ARI, ari),
+            "vendor-class-id", bbl_session_string(session, SESSION_STRING_VENDOR_CLASS_ID, vendor_class_id),
             "ipv4-address", ipv4,
             "ipv4-netmask", ipv4_netmask,
             "ipv4-gateway", ipv4_gw,
@@ -1421,10 +1387,10 @@ bbl_session_json(bbl_session_s *session)
             "dhcpv6-dns1", dhcpv6_dns1,
             "dhcpv6-dns2", dhcpv6_dns2,
             "tx-packets", session->stats.packets_tx,
-            "rx-packets", session->stats.packets_rx,
+            "rx-packets", session->hot->packets_rx,
             "rx-fragmented-packets", session->stats.ipv4_fragmented_rx,
             "tx-bytes", session->stats.bytes_tx,
-            "rx-bytes", session->stats.bytes_rx,
+            "rx-bytes", session->hot->bytes_rx,
             "tx-accounting-packets", session->stats.accounting_packets_tx,
             "rx-accounting-packets", session->stats.accounting_packets_rx,
             "tx-accounting-bytes", session->stats.accounting_bytes_tx,
@@ -1465,11 +1431,11 @@ bbl_session_ctrl_pending(int fd, uint32_t session_id __attribute__((unused)), js
         session = &g_ctx->session_list[i];
         if(!session) continue;
         
-        if(session->session_state != BBL_ESTABLISHED || 
+        if(session->hot->session_state != BBL_ESTABLISHED || 
            session->session_traffic.flows != session->session_traffic.flows_verified) {
             json_session = json_pack("{si ss si si}",
                                      "session-id", session->session_id,
-                                     "session-state", session_state_string(session->session_state),
+                                     "session-state", session_state_string(session->hot->session_state),
                                      "session-traffic-flows", session->session_traffic.flows,
                                      "session-traffic-flows-verified", session->session_traffic.flows_verified);
             json_array_append_new(json_sessions, json_session);
@@ -1595,7 +1561,7 @@ bbl_session_ctrl_stop_restart(int fd, uint32_t session_id, json_t *arguments, bo
         session = bbl_session_get(session_id);
         if(session) {
             if(restart) {
-                if(session->session_state == BBL_TERMINATED) {
+                if(session->hot->session_state == BBL_TERMINATED) {
                     bbl_session_start(session);
                 } else {
                     session->reconnect_disabled = false;
@@ -1620,7 +1586,7 @@ bbl_session_ctrl_stop_restart(int fd, uint32_t session_id, json_t *arguments, bo
                     continue;
                 }
                 if(restart) {
-                    if(session->session_state == BBL_TERMINATED) {
+                    if(session->hot->session_state == BBL_TERMINATED) {
                         bbl_session_start(session);
                     } else {
                         session->reconnect_disabled = false;
@@ -1709,7 +1675,7 @@ bbl_session_ctrl_ncp_open_close(int fd, uint32_t session_id, json_t *arguments,
     if(session_id) {
         session = bbl_session_get(session_id);
         if(session) {
-            if(session->access_type == ACCESS_TYPE_PPPOE) {
+            if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                 if(open) {
                     bbl_session_ncp_open(session, ipcp);
                 } else {
@@ -1730,7 +1696,7 @@ bbl_session_ctrl_ncp_open_close(int fd, uint32_t session_id, json_t *arguments,
                 /* Skip sessions with wrong session-group-id if present. */
                 continue;
             }
-            if(session->access_type == ACCESS_TYPE_PPPOE) {
+            if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                 if(open) {
                     bbl_session_ncp_open(session, ipcp);
                 } else {
@@ -1783,7 +1749,7 @@ bbl_session_ctrl_lcp_echo_request(int fd, uint32_t session_id, json_t *arguments
     if(session_id) {
         session = bbl_session_get(session_id);
         if(session) {
-            if(session->access_type == ACCESS_TYPE_PPPOE) {
+            if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                 session->lcp_echo_request_ignore = ignore;
             } else {
                 return bbl_ctrl_status(fd, "warning", 400, "matching session is not of type pppoe");
@@ -1800,7 +1766,7 @@ bbl_session_ctrl_lcp_echo_request(int fd, uint32_t session_id, json_t *arguments
                 /* Skip sessions with wrong session-group-id if present. */
                 continue;
             }
-            if(session->access_type == ACCESS_TYPE_PPPOE) {
+            if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
                 session->lcp_echo_request_ignore = ignore;
             }
         }
@@ -16,6 +16,34 @@ typedef struct vlan_session_key_ {
     uint16_t inner_vlan_id;
 } __attribute__ ((__packed__)) vlan_session_key_t;
 
+/*
+ * Session fields used to find and account sessions on RX, 
+ * stored in a compact array indexed by session identifier 
+ * (g_ctx->session_hot) separate from the session records. 
+ * Scans over all sessions (broadcast and multicast RX) and 
+ * RX accounting touch only one cache line per session.
+ */
+typedef struct bbl_session_hot_
+{
+    bbl_access_interface_s *access_interface; /* where this session is attached to */
+
+    struct {
+        uint32_t ifindex;
+        uint16_t outer_vlan_id;
+        uint16_t inner_vlan_id;
+    } vlan_key;
+
+    session_state_t session_state;
+    access_type_t access_type;
+
+    /* Ethernet */
+    uint8_t server_mac[ETH_ADDR_LEN];
+    uint8_t client_mac[ETH_ADDR_LEN];
+
+    uint64_t packets_rx;
+    uint64_t bytes_rx;
+} __attribute__((__aligned__(CACHE_LINE_SIZE))) bbl_session_hot_s;
+
 /*
  * Client Session to a BNG device
  */
@@ -24,7 +52,7 @@ typedef struct bbl_session_
     uint32_t session_id; /* BNG Blaster internal session identifier */
     uint16_t session_group_id;
 
-    session_state_t session_state;
+    bbl_session_hot_s *hot; /* RX hot fields */
     uint32_t send_requests;
     uint32_t version;
 
@@ -36,51 +64,18 @@ typedef struct bbl_session_
     CIRCLEQ_ENTRY(bbl_session_) session_a10nsp_tx_qnode;
 
     bbl_access_config_s *access_config;
-    bbl_access_interface_s *access_interface; /* where this session is attached to */
+    uint32_t access_config_session_id; /* per access config session identifier */
     bbl_network_interface_s *network_interface; /* selected network interface */
 
     uint8_t *write_buf; /* pointer to the slot in the tx_ring */
     uint16_t write_idx;
 
-    /* Session timer */
-    struct timer_ *timer_arp;
-    struct timer_ *timer_padi;
-    struct timer_ *timer_padr;
-    struct timer_ *timer_lcp;
-    struct timer_ *timer_lcp_echo;
-    struct timer_ *timer_auth;
-    struct timer_ *timer_ipcp;
-    struct timer_ *timer_ip6cp;
-    struct timer_ *timer_dhcp_retry;
-    struct timer_ *timer_dhcp_t1;
-    struct timer_ *timer_dhcp_t2;
-    struct timer_ *timer_dhcpv6;
-    struct timer_ *timer_dhcpv6_t1;
-    struct timer_ *timer_dhcpv6_t2;
-    struct timer_ *timer_igmp;
-    struct timer_ *timer_zapping;
-    struct timer_ *timer_icmpv6;
-    struct timer_ *timer_session;
-    struct timer_ *timer_rate;
-    struct timer_ *timer_cfm_cc;
-    struct timer_ *timer_reconnect;
-    struct timer_ *timer_monkey;
-    struct timer_ *timer_tun;
-
-    access_type_t access_type;
-
     struct {
         endpoint_state_t ipv4;
         endpoint_state_t ipv6;
         endpoint_state_t ipv6pd;
     } endpoint;
 
-    struct {
-        uint32_t ifindex;
-        uint16_t outer_vlan_id;
-        uint16_t inner_vlan_id;
-    } vlan_key;
-
     uint16_t access_third_vlan;
 
     int tun_fd;
@@ -95,10 +90,6 @@ typedef struct bbl_session_
     bbl_a10nsp_session_s *a10nsp_session;
     bbl_a10nsp_interface_s *a10nsp_interface; /* a10nsp interface */
 
-    /* Authentication */
-    char *username;
-    char *password;
-
     /* Optional reconnect delay in seconds */
     uint32_t reconnect_delay;
     bool reconnect_disabled;
@@ -107,10 +98,6 @@ typedef struct bbl_session_
     uint8_t chap_response[CHALLENGE_LEN];
 
     /* Access Line */
-    char *agent_circuit_id;
-    char *agent_remote_id;
-    char *access_aggregation_circuit_id;
-    char *vendor_class_id;
     uint32_t rate_up;
     uint32_t rate_down;
     uint32_t dsl_type;
@@ -125,11 +112,34 @@ typedef struct bbl_session_
 
     /* TCP */
     bbl_http_client_s *http_client;
-    struct netif netif; /* LwIP interface */
+    bool tcp; /* LwIP enabled */
+    uint16_t tcp_port; /* next local TCP port */
+    bbl_tcp_ctx_s *tcp_ctx; /* TCP contexts (RX demux) */
     
-    /* Ethernet */
-    uint8_t server_mac[ETH_ADDR_LEN];
-    uint8_t client_mac[ETH_ADDR_LEN];
+    /* Session timer */
+    struct timer_ *timer_arp;
+    struct timer_ *timer_padi;
+    struct timer_ *timer_padr;
+    struct timer_ *timer_lcp;
+    struct timer_ *timer_lcp_echo;
+    struct timer_ *timer_auth;
+    struct timer_ *timer_ipcp;
+    struct timer_ *timer_ip6cp;
+    struct timer_ *timer_dhcp_retry;
+    struct timer_ *timer_dhcp_t1;
+    struct timer_ *timer_dhcp_t2;
+    struct timer_ *timer_dhcpv6;
+    struct timer_ *timer_dhcpv6_t1;
+    struct timer_ *timer_dhcpv6_t2;
+    struct timer_ *timer_igmp;
+    struct timer_ *timer_zapping;
+    struct timer_ *timer_icmpv6;
+    struct timer_ *timer_session;
+    struct timer_ *timer_rate;
+    struct timer_ *timer_cfm_cc;
+    struct timer_ *timer_reconnect;
+    struct timer_ *timer_monkey;
+    struct timer_ *timer_tun;
 
     /* CFM */
     bool cfm_cc;
@@ -137,7 +147,6 @@ typedef struct bbl_session_
     uint32_t cfm_seq;
     uint8_t cfm_level;
     uint16_t cfm_ma_id;
-    char *cfm_ma_name;
 
     /* PPPoE */
     uint16_t pppoe_session_id;
@@ -235,9 +244,7 @@ typedef struct bbl_session_
     bool dhcpv6_requested;
     bool dhcpv6_established;
     uint8_t dhcpv6_retry;
-    uint8_t dhcpv6_duid[DUID_LEN];
-    uint8_t dhcpv6_server_duid[DHCPV6_BUFFER];
-    uint8_t dhcpv6_server_duid_len;
+    bbl_dhcpv6_session_s *dhcpv6;
     ipv6addr_t dhcpv6_dns1;
     ipv6addr_t dhcpv6_dns2;
     uint32_t dhcpv6_xid;
@@ -246,10 +253,6 @@ typedef struct bbl_session_
     uint32_t dhcpv6_t2;
     uint32_t dhcpv6_ia_na_iaid;
     uint32_t dhcpv6_ia_pd_iaid;
-    uint8_t dhcpv6_ia_na_option[DHCPV6_BUFFER];
-    uint8_t dhcpv6_ia_na_option_len;
-    uint8_t dhcpv6_ia_pd_option[DHCPV6_BUFFER];
-    uint8_t dhcpv6_ia_pd_option_len;
     struct timespec dhcpv6_lease_timestamp;
     struct timespec dhcpv6_request_timestamp;
 
@@ -257,21 +260,7 @@ typedef struct bbl_session_
     bool     igmp_autostart;
     uint8_t  igmp_version;
     uint8_t  igmp_robustness;
-    bbl_igmp_group_s igmp_groups[IGMP_MAX_GROUPS];
-
-    /* IGMP Zapping */
-    bbl_igmp_group_s *zapping_joined_group;
-    bbl_igmp_group_s *zapping_leaved_group;
-    uint32_t zapping_group_max;
-    uint8_t  zapping_count;
-    uint64_t zapping_join_delay_sum;
-    uint32_t zapping_join_count;
-    uint64_t zapping_leave_delay_sum;
-    uint32_t zapping_leave_count;
-    struct timespec zapping_view_start_time;
-
-    /* Multicast Traffic */
-    uint64_t mc_rx_last_seq;
+    bbl_igmp_session_s *igmp;
 
     struct {
         uint16_t group_id;
@@ -291,11 +280,9 @@ typedef struct bbl_session_
 
     struct {
         uint64_t packets_tx;
-        uint64_t packets_rx;
         bbl_rate_s rate_packets_tx;
         bbl_rate_s rate_packets_rx;
         uint64_t bytes_tx;
-        uint64_t bytes_rx;
         bbl_rate_s rate_bytes_tx;
         bbl_rate_s rate_bytes_rx;
 
@@ -376,18 +363,42 @@ bbl_session_ncp_open(bbl_session_s *session, bool ipcp);
 void
 bbl_session_ncp_close(bbl_session_s *session, bool ipcp);
 
+bool
+bbl_session_id_init();
+
+bool
+bbl_session_id_add(bbl_session_s *session);
+
 bbl_session_s *
 bbl_session_get(uint32_t session_id);
 
+bbl_session_s *
+bbl_session_get_by_vlan(vlan_session_key_t *key);
+
+bbl_session_s *
+bbl_session_get_by_mac(bbl_access_interface_s *interface, const uint8_t *mac);
+
+char *
+bbl_session_string(bbl_session_s *session, session_string_t id, char *buf);
+
 void
 bbl_session_free(bbl_session_s *session);
 
 void
 bbl_session_update_state(bbl_session_s *session, session_state_t state);
 
+void
+bbl_session_version_update(bbl_session_s *session);
+
 void
 bbl_session_clear(bbl_session_s *session);
 
+bool
+bbl_session_templates_compile(bbl_access_config_s *access_config);
+
+void
+bbl_session_templates_free(bbl_access_config_s *access_config);
+
 bool
 bbl_sessions_init();
 
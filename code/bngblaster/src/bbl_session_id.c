@@ -0,0 +1,168 @@
+/*
+ * BNG Blaster (BBL) - Session Identifier
+ *
+ * The session-id is mapped into the client MAC address,
+ * which allows to recover the session from received
+ * packets with a direct index.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+#include "bbl_session.h"
+
+/**
+ * bbl_session_id_init
+ *
+ * Init session-id space.
+ *
+ * @return true if successful
+ */
+bool
+bbl_session_id_init()
+{
+    g_ctx->session_id_mask = (uint32_t)((1ULL << g_ctx->config.session_id_bits) - 1);
+    if(g_ctx->config.session_id_interface) {
+        g_ctx->access_interface_index = calloc(BBL_SESSION_ID_INTERFACES, sizeof(bbl_access_interface_s*));
+        if(!g_ctx->access_interface_index) {
+            return false;
+        }
+    } else if(g_ctx->config.sessions > g_ctx->session_id_mask) {
+        LOG(ERROR, "Failed to create %u sessions with %u session-id bits (max %u)\n",
+            g_ctx->config.sessions, g_ctx->config.session_id_bits, g_ctx->session_id_mask);
+        return false;
+    }
+    if(g_ctx->config.session_id_bits > BBL_SESSION_ID_BITS &&
+       g_ctx->config.mac_modifier & (g_ctx->session_id_mask >> 24)) {
+        LOG(INFO, "MAC modifier bits %#x are used for session-id\n",
+            (uint8_t)(g_ctx->session_id_mask >> 24));
+    }
+    return true;
+}
+
+/**
+ * bbl_session_id_interface_add
+ *
+ * Add session to the session-id space
+ * of its access interface.
+ *
+ * @param session session
+ * @return interface session-id or 0 if failed
+ */
+static uint32_t
+bbl_session_id_interface_add(bbl_session_s *session)
+{
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
+    bbl_session_s **session_list;
+    uint32_t size;
+
+    if(!access_interface->session_list_size) {
+        if(g_ctx->access_interfaces >= BBL_SESSION_ID_INTERFACES) {
+            LOG(ERROR, "Failed to add access interface %s to session-id index (limit %u)\n",
+                access_interface->name, BBL_SESSION_ID_INTERFACES);
+            return 0;
+        }
+        access_interface->index = g_ctx->access_interfaces++;
+        g_ctx->access_interface_index[access_interface->index] = access_interface;
+    }
+    if(access_interface->sessions == access_interface->session_list_size) {
+        size = access_interface->session_list_size ? access_interface->session_list_size * 2 : 1024;
+        session_list = realloc(access_interface->session_list, size * sizeof(bbl_session_s*));
+        if(!session_list) {
+            return 0;
+        }
+        access_interface->session_list = session_list;
+        access_interface->session_list_size = size;
+    }
+    access_interface->session_list[access_interface->sessions++] = session;
+    return access_interface->sessions;
+}
+
+/**
+ * bbl_session_id_add
+ *
+ * Assign the session-id of the session and
+ * map it into the client MAC address.
+ *
+ * @param session session with session_id
+ * and access_interface set
+ * @return true if successful
+ */
+bool
+bbl_session_id_add(bbl_session_s *session)
+{
+    uint32_t session_id = session->session_id;
+
+    /* Set client OUI to locally administered */
+    session->hot->client_mac[0] = 0x02;
+    session->hot->client_mac[1] = 0x00;
+    if(g_ctx->config.session_id_interface) {
+        session_id = bbl_session_id_interface_add(session);
+        if(!session_id || session_id > g_ctx->session_id_mask) {
+            LOG(ERROR, "Failed to create session %u due to exhausted session-id space on interface %s!\n",
+                session->session_id, session->hot->access_interface->name);
+            return false;
+        }
+        session->hot->client_mac[1] = session->hot->access_interface->index;
+    }
+    /* Use session identifier for remaining bytes,
+     * the MAC modifier bits not used for the
+     * session identifier are kept. */
+    session_id |= ((uint32_t)g_ctx->config.mac_modifier << 24) & ~g_ctx->session_id_mask;
+    session->hot->client_mac[2] = session_id>>24;
+    session->hot->client_mac[3] = session_id>>16;
+    session->hot->client_mac[4] = session_id>>8;
+    session->hot->client_mac[5] = session_id;
+    return true;
+}
+
+/**
+ * bbl_session_get
+ *
+ * @param session_id session-id
+ * @return session or NULL if session not found
+ */
+bbl_session_s *
+bbl_session_get(uint32_t session_id)
+{
+    if(session_id > g_ctx->sessions || session_id < 1) {
+        return NULL;
+    }
+    return &g_ctx->session_list[session_id-1];
+}
+
+/**
+ * bbl_session_get_by_mac
+ *
+ * The session-id is mapped into the last 3 bytes (or 
+ * up to 4 bytes with sessions->id-bits) of the client 
+ * MAC address. With session-id scope interface, this
+ * session-id is unique per access interface only and
+ * MAC byte 1 holds the access interface index. 
+ *
+ * @param interface receiving access interface or NULL
+ * to select the access interface from the client MAC
+ * @param mac client MAC address
+ * @return session or NULL if session not found
+ */
+bbl_session_s *
+bbl_session_get_by_mac(bbl_access_interface_s *interface, const uint8_t *mac)
+{
+    uint32_t session_id;
+
+    memcpy(&session_id, mac+2, sizeof(session_id));
+    session_id = be32toh(session_id) & g_ctx->session_id_mask;
+
+    if(g_ctx->config.session_id_interface) {
+        if(!interface) {
+            interface = g_ctx->access_interface_index[mac[1]];
+            if(!interface) return NULL;
+        }
+        /* Session-id 0 wraps around and fails the range check. */
+        if(session_id-1 >= interface->sessions) {
+            return NULL;
+        }
+        return interface->session_list[session_id-1];
+    }
+    return bbl_session_get(session_id);
+}
@@ -0,0 +1,219 @@
+/*
+ * BNG Blaster (BBL) - Session Strings
+ *
+ * Session strings (username, ACI, ...) are compiled once
+ * per access configuration and rendered on demand.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+#include "bbl_session.h"
+
+static const char *g_session_var_names[] = {
+    [SESSION_VAR_SESSION_GLOBAL] = "{session-global}",
+    [SESSION_VAR_SESSION] = "{session}",
+    [SESSION_VAR_I1] = "{i1}",
+    [SESSION_VAR_I2] = "{i2}",
+    [SESSION_VAR_OUTER_VLAN] = "{outer-vlan}",
+    [SESSION_VAR_INNER_VLAN] = "{inner-vlan}",
+};
+
+static size_t
+bbl_session_string_uint(char *buf, size_t size, uint32_t value)
+{
+    char digits[10];
+    size_t len = 0;
+    size_t i = 0;
+
+    do {
+        digits[i++] = '0' + (value % 10);
+        value /= 10;
+    } while(value);
+
+    while(i && len < size) {
+        buf[len++] = digits[--i];
+    }
+    return len;
+}
+
+/**
+ * bbl_session_string
+ *
+ * Render session string (username, ACI, ...) from the
+ * template compiled for the access configuration. 
+ *
+ * @param session session
+ * @param id session string identifier
+ * @param buf buffer of at least SUB_STR_LEN bytes
+ * @return string (buf or the template itself if 
+ * without variables) or NULL if not configured
+ */
+char *
+bbl_session_string(bbl_session_s *session, session_string_t id, char *buf)
+{
+    bbl_access_config_s *access_config = session->access_config;
+    bbl_session_template_s *template;
+    bbl_session_template_token_s *token;
+
+    uint32_t value;
+    size_t len = 0;
+    size_t size = SUB_STR_LEN-1;
+    size_t c;
+    uint16_t i;
+
+    if(!access_config || id >= SESSION_STRING_MAX) {
+        return NULL;
+    }
+    template = &access_config->string[id];
+    if(!template->source) {
+        return NULL;
+    }
+    if(template->literal) {
+        return (char*)template->source;
+    }
+
+    for(i = 0; i < template->tokens; i++) {
+        token = &template->token[i];
+        switch(token->var) {
+            case SESSION_VAR_SESSION_GLOBAL:
+                value = session->session_id;
+                break;
+            case SESSION_VAR_SESSION:
+                value = session->access_config_session_id;
+                break;
+            case SESSION_VAR_I1:
+                value = access_config->i1 + ((session->access_config_session_id-1) * access_config->i1_step);
+                break;
+            case SESSION_VAR_I2:
+                value = access_config->i2 + ((session->access_config_session_id-1) * access_config->i2_step);
+                break;
+            case SESSION_VAR_OUTER_VLAN:
+                value = session->hot->vlan_key.outer_vlan_id;
+                break;
+            case SESSION_VAR_INNER_VLAN:
+                value = session->hot->vlan_key.inner_vlan_id;
+                break;
+            default:
+                c = token->len;
+                if(c > size - len) c = size - len;
+                memcpy(buf+len, token->literal, c);
+                len += c;
+                continue;
+        }
+        len += bbl_session_string_uint(buf+len, size - len, value);
+    }
+    buf[len] = 0;
+    return buf;
+}
+
+static bool
+bbl_session_template_compile(bbl_session_template_s *template, const char *source)
+{
+    bbl_session_template_token_s *token;
+    const char *cur = source;
+    const char *literal = source;
+    size_t len = 0;
+    int var;
+
+    template->source = source;
+    if(!source) {
+        return true;
+    }
+    if(!strchr(source, '{')) {
+        template->literal = true;
+        return true;
+    }
+
+    /* Each variable adds at most one literal and one variable 
+     * token, so the source length is an upper bound. */
+    template->token = calloc(strlen(source)+1, sizeof(bbl_session_template_token_s));
+    if(!template->token) {
+        return false;
+    }
+    while(*cur) {
+        var = SESSION_VAR_LITERAL;
+        if(*cur == '{') {
+            for(var = SESSION_VAR_SESSION_GLOBAL; var <= SESSION_VAR_INNER_VLAN; var++) {
+                len = strlen(g_session_var_names[var]);
+                if(strncmp(cur, g_session_var_names[var], len) == 0) {
+                    break;
+                }
+            }
+            if(var > SESSION_VAR_INNER_VLAN) {
+                var = SESSION_VAR_LITERAL;
+            }
+        }
+        if(var == SESSION_VAR_LITERAL) {
+            cur++;
+            continue;
+        }
+        if(cur > literal) {
+            token = &template->token[template->tokens++];
+            token->var = SESSION_VAR_LITERAL;
+            token->literal = literal;
+            token->len = cur - literal;
+        }
+        token = &template->token[template->tokens++];
+        token->var = var;
+        cur += len;
+        literal = cur;
+    }
+    if(cur > literal) {
+        token = &template->token[template->tokens++];
+        token->var = SESSION_VAR_LITERAL;
+        token->literal = literal;
+        token->len = cur - literal;
+    }
+    return true;
+}
+
+/**
+ * bbl_session_templates_compile
+ *
+ * Compile session strings of access configuration into 
+ * token lists which are rendered on demand per session, 
+ * see bbl_session_string.
+ *
+ * @param access_config access configuration
+ * @return true if successful
+ */
+bool
+bbl_session_templates_compile(bbl_access_config_s *access_config)
+{
+    const char *source[SESSION_STRING_MAX] = {
+        [SESSION_STRING_USERNAME] = access_config->username,
+        [SESSION_STRING_PASSWORD] = access_config->password,
+        [SESSION_STRING_ACI] = access_config->agent_circuit_id,
+        [SESSION_STRING_ARI] = access_config->agent_remote_id,
+        [SESSION_STRING_AACI] = access_config->access_aggregation_circuit_id,
+        [SESSION_STRING_VENDOR_CLASS_ID] = access_config->vendor_class_id,
+        [SESSION_STRING_CFM_MA_NAME] = access_config->cfm_ma_name,
+    };
+    int id;
+
+    for(id = 0; id < SESSION_STRING_MAX; id++) {
+        if(!bbl_session_template_compile(&access_config->string[id], source[id])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * bbl_session_templates_free
+ *
+ * @param access_config access configuration
+ */
+void
+bbl_session_templates_free(bbl_access_config_s *access_config)
+{
+    int id;
+
+    for(id = 0; id < SESSION_STRING_MAX; id++) {
+        if(access_config->string[id].token) {
+            free(access_config->string[id].token);
+        }
+        memset(&access_config->string[id], 0x0, sizeof(bbl_session_template_s));
+    }
+}
@@ -115,15 +115,19 @@ bbl_stats_generate_multicast(bbl_stats_s *stats, bool reset)
             stats->join_delay_violations_1s += session->stats.join_delay_violations_1s;
             stats->join_delay_violations_2s += session->stats.join_delay_violations_2s;
 
-            stats->zapping_join_count += session->zapping_join_count;
-            stats->zapping_leave_count += session->zapping_leave_count;
+            if(session->igmp) {
+                stats->zapping_join_count += session->igmp->zapping_join_count;
+                stats->zapping_leave_count += session->igmp->zapping_leave_count;
+            }
 
             if(reset) {
-                session->zapping_count = 0;
-                session->zapping_join_delay_sum = 0;
-                session->zapping_join_count = 0;
-                session->zapping_leave_delay_sum = 0;
-                session->zapping_leave_count = 0;
+                if(session->igmp) {
+                    session->igmp->zapping_count = 0;
+                    session->igmp->zapping_join_delay_sum = 0;
+                    session->igmp->zapping_join_count = 0;
+                    session->igmp->zapping_leave_delay_sum = 0;
+                    session->igmp->zapping_leave_count = 0;
+                }
                 session->stats.min_join_delay = 0;
                 session->stats.avg_join_delay = 0;
                 session->stats.max_join_delay = 0;
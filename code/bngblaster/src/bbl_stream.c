@@ -6,6 +6,7 @@
  * Copyright (C) 2020-2025, RtBrick, Inc.
  * SPDX-License-Identifier: BSD-3-Clause
  */
+#include <fcntl.h>
 #include "bbl.h"
 #include "bbl_session.h"
 #include "bbl_stream.h"
@@ -58,16 +59,48 @@ bbl_stream_index_init()
     return true;
 }
 
+/**
+ * bbl_stream_delay
+ *
+ * Update stream delay statistics, the optional delay 
+ * histogram and the interarrival jitter estimate as 
+ * defined in RFC 3550 section 6.4.1, with jitter kept 
+ * scaled by 16 to allow integer arithmetic. 
+ *
+ * @param stream stream
+ * @param rx_timestamp RX timestamp
+ * @param bbl_timestamp TX timestamp (BBL header)
+ */
 static void
 bbl_stream_delay(bbl_stream_s *stream, struct timespec *rx_timestamp, struct timespec *bbl_timestamp)
 {
     struct timespec delay;
     uint64_t delay_us;
+    int64_t transit;
+    int64_t d;
+
     timespec_sub(&delay, rx_timestamp, bbl_timestamp);
-    
+
+    transit = (delay.tv_sec * SEC) + delay.tv_nsec;
+    if(stream->rx_transit_ns) {
+        d = transit - stream->rx_transit_ns;
+        if(d < 0) d = -d;
+        stream->rx_jitter += d - ((stream->rx_jitter + 8) >> 4);
+    }
+    stream->rx_transit_ns = transit ? transit : 1;
+
     delay_us = (delay.tv_sec * 1000000) + (delay.tv_nsec / 1000);
     if(delay_us == 0) delay_us = 1;
 
+    if(g_ctx->config.stream_delay_hist) {
+        if(unlikely(!stream->rx_delay_hist)) {
+            stream->rx_delay_hist = calloc(1, sizeof(hist_s));
+        }
+        if(likely(stream->rx_delay_hist != NULL)) {
+            hist_add(stream->rx_delay_hist, delay_us);
+        }
+    }
+
     if(delay_us > stream->rx_max_delay_us) {
         stream->rx_max_delay_us = delay_us;
     }
@@ -81,7 +114,7 @@ bbl_stream_delay(bbl_stream_s *stream, struct timespec *rx_timestamp, struct tim
 }
 
 static bool
-bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream)
+bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
@@ -113,12 +146,12 @@ bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream)
         return false;
     }
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
     eth.vlan_outer_priority = config->vlan_priority;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_inner_priority = config->vlan_inner_priority;
     eth.vlan_three = session->access_third_vlan;
     eth.type = ETH_TYPE_PPPOE_SESSION;
@@ -131,9 +164,9 @@ bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream)
     bbl.type = stream->type;
     bbl.sub_type = stream->sub_type;
     bbl.session_id = session->session_id;
-    bbl.ifindex = session->vlan_key.ifindex;
-    bbl.outer_vlan_id = session->vlan_key.outer_vlan_id;
-    bbl.inner_vlan_id = session->vlan_key.inner_vlan_id;
+    bbl.ifindex = session->hot->vlan_key.ifindex;
+    bbl.outer_vlan_id = session->hot->vlan_key.outer_vlan_id;
+    bbl.inner_vlan_id = session->hot->vlan_key.inner_vlan_id;
     bbl.flow_id = stream->flow_id;
     bbl.tos = config->priority;
     bbl.direction = BBL_DIRECTION_UP;
@@ -216,23 +249,21 @@ bbl_stream_build_access_pppoe_packet(bbl_stream_s *stream)
 
     buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
     if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
-    stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
+    packet->buf = malloc(buf_len);
+    packet->bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
-    if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+    if(encode_ethernet(packet->buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
         return false;
     }
-    stream->tx_len = tx_len;
+    packet->len = tx_len;
     return true;
 }
 
 static bool
-bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
+bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     bbl_session_s *session = stream->session;
     bbl_a10nsp_session_s *a10nsp_session = session->a10nsp_session;
@@ -256,16 +287,16 @@ bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
 
     if(stream->direction == BBL_DIRECTION_UP) {
         bbl.direction = BBL_DIRECTION_UP;
-        eth.dst = session->server_mac;
-        eth.src = session->client_mac;
+        eth.dst = session->hot->server_mac;
+        eth.src = session->hot->client_mac;
         eth.qinq = session->access_config->qinq;
-        eth.vlan_outer = session->vlan_key.outer_vlan_id;
+        eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
         udp.src = config->src_port;
         udp.dst = config->dst_port;
     } else {
         bbl.direction = BBL_DIRECTION_DOWN;
-        eth.dst = session->client_mac;
-        eth.src = session->server_mac;
+        eth.dst = session->hot->client_mac;
+        eth.src = session->hot->server_mac;
         eth.qinq = a10nsp_interface->qinq;
         eth.vlan_outer = a10nsp_session->s_vlan;
         if(stream->reverse) {
@@ -276,7 +307,7 @@ bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
             udp.dst = config->dst_port;
         }
     }
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = config->vlan_priority;
     eth.vlan_inner_priority = config->vlan_inner_priority;
@@ -288,9 +319,9 @@ bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
     bbl.type = stream->type;
     bbl.sub_type = stream->sub_type;
     bbl.session_id = session->session_id;
-    bbl.ifindex = session->vlan_key.ifindex;
-    bbl.outer_vlan_id = session->vlan_key.outer_vlan_id;
-    bbl.inner_vlan_id = session->vlan_key.inner_vlan_id;
+    bbl.ifindex = session->hot->vlan_key.ifindex;
+    bbl.outer_vlan_id = session->hot->vlan_key.outer_vlan_id;
+    bbl.inner_vlan_id = session->hot->vlan_key.inner_vlan_id;
     bbl.flow_id = stream->flow_id;
     bbl.tos = config->priority;
     switch(stream->sub_type) {
@@ -355,23 +386,21 @@ bbl_stream_build_a10nsp_pppoe_packet(bbl_stream_s *stream)
 
     buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
     if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
-    stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
+    packet->buf = malloc(buf_len);
+    packet->bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
-    if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+    if(encode_ethernet(packet->buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
         return false;
     }
-    stream->tx_len = tx_len;
+    packet->len = tx_len;
     return true;
 }
 
 static bool
-bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
+bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     bbl_session_s *session = stream->session;
     bbl_a10nsp_session_s *a10nsp_session = session->a10nsp_session;
@@ -394,16 +423,16 @@ bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
 
     if(stream->direction == BBL_DIRECTION_UP) {
         bbl.direction = BBL_DIRECTION_UP;
-        eth.dst = session->server_mac;
-        eth.src = session->client_mac;
+        eth.dst = session->hot->server_mac;
+        eth.src = session->hot->client_mac;
         eth.qinq = session->access_config->qinq;
-        eth.vlan_outer = session->vlan_key.outer_vlan_id;
+        eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
         udp.src = config->src_port;
         udp.dst = config->dst_port;
     } else {
         bbl.direction = BBL_DIRECTION_DOWN;
-        eth.dst = session->client_mac;
-        eth.src = session->server_mac;
+        eth.dst = session->hot->client_mac;
+        eth.src = session->hot->server_mac;
         eth.qinq = a10nsp_interface->qinq;
         eth.vlan_outer = a10nsp_session->s_vlan;
         if(stream->reverse) {
@@ -414,7 +443,7 @@ bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
             udp.dst = config->dst_port;
         }
     }
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = config->vlan_priority;
     eth.vlan_inner_priority = config->vlan_inner_priority;
@@ -423,9 +452,9 @@ bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
     bbl.type = stream->type;
     bbl.sub_type = stream->sub_type;
     bbl.session_id = session->session_id;
-    bbl.ifindex = session->vlan_key.ifindex;
-    bbl.outer_vlan_id = session->vlan_key.outer_vlan_id;
-    bbl.inner_vlan_id = session->vlan_key.inner_vlan_id;
+    bbl.ifindex = session->hot->vlan_key.ifindex;
+    bbl.outer_vlan_id = session->hot->vlan_key.outer_vlan_id;
+    bbl.inner_vlan_id = session->hot->vlan_key.inner_vlan_id;
     bbl.flow_id = stream->flow_id;
     bbl.tos = config->priority;
     switch(stream->sub_type) {
@@ -490,23 +519,21 @@ bbl_stream_build_a10nsp_ipoe_packet(bbl_stream_s *stream)
 
     buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
     if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
-    stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
+    packet->buf = malloc(buf_len);
+    packet->bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
-    if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+    if(encode_ethernet(packet->buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
         return false;
     }
-    stream->tx_len = tx_len;
+    packet->len = tx_len;
     return true;
 }
 
 static bool
-bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream)
+bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
@@ -537,11 +564,11 @@ bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream)
         return false;
     }
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = config->vlan_priority;
     eth.vlan_inner_priority = config->vlan_inner_priority;
@@ -553,9 +580,9 @@ bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream)
     bbl.type = stream->type;
     bbl.sub_type = stream->sub_type;
     bbl.session_id = session->session_id;
-    bbl.ifindex = session->vlan_key.ifindex;
-    bbl.outer_vlan_id = session->vlan_key.outer_vlan_id;
-    bbl.inner_vlan_id = session->vlan_key.inner_vlan_id;
+    bbl.ifindex = session->hot->vlan_key.ifindex;
+    bbl.outer_vlan_id = session->hot->vlan_key.outer_vlan_id;
+    bbl.inner_vlan_id = session->hot->vlan_key.inner_vlan_id;
     bbl.flow_id = stream->flow_id;
     bbl.tos = config->priority;
     bbl.direction = BBL_DIRECTION_UP;
@@ -636,23 +663,21 @@ bbl_stream_build_access_ipoe_packet(bbl_stream_s *stream)
 
     buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
     if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
-    stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
+    packet->buf = malloc(buf_len);
+    packet->bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
-    if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+    if(encode_ethernet(packet->buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
         return false;
     }
-    stream->tx_len = tx_len;
+    packet->len = tx_len;
     return true;
 }
 
 static bool
-bbl_stream_build_network_packet(bbl_stream_s *stream)
+bbl_stream_build_network_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
@@ -714,9 +739,9 @@ bbl_stream_build_network_packet(bbl_stream_s *stream)
     bbl.sub_type = stream->sub_type;
     if(session) {
         bbl.session_id = session->session_id;
-        bbl.ifindex = session->vlan_key.ifindex;
-        bbl.outer_vlan_id = session->vlan_key.outer_vlan_id;
-        bbl.inner_vlan_id = session->vlan_key.inner_vlan_id;
+        bbl.ifindex = session->hot->vlan_key.ifindex;
+        bbl.outer_vlan_id = session->hot->vlan_key.outer_vlan_id;
+        bbl.inner_vlan_id = session->hot->vlan_key.inner_vlan_id;
     }
     bbl.flow_id = stream->flow_id;
     bbl.tos = config->priority;
@@ -741,9 +766,9 @@ bbl_stream_build_network_packet(bbl_stream_s *stream)
             } else {
                 if(session) {
                     ipv4.dst = session->ip_address;
-                    if(session->access_type == ACCESS_TYPE_IPOE && 
+                    if(session->hot->access_type == ACCESS_TYPE_IPOE && 
                        ipv4_addr_in_network(ipv4.dst, &network_interface->ip)) {
-                        eth.dst = session->client_mac;       
+                        eth.dst = session->hot->client_mac;       
                     }
                 } else {
                     return false;
@@ -813,23 +838,21 @@ bbl_stream_build_network_packet(bbl_stream_s *stream)
 
     buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
     if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
-    stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
+    packet->buf = malloc(buf_len);
+    packet->bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
     stream->ipv6_src = ipv6.src;
     stream->ipv6_dst = ipv6.dst;
-    if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+    if(encode_ethernet(packet->buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
         return false;
     }
-    stream->tx_len = tx_len;
+    packet->len = tx_len;
     return true;
 }
 
 static bool
-bbl_stream_build_l2tp_packet(bbl_stream_s *stream)
+bbl_stream_build_l2tp_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     bbl_session_s *session = stream->session;
     bbl_stream_config_s *config = stream->config;
@@ -902,9 +925,9 @@ bbl_stream_build_l2tp_packet(bbl_stream_s *stream)
     bbl.type = BBL_TYPE_UNICAST;
     bbl.sub_type = BBL_SUB_TYPE_IPV4;
     bbl.session_id = session->session_id;
-    bbl.ifindex = session->vlan_key.ifindex;
-    bbl.outer_vlan_id = session->vlan_key.outer_vlan_id;
-    bbl.inner_vlan_id = session->vlan_key.inner_vlan_id;
+    bbl.ifindex = session->hot->vlan_key.ifindex;
+    bbl.outer_vlan_id = session->hot->vlan_key.outer_vlan_id;
+    bbl.inner_vlan_id = session->hot->vlan_key.inner_vlan_id;
     bbl.flow_id = stream->flow_id;
     bbl.tos = config->priority;
     bbl.direction = BBL_DIRECTION_DOWN;
@@ -913,58 +936,56 @@ bbl_stream_build_l2tp_packet(bbl_stream_s *stream)
     }
     buf_len = config->length + BBL_MAX_STREAM_OVERHEAD;
     if(buf_len < 256) buf_len = 256;
-    stream->tx_buf = malloc(buf_len);
-    stream->tx_bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
+    packet->buf = malloc(buf_len);
+    packet->bbl_hdr_len = bbl.padding+BBL_HEADER_LEN;
     stream->ipv4_src = ipv4.src;
     stream->ipv4_dst = ipv4.dst;
-    if(encode_ethernet(stream->tx_buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+    if(encode_ethernet(packet->buf, &tx_len, &eth) != PROTOCOL_SUCCESS) {
         return false;
     }
-    stream->tx_len = tx_len;
+    packet->len = tx_len;
     return true;
 }
 
 static bool
-bbl_stream_build_packet(bbl_stream_s *stream)
+bbl_stream_build_packet(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
     if(stream->config->stream_group_id == 0) {
         /* RAW stream */
-        return bbl_stream_build_network_packet(stream);
+        return bbl_stream_build_network_packet(stream, packet);
     }
     if(stream->session) {
-        if(stream->session->access_type == ACCESS_TYPE_PPPOE) {
+        if(stream->session->hot->access_type == ACCESS_TYPE_PPPOE) {
             if(stream->session->l2tp_session) {
                 if(stream->direction == BBL_DIRECTION_UP) {
-                    return bbl_stream_build_access_pppoe_packet(stream);
+                    return bbl_stream_build_access_pppoe_packet(stream, packet);
                 } else {
-                    return bbl_stream_build_l2tp_packet(stream);
+                    return bbl_stream_build_l2tp_packet(stream, packet);
                 }
             } else if(stream->session->a10nsp_session) {
-                return bbl_stream_build_a10nsp_pppoe_packet(stream);
+                return bbl_stream_build_a10nsp_pppoe_packet(stream, packet);
             } else {
                 switch(stream->sub_type) {
                     case BBL_SUB_TYPE_IPV4:
                     case BBL_SUB_TYPE_IPV6:
                     case BBL_SUB_TYPE_IPV6PD:
                         if(stream->direction == BBL_DIRECTION_UP) {
-                            return bbl_stream_build_access_pppoe_packet(stream);
+                            return bbl_stream_build_access_pppoe_packet(stream, packet);
                         } else {
-                            return bbl_stream_build_network_packet(stream);
+                            return bbl_stream_build_network_packet(stream, packet);
                         }
                     default:
                         break;
                 }
             }
-        } else if(stream->session->access_type == ACCESS_TYPE_IPOE) {
+        } else if(stream->session->hot->access_type == ACCESS_TYPE_IPOE) {
             if(stream->session->a10nsp_session) {
-                return bbl_stream_build_a10nsp_ipoe_packet(stream);
+                return bbl_stream_build_a10nsp_ipoe_packet(stream, packet);
             } else {
                 if(stream->direction == BBL_DIRECTION_UP) {
-                    return bbl_stream_build_access_ipoe_packet(stream);
+                    return bbl_stream_build_access_ipoe_packet(stream, packet);
                 } else {
-                    return bbl_stream_build_network_packet(stream);
+                    return bbl_stream_build_network_packet(stream, packet);
                 }
             }
         }
@@ -972,212 +993,348 @@ bbl_stream_build_packet(bbl_stream_s *stream)
     return false;
 }
 
+static bbl_stream_stats_s *
+bbl_stream_stats_get(bbl_stream_stats_s *stats, bbl_stream_stats_s **head,
+                     bbl_access_interface_s *access_interface,
+                     bbl_network_interface_s *network_interface,
+                     bbl_a10nsp_interface_s *a10nsp_interface)
+{
+    if(likely(stats && stats->owner == head &&
+              stats->access_interface == access_interface &&
+              stats->network_interface == network_interface &&
+              stats->a10nsp_interface == a10nsp_interface)) {
+        return stats;
+    }
+    stats = *head;
+    while(stats) {
+        if(stats->access_interface == access_interface &&
+           stats->network_interface == network_interface &&
+           stats->a10nsp_interface == a10nsp_interface) {
+            return stats;
+        }
+        stats = stats->next;
+    }
+    stats = calloc(1, sizeof(bbl_stream_stats_s));
+    if(!stats) {
+        return NULL;
+    }
+    stats->owner = head;
+    stats->access_interface = access_interface;
+    stats->network_interface = network_interface;
+    stats->a10nsp_interface = a10nsp_interface;
+    stats->next = *head;
+    /* Publish new record to the main thread. */
+    __atomic_store_n(head, stats, __ATOMIC_RELEASE);
+    return stats;
+}
+
 static void
-bbl_stream_tx_stats(bbl_stream_s *stream, uint64_t packets, uint64_t bytes)
+bbl_stream_stats_fold(bbl_stream_stats_s *stats)
 {
-    bbl_session_s *session = stream->session;
-    bbl_access_interface_s *access_interface;
-    bbl_network_interface_s *network_interface;
-    bbl_a10nsp_interface_s *a10nsp_interface;
+    const volatile uint64_t *counters = (const volatile uint64_t*)&stats->counters;
+    uint64_t *synced = (uint64_t*)&stats->synced;
+    bbl_stream_counters_s delta;
+    uint64_t *d = (uint64_t*)&delta;
+    uint64_t value;
+    size_t i;
+
+    for(i = 0; i < sizeof(bbl_stream_counters_s)/sizeof(uint64_t); i++) {
+        value = counters[i];
+        d[i] = value - synced[i];
+        synced[i] = value;
+    }
+
+    if(stats->access_interface) {
+        bbl_access_interface_s *access_interface = stats->access_interface;
+        access_interface->stats.packets_tx += delta.packets_tx;
+        access_interface->stats.bytes_tx += delta.bytes_tx;
+        access_interface->stats.stream_tx += delta.stream_tx;
+        access_interface->stats.session_ipv4_tx += delta.session_ipv4_tx;
+        access_interface->stats.session_ipv6_tx += delta.session_ipv6_tx;
+        access_interface->stats.session_ipv6pd_tx += delta.session_ipv6pd_tx;
+        access_interface->stats.packets_rx += delta.packets_rx;
+        access_interface->stats.bytes_rx += delta.bytes_rx;
+        access_interface->stats.stream_rx += delta.stream_rx;
+        access_interface->stats.stream_loss += delta.stream_loss;
+        access_interface->stats.session_ipv4_rx += delta.session_ipv4_rx;
+        access_interface->stats.session_ipv6_rx += delta.session_ipv6_rx;
+        access_interface->stats.session_ipv6pd_rx += delta.session_ipv6pd_rx;
+        access_interface->stats.session_ipv4_loss += delta.session_ipv4_loss;
+        access_interface->stats.session_ipv6_loss += delta.session_ipv6_loss;
+        access_interface->stats.session_ipv6pd_loss += delta.session_ipv6pd_loss;
+    } else if(stats->network_interface) {
+        bbl_network_interface_s *network_interface = stats->network_interface;
+        network_interface->stats.packets_tx += delta.packets_tx;
+        network_interface->stats.bytes_tx += delta.bytes_tx;
+        network_interface->stats.stream_tx += delta.stream_tx;
+        network_interface->stats.mc_tx += delta.mc_tx;
+        network_interface->stats.session_ipv4_tx += delta.session_ipv4_tx;
+        network_interface->stats.session_ipv6_tx += delta.session_ipv6_tx;
+        network_interface->stats.session_ipv6pd_tx += delta.session_ipv6pd_tx;
+        network_interface->stats.packets_rx += delta.packets_rx;
+        network_interface->stats.bytes_rx += delta.bytes_rx;
+        network_interface->stats.stream_rx += delta.stream_rx;
+        network_interface->stats.stream_loss += delta.stream_loss;
+        network_interface->stats.session_ipv4_rx += delta.session_ipv4_rx;
+        network_interface->stats.session_ipv6_rx += delta.session_ipv6_rx;
+        network_interface->stats.session_ipv6pd_rx += delta.session_ipv6pd_rx;
+        network_interface->stats.session_ipv4_loss += delta.session_ipv4_loss;
+        network_interface->stats.session_ipv6_loss += delta.session_ipv6_loss;
+        network_interface->stats.session_ipv6pd_loss += delta.session_ipv6pd_loss;
+    } else if(stats->a10nsp_interface) {
+        bbl_a10nsp_interface_s *a10nsp_interface = stats->a10nsp_interface;
+        a10nsp_interface->stats.packets_tx += delta.packets_tx;
+        a10nsp_interface->stats.bytes_tx += delta.bytes_tx;
+        a10nsp_interface->stats.stream_tx += delta.stream_tx;
+        a10nsp_interface->stats.session_ipv4_tx += delta.session_ipv4_tx;
+        a10nsp_interface->stats.session_ipv6_tx += delta.session_ipv6_tx;
+        a10nsp_interface->stats.session_ipv6pd_tx += delta.session_ipv6pd_tx;
+        a10nsp_interface->stats.packets_rx += delta.packets_rx;
+        a10nsp_interface->stats.bytes_rx += delta.bytes_rx;
+        a10nsp_interface->stats.stream_rx += delta.stream_rx;
+        a10nsp_interface->stats.stream_loss += delta.stream_loss;
+        a10nsp_interface->stats.session_ipv4_rx += delta.session_ipv4_rx;
+        a10nsp_interface->stats.session_ipv6_rx += delta.session_ipv6_rx;
+        a10nsp_interface->stats.session_ipv6pd_rx += delta.session_ipv6pd_rx;
+        a10nsp_interface->stats.session_ipv4_loss += delta.session_ipv4_loss;
+        a10nsp_interface->stats.session_ipv6_loss += delta.session_ipv6_loss;
+        a10nsp_interface->stats.session_ipv6pd_loss += delta.session_ipv6pd_loss;
+    }
+}
 
-    if(packets == 0) return;
-    if(stream->direction == BBL_DIRECTION_UP) {
-        access_interface = stream->tx_access_interface;
-        session = stream->session;
-        if(access_interface) {
-            access_interface->stats.packets_tx += packets;
-            access_interface->stats.bytes_tx += bytes;
-            access_interface->stats.stream_tx += packets;
-            if(session) {
-                session->stats.packets_tx += packets;
-                session->stats.bytes_tx += bytes;
-                session->stats.accounting_packets_tx += packets;
-                session->stats.accounting_bytes_tx += bytes;
-                if(stream->session_traffic) {
-                    switch(stream->sub_type) {
-                        case BBL_SUB_TYPE_IPV4:
-                            access_interface->stats.session_ipv4_tx += packets;
-                            break;
-                        case BBL_SUB_TYPE_IPV6:
-                            access_interface->stats.session_ipv6_tx += packets;
-                            break;
-                        case BBL_SUB_TYPE_IPV6PD:
-                            access_interface->stats.session_ipv6pd_tx += packets;
-                            break;
-                        default:
-                            break;
+/**
+ * bbl_stream_tx_epoch
+ *
+ * Fold TX packets of all streams of the given IO 
+ * handle into the stream stats of the calling thread. 
+ * This function is called once per second (epoch) 
+ * by the thread sending the streams.
+ *
+ * @param io IO handle
+ * @param stats stream stats list head of the calling thread
+ */
+void
+bbl_stream_tx_epoch(io_handle_s *io, bbl_stream_stats_s **stats)
+{
+    io_bucket_s *io_bucket = io->bucket_head;
+    bbl_stream_s *stream;
+    bbl_stream_stats_s *tx_stats;
+    volatile bbl_stream_counters_s *counters;
+
+    uint64_t packets;
+    uint64_t packets_delta;
+
+    while(io_bucket) {
+        stream = io_bucket->stream_head;
+        while(stream) {
+            packets = stream->tx_packets;
+            packets_delta = packets - stream->tx_epoch_packets;
+            if(packets_delta) {
+                if(stream->direction == BBL_DIRECTION_UP) {
+                    tx_stats = bbl_stream_stats_get(stream->tx_stats, stats, 
+                        stream->tx_access_interface, NULL, NULL);
+                } else {
+                    tx_stats = bbl_stream_stats_get(stream->tx_stats, stats, NULL,
+                        stream->tx_network_interface, 
+                        stream->tx_network_interface ? NULL : stream->tx_a10nsp_interface);
+                }
+                if(tx_stats) {
+                    stream->tx_stats = tx_stats;
+                    stream->tx_epoch_packets = packets;
+                    counters = &tx_stats->counters;
+                    counters->packets_tx += packets_delta;
+                    counters->bytes_tx += packets_delta * stream->tx_len;
+                    counters->stream_tx += packets_delta;
+                    if(stream->type == BBL_TYPE_MULTICAST) {
+                        counters->mc_tx += packets_delta;
+                    }
+                    if(stream->session && stream->session_traffic) {
+                        switch(stream->sub_type) {
+                            case BBL_SUB_TYPE_IPV4:
+                                counters->session_ipv4_tx += packets_delta;
+                                break;
+                            case BBL_SUB_TYPE_IPV6:
+                                counters->session_ipv6_tx += packets_delta;
+                                break;
+                            case BBL_SUB_TYPE_IPV6PD:
+                                counters->session_ipv6pd_tx += packets_delta;
+                                break;
+                            default:
+                                break;
+                        }
                     }
                 }
             }
+            if(g_ctx->config.stream_rate_calc && stream->pps >= 1) {
+                bbl_compute_avg_rate(&stream->rate_packets_tx, packets);
+            }
+            stream = stream->io_next;
+        }
+        io_bucket = io_bucket->next;
+    }
+}
+
+/**
+ * bbl_stream_rx_account
+ *
+ * Add received stream packet to the stream 
+ * stats of the calling thread. This function 
+ * must be called after the RX interface of 
+ * the stream has been updated.
+ *
+ * @param stream stream
+ * @param stats stream stats list head of the calling thread
+ */
+void
+bbl_stream_rx_account(bbl_stream_s *stream, bbl_stream_stats_s **stats)
+{
+    bbl_stream_stats_s *rx_stats;
+    volatile bbl_stream_counters_s *counters;
+    uint64_t loss;
+
+    rx_stats = bbl_stream_stats_get(stream->rx_stats, stats, 
+        stream->rx_access_interface, 
+        stream->rx_access_interface ? NULL : stream->rx_network_interface, 
+        (stream->rx_access_interface || stream->rx_network_interface) ? NULL : stream->rx_a10nsp_interface);
+    if(unlikely(!rx_stats)) {
+        return;
+    }
+    stream->rx_stats = rx_stats;
+
+    loss = stream->rx_loss - stream->rx_stats_loss;
+    stream->rx_stats_loss = stream->rx_loss;
+
+    counters = &rx_stats->counters;
+    counters->stream_rx++;
+    counters->stream_loss += loss;
+    if(!stream->rx_fragments) {
+        counters->packets_rx++;
+        counters->bytes_rx += stream->rx_len;
+    }
+    if(stream->session && stream->session_traffic) {
+        switch(stream->sub_type) {
+            case BBL_SUB_TYPE_IPV4:
+                counters->session_ipv4_rx++;
+                counters->session_ipv4_loss += loss;
+                break;
+            case BBL_SUB_TYPE_IPV6:
+                counters->session_ipv6_rx++;
+                counters->session_ipv6_loss += loss;
+                break;
+            case BBL_SUB_TYPE_IPV6PD:
+                counters->session_ipv6pd_rx++;
+                counters->session_ipv6pd_loss += loss;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void
+bbl_stream_stats_sync()
+{
+    bbl_interface_s *interface;
+    io_handle_s *io;
+    io_thread_s *thread;
+    bbl_stream_stats_s *stats;
+
+    /* TX epoch of streams send by the main thread. */
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        io = interface->io.tx;
+        while(io) {
+            if(!(io->thread && io->thread->active)) {
+                bbl_stream_tx_epoch(io, io->thread ? &io->thread->stream_stats : &g_ctx->stream_stats);
+            }
+            io = io->next;
+        }
+    }
+
+    stats = g_ctx->stream_stats;
+    while(stats) {
+        bbl_stream_stats_fold(stats);
+        stats = stats->next;
+    }
+    thread = g_ctx->io_threads;
+    while(thread) {
+        stats = __atomic_load_n(&thread->stream_stats, __ATOMIC_ACQUIRE);
+        while(stats) {
+            bbl_stream_stats_fold(stats);
+            stats = stats->next;
+        }
+        thread = thread->next;
+    }
+}
+
+/**
+ * bbl_stream_stats_job
+ *
+ * Fold the stream stats of all threads
+ * into the interface stats once per second. 
+ *
+ * @param timer timer
+ */
+void
+bbl_stream_stats_job(timer_s *timer)
+{
+    UNUSED(timer);
+    bbl_stream_stats_sync();
+}
+
+static void
+bbl_stream_tx_stats(bbl_stream_s *stream, uint64_t packets, uint64_t bytes)
+{
+    bbl_session_s *session = stream->session;
+
+    if(!(packets && session)) return;
+    if(stream->direction == BBL_DIRECTION_UP) {
+        if(stream->tx_access_interface) {
+            session->stats.packets_tx += packets;
+            session->stats.bytes_tx += bytes;
+            session->stats.accounting_packets_tx += packets;
+            session->stats.accounting_bytes_tx += bytes;
         }
     } else {
         if(stream->tx_network_interface) {
-            network_interface = stream->tx_network_interface;
-            network_interface->stats.packets_tx += packets;
-            network_interface->stats.bytes_tx += bytes;
-            network_interface->stats.stream_tx += packets;
-            if(stream->type == BBL_TYPE_MULTICAST) {
-                network_interface->stats.mc_tx += packets;
-            }
-            if(session) {
-                if(session->l2tp_session) {
-                    network_interface->stats.l2tp_data_tx += packets;
-                    session->l2tp_session->tunnel->stats.data_tx += packets;
-                    session->l2tp_session->stats.data_tx += packets;
-                    if(stream->sub_type == BBL_SUB_TYPE_IPV4) {
-                        session->l2tp_session->stats.data_ipv4_tx += packets;
-                    }
-                }
-                if(stream->session_traffic) {
-                    switch(stream->sub_type) {
-                        case BBL_SUB_TYPE_IPV4:
-                            network_interface->stats.session_ipv4_tx += packets;
-                            break;
-                        case BBL_SUB_TYPE_IPV6:
-                            network_interface->stats.session_ipv6_tx += packets;
-                            break;
-                        case BBL_SUB_TYPE_IPV6PD:
-                            network_interface->stats.session_ipv6pd_tx += packets;
-                            break;
-                        default:
-                            break;
-                    }
+            if(session->l2tp_session) {
+                stream->tx_network_interface->stats.l2tp_data_tx += packets;
+                session->l2tp_session->tunnel->stats.data_tx += packets;
+                session->l2tp_session->stats.data_tx += packets;
+                if(stream->sub_type == BBL_SUB_TYPE_IPV4) {
+                    session->l2tp_session->stats.data_ipv4_tx += packets;
                 }
             }
         } else if(stream->tx_a10nsp_interface) {
-            a10nsp_interface = stream->tx_a10nsp_interface;
-            a10nsp_interface->stats.packets_tx += packets;
-            a10nsp_interface->stats.bytes_tx += bytes;
-            a10nsp_interface->stats.stream_tx += packets;
-            if(session) {
-                if(session->a10nsp_session) {
-                    session->a10nsp_session->stats.packets_tx += packets;
-                }
-                if(stream->session_traffic) {
-                    switch(stream->sub_type) {
-                        case BBL_SUB_TYPE_IPV4:
-                            a10nsp_interface->stats.session_ipv4_tx += packets;
-                            break;
-                        case BBL_SUB_TYPE_IPV6:
-                            a10nsp_interface->stats.session_ipv6_tx += packets;
-                            break;
-                        case BBL_SUB_TYPE_IPV6PD:
-                            a10nsp_interface->stats.session_ipv6pd_tx += packets;
-                            break;
-                        default:
-                            break;
-                    }
-                }
+            if(session->a10nsp_session) {
+                session->a10nsp_session->stats.packets_tx += packets;
             }
         }
     }
 }
 
 static void
-bbl_stream_rx_stats(bbl_stream_s *stream, uint64_t packets, uint64_t bytes, uint64_t loss)
+bbl_stream_rx_stats(bbl_stream_s *stream, uint64_t packets, uint64_t bytes)
 {
     bbl_session_s *session = stream->session;
-    bbl_access_interface_s *access_interface;
-    bbl_network_interface_s *network_interface;
-    bbl_a10nsp_interface_s *a10nsp_interface;
 
-    if(packets == 0) return;
+    if(!(packets && session)) return;
     if(stream->rx_access_interface) {
-        access_interface = stream->rx_access_interface;
-        access_interface->stats.stream_rx += packets;
-        access_interface->stats.stream_loss += loss;
-        if(!stream->rx_fragments) {
-            access_interface->stats.packets_rx += packets;
-            access_interface->stats.bytes_rx += bytes;
-        }
-        if(session) {
-            session->stats.packets_rx += packets;
-            session->stats.bytes_rx += bytes;
-            session->stats.accounting_packets_rx += packets;
-            session->stats.accounting_bytes_rx += bytes;
-            if(stream->session_traffic) {
-                switch(stream->sub_type) {
-                    case BBL_SUB_TYPE_IPV4:
-                        access_interface->stats.session_ipv4_rx += packets;
-                        access_interface->stats.session_ipv4_loss += loss;
-                        break;
-                    case BBL_SUB_TYPE_IPV6:
-                        access_interface->stats.session_ipv6_rx += packets;
-                        access_interface->stats.session_ipv6_loss += loss;
-                        break;
-                    case BBL_SUB_TYPE_IPV6PD:
-                        access_interface->stats.session_ipv6pd_rx += packets;
-                        access_interface->stats.session_ipv6pd_loss += loss;
-                        break;
-                    default:
-                        break;
-                }
-            }
-        }
+        session->hot->packets_rx += packets;
+        session->hot->bytes_rx += bytes;
+        session->stats.accounting_packets_rx += packets;
+        session->stats.accounting_bytes_rx += bytes;
     } else if(stream->rx_network_interface) {
-        network_interface = stream->rx_network_interface;
-        network_interface->stats.stream_rx += packets;
-        network_interface->stats.stream_loss += loss;
-        if(!stream->rx_fragments) {
-            network_interface->stats.packets_rx += packets;
-            network_interface->stats.bytes_rx += bytes;
-        }
-        if(session) {
-            if(session->l2tp_session) {
-                network_interface->stats.l2tp_data_rx += packets;
-                session->l2tp_session->tunnel->stats.data_rx += packets;
-                session->l2tp_session->stats.data_rx += packets;
-                if(stream->type == BBL_SUB_TYPE_IPV4) {
-                    session->l2tp_session->stats.data_ipv4_rx += packets;
-                }
-            }
-            if(stream->session_traffic) {
-                switch(stream->sub_type) {
-                    case BBL_SUB_TYPE_IPV4:
-                        network_interface->stats.session_ipv4_rx += packets;
-                        network_interface->stats.session_ipv4_loss += loss;
-                        break;
-                    case BBL_SUB_TYPE_IPV6:
-                        network_interface->stats.session_ipv6_rx += packets;
-                        network_interface->stats.session_ipv6_loss += loss;
-                        break;
-                    case BBL_SUB_TYPE_IPV6PD:
-                        network_interface->stats.session_ipv6pd_rx += packets;
-                        network_interface->stats.session_ipv6pd_loss += loss;
-                        break;
-                    default:
-                        break;
-                }
+        if(session->l2tp_session) {
+            stream->rx_network_interface->stats.l2tp_data_rx += packets;
+            session->l2tp_session->tunnel->stats.data_rx += packets;
+            session->l2tp_session->stats.data_rx += packets;
+            if(stream->type == BBL_SUB_TYPE_IPV4) {
+                session->l2tp_session->stats.data_ipv4_rx += packets;
             }
         }
     } else if(stream->rx_a10nsp_interface) {
-        a10nsp_interface = stream->rx_a10nsp_interface;
-        a10nsp_interface->stats.packets_rx += packets;
-        a10nsp_interface->stats.bytes_rx += bytes;
-        a10nsp_interface->stats.stream_rx += packets;
-        a10nsp_interface->stats.stream_loss += loss;
-        if(session) {
-            if(session->a10nsp_session) {
-                session->a10nsp_session->stats.packets_rx += packets;
-            }
-            if(stream->session_traffic) {
-                switch(stream->sub_type) {
-                    case BBL_SUB_TYPE_IPV4:
-                        a10nsp_interface->stats.session_ipv4_rx += packets;
-                        a10nsp_interface->stats.session_ipv4_loss += loss;
-                        break;
-                    case BBL_SUB_TYPE_IPV6:
-                        a10nsp_interface->stats.session_ipv6_rx += packets;
-                        a10nsp_interface->stats.session_ipv6_loss += loss;
-                        break;
-                    case BBL_SUB_TYPE_IPV6PD:
-                        a10nsp_interface->stats.session_ipv6pd_rx += packets;
-                        a10nsp_interface->stats.session_ipv6pd_loss += loss;
-                        break;
-                    default:
-                        break;
-                }
-            }
+        if(session->a10nsp_session) {
+            session->a10nsp_session->stats.packets_rx += packets;
         }
     }
 }
@@ -1230,40 +1387,41 @@ bbl_stream_ctrl(bbl_stream_s *stream)
     bbl_session_s *session = stream->session;
 
     uint64_t packets;
-    uint64_t loss;
     uint64_t packets_delta;
     uint64_t bytes_delta;
-    uint64_t loss_delta;
 
-    /* Calculate TX packets/bytes since last sync. */
+    /* Calculate TX packets/bytes since last sync. Interface
+     * stats and TX rate are updated by the thread sending 
+     * the stream (see bbl_stream_tx_epoch). */
     packets = stream->tx_packets;
     packets_delta = packets - stream->last_sync_packets_tx;
     if(packets_delta) {
-        bytes_delta = packets_delta * stream->tx_len;
+        bytes_delta = packets_delta * stream->tx_ctrl_len;
         stream->last_sync_packets_tx = packets;
         bbl_stream_tx_stats(stream, packets_delta, bytes_delta);
     }
-    if(g_ctx->config.stream_rate_calc && stream->pps >= 1) {
-        bbl_compute_avg_rate(&stream->rate_packets_tx, packets);
-    }
     if(unlikely(stream->type == BBL_TYPE_MULTICAST)) {
         return;
     }
-    /* Calculate RX packets/bytes since last sync. */
+    /* Calculate RX packets/bytes since last sync. Interface 
+     * stats are updated by the receiving thread 
+     * (see bbl_stream_rx_account). */
     packets = stream->rx_packets;
     packets_delta = packets - stream->last_sync_packets_rx;
     if(packets_delta) {
         bytes_delta = packets_delta * stream->rx_len;
         stream->last_sync_packets_rx = packets;
-        /* Calculate RX loss since last sync. */
-        loss = stream->rx_loss;
-        loss_delta = loss - stream->last_sync_loss;
-        stream->last_sync_loss = loss;
-        bbl_stream_rx_stats(stream, packets_delta, bytes_delta, loss_delta);
+        stream->last_sync_loss = stream->rx_loss;
+        bbl_stream_rx_stats(stream, packets_delta, bytes_delta);
         if(unlikely(stream->rx_wrong_session)) {
             bbl_stream_rx_wrong_session(stream);
         }
         if(unlikely(!stream->verified)) {
+            if(stream->nat && stream->reverse) {
+                /* NAT enabled downstream streams wait for 
+                 * the source learned with the first packet. */
+                bbl_stream_tx_ctrl_update(stream->reverse);
+            }
             if(stream->rx_first_seq) {
                 if(stream->session_traffic) {
                     if(session) {
@@ -1304,6 +1462,10 @@ bbl_stream_final()
         bbl_stream_ctrl(stream);
         stream = stream->next;
     }
+    /* All threads are stopped at this point, 
+     * which allows to run the final TX epoch 
+     * of threaded streams in the main thread. */
+    bbl_stream_stats_sync();
 }
 
 static bool
@@ -1324,14 +1486,6 @@ bbl_stream_ldp_lookup(bbl_stream_s *stream)
     if(!(stream->ldp_entry && stream->ldp_entry->active)) {
         return false;
     }
-    if(stream->ldp_entry->version != stream->ldp_entry_version) {
-        stream->ldp_entry_version = stream->ldp_entry->version;
-        /* Free packet if LDP entry has changed. */
-        if(stream->tx_buf) {
-            free(stream->tx_buf);
-            stream->tx_buf = NULL;
-        }
-    }
     return true;
 }
 
@@ -1354,46 +1508,294 @@ bbl_stream_can_send(bbl_stream_s *stream)
             return true;
         }
     }
+    return false;
+}
 
-    /* Free packet if not ready to send. */
-    if(stream->tx_buf) {
-        free(stream->tx_buf);
-        stream->tx_buf = NULL;
+/**
+ * bbl_stream_tx_ctrl
+ *
+ * Check if the stream packet needs to be freed or 
+ * (re)build because session or LDP state has changed. 
+ * This function reads state owned by the main thread
+ * and must not be called from TX threads. 
+ *
+ * @param stream stream
+ * @return stream TX control action
+ */
+static bbl_stream_tx_ctrl_t
+bbl_stream_tx_ctrl(bbl_stream_s *stream)
+{
+    bbl_session_s *session = stream->session;
+
+    if(!bbl_stream_can_send(stream)) {
+        return STREAM_TX_CTRL_FREE;
     }
-    return false;
+    if(!stream->tx_ctrl_active) {
+        return STREAM_TX_CTRL_BUILD;
+    }
+    if(session && session->version != stream->session_version) {
+        return STREAM_TX_CTRL_BUILD;
+    }
+    if(stream->ldp_entry && stream->ldp_entry->version != stream->ldp_entry_version) {
+        return STREAM_TX_CTRL_BUILD;
+    }
+    return STREAM_TX_CTRL_NONE;
 }
 
 static void
-bbl_stream_update_tcp(bbl_stream_s *stream)
+bbl_stream_tx_ctrl_commit(bbl_stream_s *stream, bbl_stream_tx_ctrl_t action)
 {
-    uint16_t  tcp_len = stream->tx_bbl_hdr_len + TCP_HDR_LEN_MIN;
-    uint8_t  *tcp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - tcp_len));
-    uint16_t *checksum = (uint16_t*)(tcp_buf+16);
+    if(action == STREAM_TX_CTRL_BUILD) {
+        stream->tx_ctrl_active = true;
+        if(stream->session) {
+            stream->session_version = stream->session->version;
+        }
+        if(stream->ldp_entry) {
+            stream->ldp_entry_version = stream->ldp_entry->version;
+        }
+    } else if(action == STREAM_TX_CTRL_FREE) {
+        stream->tx_ctrl_active = false;
+    }
+}
 
-    if(stream->tcp_flags) {
-        *(tcp_buf+13) = stream->tcp_flags & 0x3f;
+/**
+ * bbl_stream_packet_free
+ *
+ * @param packet stream packet
+ */
+void
+bbl_stream_packet_free(bbl_stream_packet_s *packet)
+{
+    if(packet) {
+        if(packet->buf) free(packet->buf);
+        free(packet);
     }
+}
 
-    *checksum = 0;
+/**
+ * bbl_stream_packet_build
+ *
+ * Build stream packet in main thread.
+ *
+ * @param stream stream
+ * @return stream packet or NULL if build failed
+ */
+static bbl_stream_packet_s *
+bbl_stream_packet_build(bbl_stream_s *stream)
+{
+    bbl_stream_packet_s *packet = calloc(1, sizeof(bbl_stream_packet_s));
+    if(!packet) {
+        return NULL;
+    }
+    if(!bbl_stream_build_packet(stream, packet)) {
+        LOG(ERROR, "Failed to build packet for stream %s\n", stream->config->name);
+        bbl_stream_packet_free(packet);
+        return NULL;
+    }
     if(stream->ipv6_src && stream->ipv6_dst) {
-        *checksum = bbl_ipv6_tcp_checksum(stream->ipv6_src, stream->ipv6_dst, tcp_buf, tcp_len);
+        packet->ipv6 = true;
+        memcpy(packet->ipv6_src, stream->ipv6_src, IPV6_ADDR_LEN);
+        memcpy(packet->ipv6_dst, stream->ipv6_dst, IPV6_ADDR_LEN);
     } else {
-        *checksum = bbl_ipv4_tcp_checksum(stream->ipv4_src, stream->ipv4_dst, tcp_buf, tcp_len);
+        packet->ipv4_src = stream->ipv4_src;
+        packet->ipv4_dst = stream->ipv4_dst;
     }
+    stream->tx_ctrl_len = packet->len;
+    return packet;
 }
 
+/**
+ * bbl_stream_tx_swap
+ *
+ * Replace the TX packet of the stream in the
+ * thread sending the stream and free the old one.
+ *
+ * @param stream stream
+ * @param packet new stream packet or NULL
+ */
 static void
-bbl_stream_update_udp(bbl_stream_s *stream)
+bbl_stream_tx_swap(bbl_stream_s *stream, bbl_stream_packet_s *packet)
 {
-    uint16_t  udp_len = stream->tx_bbl_hdr_len + UDP_HDR_LEN;
-    uint8_t  *udp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - udp_len));
-    uint16_t *checksum = (uint16_t*)(udp_buf+6);
-
-    *checksum = 0;
-    if(stream->ipv6_src && stream->ipv6_dst) {
-        *checksum = bbl_ipv6_udp_checksum(stream->ipv6_src, stream->ipv6_dst, udp_buf, udp_len);
+    bbl_stream_packet_free(stream->tx_packet);
+    stream->tx_packet = packet;
+    if(packet) {
+        stream->tx_buf = packet->buf;
+        stream->tx_len = packet->len;
+        stream->tx_bbl_hdr_len = packet->bbl_hdr_len;
+        stream->tx_version++;
     } else {
-        *checksum = bbl_ipv4_udp_checksum(stream->ipv4_src, stream->ipv4_dst, udp_buf, udp_len);
+        stream->tx_buf = NULL;
+    }
+}
+
+static bool
+bbl_stream_tx_build(bbl_stream_s *stream)
+{
+    bbl_stream_packet_s *packet = bbl_stream_packet_build(stream);
+    bbl_stream_tx_swap(stream, packet);
+    return packet != NULL;
+}
+
+/**
+ * bbl_stream_tx_msg
+ *
+ * Process stream control message received 
+ * from main thread in the owning TX thread.
+ *
+ * @param stream stream
+ * @param type message type
+ * @param packet new stream packet (IO_STREAM_MSG_BUILD)
+ */
+void
+bbl_stream_tx_msg(bbl_stream_s *stream, io_stream_msg_type_t type, bbl_stream_packet_s *packet)
+{
+    switch(type) {
+        case IO_STREAM_MSG_BUILD:
+            bbl_stream_tx_swap(stream, packet);
+            break;
+        case IO_STREAM_MSG_FREE:
+            bbl_stream_tx_swap(stream, NULL);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * bbl_stream_tx_ctrl_update
+ *
+ * Schedule threaded stream for the TX control 
+ * job after session, endpoint or LDP state 
+ * has changed. 
+ *
+ * @param stream stream
+ */
+void
+bbl_stream_tx_ctrl_update(bbl_stream_s *stream)
+{
+    if(stream->threaded && !stream->tx_ctrl_pending) {
+        stream->tx_ctrl_pending = true;
+        stream->tx_ctrl_next = g_ctx->stream_tx_ctrl;
+        g_ctx->stream_tx_ctrl = stream;
+    }
+}
+
+/**
+ * bbl_stream_session_update
+ *
+ * Schedule all threaded streams of the session 
+ * for the TX control job. 
+ *
+ * @param session session
+ */
+void
+bbl_stream_session_update(bbl_session_s *session)
+{
+    bbl_stream_s *stream = session->streams.head;
+    while(stream) {
+        bbl_stream_tx_ctrl_update(stream);
+        stream = stream->session_next;
+    }
+}
+
+/**
+ * bbl_stream_multicast_update
+ *
+ * Schedule all threaded multicast streams for the 
+ * TX control job after the multicast endpoint 
+ * has changed. 
+ */
+void
+bbl_stream_multicast_update()
+{
+    bbl_stream_s *stream = g_ctx->stream_head;
+    while(stream) {
+        if(stream->type == BBL_TYPE_MULTICAST) {
+            bbl_stream_tx_ctrl_update(stream);
+        }
+        stream = stream->next;
+    }
+}
+
+/**
+ * bbl_stream_ldp_update
+ *
+ * Schedule all threaded streams with LDP lookup 
+ * for the TX control job with the next run after 
+ * the LDP database has changed. 
+ */
+void
+bbl_stream_ldp_update()
+{
+    g_ctx->stream_ldp_update = true;
+}
+
+/**
+ * bbl_stream_tx_ctrl_job
+ *
+ * This job is scheduled in the main loop if there 
+ * are threaded streams, requesting stream packet 
+ * (re)builds from the owning TX thread for all 
+ * streams scheduled with bbl_stream_tx_ctrl_update. 
+ */
+void
+bbl_stream_tx_ctrl_job(timer_s *timer)
+{
+    bbl_stream_s *stream;
+    bbl_stream_s *retry = NULL;
+    bbl_stream_packet_s *packet;
+    bbl_stream_tx_ctrl_t action;
+    io_stream_msg_type_t type;
+    bool failed;
+
+    UNUSED(timer);
+
+    if(g_ctx->stream_ldp_update) {
+        g_ctx->stream_ldp_update = false;
+        stream = g_ctx->stream_ldp;
+        while(stream) {
+            bbl_stream_tx_ctrl_update(stream);
+            stream = stream->ldp_next;
+        }
+    }
+
+    while((stream = g_ctx->stream_tx_ctrl)) {
+        action = bbl_stream_tx_ctrl(stream);
+        packet = NULL;
+        failed = false;
+        if(action == STREAM_TX_CTRL_BUILD) {
+            packet = bbl_stream_packet_build(stream);
+            if(!packet) {
+                /* Stop sending the old packet and 
+                 * retry build with next interval. */
+                action = STREAM_TX_CTRL_FREE;
+                failed = true;
+            }
+        }
+        if(action == STREAM_TX_CTRL_FREE && !stream->tx_ctrl_active) {
+            action = STREAM_TX_CTRL_NONE;
+        }
+        if(action != STREAM_TX_CTRL_NONE) {
+            type = action == STREAM_TX_CTRL_BUILD ? IO_STREAM_MSG_BUILD : IO_STREAM_MSG_FREE;
+            if(!io_thread_stream_msg(stream->io->thread, stream, type, packet)) {
+                /* Retry with next interval. */
+                bbl_stream_packet_free(packet);
+                break;
+            }
+            bbl_stream_tx_ctrl_commit(stream, action);
+        }
+        g_ctx->stream_tx_ctrl = stream->tx_ctrl_next;
+        stream->tx_ctrl_next = NULL;
+        stream->tx_ctrl_pending = false;
+        if(failed) {
+            stream->tx_ctrl_next = retry;
+            retry = stream;
+        }
+    }
+    while((stream = retry)) {
+        retry = stream->tx_ctrl_next;
+        stream->tx_ctrl_next = NULL;
+        bbl_stream_tx_ctrl_update(stream);
     }
 }
 
@@ -1401,9 +1803,8 @@ static protocol_error_t
 bbl_stream_io_send(bbl_stream_s *stream)
 {
     struct timespec time_elapsed;
-    bbl_session_s *session;
+    bbl_stream_tx_ctrl_t action;
     io_handle_s *io = stream->io;
-    uint8_t *ptr;
 
     if(unlikely(stream->reset)) {
         stream->reset = false;
@@ -1420,9 +1821,26 @@ bbl_stream_io_send(bbl_stream_s *stream)
     if(!stream->enabled) {
         return STREAM_WAIT;
     }
-    
-    if(!bbl_stream_can_send(stream)) {
-        return WRONG_PROTOCOL_STATE;
+
+    if(stream->threaded) {
+        /* The stream packet is (re)build by the main 
+         * thread and passed to the TX thread 
+         * (see bbl_stream_tx_ctrl_job). */
+        if(!stream->tx_buf) {
+            return WRONG_PROTOCOL_STATE;
+        }
+    } else {
+        action = bbl_stream_tx_ctrl(stream);
+        bbl_stream_tx_ctrl_commit(stream, action);
+        if(action == STREAM_TX_CTRL_FREE) {
+            bbl_stream_tx_swap(stream, NULL);
+            return WRONG_PROTOCOL_STATE;
+        }
+        if(action == STREAM_TX_CTRL_BUILD || !stream->tx_buf) {
+            if(!bbl_stream_tx_build(stream)) {
+                return ENCODE_ERROR;
+            }
+        }
     }
     
     /** Enforce optional stream packet limit ... */
@@ -1460,37 +1878,50 @@ bbl_stream_io_send(bbl_stream_s *stream)
         stream->wait_start.tv_sec = io->timestamp.tv_sec;
         stream->wait_start.tv_nsec = io->timestamp.tv_nsec;
     }
-    
-    session = stream->session;
-    if(session && session->version != stream->session_version) {
-        if(stream->tx_buf) {
-            free(stream->tx_buf);
-            stream->tx_buf = NULL;
-        }
-        stream->session_version = session->version;
+
+    bbl_stream_tx_update(stream, &io->timestamp);
+    if(stream->flow_seq == 1) {
+        stream->tx_first_epoch = io->timestamp.tv_sec;
     }
+    return PROTOCOL_SUCCESS;
+}
 
-    if(!stream->tx_buf) {
-        if(!bbl_stream_build_packet(stream)) {
-            LOG(ERROR, "Failed to build packet for stream %s\n", stream->config->name);
-            return ENCODE_ERROR;
-        }
+/**
+ * bbl_stream_tx_template
+ *
+ * Copy stream packet into TX buffer. If the TX buffer
+ * still holds the current packet template of this stream,
+ * only the bytes changed per packet by bbl_stream_io_send
+ * are copied (BBL header sequence and timestamp, TCP flags
+ * and L4 checksum).
+ *
+ * @param stream stream
+ * @param buf TX buffer
+ * @param template stream template resident in TX buffer
+ */
+void
+bbl_stream_tx_template(bbl_stream_s *stream, uint8_t *buf, io_template_s *template)
+{
+    uint16_t offset;
+
+    if(template->stream != stream || template->version != stream->tx_version) {
+        memcpy(buf, stream->tx_buf, stream->tx_len);
+        template->stream = stream;
+        template->version = stream->tx_version;
+        return;
     }
 
-    /* Update BBL header fields */
-    ptr = stream->tx_buf + stream->tx_len - 16;
-    *(uint64_t*)ptr = stream->flow_seq; ptr += sizeof(uint64_t);
-    *(uint32_t*)ptr = io->timestamp.tv_sec; ptr += sizeof(uint32_t);
-    *(uint32_t*)ptr = io->timestamp.tv_nsec;
+    offset = stream->tx_len - 16;
+    memcpy(buf + offset, stream->tx_buf + offset, 16);
     if(stream->tcp) {
-        bbl_stream_update_tcp(stream);
+        /* TCP flags and checksum */
+        offset = stream->tx_len - (stream->tx_bbl_hdr_len + TCP_HDR_LEN_MIN) + 13;
+        memcpy(buf + offset, stream->tx_buf + offset, 5);
     } else if(g_ctx->config.stream_udp_checksum) {
-        bbl_stream_update_udp(stream);
-    }
-    if(stream->flow_seq == 1) {
-        stream->tx_first_epoch = io->timestamp.tv_sec;
+        /* UDP checksum */
+        offset = stream->tx_len - (stream->tx_bbl_hdr_len + UDP_HDR_LEN) + 6;
+        memcpy(buf + offset, stream->tx_buf + offset, 2);
     }
-    return PROTOCOL_SUCCESS;
 }
 
 /**
@@ -1501,17 +1932,19 @@ bbl_stream_io_send(bbl_stream_s *stream)
 void
 bbl_stream_io_stop(io_handle_s *io)
 {
-    io_bucket_s *io_bucket = io->bucket_head;
-    while(io_bucket) {
-        io_bucket->base = 0;
-        io_bucket->stream_cur = NULL;
-        io_bucket = io_bucket->next;
-    }
+    atomic_store_explicit(&io->sched.reset, true, memory_order_release);
 }
 
 /**
  * bbl_stream_io_send_iter
  *
+ * Pop the next stream due to send from the IO handle 
+ * calendar queue. Every stream is rescheduled with its
+ * own interval after being visited, such that only 
+ * streams due to send are visited with constant work 
+ * per packet, independent of the number of streams 
+ * and rates per IO handle. 
+ *
  * @param io IO handle
  * @param now nsec timestamp (CLOCK_MONOTONIC)
  * @return stream or NULL if nothing to send
@@ -1519,57 +1952,42 @@ bbl_stream_io_stop(io_handle_s *io)
 bbl_stream_s *
 bbl_stream_io_send_iter(io_handle_s *io, uint64_t now)
 {
-    io_bucket_s *io_bucket = io->bucket_cur;
+    io_sched_s *sched = &io->sched;
     bbl_stream_s *stream;
+    uint64_t slot = now >> IO_SCHED_SLOT_BITS;
     uint64_t min = now - g_ctx->config.stream_burst_ms;
-    uint64_t expired;
-    while(io_bucket) {
-        if(io_bucket->stream_cur) {
-            stream = io_bucket->stream_cur;
-        } else {
-            stream = io_bucket->stream_head;
-            io_bucket->stream_cur = stream;
-            if(io_bucket->base) {
-                io_bucket->base += io_bucket->nsec;
-                if(io_bucket->base < min) {
-                    io_bucket->base = min;
-                }
-            } else {
-                io_bucket->base = now;
-            }
-        }
-        if(io_bucket->base >= now) {
-            /* next bucket */
-            io_bucket = io_bucket->next;
-            if(!io_bucket) io_bucket = io->bucket_head;
-            if(io_bucket == io->bucket_cur) return NULL;
-            continue;
-        }
-        expired = now - io_bucket->base;
-        while(stream) {
-            if(stream->expired > expired) {
-                io_bucket->stream_cur = stream;
-                break;
-            }
-            if (bbl_stream_io_send(stream) == PROTOCOL_SUCCESS) {
-                io_bucket->stream_cur = stream->io_next;
-                io->bucket_cur = io_bucket;
+    protocol_error_t result;
+
+    if(unlikely(atomic_load_explicit(&sched->reset, memory_order_acquire))) {
+        io_stream_sched_init(io, now);
+    }
+    while(true) {
+        while((stream = sched->list)) {
+            sched->list = stream->sched_next;
+            if(stream->sched_time >= sched->list_end) {
+                /* Stream is scheduled beyond the 
+                 * wheel horizon (next rotation). */
+                io_stream_sched_add(io, stream);
+                continue;
+            }
+            result = bbl_stream_io_send(stream);
+            stream->sched_time += stream->sched_interval;
+            if(stream->sched_time < min) {
+                stream->sched_time = min;
+            }
+            io_stream_sched_add(io, stream);
+            if(result == PROTOCOL_SUCCESS) {
                 return stream;
             }
-            stream = stream->io_next;
         }
-        if(!stream) {
-            if(io_bucket->stream_cur == io_bucket->stream_head) {
-                /* We can reset bucket base if none of the streams 
-                 * in the bucket is active. */
-                io_bucket->base = 0;
-            }
-            io_bucket->stream_cur = NULL;
+        /* Move to the next slot if elapsed. */
+        if(sched->cursor >= slot || !sched->wheel) {
+            return NULL;
         }
-        /* next bucket */
-        io_bucket = io_bucket->next;
-        if(!io_bucket) io_bucket = io->bucket_head;
-        if(io_bucket == io->bucket_cur) return NULL;
+        sched->list = sched->wheel[sched->cursor & IO_SCHED_WHEEL_MASK];
+        sched->wheel[sched->cursor & IO_SCHED_WHEEL_MASK] = NULL;
+        sched->cursor++;
+        sched->list_end = sched->cursor << IO_SCHED_SLOT_BITS;
     }
     return NULL;
 }
@@ -1579,17 +1997,30 @@ bbl_stream_group_job(timer_s *timer)
 {
     bbl_stream_group_s *group = timer->data;
     bbl_stream_s *stream = group->head;
+
+    uint64_t tx_packets = 0;
+    uint64_t rx_packets = 0;
+    uint64_t rx_loss = 0;
+
     while(stream) {
         bbl_stream_ctrl(stream);
+        tx_packets += stream->last_sync_packets_tx;
+        rx_packets += stream->last_sync_packets_rx;
+        rx_loss += stream->last_sync_loss;
         stream = stream->group_next;
     }
+    group->tx_packets = tx_packets;
+    group->rx_packets = rx_packets;
+    group->rx_loss = rx_loss;
 }
 
 static bbl_stream_group_s *
 bbl_stream_group_init(double pps)
 {
+    static uint32_t id = 0;
     time_t interval = 1;
     bbl_stream_group_s *group = calloc(1, sizeof(bbl_stream_group_s));
+    group->id = id++;
     group->pps = pps;
     if(pps < 1.0) {
         interval = 1.0 / pps;
@@ -1670,9 +2101,6 @@ bbl_stream_select_io(bbl_stream_s *stream)
         }
         io_iter = io_iter->next;
     }
-    if(io->thread) {
-        stream->threaded = true;
-    }
     io_stream_add(io, stream);
 }
 
@@ -1689,6 +2117,10 @@ bbl_stream_add(bbl_stream_s *stream)
     if(stream->config->setup_interval) {
         stream->setup = true;
     }
+    if(stream->ldp_lookup) {
+        stream->ldp_next = g_ctx->stream_ldp;
+        g_ctx->stream_ldp = stream;
+    }
     if(g_ctx->stream_head) {
         g_ctx->stream_tail->next = stream;
     } else {
@@ -1711,7 +2143,7 @@ bbl_stream_session_add(bbl_stream_config_s *config, bbl_session_s *session)
     assert(config);
     assert(session);
 
-    access_interface = session->access_interface;
+    access_interface = session->hot->access_interface;
     /* *
      * The corresponding network/a01nsp interfaces will be selected
      * in the following order:
@@ -1950,6 +2382,9 @@ bbl_stream_init() {
     uint32_t group;
     uint32_t source;
 
+    timer_add_periodic(&g_ctx->timer_root, &g_ctx->stream_stats_job, "Stream Stats", 
+                       1, 0, g_ctx, &bbl_stream_stats_job);
+
     /* Add RAW streams */
     config = g_ctx->config.stream_config;
     while(config) {
@@ -2182,6 +2617,11 @@ bbl_stream_reset(bbl_stream_s *stream)
 
     stream->rx_min_delay_us = 0;
     stream->rx_max_delay_us = 0;
+    stream->rx_transit_ns = 0;
+    stream->rx_jitter = 0;
+    if(stream->rx_delay_hist) {
+        hist_reset(stream->rx_delay_hist);
+    }
     stream->rx_len = 0;
     stream->rx_fragments = 0;
     stream->rx_fragment_offset = 0;
@@ -2199,6 +2639,9 @@ bbl_stream_reset(bbl_stream_s *stream)
     stream->rx_mpls2_label = 0;
     stream->rx_source_ip = 0;
     stream->rx_source_port = 0;
+    if(stream->nat && stream->reverse) {
+        bbl_stream_tx_ctrl_update(stream->reverse);
+    }
     stream->rx_first_seq = 0;
     stream->rx_last_seq = 0;
 
@@ -2332,16 +2775,16 @@ bbl_stream_rx(bbl_ethernet_header_s *eth, uint8_t *mac)
                 if(!session) {
                     return NULL;
                 }
-                if(session->session_state == BBL_TERMINATED || 
-                   session->session_state == BBL_IDLE) {
+                if(session->hot->session_state == BBL_TERMINATED || 
+                   session->hot->session_state == BBL_IDLE) {
                     return NULL;
                 }
-                if(memcmp(session->client_mac, eth->dst, ETH_ADDR_LEN) != 0) {
+                if(memcmp(session->hot->client_mac, eth->dst, ETH_ADDR_LEN) != 0) {
                     return NULL;
                 }
                 if(stream->session_traffic) {
-                    if(bbl->outer_vlan_id != session->vlan_key.outer_vlan_id ||
-                       bbl->inner_vlan_id != session->vlan_key.inner_vlan_id ||
+                    if(bbl->outer_vlan_id != session->hot->vlan_key.outer_vlan_id ||
+                       bbl->inner_vlan_id != session->hot->vlan_key.inner_vlan_id ||
                        bbl->session_id != session->session_id) {
                         stream->rx_wrong_session++;
                         return NULL;
@@ -2509,6 +2952,76 @@ NEXT:
     return jobj_array;
 }
 
+/**
+ * bbl_stream_delay_json
+ *
+ * Aggregate delay and jitter of all unicast streams
+ * matching the given filters by merging the per-stream
+ * delay histograms. 
+ */
+static json_t *
+bbl_stream_delay_json(int session_group_id, const char *name, const char *interface, uint8_t direction)
+{
+    bbl_stream_s *stream = g_ctx->stream_head;
+    json_t *jobj;
+    hist_s hist = {0};
+
+    uint64_t streams = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    uint64_t jitter;
+    uint64_t jitter_sum = 0;
+    uint64_t jitter_max = 0;
+
+    while(stream) {
+        if(stream->type != BBL_TYPE_UNICAST || !stream->verified) goto NEXT;
+        if(session_group_id >= 0) {
+            if(!(stream->session && stream->session->session_group_id == session_group_id)) goto NEXT;
+        }
+        if(name) {
+            if(!strcmp(name, stream->config->name) == 0) goto NEXT;
+        }
+        if(interface) {
+            if(!strcmp(interface, stream->tx_interface->name) == 0) goto NEXT;
+        }
+        if(!(stream->direction & direction)) goto NEXT;
+
+        streams++;
+        if(stream->rx_min_delay_us && (!min || stream->rx_min_delay_us < min)) {
+            min = stream->rx_min_delay_us;
+        }
+        if(stream->rx_max_delay_us > max) {
+            max = stream->rx_max_delay_us;
+        }
+        jitter = stream->rx_jitter >> 4;
+        jitter_sum += jitter;
+        if(jitter > jitter_max) {
+            jitter_max = jitter;
+        }
+        if(stream->rx_delay_hist) {
+            hist_merge(&hist, stream->rx_delay_hist);
+        }
+NEXT:
+        stream = stream->next;
+    }
+
+    jobj = json_pack("{sI sI sI sf sf}",
+        "streams", streams,
+        "delay-us-min", min,
+        "delay-us-max", max,
+        "jitter-us-avg", streams ? (double)jitter_sum / streams / 1000.0 : 0.0,
+        "jitter-us-max", (double)jitter_max / 1000.0);
+    if(jobj && hist.count) {
+        json_object_set_new(jobj, "delay-packets", json_integer(hist.count));
+        json_object_set_new(jobj, "delay-packets-overflow", json_integer(hist.overflow));
+        json_object_set_new(jobj, "delay-us-p50", json_integer(hist_percentile(&hist, 50)));
+        json_object_set_new(jobj, "delay-us-p90", json_integer(hist_percentile(&hist, 90)));
+        json_object_set_new(jobj, "delay-us-p99", json_integer(hist_percentile(&hist, 99)));
+        json_object_set_new(jobj, "delay-us-p999", json_integer(hist_percentile(&hist, 99.9)));
+    }
+    return jobj;
+}
+
 json_t *
 bbl_stream_json(bbl_stream_s *stream, bool debug)
 {
@@ -2586,9 +3099,9 @@ bbl_stream_json(bbl_stream_s *stream, bool debug)
             "rx-outer-vlan-pbit", stream->rx_outer_vlan_pbit,
             "rx-inner-vlan-pbit", stream->rx_inner_vlan_pbit,
             "rx-len", stream->rx_len,
-            "tx-len", stream->tx_len,
+            "tx-len", stream->tx_ctrl_len,
             "tx-packets", stream->tx_packets - stream->reset_packets_tx,
-            "tx-bytes", (stream->tx_packets - stream->reset_packets_tx) * stream->tx_len,
+            "tx-bytes", (stream->tx_packets - stream->reset_packets_tx) * stream->tx_ctrl_len,
             "rx-packets", stream->rx_packets - stream->reset_packets_rx,
             "rx-bytes", (stream->rx_packets - stream->reset_packets_rx) * stream->rx_len,
             "rx-loss", stream->rx_loss - stream->reset_loss,
@@ -2599,10 +3112,10 @@ bbl_stream_json(bbl_stream_s *stream, bool debug)
             "tx-pps", stream->rate_packets_tx.avg,
             "rx-pps-max", stream->rate_packets_rx.avg_max,
             "tx-pps-max", stream->rate_packets_tx.avg_max,
-            "tx-bps-l2", stream->rate_packets_tx.avg * stream->tx_len * 8,
+            "tx-bps-l2", stream->rate_packets_tx.avg * stream->tx_ctrl_len * 8,
             "rx-bps-l2", stream->rate_packets_rx.avg * stream->rx_len * 8,
             "rx-bps-l3", stream->rate_packets_rx.avg * stream->config->length * 8,
-            "tx-mbps-l2", (double)(stream->rate_packets_tx.avg * stream->tx_len * 8) / 1000000.0,
+            "tx-mbps-l2", (double)(stream->rate_packets_tx.avg * stream->tx_ctrl_len * 8) / 1000000.0,
             "rx-mbps-l2", (double)(stream->rate_packets_rx.avg * stream->rx_len * 8) / 1000000.0,
             "rx-mbps-l3", (double)(stream->rate_packets_rx.avg * stream->config->length * 8) / 1000000.0,
             "tx-first-epoch", stream->tx_first_epoch,
@@ -2610,6 +3123,16 @@ bbl_stream_json(bbl_stream_s *stream, bool debug)
             "rx-last-epoch", stream->rx_last_epoch
             );
 
+        if(g_ctx->config.stream_delay_calc) {
+            json_object_set_new(root, "rx-jitter-us", json_real((double)(stream->rx_jitter >> 4) / 1000.0));
+        }
+        if(stream->rx_delay_hist) {
+            json_object_set_new(root, "rx-delay-packets-overflow", json_integer(stream->rx_delay_hist->overflow));
+            json_object_set_new(root, "rx-delay-us-p50", json_integer(hist_percentile(stream->rx_delay_hist, 50)));
+            json_object_set_new(root, "rx-delay-us-p90", json_integer(hist_percentile(stream->rx_delay_hist, 90)));
+            json_object_set_new(root, "rx-delay-us-p99", json_integer(hist_percentile(stream->rx_delay_hist, 99)));
+            json_object_set_new(root, "rx-delay-us-p999", json_integer(hist_percentile(stream->rx_delay_hist, 99.9)));
+        }
         if(stream->rx_interface_changes) { 
             json_object_set_new(root, "rx-interface-changes", json_integer(stream->rx_interface_changes));
             json_object_set_new(root, "rx-interface-changed-epoch", json_integer(stream->rx_interface_changed_epoch));
@@ -2662,12 +3185,12 @@ bbl_stream_json(bbl_stream_s *stream, bool debug)
             "active", *(stream->endpoint) == ENDPOINT_ACTIVE ? true : false,
             "tx-interface", tx_interface,
             "tx-interface-state", tx_interface_state,
-            "tx-len", stream->tx_len,
+            "tx-len", stream->tx_ctrl_len,
             "tx-packets", stream->tx_packets - stream->reset_packets_tx,
             "tx-pps", stream->rate_packets_tx.avg,
             "tx-pps-max", stream->rate_packets_tx.avg_max,
-            "tx-bps-l2", stream->rate_packets_tx.avg * stream->tx_len * 8,
-            "tx-mbps-l2", (double)(stream->rate_packets_tx.avg * stream->tx_len * 8) / 1000000.0);
+            "tx-bps-l2", stream->rate_packets_tx.avg * stream->tx_ctrl_len * 8,
+            "tx-mbps-l2", (double)(stream->rate_packets_tx.avg * stream->tx_ctrl_len * 8) / 1000000.0);
     }
     if(root && debug) {
         /* Add debug informations. */
@@ -2788,6 +3311,189 @@ bbl_stream_ctrl_summary(int fd, uint32_t session_id __attribute__((unused)), jso
     return result;
 }
 
+/**
+ * bbl_stream_export
+ *
+ * Copy the counters of all streams in one pass into
+ * a columnar buffer (see bbl_stream_export_hdr_s).
+ */
+static uint8_t *
+bbl_stream_export(size_t *len)
+{
+    bbl_stream_export_hdr_s *hdr;
+    bbl_stream_s *stream = g_ctx->stream_head;
+    uint64_t streams = g_ctx->streams;
+    uint64_t i = 0;
+    uint8_t *buf;
+    uint8_t flags;
+
+    uint64_t *flow_id, *tx_packets, *rx_packets, *rx_loss, *rx_wrong_order;
+    uint64_t *rx_min_delay, *rx_max_delay, *rx_jitter;
+    uint16_t *tx_len, *rx_len;
+    uint8_t *rx_flags;
+
+    *len = sizeof(bbl_stream_export_hdr_s) + streams * BBL_STREAM_EXPORT_ROW_LEN;
+    buf = malloc(*len);
+    if(!buf) {
+        return NULL;
+    }
+    flow_id = (uint64_t*)(buf + sizeof(bbl_stream_export_hdr_s));
+    tx_packets = flow_id + streams;
+    rx_packets = tx_packets + streams;
+    rx_loss = rx_packets + streams;
+    rx_wrong_order = rx_loss + streams;
+    rx_min_delay = rx_wrong_order + streams;
+    rx_max_delay = rx_min_delay + streams;
+    rx_jitter = rx_max_delay + streams;
+    tx_len = (uint16_t*)(rx_jitter + streams);
+    rx_len = tx_len + streams;
+    rx_flags = (uint8_t*)(rx_len + streams);
+
+    while(stream && i < streams) {
+        flow_id[i] = stream->flow_id;
+        tx_packets[i] = stream->tx_packets - stream->reset_packets_tx;
+        rx_packets[i] = stream->rx_packets - stream->reset_packets_rx;
+        rx_loss[i] = stream->rx_loss - stream->reset_loss;
+        rx_wrong_order[i] = stream->rx_wrong_order;
+        rx_min_delay[i] = stream->rx_min_delay_us;
+        rx_max_delay[i] = stream->rx_max_delay_us;
+        rx_jitter[i] = stream->rx_jitter >> 4;
+        tx_len[i] = stream->tx_ctrl_len;
+        rx_len[i] = stream->rx_len;
+        flags = 0;
+        if(stream->direction == BBL_DIRECTION_UP) flags |= BBL_STREAM_EXPORT_FLAG_UP;
+        if(stream->enabled) flags |= BBL_STREAM_EXPORT_FLAG_ENABLED;
+        if(stream->verified) flags |= BBL_STREAM_EXPORT_FLAG_VERIFIED;
+        if(*(stream->endpoint) == ENDPOINT_ACTIVE) flags |= BBL_STREAM_EXPORT_FLAG_ACTIVE;
+        rx_flags[i] = flags;
+        stream = stream->next;
+        i++;
+    }
+    /* Zero columns of streams not found. */
+    while(i < streams) {
+        flow_id[i] = 0; tx_packets[i] = 0; rx_packets[i] = 0;
+        rx_loss[i] = 0; rx_wrong_order[i] = 0; rx_min_delay[i] = 0;
+        rx_max_delay[i] = 0; rx_jitter[i] = 0; tx_len[i] = 0; 
+        rx_len[i] = 0; rx_flags[i] = 0;
+        i++;
+    }
+
+    hdr = (bbl_stream_export_hdr_s*)buf;
+    hdr->magic = BBL_STREAM_EXPORT_MAGIC;
+    hdr->version = BBL_STREAM_EXPORT_VERSION;
+    hdr->columns = BBL_STREAM_EXPORT_COLUMNS;
+    hdr->streams = streams;
+    hdr->timestamp = time(NULL);
+    return buf;
+}
+
+static bool
+bbl_stream_export_write(int fd, uint8_t *buf, size_t len)
+{
+    ssize_t rc;
+    while(len) {
+        rc = write(fd, buf, len);
+        if(rc < 0) {
+            if(errno == EINTR) continue;
+            return false;
+        }
+        buf += rc;
+        len -= rc;
+    }
+    return true;
+}
+
+int
+bbl_stream_ctrl_export(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    int result = 0;
+    int file_fd;
+    const char *file_path = NULL;
+    uint8_t *buf;
+    size_t len;
+
+    json_unpack(arguments, "{s:s}", "file", &file_path);
+
+    buf = bbl_stream_export(&len);
+    if(!buf) {
+        return bbl_ctrl_status(fd, "error", 500, "internal error");
+    }
+    if(!file_path) {
+        /* Binary export is written directly to the socket. */
+        if(!bbl_stream_export_write(fd, buf, len)) {
+            result = -1;
+        }
+        free(buf);
+        return result;
+    }
+
+    file_fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(file_fd < 0) {
+        free(buf);
+        return bbl_ctrl_status(fd, "error", 500, "failed to open file");
+    }
+    if(!bbl_stream_export_write(file_fd, buf, len)) {
+        close(file_fd);
+        free(buf);
+        return bbl_ctrl_status(fd, "error", 500, "failed to write file");
+    }
+    close(file_fd);
+    free(buf);
+
+    json_t *root = json_pack("{ss si s{sI sI}}",
+        "status", "ok",
+        "code", 200,
+        "stream-export", 
+        "streams", (len - sizeof(bbl_stream_export_hdr_s)) / BBL_STREAM_EXPORT_ROW_LEN,
+        "bytes", len);
+    if(root) {
+        result = json_dumpfd(root, fd, 0);
+        json_decref(root);
+    }
+    return result;
+}
+
+int
+bbl_stream_ctrl_delay(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    int result = 0;
+
+    const char *name = NULL;
+    const char *interface = NULL;
+    const char *s = NULL;
+
+    int session_group_id = -1;
+    uint8_t direction = BBL_DIRECTION_BOTH;
+
+    if(json_unpack(arguments, "{s:i}", "session-group-id", &session_group_id) == 0) {
+        if(session_group_id < 0 || session_group_id > UINT16_MAX) {
+            return bbl_ctrl_status(fd, "error", 400, "invalid session-group-id");
+        }
+    }
+    if(json_unpack(arguments, "{s:s}", "direction", &s) == 0) {
+        if(strcmp(s, "upstream") == 0) {
+            direction = BBL_DIRECTION_UP;
+        } else if(strcmp(s, "downstream") == 0) {
+            direction = BBL_DIRECTION_DOWN;
+        } else if(strcmp(s, "both") == 0) {
+            direction = BBL_DIRECTION_BOTH;
+        } else {
+            return bbl_ctrl_status(fd, "error", 400, "invalid direction");
+        }
+    }
+    json_unpack(arguments, "{s:s}", "name", &name);
+    json_unpack(arguments, "{s:s}", "interface", &interface);
+
+    json_t *root = json_pack("{ss si so*}",
+        "status", "ok",
+        "code", 200,
+        "stream-delay", bbl_stream_delay_json(session_group_id, name, interface, direction));
+
+    result = json_dumpfd(root, fd, 0);
+    json_decref(root);
+    return result;
+}
+
 int
 bbl_stream_ctrl_session(int fd, uint32_t session_id, json_t *arguments __attribute__((unused)))
 {
@@ -2819,7 +3525,7 @@ bbl_stream_ctrl_session(int fd, uint32_t session_id, json_t *arguments __attribu
                          "code", 200,
                          "session-streams",
                          "session-id", session->session_id,
-                         "rx-packets", session->stats.packets_rx,
+                         "rx-packets", session->hot->packets_rx,
                          "tx-packets", session->stats.packets_tx,
                          "rx-accounting-packets", session->stats.accounting_packets_rx,
                          "tx-accounting-packets", session->stats.accounting_packets_tx,
@@ -9,12 +9,20 @@
 #ifndef __BBL_STREAM_H__
 #define __BBL_STREAM_H__
 
+#define BBL_STREAM_TX_CTRL_INTERVAL (10 * MSEC)
+
 typedef enum {
     STREAM_STATE_ANY         = 0,
     STREAM_STATE_VERIFIED    = 1,
     STREAM_STATE_BIVERIFIED  = 2,
 } stream_state_t;
 
+typedef enum {
+    STREAM_TX_CTRL_NONE     = 0,
+    STREAM_TX_CTRL_BUILD    = 1,
+    STREAM_TX_CTRL_FREE     = 2,
+} bbl_stream_tx_ctrl_t;
+
 typedef struct bbl_stream_config_
 {
     char *name;
@@ -76,15 +84,115 @@ typedef struct bbl_stream_config_
     bbl_stream_config_s *next; /* Next stream config */
 } bbl_stream_config_s;
 
+/**
+ * Binary stream export (stream-export) starts with this
+ * header followed by one column per counter, each carrying 
+ * the values of all streams. All values are written in host
+ * byte order, which readers detect using the magic:
+ *
+ * flow-id (u64), tx-packets (u64), rx-packets (u64),
+ * rx-loss (u64), rx-wrong-order (u64), rx-min-delay-us (u64),
+ * rx-max-delay-us (u64), rx-jitter-ns (u64), tx-len (u16),
+ * rx-len (u16), flags (u8)
+ */
+#define BBL_STREAM_EXPORT_MAGIC         0x534c4242 /* BBLS */
+#define BBL_STREAM_EXPORT_VERSION       1
+#define BBL_STREAM_EXPORT_COLUMNS       11
+#define BBL_STREAM_EXPORT_ROW_LEN       (8*8+2*2+1)
+
+#define BBL_STREAM_EXPORT_FLAG_UP       0x01
+#define BBL_STREAM_EXPORT_FLAG_ENABLED  0x02
+#define BBL_STREAM_EXPORT_FLAG_VERIFIED 0x04
+#define BBL_STREAM_EXPORT_FLAG_ACTIVE   0x08
+
+typedef struct bbl_stream_export_hdr_ {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t columns;
+    uint64_t streams;
+    uint64_t timestamp;
+} __attribute__ ((__packed__)) bbl_stream_export_hdr_s;
+
 typedef struct bbl_stream_group_
 {
+    uint32_t id;
     double pps;
     uint32_t count;
+
+    /* Sum of all streams updated by group job. */
+    uint64_t tx_packets;
+    uint64_t rx_packets;
+    uint64_t rx_loss;
+
     bbl_stream_s *head;
     struct timer_ *timer;
     bbl_stream_group_s *next;
 } bbl_stream_group_s;
 
+typedef struct bbl_stream_counters_
+{
+    uint64_t packets_tx;
+    uint64_t bytes_tx;
+    uint64_t stream_tx;
+    uint64_t mc_tx;
+    uint64_t session_ipv4_tx;
+    uint64_t session_ipv6_tx;
+    uint64_t session_ipv6pd_tx;
+
+    uint64_t packets_rx;
+    uint64_t bytes_rx;
+    uint64_t stream_rx;
+    uint64_t stream_loss;
+    uint64_t session_ipv4_rx;
+    uint64_t session_ipv6_rx;
+    uint64_t session_ipv6pd_rx;
+    uint64_t session_ipv4_loss;
+    uint64_t session_ipv6_loss;
+    uint64_t session_ipv6pd_loss;
+} bbl_stream_counters_s;
+
+/**
+ * Stream interface counters of one thread and logical 
+ * interface. The counters are written by the owning 
+ * (TX/RX or main) thread only and folded into the 
+ * interface stats by the main thread once per 
+ * second (epoch), so that the main thread does not 
+ * need to walk all streams for interface stats. 
+ * 
+ * Records are never removed, new records are 
+ * added to the head of the owner list. 
+ */
+typedef struct bbl_stream_stats_
+{
+    bbl_stream_stats_s **owner; /* owner list head */
+    bbl_access_interface_s *access_interface;
+    bbl_network_interface_s *network_interface;
+    bbl_a10nsp_interface_s *a10nsp_interface;
+
+    volatile bbl_stream_counters_s counters; /* owner thread */
+    bbl_stream_counters_s synced; /* main thread */
+
+    bbl_stream_stats_s *next;
+} bbl_stream_stats_s;
+
+/**
+ * Stream packet built by the main thread, including
+ * a copy of the L3 addresses required to calculate
+ * the L4 checksum in the thread sending the stream.
+ * The packet is owned by the TX thread once passed.
+ */
+typedef struct bbl_stream_packet_
+{
+    uint8_t *buf;
+    uint16_t len;
+    uint16_t bbl_hdr_len;
+    bool ipv6;
+    uint32_t ipv4_src;
+    uint32_t ipv4_dst;
+    ipv6addr_t ipv6_src;
+    ipv6addr_t ipv6_dst;
+} bbl_stream_packet_s;
+
 /**
  * In the architecture of BNG Blaster, every traffic stream 
  * corresponds to one or two flows, namely upstream and downstream. 
@@ -95,6 +203,15 @@ typedef struct bbl_stream_group_
  * by the main thread, the second section by the TX thread, and the 
  * final section by the RX thread. This design was used to allow 
  * lock-free but thread-safe access across different threads.
+ *
+ * The TX packet (tx_packet, tx_buf and related fields) is owned by the 
+ * thread sending the stream. Stream packets are always built by the 
+ * main thread, which owns the session, endpoint and LDP state. For 
+ * threaded streams, the new packet is passed to the TX thread via the 
+ * thread stream message ring (see io_thread_stream_msg), which swaps it 
+ * in and frees the old one, such that TX threads never read session 
+ * state. Threaded streams are checked only after session, endpoint or 
+ * LDP state has changed (see bbl_stream_tx_ctrl_update).
  */
 typedef struct bbl_stream_
 {
@@ -107,7 +224,6 @@ typedef struct bbl_stream_
     uint64_t reset_packets_rx;
     uint64_t reset_loss;
 
-    bbl_rate_s rate_packets_tx;
     bbl_rate_s rate_packets_rx;
 
     uint64_t flow_id; /* KEY */
@@ -128,6 +244,8 @@ typedef struct bbl_stream_
     bool tcp;
     bool lag;
     bool ldp_lookup;
+    bool tx_ctrl_active; /* TX packet requested by main thread */
+    bool tx_ctrl_pending; /* TX control check pending */
 
     uint32_t session_version;
     uint32_t ldp_entry_version;
@@ -138,9 +256,7 @@ typedef struct bbl_stream_
     double pps;
     uint64_t expired;
 
-    uint16_t tx_len; /* TX length */
-    uint16_t tx_bbl_hdr_len; /* TX BBL HDR length */
-    uint8_t *tx_buf; /* TX buffer */
+    uint16_t tx_ctrl_len; /* TX length of the last packet built */
 
     uint8_t *ipv6_src;
     uint8_t *ipv6_dst;
@@ -153,6 +269,8 @@ typedef struct bbl_stream_
     bbl_stream_s *lag_next; /* Next stream of same LAG group */
     bbl_stream_s *session_next; /* Next stream of same session */
     bbl_stream_s *reverse; /* Reverse stream direction */
+    bbl_stream_s *tx_ctrl_next; /* Next stream with pending TX control check */
+    bbl_stream_s *ldp_next; /* Next stream with LDP lookup */
 
     bbl_stream_group_s *group;
     bbl_session_s *session;
@@ -168,11 +286,25 @@ typedef struct bbl_stream_
 
     char _pad0 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
+    uint16_t tx_len; /* TX length */
+    uint16_t tx_bbl_hdr_len; /* TX BBL HDR length */
+    uint8_t *tx_buf; /* TX buffer */
+    uint32_t tx_version; /* TX buffer version (incremented with every new TX buffer) */
+    uint32_t tx_checksum_version; /* TX buffer version with valid L4 checksum */
+    bbl_stream_packet_s *tx_packet; /* TX packet */
+
     volatile uint64_t tx_packets;
+    uint64_t tx_epoch_packets; /* TX packets folded into tx_stats */
+    bbl_stream_stats_s *tx_stats;
+    bbl_rate_s rate_packets_tx;
 
     uint64_t flow_seq;
     uint64_t max_packets;
 
+    uint64_t sched_time; /* next TX time (nsec) */
+    uint64_t sched_interval; /* TX interval (nsec) */
+    bbl_stream_s *sched_next; /* next stream of same IO scheduler slot */
+
     __time_t tx_first_epoch;
 
     struct timespec wait_start;
@@ -181,12 +313,17 @@ typedef struct bbl_stream_
 
     volatile uint64_t rx_packets;
     volatile uint64_t rx_loss;
+    uint64_t rx_stats_loss; /* RX loss folded into rx_stats */
+    bbl_stream_stats_s *rx_stats;
     
     uint64_t rx_wrong_session;
     uint64_t rx_wrong_order;
 
     uint64_t rx_min_delay_us;
     uint64_t rx_max_delay_us;
+    int64_t  rx_transit_ns; /* Last transit time (RX - TX timestamp) */
+    uint64_t rx_jitter; /* RFC 3550 interarrival jitter in nanoseconds * 16 */
+    hist_s  *rx_delay_hist; /* Delay histogram in microseconds */
 
     uint16_t rx_len;
     uint64_t rx_first_seq;
@@ -240,12 +377,48 @@ bbl_stream_init();
 void
 bbl_stream_final();
 
+void
+bbl_stream_tx_epoch(io_handle_s *io, bbl_stream_stats_s **stats);
+
+void
+bbl_stream_rx_account(bbl_stream_s *stream, bbl_stream_stats_s **stats);
+
+void
+bbl_stream_stats_job(timer_s *timer);
+
 void
 bbl_stream_io_stop(io_handle_s *io);
 
 bbl_stream_s *
 bbl_stream_io_send_iter(io_handle_s *io, uint64_t now);
 
+void
+bbl_stream_packet_free(bbl_stream_packet_s *packet);
+
+void
+bbl_stream_tx_msg(bbl_stream_s *stream, io_stream_msg_type_t type, bbl_stream_packet_s *packet);
+
+void
+bbl_stream_tx_ctrl_update(bbl_stream_s *stream);
+
+void
+bbl_stream_session_update(bbl_session_s *session);
+
+void
+bbl_stream_multicast_update();
+
+void
+bbl_stream_ldp_update();
+
+void
+bbl_stream_tx_ctrl_job(timer_s *timer);
+
+void
+bbl_stream_tx_update(bbl_stream_s *stream, struct timespec *timestamp);
+
+void
+bbl_stream_tx_template(bbl_stream_s *stream, uint8_t *buf, io_template_s *template);
+
 bbl_stream_s *
 bbl_stream_rx(bbl_ethernet_header_s *eth, uint8_t *mac);
 
@@ -264,6 +437,12 @@ bbl_stream_ctrl_info(int fd, uint32_t session_id __attribute__((unused)), json_t
 int
 bbl_stream_ctrl_summary(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments __attribute__((unused)));
 
+int
+bbl_stream_ctrl_export(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
+
+int
+bbl_stream_ctrl_delay(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
+
 int
 bbl_stream_ctrl_session(int fd, uint32_t session_id, json_t *arguments __attribute__((unused)));
 
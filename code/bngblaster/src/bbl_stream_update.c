@@ -0,0 +1,120 @@
+/*
+ * BNG Blaster (BBL) - Stream TX Update
+ *
+ * Per packet update of BBL sequence, timestamp and 
+ * L4 checksum of the stream TX buffer.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "bbl.h"
+#include "bbl_stream.h"
+
+/**
+ * Update L4 checksum after BBL sequence and timestamp have
+ * changed. The checksum is updated incrementally if the 
+ * TX buffer still holds a valid checksum, otherwise it is
+ * calculated over the full L4 header and payload. 
+ *
+ * @param stream stream
+ * @param l4 L4 header
+ * @param l4_len L4 length
+ * @param checksum L4 checksum
+ * @param old last 17 bytes of the L4 payload before update
+ * @return true if checksum was updated incrementally
+ */
+static bool
+bbl_stream_update_checksum(bbl_stream_s *stream, uint8_t *l4, uint16_t l4_len, uint16_t *checksum, uint8_t *old)
+{
+    uint16_t offset;
+
+    if(stream->tx_checksum_version != stream->tx_version) {
+        stream->tx_checksum_version = stream->tx_version;
+        return false;
+    }
+    /* Changed bytes starting with the 16 bit word containing 
+     * the first byte of the BBL sequence up to the end. */
+    offset = (l4_len - 16) & ~1;
+    *checksum = bbl_checksum_update(*checksum, old + 17 - (l4_len - offset), 
+                                    l4 + offset, l4_len - offset);
+    return true;
+}
+
+static void
+bbl_stream_update_tcp(bbl_stream_s *stream, uint8_t *old)
+{
+    bbl_stream_packet_s *packet = stream->tx_packet;
+    uint16_t  tcp_len = stream->tx_bbl_hdr_len + TCP_HDR_LEN_MIN;
+    uint8_t  *tcp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - tcp_len));
+    uint16_t *checksum = (uint16_t*)(tcp_buf+16);
+    uint8_t   flags[2];
+
+    if(bbl_stream_update_checksum(stream, tcp_buf, tcp_len, checksum, old)) {
+        if(stream->tcp_flags && *(tcp_buf+13) != (stream->tcp_flags & 0x3f)) {
+            /* Data offset and flags */
+            flags[0] = *(tcp_buf+12);
+            flags[1] = *(tcp_buf+13);
+            *(tcp_buf+13) = stream->tcp_flags & 0x3f;
+            *checksum = bbl_checksum_update(*checksum, flags, tcp_buf+12, sizeof(flags));
+        }
+        return;
+    }
+
+    if(stream->tcp_flags) {
+        *(tcp_buf+13) = stream->tcp_flags & 0x3f;
+    }
+
+    *checksum = 0;
+    if(packet->ipv6) {
+        *checksum = bbl_ipv6_tcp_checksum(packet->ipv6_src, packet->ipv6_dst, tcp_buf, tcp_len);
+    } else {
+        *checksum = bbl_ipv4_tcp_checksum(packet->ipv4_src, packet->ipv4_dst, tcp_buf, tcp_len);
+    }
+}
+
+static void
+bbl_stream_update_udp(bbl_stream_s *stream, uint8_t *old)
+{
+    bbl_stream_packet_s *packet = stream->tx_packet;
+    uint16_t  udp_len = stream->tx_bbl_hdr_len + UDP_HDR_LEN;
+    uint8_t  *udp_buf = (uint8_t*)(stream->tx_buf + (stream->tx_len - udp_len));
+    uint16_t *checksum = (uint16_t*)(udp_buf+6);
+
+    if(bbl_stream_update_checksum(stream, udp_buf, udp_len, checksum, old)) {
+        return;
+    }
+
+    *checksum = 0;
+    if(packet->ipv6) {
+        *checksum = bbl_ipv6_udp_checksum(packet->ipv6_src, packet->ipv6_dst, udp_buf, udp_len);
+    } else {
+        *checksum = bbl_ipv4_udp_checksum(packet->ipv4_src, packet->ipv4_dst, udp_buf, udp_len);
+    }
+}
+
+/**
+ * bbl_stream_tx_update
+ *
+ * Update BBL sequence and timestamp in the stream 
+ * TX buffer followed by the L4 checksum if required. 
+ *
+ * @param stream stream
+ * @param timestamp TX timestamp
+ */
+void
+bbl_stream_tx_update(bbl_stream_s *stream, struct timespec *timestamp)
+{
+    uint8_t *ptr;
+    uint8_t old[17]; /* BBL sequence and timestamp with preceding byte */
+
+    ptr = stream->tx_buf + stream->tx_len - 16;
+    memcpy(old, ptr - 1, sizeof(old));
+    *(uint64_t*)ptr = stream->flow_seq; ptr += sizeof(uint64_t);
+    *(uint32_t*)ptr = timestamp->tv_sec; ptr += sizeof(uint32_t);
+    *(uint32_t*)ptr = timestamp->tv_nsec;
+    if(stream->tcp) {
+        bbl_stream_update_tcp(stream, old);
+    } else if(g_ctx->config.stream_udp_checksum) {
+        bbl_stream_update_udp(stream, old);
+    }
+}
@@ -0,0 +1,439 @@
+/*
+ * BNG Blaster (BBL) - Control Socket Subscriptions
+ *
+ * Subscriptions push periodic delta records over the
+ * control socket connection, such that collectors do not
+ * need to poll and serialise all statistics repeatedly.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <sys/socket.h>
+#include "bbl.h"
+#include "bbl_session.h"
+#include "bbl_stream.h"
+#include "bbl_subscribe.h"
+
+static bbl_subscribe_s *g_subscriptions = NULL;
+static uint32_t g_subscribe_sessions = 0;
+
+static void
+bbl_subscribe_free(bbl_subscribe_s *subscribe)
+{
+    bbl_subscribe_s **prev = &g_subscriptions;
+    while(*prev) {
+        if(*prev == subscribe) {
+            *prev = subscribe->next;
+            break;
+        }
+        prev = &(*prev)->next;
+    }
+    if(subscribe->topics & BBL_SUBSCRIBE_SESSIONS) {
+        g_subscribe_sessions--;
+    }
+    LOG(INFO, "Subscription %u closed\n", subscribe->id);
+    if(subscribe->timer) {
+        /* Timer deletion is deferred, therefore the 
+         * reference must be removed before free. */
+        subscribe->timer->ptimer = NULL;
+        timer_del(subscribe->timer);
+        subscribe->timer = NULL;
+    }
+    close(subscribe->fd);
+    free(subscribe->interfaces);
+    free(subscribe->interfaces_next);
+    free(subscribe->stream_groups);
+    free(subscribe->stream_groups_next);
+    free(subscribe->session_changes);
+    free(subscribe);
+}
+
+/**
+ * bbl_subscribe_session_state
+ *
+ * Called on session state changes if there is
+ * at least one subscription for sessions.
+ */
+void
+bbl_subscribe_session_state(bbl_session_s *session)
+{
+    bbl_subscribe_s *subscribe = g_subscriptions;
+    bbl_subscribe_session_change_s *change;
+
+    if(!g_subscribe_sessions) {
+        return;
+    }
+    while(subscribe) {
+        if(subscribe->session_changes) {
+            if(subscribe->session_change_count < BBL_SUBSCRIBE_SESSION_CHANGES) {
+                change = &subscribe->session_changes[subscribe->session_change_count++];
+                change->session_id = session->session_id;
+                change->state = session->hot->session_state;
+            } else {
+                subscribe->session_changes_dropped++;
+            }
+        }
+        subscribe = subscribe->next;
+    }
+}
+
+/**
+ * Store current counter in the next snapshot, 
+ * which is committed only after the record was 
+ * sent (see bbl_subscribe_commit), and return 
+ * the delta to the last snapshot. 
+ */
+static inline uint64_t
+bbl_subscribe_delta(uint64_t last, uint64_t *next, uint64_t current)
+{
+    *next = current;
+    if(current > last) {
+        return current - last;
+    }
+    return 0;
+}
+
+static void
+bbl_subscribe_commit(bbl_subscribe_s *subscribe)
+{
+    if(subscribe->interfaces) {
+        memcpy(subscribe->interfaces, subscribe->interfaces_next, 
+               subscribe->interface_count * 4 * sizeof(uint64_t));
+    }
+    if(subscribe->stream_groups) {
+        memcpy(subscribe->stream_groups, subscribe->stream_groups_next, 
+               subscribe->stream_group_count * 3 * sizeof(uint64_t));
+    }
+}
+
+static json_t *
+bbl_subscribe_interfaces(bbl_subscribe_s *subscribe, double seconds)
+{
+    bbl_interface_s *interface;
+    io_handle_s *io;
+    json_t *jobj_array = json_array();
+    uint64_t *last = subscribe->interfaces;
+    uint64_t *next = subscribe->interfaces_next;
+    uint64_t tx_packets, tx_bytes, rx_packets, rx_bytes;
+    uint32_t i = 0;
+
+    CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+        if(i++ >= subscribe->interface_count) break;
+
+        tx_packets = 0;
+        tx_bytes = 0;
+        io = interface->io.tx;
+        while(io) {
+            tx_packets += io->stats.packets;
+            tx_bytes += io->stats.bytes;
+            io = io->next;
+        }
+        rx_packets = 0;
+        rx_bytes = 0;
+        io = interface->io.rx;
+        while(io) {
+            rx_packets += io->stats.packets;
+            rx_bytes += io->stats.bytes;
+            io = io->next;
+        }
+        tx_packets = bbl_subscribe_delta(last[0], &next[0], tx_packets);
+        tx_bytes = bbl_subscribe_delta(last[1], &next[1], tx_bytes);
+        rx_packets = bbl_subscribe_delta(last[2], &next[2], rx_packets);
+        rx_bytes = bbl_subscribe_delta(last[3], &next[3], rx_bytes);
+        last += 4;
+        next += 4;
+
+        json_array_append_new(jobj_array, json_pack("{ss ss sI sI sI sI sI sI sI sI}",
+            "name", interface->name,
+            "state", interface_state_string(interface->state),
+            "tx-packets", tx_packets,
+            "tx-bytes", tx_bytes,
+            "rx-packets", rx_packets,
+            "rx-bytes", rx_bytes,
+            "tx-pps", (json_int_t)(tx_packets / seconds),
+            "rx-pps", (json_int_t)(rx_packets / seconds),
+            "tx-kbps", (json_int_t)((tx_bytes * 8) / seconds / 1000),
+            "rx-kbps", (json_int_t)((rx_bytes * 8) / seconds / 1000)));
+    }
+    return jobj_array;
+}
+
+static json_t *
+bbl_subscribe_stream_groups(bbl_subscribe_s *subscribe, double seconds)
+{
+    bbl_stream_group_s *group = g_ctx->stream_groups;
+    json_t *jobj_array = json_array();
+    uint64_t *last;
+    uint64_t *next;
+    uint64_t *stream_groups;
+    uint64_t tx_packets, rx_packets, rx_loss;
+    uint32_t count;
+
+    while(group) {
+        if(group->id >= subscribe->stream_group_count) {
+            /* Groups are created dynamically with new streams. */
+            count = group->id + 1;
+            stream_groups = realloc(subscribe->stream_groups, count * 3 * sizeof(uint64_t));
+            if(!stream_groups) break;
+            memset(stream_groups + (subscribe->stream_group_count * 3), 0x0,
+                   (count - subscribe->stream_group_count) * 3 * sizeof(uint64_t));
+            subscribe->stream_groups = stream_groups;
+            stream_groups = realloc(subscribe->stream_groups_next, count * 3 * sizeof(uint64_t));
+            if(!stream_groups) break;
+            memset(stream_groups + (subscribe->stream_group_count * 3), 0x0,
+                   (count - subscribe->stream_group_count) * 3 * sizeof(uint64_t));
+            subscribe->stream_groups_next = stream_groups;
+            subscribe->stream_group_count = count;
+        }
+        last = &subscribe->stream_groups[group->id * 3];
+        next = &subscribe->stream_groups_next[group->id * 3];
+        tx_packets = bbl_subscribe_delta(last[0], &next[0], group->tx_packets);
+        rx_packets = bbl_subscribe_delta(last[1], &next[1], group->rx_packets);
+        rx_loss = bbl_subscribe_delta(last[2], &next[2], group->rx_loss);
+        if(tx_packets || rx_packets || rx_loss) {
+            /* Push only groups with changes. */
+            json_array_append_new(jobj_array, json_pack("{si sf si sI sI sI sI sI}",
+                "id", group->id,
+                "pps", group->pps,
+                "streams", group->count,
+                "tx-packets", tx_packets,
+                "rx-packets", rx_packets,
+                "rx-loss", rx_loss,
+                "tx-pps", (json_int_t)(tx_packets / seconds),
+                "rx-pps", (json_int_t)(rx_packets / seconds)));
+        }
+        group = group->next;
+    }
+    return jobj_array;
+}
+
+static json_t *
+bbl_subscribe_sessions(bbl_subscribe_s *subscribe)
+{
+    bbl_subscribe_session_change_s *change;
+    json_t *jobj_array = json_array();
+    json_t *jobj;
+    uint32_t i;
+
+    for(i = 0; i < subscribe->session_change_count; i++) {
+        change = &subscribe->session_changes[i];
+        json_array_append_new(jobj_array, json_pack("{si ss}",
+            "session-id", change->session_id,
+            "state", session_state_string(change->state)));
+    }
+    jobj = json_pack("{si si si si so}",
+        "sessions", g_ctx->sessions,
+        "established", g_ctx->sessions_established,
+        "outstanding", g_ctx->sessions_outstanding,
+        "terminated", g_ctx->sessions_terminated,
+        "changes", jobj_array);
+    if(jobj && subscribe->session_changes_dropped) {
+        json_object_set_new(jobj, "changes-dropped", json_integer(subscribe->session_changes_dropped));
+    }
+    return jobj;
+}
+
+void
+bbl_subscribe_job(timer_s *timer)
+{
+    bbl_subscribe_s *subscribe = timer->data;
+    struct timespec now;
+    struct timespec time_diff;
+    double seconds;
+    json_t *root;
+    char *record;
+    size_t len;
+    ssize_t sent;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timespec_sub(&time_diff, &now, &subscribe->last);
+    seconds = time_diff.tv_sec + (double)time_diff.tv_nsec / SEC;
+    if(seconds <= 0) {
+        return;
+    }
+
+    root = json_pack("{si sI sf}",
+        "subscription", subscribe->id,
+        "timestamp", (json_int_t)time(NULL),
+        "interval", seconds);
+    if(!root) {
+        return;
+    }
+    if(subscribe->topics & BBL_SUBSCRIBE_INTERFACES) {
+        json_object_set_new(root, "interfaces", bbl_subscribe_interfaces(subscribe, seconds));
+    }
+    if(subscribe->topics & BBL_SUBSCRIBE_STREAM_GROUPS) {
+        json_object_set_new(root, "stream-groups", bbl_subscribe_stream_groups(subscribe, seconds));
+    }
+    if(subscribe->topics & BBL_SUBSCRIBE_SESSIONS) {
+        json_object_set_new(root, "sessions", bbl_subscribe_sessions(subscribe));
+    }
+    record = json_dumps(root, JSON_COMPACT);
+    json_decref(root);
+    if(!record) {
+        return;
+    }
+    len = strlen(record);
+    record[len++] = '\n'; /* replace null termination */
+
+    /* Never block the main loop for slow collectors. A record
+     * which can't be sent at all is skipped and the snapshots 
+     * are kept, so that the next record carries the deltas 
+     * of both intervals. A partially sent record breaks the 
+     * framing and closes the subscription. */
+    sent = send(subscribe->fd, record, len, MSG_DONTWAIT|MSG_NOSIGNAL);
+    free(record);
+    if(sent == (ssize_t)len) {
+        bbl_subscribe_commit(subscribe);
+        subscribe->last = now;
+        subscribe->session_change_count = 0;
+        subscribe->session_changes_dropped = 0;
+    } else if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        LOG(DEBUG, "Subscription %u record skipped (socket busy)\n", subscribe->id);
+    } else {
+        bbl_subscribe_free(subscribe);
+    }
+}
+
+void
+bbl_subscribe_close_all()
+{
+    while(g_subscriptions) {
+        bbl_subscribe_free(g_subscriptions);
+    }
+}
+
+static bool
+bbl_subscribe_topic(const char *topic, uint8_t *topics)
+{
+    if(strcmp(topic, "interfaces") == 0) {
+        *topics |= BBL_SUBSCRIBE_INTERFACES;
+    } else if(strcmp(topic, "stream-groups") == 0) {
+        *topics |= BBL_SUBSCRIBE_STREAM_GROUPS;
+    } else if(strcmp(topic, "sessions") == 0) {
+        *topics |= BBL_SUBSCRIBE_SESSIONS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * bbl_subscribe_ctrl
+ *
+ * The subscribe command takes over the control socket
+ * connection which is used exclusively to push records
+ * afterwards. The subscription is closed with the connection.
+ */
+int
+bbl_subscribe_ctrl(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments)
+{
+    static uint32_t id = 0;
+
+    bbl_subscribe_s *subscribe;
+    bbl_interface_s *interface;
+    json_t *value;
+    json_t *topic;
+    json_t *root;
+    char *response;
+    size_t i, len;
+    int interval = 1;
+    uint8_t topics = 0;
+
+    value = json_object_get(arguments, "topics");
+    if(value) {
+        if(json_is_string(value)) {
+            if(!bbl_subscribe_topic(json_string_value(value), &topics)) {
+                return bbl_ctrl_status(fd, "error", 400, "invalid topic");
+            }
+        } else if(json_is_array(value)) {
+            for(i = 0; i < json_array_size(value); i++) {
+                topic = json_array_get(value, i);
+                if(!(json_is_string(topic) && bbl_subscribe_topic(json_string_value(topic), &topics))) {
+                    return bbl_ctrl_status(fd, "error", 400, "invalid topic");
+                }
+            }
+        } else {
+            return bbl_ctrl_status(fd, "error", 400, "invalid topics");
+        }
+    } else {
+        topics = BBL_SUBSCRIBE_INTERFACES|BBL_SUBSCRIBE_STREAM_GROUPS|BBL_SUBSCRIBE_SESSIONS;
+    }
+    if(!topics) {
+        return bbl_ctrl_status(fd, "error", 400, "missing topics");
+    }
+    value = json_object_get(arguments, "interval");
+    if(value) {
+        if(!json_is_integer(value) || json_integer_value(value) < 1 || json_integer_value(value) > 3600) {
+            return bbl_ctrl_status(fd, "error", 400, "invalid interval");
+        }
+        interval = json_integer_value(value);
+    }
+
+    subscribe = calloc(1, sizeof(bbl_subscribe_s));
+    if(!subscribe) {
+        return bbl_ctrl_status(fd, "error", 500, "internal error");
+    }
+    subscribe->fd = dup(fd);
+    if(subscribe->fd < 0) {
+        free(subscribe);
+        return bbl_ctrl_status(fd, "error", 500, "internal error");
+    }
+    subscribe->id = ++id;
+    subscribe->topics = topics;
+    subscribe->interval = interval;
+    if(topics & BBL_SUBSCRIBE_INTERFACES) {
+        CIRCLEQ_FOREACH(interface, &g_ctx->interface_qhead, interface_qnode) {
+            subscribe->interface_count++;
+        }
+        subscribe->interfaces = calloc(subscribe->interface_count * 4, sizeof(uint64_t));
+        subscribe->interfaces_next = calloc(subscribe->interface_count * 4, sizeof(uint64_t));
+        if(!(subscribe->interfaces && subscribe->interfaces_next)) {
+            subscribe->interface_count = 0;
+        }
+    }
+    if(topics & BBL_SUBSCRIBE_SESSIONS) {
+        subscribe->session_changes = calloc(BBL_SUBSCRIBE_SESSION_CHANGES, sizeof(bbl_subscribe_session_change_s));
+        g_subscribe_sessions++;
+    }
+    subscribe->next = g_subscriptions;
+    g_subscriptions = subscribe;
+
+    /* Take initial snapshots such that the
+     * first record carries deltas already. */
+    if(topics & BBL_SUBSCRIBE_INTERFACES) {
+        json_decref(bbl_subscribe_interfaces(subscribe, 1));
+    }
+    if(topics & BBL_SUBSCRIBE_STREAM_GROUPS) {
+        json_decref(bbl_subscribe_stream_groups(subscribe, 1));
+    }
+    bbl_subscribe_commit(subscribe);
+    clock_gettime(CLOCK_MONOTONIC, &subscribe->last);
+    timer_add_periodic(&g_ctx->timer_root, &subscribe->timer, "Subscription",
+                       interval, 0, subscribe, &bbl_subscribe_job);
+
+    LOG(INFO, "Subscription %u opened with interval %us\n", subscribe->id, interval);
+
+    /* Response is newline terminated like all records. */
+    root = json_pack("{ss si si}",
+        "status", "ok",
+        "code", 200,
+        "subscription", subscribe->id);
+    if(!root) {
+        bbl_subscribe_free(subscribe);
+        return -1;
+    }
+    response = json_dumps(root, JSON_COMPACT);
+    json_decref(root);
+    if(!response) {
+        bbl_subscribe_free(subscribe);
+        return -1;
+    }
+    len = strlen(response);
+    response[len++] = '\n';
+    if(send(fd, response, len, MSG_NOSIGNAL) != (ssize_t)len) {
+        bbl_subscribe_free(subscribe);
+    }
+    free(response);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * BNG Blaster (BBL) - Control Socket Subscriptions
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __BBL_SUBSCRIBE_H__
+#define __BBL_SUBSCRIBE_H__
+
+#define BBL_SUBSCRIBE_INTERFACES        0x01
+#define BBL_SUBSCRIBE_STREAM_GROUPS     0x02
+#define BBL_SUBSCRIBE_SESSIONS          0x04
+
+#define BBL_SUBSCRIBE_SESSION_CHANGES   1024
+
+typedef struct bbl_subscribe_session_change_ {
+    uint32_t session_id;
+    uint32_t state;
+} bbl_subscribe_session_change_s;
+
+typedef struct bbl_subscribe_ {
+    int fd; /* dup of ctrl socket client fd */
+    uint32_t id;
+    uint8_t topics;
+    time_t interval;
+
+    struct timer_ *timer;
+    struct timespec last;
+
+    /* Counter snapshots of last record sent
+     * used to calculate deltas and snapshots 
+     * of the current record (next). */
+    uint64_t *interfaces; /* tx/rx packets/bytes per interface */
+    uint64_t *interfaces_next;
+    uint32_t interface_count;
+    uint64_t *stream_groups; /* tx/rx packets and loss per group */
+    uint64_t *stream_groups_next;
+    uint32_t stream_group_count;
+
+    bbl_subscribe_session_change_s *session_changes;
+    uint32_t session_change_count;
+    uint32_t session_changes_dropped;
+
+    struct bbl_subscribe_ *next;
+} bbl_subscribe_s;
+
+void
+bbl_subscribe_session_state(bbl_session_s *session);
+
+void
+bbl_subscribe_close_all();
+
+int
+bbl_subscribe_ctrl(int fd, uint32_t session_id __attribute__((unused)), json_t *arguments);
+
+#endif
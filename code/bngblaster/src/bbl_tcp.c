@@ -13,6 +13,14 @@
 
 size_t g_netif_count = 0;
 
+/* All session TCP connections share one LwIP interface,
+ * demultiplexed by the TCP contexts of the receiving
+ * session (RX) and by the session stored in the PCB 
+ * extended argument (TX). */
+static struct netif g_session_netif = {0};
+static bbl_session_s *g_session_rx = NULL;
+static uint8_t g_session_arg_id = 0;
+
 const char *
 tcp_err_string(err_t err)
 {
@@ -79,7 +87,18 @@ bbl_tcp_close(bbl_tcp_ctx_s *tcpc)
  */
 void
 bbl_tcp_ctx_free(bbl_tcp_ctx_s *tcpc) {
+    bbl_tcp_ctx_s **next;
     if(tcpc) {
+        if(tcpc->session) {
+            next = &tcpc->session->tcp_ctx;
+            while(*next) {
+                if(*next == tcpc) {
+                    *next = tcpc->session_next;
+                    break;
+                }
+                next = &(*next)->session_next;
+            }
+        }
         if(tcpc->ifname) {
             free(tcpc->ifname);
             tcpc->ifname = NULL;
@@ -138,40 +157,96 @@ bbl_tcp_ctx_new_session(bbl_session_s *session)
         return NULL;
     }
 
-    /* Bind local network interface */
-    tcp_bind_netif(tcpc->pcb, &session->netif);
+    /* Bind shared session network interface */
+    tcp_bind_netif(tcpc->pcb, &g_session_netif);
+    tcp_ext_arg_set(tcpc->pcb, g_session_arg_id, session);
     
     /* Add BBL TCP context as argument */
     tcp_arg(tcpc->pcb, tcpc);
 
+    /* Add to session for RX demultiplexing. */
+    tcpc->session_next = session->tcp_ctx;
+    session->tcp_ctx = tcpc;
+
     sprintf(s, "ID: %u", session->session_id);
     tcpc->ifname = strdup(s);
     return tcpc;
 }
 
+/**
+ * bbl_tcp_session_bind
+ *
+ * Bind session TCP connections to local ports allocated
+ * per session instead of the LwIP ephemeral port range, 
+ * which is shared by all connections and therefore
+ * limited to 16384 connections. 
+ * 
+ * The local address is owned by the session, such that
+ * only the connections of the same session need to be 
+ * checked instead of searching all connections in LwIP 
+ * (tcp_bind). Ports are allocated round robin, so that
+ * closed connections (TIME-WAIT) are not reused before
+ * all other ports of the session are used. 
+ * 
+ * @param tcpc TCP context
+ */
+static void
+bbl_tcp_session_bind(bbl_tcp_ctx_s *tcpc)
+{
+    bbl_session_s *session = tcpc->session;
+    bbl_tcp_ctx_s *other;
+    uint16_t attempts = BBL_TCP_SESSION_BIND_ATTEMPTS;
+    uint16_t port;
+
+    while(attempts--) {
+        port = session->tcp_port++;
+        if(session->tcp_port < BBL_TCP_SESSION_PORT_MIN) {
+            session->tcp_port = BBL_TCP_SESSION_PORT_MIN;
+        }
+        for(other = session->tcp_ctx; other; other = other->session_next) {
+            if(other != tcpc && other->pcb && other->pcb->local_port == port) {
+                break;
+            }
+        }
+        if(!other) {
+            ip_addr_set(&tcpc->pcb->local_ip, &tcpc->local_addr);
+            tcpc->pcb->local_port = port;
+            TCP_REG(&tcp_bound_pcbs, tcpc->pcb);
+            return;
+        }
+    }
+    /* Fallback to LwIP ephemeral port. */
+    tcp_bind(tcpc->pcb, &tcpc->local_addr, 0);
+}
+
 err_t 
 bbl_tcp_sent_cb(void *arg, struct tcp_pcb *tpcb, u16_t len)
 {
     bbl_tcp_ctx_s *tcpc = arg;
-    uint16_t tx;
+    uint32_t tx;
     err_t result = ERR_OK;
 
     UNUSED(len);
 
     if(tcpc->tx.offset < tcpc->tx.len) {
-        tx = tcp_sndbuf(tpcb);
-        if(tx) {
-            if(tx > 4096) tx = 4096;
+        /* Fill the send buffer, which is larger 
+         * than 64K with TCP window scaling. */
+        while(tcpc->tx.offset < tcpc->tx.len) {
+            tx = tcp_sndbuf(tpcb);
+            if(!tx) {
+                result = ERR_MEM;
+                break;
+            }
+            if(tx > BBL_TCP_WRITE_MAX) tx = BBL_TCP_WRITE_MAX;
             if((tcpc->tx.offset + tx) > tcpc->tx.len) {
                 tx = tcpc->tx.len - tcpc->tx.offset;
             }
             result = tcp_write(tpcb, tcpc->tx.buf + tcpc->tx.offset, tx, tcpc->tx.flags);
-            if(result == ERR_OK) {
-                tcpc->state = BBL_TCP_STATE_SENDING;
-                tcpc->tx.offset += tx;
+            if(result != ERR_OK) {
+                break;
             }
-        } else {
-            result = ERR_MEM;
+            tcpc->state = BBL_TCP_STATE_SENDING;
+            tcpc->tx.offset += tx;
         }
     } else if(tcpc->pcb->unacked == NULL && tcpc->pcb->unsent == NULL) {
         /* Idle means that it is save to replace buffer. */
@@ -626,7 +701,7 @@ bbl_tcp_ipv4_connect_session(bbl_session_s *session, ipv4addr_t *src, ipv4addr_t
 
     /* Bind local IP address and port */
     tcpc->local_addr.u_addr.ip4.addr = *src;
-    tcp_bind(tcpc->pcb, &tcpc->local_addr, 0);
+    bbl_tcp_session_bind(tcpc);
 
     /* Disable nagle algorithm */
     tcp_nagle_disable(tcpc->pcb);
@@ -773,7 +848,7 @@ bbl_tcp_ipv6_connect_session(bbl_session_s *session, ipv6addr_t *src, ipv6addr_t
     /* Bind local IP address and port */
     memcpy(&tcpc->local_addr.u_addr.ip6.addr, src, sizeof(ip6_addr_t));
     tcpc->local_addr.type = IPADDR_TYPE_V6;
-    tcp_bind(tcpc->pcb, &tcpc->local_addr, 0);
+    bbl_tcp_session_bind(tcpc);
 
     /* Disable nagle algorithm */
     tcp_nagle_disable(tcpc->pcb);
@@ -862,7 +937,7 @@ bbl_tcp_ipv4_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
     struct pbuf *pbuf;
     UNUSED(eth);
 
-    if(!(g_ctx->tcp && session->netif.state)) {
+    if(!(g_ctx->tcp && session->tcp)) {
         /* TCP not enabled! */
         return;
     }
@@ -875,15 +950,17 @@ bbl_tcp_ipv4_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
         format_ipv4_address(&ipv4->src), tcp->src);
 #endif
 
-    ip_data.current_netif = &session->netif;
-    ip_data.current_input_netif = &session->netif;
+    ip_data.current_netif = &g_session_netif;
+    ip_data.current_input_netif = &g_session_netif;
     ip_data.current_iphdr_dest.type = IPADDR_TYPE_V4;
     ip_data.current_iphdr_dest.u_addr.ip4.addr = ipv4->dst;
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V4;
     ip_data.current_iphdr_src.u_addr.ip4.addr = ipv4->src;
 
     pbuf = pbuf_alloc_reference(ipv4->payload, ipv4->payload_len, PBUF_ROM);
-    tcp_input(pbuf, &session->netif);
+    g_session_rx = session;
+    tcp_input(pbuf, &g_session_netif);
+    g_session_rx = NULL;
 }
 
 /**
@@ -940,7 +1017,7 @@ bbl_tcp_ipv6_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
     struct pbuf *pbuf;
     UNUSED(eth);
 
-    if(!(g_ctx->tcp && session->netif.state)) {
+    if(!(g_ctx->tcp && session->tcp)) {
         /* TCP not enabled! */
         return;
     }
@@ -953,18 +1030,20 @@ bbl_tcp_ipv6_rx_session(bbl_session_s *session, bbl_ethernet_header_s *eth, bbl_
         format_ipv6_address((ipv6addr_t*)ipv6->src), tcp->src);
 #endif
 
+    g_session_rx = session;
     pbuf = pbuf_alloc_reference(ipv6->hdr, ipv6->len, PBUF_ROM);
-    session->netif.input(pbuf, &session->netif);
+    g_session_netif.input(pbuf, &g_session_netif);
 
-    ip_data.current_netif = &session->netif;
-    ip_data.current_input_netif = &session->netif;
+    ip_data.current_netif = &g_session_netif;
+    ip_data.current_input_netif = &g_session_netif;
     memcpy(&ip_data.current_iphdr_dest.u_addr.ip6.addr, ipv6->dst, sizeof(ip6_addr_t));
     ip_data.current_iphdr_dest.type = IPADDR_TYPE_V6;
     memcpy(&ip_data.current_iphdr_src.u_addr.ip6.addr, ipv6->src, sizeof(ip6_addr_t));
     ip_data.current_iphdr_src.type = IPADDR_TYPE_V6;
 
     pbuf = pbuf_alloc_reference(ipv6->payload, ipv6->payload_len, PBUF_ROM);
-    tcp_input(pbuf, &session->netif);
+    tcp_input(pbuf, &g_session_netif);
+    g_session_rx = NULL;
 }
 
 /**
@@ -988,6 +1067,7 @@ bbl_tcp_send(bbl_tcp_ctx_s *tcpc, uint8_t *buf, uint32_t len)
 
     if(tcpc->state == BBL_TCP_STATE_IDLE) {
         bbl_tcp_sent_cb(tcpc, tcpc->pcb, 0);
+        tcp_output(tcpc->pcb);
     }
     return true;
 }
@@ -1015,32 +1095,132 @@ bbl_tcp_netif_output_ipv4(struct netif *netif, struct pbuf *p, const ip4_addr_t
     return ERR_OK;
 }
 
+/**
+ * bbl_tcp_lwip_out_hook
+ *
+ * LwIP hook (LWIP_HOOK_TCP_OUT_ADD_TCPOPTS) called for 
+ * every TCP segment sent by a PCB, used to store the
+ * session in the pbuf for the shared session interface.
+ */
+u32_t *
+bbl_tcp_lwip_out_hook(struct pbuf *p, const struct tcp_pcb *pcb, u32_t *opts)
+{
+    if(pcb) {
+        p->session = tcp_ext_arg_get(pcb, g_session_arg_id);
+    }
+    return opts;
+}
+
+/**
+ * bbl_tcp_lwip_in_hook
+ *
+ * LwIP hook (LWIP_HOOK_TCP_INPUT_PCB) called for every
+ * TCP segment received, used to demultiplex segments 
+ * received on the shared session interface by the TCP
+ * contexts of the receiving session instead of searching
+ * all active connections. 
+ */
+struct tcp_pcb *
+bbl_tcp_lwip_in_hook(const struct tcp_hdr *hdr, struct netif *inp)
+{
+    bbl_tcp_ctx_s *tcpc;
+    struct tcp_pcb *pcb;
+
+    if(!(g_session_rx && inp == &g_session_netif)) {
+        return NULL;
+    }
+    for(tcpc = g_session_rx->tcp_ctx; tcpc; tcpc = tcpc->session_next) {
+        pcb = tcpc->pcb;
+        if(pcb && pcb->state != CLOSED && pcb->state != LISTEN && pcb->state != TIME_WAIT &&
+           pcb->remote_port == hdr->src &&
+           pcb->local_port == hdr->dest &&
+           ip_addr_eq(&pcb->remote_ip, ip_current_src_addr()) &&
+           ip_addr_eq(&pcb->local_ip, ip_current_dest_addr())) {
+            return pcb;
+        }
+    }
+    /* Fallback to LwIP (e.g. closed connections in TIME-WAIT). */
+    return NULL;
+}
+
+/**
+ * bbl_tcp_lwip_mss_hook
+ *
+ * LwIP hook (LWIP_HOOK_TCP_EFF_SEND_MSS) used to limit
+ * the MSS of session TCP connections to the session MTU, 
+ * which is the PPPoE MRU or the IPoE MTU of the shared 
+ * session interface.
+ */
+u16_t
+bbl_tcp_lwip_mss_hook(const struct tcp_pcb *pcb, u16_t mss)
+{
+    bbl_session_s *session = tcp_ext_arg_get(pcb, g_session_arg_id);
+    uint16_t mtu = BBL_TCP_SESSION_MTU;
+    uint16_t offset;
+
+    if(!session) {
+        return mss;
+    }
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
+        if(session->mru && session->mru < mtu) {
+            mtu = session->mru;
+        }
+        if(session->peer_mru && session->peer_mru < mtu) {
+            mtu = session->peer_mru;
+        }
+    }
+    if(IP_IS_V6(&pcb->remote_ip)) {
+        offset = IP6_HLEN + TCP_HLEN;
+    } else {
+        offset = IP_HLEN + TCP_HLEN;
+    }
+    if(mtu > offset && mss > mtu - offset) {
+        mss = mtu - offset;
+    }
+    return mss;
+}
+
+static bbl_session_s *
+bbl_tcp_pbuf_session(struct pbuf *p)
+{
+    if(p->session) {
+        return p->session;
+    }
+    /* Segments sent without PCB (e.g. reset) 
+     * while processing a received packet. */
+    return g_session_rx;
+}
+
 /**
  * Function of type netif_output_fn
  */
 err_t 
 bbl_tcp_netif_output_ipv4_session(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
 {
-    bbl_session_s *session = netif->state;
+    bbl_session_s *session = bbl_tcp_pbuf_session(p);
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
 
+    UNUSED(netif);
     UNUSED(ipaddr);
 
-    if(session->session_state != BBL_ESTABLISHED) {
+    if(!session) {
+        return ERR_RTE;
+    }
+    if(session->hot->session_state != BBL_ESTABLISHED) {
         return ERR_IF;
     }
 
-    eth.src = session->client_mac;
-    eth.dst = session->server_mac;
+    eth.src = session->hot->client_mac;
+    eth.dst = session->hot->server_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         eth.type = ETH_TYPE_PPPOE_SESSION;
         eth.next = &pppoe;
         pppoe.session_id = session->pppoe_session_id;
@@ -1054,7 +1234,7 @@ bbl_tcp_netif_output_ipv4_session(struct netif *netif, struct pbuf *p, const ip4
         eth.next = p;
     }
 
-    if(bbl_txq_to_buffer(session->access_interface->txq, &eth) != BBL_TXQ_OK) {
+    if(bbl_txq_to_buffer(session->hot->access_interface->txq, &eth) != BBL_TXQ_OK) {
         return ERR_IF;
     }
     return ERR_OK;
@@ -1089,26 +1269,30 @@ bbl_tcp_netif_output_ipv6(struct netif *netif, struct pbuf *p, const ip6_addr_t
 err_t 
 bbl_tcp_netif_output_ipv6_session(struct netif *netif, struct pbuf *p, const ip6_addr_t *ipaddr)
 {
-    bbl_session_s *session = netif->state;
+    bbl_session_s *session = bbl_tcp_pbuf_session(p);
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
 
+    UNUSED(netif);
     UNUSED(ipaddr);
 
-    if(session->session_state != BBL_ESTABLISHED) {
+    if(!session) {
+        return ERR_RTE;
+    }
+    if(session->hot->session_state != BBL_ESTABLISHED) {
         return ERR_IF;
     }
 
-    eth.src = session->client_mac;
-    eth.dst = session->server_mac;
+    eth.src = session->hot->client_mac;
+    eth.dst = session->hot->server_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         eth.type = ETH_TYPE_PPPOE_SESSION;
         eth.next = &pppoe;
         pppoe.session_id = session->pppoe_session_id;
@@ -1122,7 +1306,7 @@ bbl_tcp_netif_output_ipv6_session(struct netif *netif, struct pbuf *p, const ip6
         eth.next = p;
     }
 
-    if(bbl_txq_to_buffer(session->access_interface->txq, &eth) != BBL_TXQ_OK) {
+    if(bbl_txq_to_buffer(session->hot->access_interface->txq, &eth) != BBL_TXQ_OK) {
         return ERR_IF;
     }
     return ERR_OK;
@@ -1200,23 +1384,10 @@ bbl_tcp_session_init(bbl_session_s *session)
         return true;
     }
 
-    if(session->netif.state) {
-        /* Already initialised! */
-        return true;
-    }
-
-    if(!(g_netif_count < BBL_TCP_NETIF_MAX)) {
-        LOG(ERROR, "Failed to init TCP for session %u (max 255 TCP interfaces supported)\n", session->session_id);
-        return false;
+    if(!session->tcp) {
+        session->tcp = true;
+        session->tcp_port = BBL_TCP_SESSION_PORT_MIN;
     }
-    if(!netif_add(&session->netif, NULL, NULL, NULL, session, bbl_tcp_netif_init_session, ip_input))  {
-        return false;
-    }
-    g_netif_count++;
-
-    session->netif.state = session;
-    session->netif.mtu = 1280;
-    session->netif.mtu6 = 1280;
     return true;
 }
 
@@ -1231,18 +1402,31 @@ bbl_tcp_timer(timer_s *timer)
  * bbl_tcp_init
  * 
  * Init TCP (LwIP) and start global TCP timer job. 
+ * 
+ * @return return true if successfully
  */
-void
+bool
 bbl_tcp_init()
 {
     if(!g_ctx->tcp) {
         /* TCP not enabled! */
-        return;
+        return true;
     }
 
     lwip_init();
 
+    /* Add shared session network interface. */
+    g_session_arg_id = tcp_ext_arg_alloc_id();
+    if(!netif_add(&g_session_netif, NULL, NULL, NULL, NULL, bbl_tcp_netif_init_session, ip_input)) {
+        LOG_NOARG(ERROR, "Failed to init TCP session interface\n");
+        return false;
+    }
+    g_netif_count++;
+    g_session_netif.mtu = BBL_TCP_SESSION_MTU;
+    g_session_netif.mtu6 = BBL_TCP_SESSION_MTU;
+
     /* Start TCP timer */
     timer_add_periodic(&g_ctx->timer_root, &g_ctx->tcp_timer, "TCP",
                        0, BBL_TCP_INTERVAL, g_ctx, &bbl_tcp_timer);
+    return true;
 }
\ No newline at end of file
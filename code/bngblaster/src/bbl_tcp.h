@@ -17,6 +17,10 @@
 #define BBL_TCP_INTERVAL 250*MSEC
 #define BBL_TCP_HASHTABLE_SIZE 32771
 #define BBL_TCP_NETIF_MAX 255
+#define BBL_TCP_WRITE_MAX 16384
+#define BBL_TCP_SESSION_MTU 1500 /* IPoE, limited by PPPoE MRU per session */
+#define BBL_TCP_SESSION_PORT_MIN 49152
+#define BBL_TCP_SESSION_BIND_ATTEMPTS 256
 
 typedef enum bbl_tcp_state_ {
     BBL_TCP_STATE_CLOSED,
@@ -37,6 +41,7 @@ typedef struct bbl_tcp_ctx_
     char* ifname;
     bbl_network_interface_s *interface;
     bbl_session_s *session;
+    struct bbl_tcp_ctx_ *session_next; /* next TCP context of session */
 
     bool listen;
     uint8_t af; /* AF_INET or AF_INET6 */
@@ -135,7 +140,7 @@ bbl_tcp_network_interface_init(bbl_network_interface_s *interface, bbl_network_c
 bool
 bbl_tcp_session_init(bbl_session_s *session);
 
-void
+bool
 bbl_tcp_init();
 
 #endif
\ No newline at end of file
@@ -124,11 +124,11 @@ bbl_tun_pppoe_tx_job(timer_s *timer) {
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.type = ETH_TYPE_PPPOE_SESSION;
     eth.next = &pppoe;
@@ -146,7 +146,7 @@ bbl_tun_pppoe_tx_job(timer_s *timer) {
             }
             pppoe.next = buf;
             pppoe.raw_len = len;
-            bbl_txq_to_buffer(session->access_interface->txq, &eth);
+            bbl_txq_to_buffer(session->hot->access_interface->txq, &eth);
         } else {
             break;
         }
@@ -162,11 +162,11 @@ bbl_tun_ipoe_tx_job(timer_s *timer) {
     ssize_t len = 1;
     bbl_ethernet_header_s eth = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     while(true) {
         len = read(session->tun_fd, buf, sizeof(buf));
@@ -181,7 +181,7 @@ bbl_tun_ipoe_tx_job(timer_s *timer) {
             }
             eth.next = buf;
             eth.raw_len = len;
-            bbl_txq_to_buffer(session->access_interface->txq, &eth);
+            bbl_txq_to_buffer(session->hot->access_interface->txq, &eth);
         } else {
             break;
         }
@@ -193,7 +193,7 @@ bool
 bbl_tun_session_up(bbl_session_s *session)
 {
     if(!session->tun_dev) return true;
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         timer_add_periodic(&g_ctx->timer_root, &session->timer_tun, "TUN", 
                            0, 1 * MSEC, session, &bbl_tun_pppoe_tx_job);
     } else {
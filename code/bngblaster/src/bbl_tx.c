@@ -20,19 +20,22 @@ bbl_tx_igmp_timeout(timer_s *timer)
     int i;
     bool send = false;
 
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
-        if(session->session_state != BBL_ESTABLISHED ||
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
+        if(session->hot->session_state != BBL_ESTABLISHED ||
             session->ipcp_state != BBL_PPP_OPENED) {
             return;
         }
     } else {
-        if(session->session_state != BBL_ESTABLISHED) {
+        if(session->hot->session_state != BBL_ESTABLISHED) {
             return;
         }
     }
+    if(!session->igmp) {
+        return;
+    }
 
     for(i=0; i < IGMP_MAX_GROUPS; i++) {
-        group = &session->igmp_groups[i];
+        group = &session->igmp->groups[i];
         if(group->state == IGMP_GROUP_JOINING) {
             if(group->robustness_count) {
                 session->send_requests |= BBL_SEND_IGMP;
@@ -61,7 +64,7 @@ bbl_tx_igmp_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_igmp(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
@@ -80,19 +83,24 @@ bbl_tx_encode_packet_igmp(bbl_session_s *session)
     struct timespec timestamp;
     clock_gettime(CLOCK_MONOTONIC, &timestamp);
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    if(!session->igmp) {
+        session->send_requests &= ~BBL_SEND_IGMP;
+        return IGNORED;
+    }
+
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
 
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         /* Check session and IPCP (PPP IPv4) state to prevent sending IGMP request
          * after session or IPCP has closed. */
-        if(session->session_state != BBL_ESTABLISHED || session->ipcp_state != BBL_PPP_OPENED) {
+        if(session->hot->session_state != BBL_ESTABLISHED || session->ipcp_state != BBL_PPP_OPENED) {
             session->send_requests &= ~BBL_SEND_IGMP;
             return WRONG_PROTOCOL_STATE;
         }
@@ -103,7 +111,7 @@ bbl_tx_encode_packet_igmp(bbl_session_s *session)
         pppoe.next = &ipv4;
     } else {
         /* IPoE */
-        if(session->session_state != BBL_ESTABLISHED) {
+        if(session->hot->session_state != BBL_ESTABLISHED) {
             session->send_requests &= ~BBL_SEND_IGMP;
             return WRONG_PROTOCOL_STATE;
         }
@@ -119,8 +127,8 @@ bbl_tx_encode_packet_igmp(bbl_session_s *session)
     ipv4.router_alert_option = true;
     ipv4.next = &igmp;
     for(i=0; i < IGMP_MAX_GROUPS; i++) {
-        if(session->igmp_groups[i].send && session->igmp_groups[i].state) {
-            group = &session->igmp_groups[i];
+        if(session->igmp->groups[i].send && session->igmp->groups[i].state) {
+            group = &session->igmp->groups[i];
             if(group->state == IGMP_GROUP_LEAVING) {
                 if(is_join) {
                     if(!g_ctx->config.igmp_combined_leave_join) {
@@ -192,7 +200,7 @@ bbl_tx_encode_packet_igmp(bbl_session_s *session)
             } else {
                 ipv4.dst = group->group;
                 igmp.group = group->group;
-                if(session->access_type != ACCESS_TYPE_PPPOE) {
+                if(session->hot->access_type != ACCESS_TYPE_PPPOE) {
                     /* IPoE */
                     ipv4_multicast_mac(group->group, mac);
                     eth.dst = mac;
@@ -258,8 +266,8 @@ void
 bbl_tx_pap_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPP_AUTH) {
-        session->access_interface->stats.pap_timeout++;
+    if(session->hot->session_state == BBL_PPP_AUTH) {
+        session->hot->access_interface->stats.pap_timeout++;
         if(session->auth_retries > g_ctx->config.authentication_retry) {
             bbl_session_clear(session);
         } else {
@@ -269,20 +277,45 @@ bbl_tx_pap_timeout(timer_s *timer)
     }
 }
 
+/**
+ * bbl_tx_access_line_strings
+ *
+ * Render ACI, ARI and AACI of the session into the 
+ * given buffers which must remain valid until encoded.
+ *
+ * @param session session
+ * @param access_line access line
+ * @param buf three buffers of SUB_STR_LEN bytes
+ * @return true if ACI or ARI is configured
+ */
+static bool
+bbl_tx_access_line_strings(bbl_session_s *session, access_line_s *access_line, char buf[][SUB_STR_LEN])
+{
+    access_line->aci = bbl_session_string(session, SESSION_STRING_ACI, buf[0]);
+    access_line->ari = bbl_session_string(session, SESSION_STRING_ARI, buf[1]);
+    if(access_line->aci || access_line->ari) {
+        access_line->aaci = bbl_session_string(session, SESSION_STRING_AACI, buf[2]);
+        return true;
+    }
+    return false;
+}
+
 static protocol_error_t
 bbl_tx_encode_packet_pap_request(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
     bbl_pap_s pap = {0};
+    char username[SUB_STR_LEN];
+    char password[SUB_STR_LEN];
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -294,10 +327,10 @@ bbl_tx_encode_packet_pap_request(bbl_session_s *session)
 
     pap.code = PAP_CODE_REQUEST;
     pap.identifier = 1;
-    pap.username = session->username;
-    pap.username_len = strlen(session->username);
-    pap.password = session->password;
-    pap.password_len = strlen(session->password);
+    pap.username = bbl_session_string(session, SESSION_STRING_USERNAME, username);
+    pap.username_len = strlen(pap.username);
+    pap.password = bbl_session_string(session, SESSION_STRING_PASSWORD, password);
+    pap.password_len = strlen(pap.password);
 
     timer_add(&g_ctx->timer_root, &session->timer_auth, "Authentication Timeout",
               g_ctx->config.authentication_timeout, 0, session, &bbl_tx_pap_timeout);
@@ -310,8 +343,8 @@ void
 bbl_tx_chap_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPP_AUTH) {
-        session->access_interface->stats.chap_timeout++;
+    if(session->hot->session_state == BBL_PPP_AUTH) {
+        session->hot->access_interface->stats.chap_timeout++;
         if(session->auth_retries > g_ctx->config.authentication_retry) {
             bbl_session_clear(session);
         } else {
@@ -324,19 +357,20 @@ bbl_tx_chap_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_chap_response(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
     bbl_chap_s chap = {0};
+    char username[SUB_STR_LEN];
 
     access_interface->stats.chap_tx++;
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -349,8 +383,8 @@ bbl_tx_encode_packet_chap_response(bbl_session_s *session)
     chap.identifier = session->chap_identifier;
     chap.challenge = session->chap_response;
     chap.challenge_len = CHALLENGE_LEN;
-    chap.name = session->username;
-    chap.name_len = strlen(session->username);
+    chap.name = bbl_session_string(session, SESSION_STRING_USERNAME, username);
+    chap.name_len = strlen(chap.name);
 
     timer_add(&g_ctx->timer_root, &session->timer_auth, "Authentication Timeout", 
               g_ctx->config.authentication_timeout, 0, session, &bbl_tx_chap_timeout);
@@ -364,7 +398,7 @@ bbl_icmpv6_timeout(timer_s *timer)
 {
     bbl_session_s *session  = timer->data;
     if(!session->icmpv6_ra_received) {
-        session->access_interface->stats.icmpv6_rs_timeout++;
+        session->hot->access_interface->stats.icmpv6_rs_timeout++;
         session->send_requests |= BBL_SEND_ICMPV6_RS;
         bbl_session_tx_qnode_insert(session);
     }
@@ -373,7 +407,7 @@ bbl_icmpv6_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_icmpv6_rs(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
@@ -381,18 +415,18 @@ bbl_tx_encode_packet_icmpv6_rs(bbl_session_s *session)
     bbl_icmpv6_s icmpv6 = {0};
     uint8_t mac[ETH_ADDR_LEN];
 
-    eth.src = session->client_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         if(session->ip6cp_state != BBL_PPP_OPENED) {
             return WRONG_PROTOCOL_STATE;
         }
-        eth.dst = session->server_mac;
+        eth.dst = session->hot->server_mac;
         eth.type = ETH_TYPE_PPPOE_SESSION;
         eth.next = &pppoe;
 
@@ -427,14 +461,14 @@ bbl_tx_dhcpv6_timeout(timer_s *timer)
     bbl_session_s *session = timer->data;
     if(!(session->dhcpv6_state == BBL_DHCP_BOUND ||
          session->dhcpv6_state == BBL_DHCP_INIT)) {
-        session->access_interface->stats.dhcpv6_timeout++;
+        session->hot->access_interface->stats.dhcpv6_timeout++;
         if(session->dhcpv6_retry < g_ctx->config.dhcpv6_retry) {
             session->send_requests |= BBL_SEND_DHCPV6_REQUEST;
             bbl_session_tx_qnode_insert(session);
         } else {
             if(session->dhcpv6_state == BBL_DHCP_RELEASE) {
                 session->dhcpv6_state = BBL_DHCP_INIT;
-                if(session->session_state == BBL_TERMINATING) {
+                if(session->hot->session_state == BBL_TERMINATING) {
                     bbl_session_clear(session);
                 }
             } else {
@@ -447,7 +481,7 @@ bbl_tx_dhcpv6_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
@@ -456,6 +490,7 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
     bbl_dhcpv6_s dhcpv6 = {0};
     bbl_dhcpv6_s dhcpv6_relay = {0};
     access_line_s access_line = {0};
+    char access_line_buf[3][SUB_STR_LEN];
     struct timespec now;
     struct timespec time_diff;
     time_t elapsed = 0;
@@ -463,7 +498,8 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
     uint8_t mac[ETH_ADDR_LEN];
 
     if(session->dhcpv6_state == BBL_DHCP_INIT ||
-       session->dhcpv6_state == BBL_DHCP_BOUND) {
+       session->dhcpv6_state == BBL_DHCP_BOUND ||
+       !session->dhcpv6) {
         return IGNORED;
     }
 
@@ -472,10 +508,7 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
         dhcpv6_relay.peer_address = (void*)session->link_local_ipv6_address;
         dhcpv6_relay.relay_message = &dhcpv6;
         if(g_ctx->config.dhcpv6_access_line && 
-           (session->agent_circuit_id || session->agent_remote_id)) {
-            access_line.aci = session->agent_circuit_id;
-            access_line.ari = session->agent_remote_id;
-            access_line.aaci = session->access_aggregation_circuit_id;
+           bbl_tx_access_line_strings(session, &access_line, access_line_buf)) {
             access_line.up = session->rate_up;
             access_line.down = session->rate_down;
             access_line.dsl_type = session->dsl_type;
@@ -484,7 +517,7 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
         if(!access_line.aci) {
             /* The ACI is mapped to the Interface-Id option, 
             * which is mandatory for relay forward messages. */
-            access_line.aci = format_mac_address(session->client_mac);
+            access_line.aci = format_mac_address(session->hot->client_mac);
         }
         dhcpv6_relay.access_line = &access_line;
         udp.next = &dhcpv6_relay;
@@ -492,16 +525,16 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
         udp.next = &dhcpv6;
     }
 
-    eth.src = session->client_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
-    if(session->access_type == ACCESS_TYPE_PPPOE) {
+    if(session->hot->access_type == ACCESS_TYPE_PPPOE) {
         if(session->ip6cp_state != BBL_PPP_OPENED) {
             return WRONG_PROTOCOL_STATE;
         }
-        eth.dst = session->server_mac;
+        eth.dst = session->hot->server_mac;
         eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
         eth.type = ETH_TYPE_PPPOE_SESSION;
         eth.next = &pppoe;
@@ -541,16 +574,16 @@ bbl_tx_encode_packet_dhcpv6_request(bbl_session_s *session)
     }
     dhcpv6.elapsed = elapsed;
     dhcpv6.xid = session->dhcpv6_xid;
-    dhcpv6.client_duid = session->dhcpv6_duid;
+    dhcpv6.client_duid = session->dhcpv6->duid;
     dhcpv6.client_duid_len = DUID_LEN;
-    dhcpv6.server_duid = session->dhcpv6_server_duid;
-    dhcpv6.server_duid_len = session->dhcpv6_server_duid_len;
+    dhcpv6.server_duid = session->dhcpv6->server_duid;
+    dhcpv6.server_duid_len = session->dhcpv6->server_duid_len;
     dhcpv6.ia_na_iaid = session->dhcpv6_ia_na_iaid;
-    dhcpv6.ia_na_option = session->dhcpv6_ia_na_option;
-    dhcpv6.ia_na_option_len = session->dhcpv6_ia_na_option_len;
+    dhcpv6.ia_na_option = session->dhcpv6->ia_na_option;
+    dhcpv6.ia_na_option_len = session->dhcpv6->ia_na_option_len;
     dhcpv6.ia_pd_iaid = session->dhcpv6_ia_pd_iaid;
-    dhcpv6.ia_pd_option = session->dhcpv6_ia_pd_option;
-    dhcpv6.ia_pd_option_len = session->dhcpv6_ia_pd_option_len;
+    dhcpv6.ia_pd_option = session->dhcpv6->ia_pd_option;
+    dhcpv6.ia_pd_option_len = session->dhcpv6->ia_pd_option_len;
     dhcpv6.oro = true;
     switch (session->dhcpv6_state) {
         case BBL_DHCP_SELECTING:
@@ -599,9 +632,9 @@ void
 bbl_tx_ip6cp_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPP_NETWORK && session->ip6cp_state != BBL_PPP_OPENED) {
+    if(session->hot->session_state == BBL_PPP_NETWORK && session->ip6cp_state != BBL_PPP_OPENED) {
         if(session->ip6cp_retries) {
-            session->access_interface->stats.ip6cp_timeout++;
+            session->hot->access_interface->stats.ip6cp_timeout++;
         }
         if(session->ip6cp_retries > g_ctx->config.ip6cp_conf_request_retry) {
             session->ip6cp_state = BBL_PPP_CLOSED;
@@ -619,7 +652,7 @@ bbl_tx_ip6cp_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_ip6cp_request(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
@@ -629,11 +662,11 @@ bbl_tx_encode_packet_ip6cp_request(bbl_session_s *session)
         return WRONG_PROTOCOL_STATE;
     }
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -658,17 +691,17 @@ bbl_tx_encode_packet_ip6cp_request(bbl_session_s *session)
 static protocol_error_t
 bbl_tx_encode_packet_ip6cp_response(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
     bbl_ip6cp_s ip6cp = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -695,9 +728,9 @@ void
 bbl_ipcp_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPP_NETWORK && session->ipcp_state != BBL_PPP_OPENED) {
+    if(session->hot->session_state == BBL_PPP_NETWORK && session->ipcp_state != BBL_PPP_OPENED) {
         if(session->ipcp_retries) {
-            session->access_interface->stats.ipcp_timeout++;
+            session->hot->access_interface->stats.ipcp_timeout++;
         }
         if(session->ipcp_retries > g_ctx->config.ipcp_conf_request_retry) {
             session->ipcp_state = BBL_PPP_CLOSED;
@@ -715,7 +748,7 @@ bbl_ipcp_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_ipcp_request(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
@@ -725,11 +758,11 @@ bbl_tx_encode_packet_ipcp_request(bbl_session_s *session)
         return WRONG_PROTOCOL_STATE;
     }
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -766,17 +799,17 @@ bbl_tx_encode_packet_ipcp_request(bbl_session_s *session)
 static protocol_error_t
 bbl_tx_encode_packet_ipcp_response(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
     bbl_ipcp_s ipcp = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -801,9 +834,9 @@ void
 bbl_lcp_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPP_LINK && session->lcp_state != BBL_PPP_OPENED) {
+    if(session->hot->session_state == BBL_PPP_LINK && session->lcp_state != BBL_PPP_OPENED) {
         if(session->lcp_retries) {
-            session->access_interface->stats.lcp_timeout++;
+            session->hot->access_interface->stats.lcp_timeout++;
         }
         if(session->lcp_retries > g_ctx->config.lcp_conf_request_retry) {
             bbl_session_clear(session);
@@ -811,7 +844,7 @@ bbl_lcp_timeout(timer_s *timer)
             session->send_requests |= BBL_SEND_LCP_REQUEST;
             bbl_session_tx_qnode_insert(session);
         }
-    } else if(session->session_state == BBL_PPP_TERMINATING) {
+    } else if(session->hot->session_state == BBL_PPP_TERMINATING) {
         if(session->lcp_retries > 3) {
             /* Send max 3 terminate requests. */
             bbl_session_update_state(session, BBL_TERMINATING);
@@ -833,18 +866,18 @@ bbl_lcp_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_lcp_request(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
     bbl_lcp_s lcp = {0};
     uint16_t timeout = 1; /* default timeout 1 second */
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -877,17 +910,17 @@ bbl_tx_encode_packet_lcp_request(bbl_session_s *session)
 static protocol_error_t
 bbl_tx_encode_packet_lcp_response(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_session_s pppoe = {0};
     bbl_lcp_s lcp = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -921,7 +954,7 @@ void
 bbl_padi_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPPOE_INIT) {
+    if(session->hot->session_state == BBL_PPPOE_INIT) {
         session->send_requests = BBL_SEND_DISCOVERY;
         bbl_session_tx_qnode_insert(session);
     }
@@ -931,7 +964,7 @@ void
 bbl_padr_timeout(timer_s *timer)
 {
     bbl_session_s *session = timer->data;
-    if(session->session_state == BBL_PPPOE_REQUEST) {
+    if(session->hot->session_state == BBL_PPPOE_REQUEST) {
         if(session->pppoe_retries > g_ctx->config.pppoe_discovery_retry) {
             bbl_session_update_state(session, BBL_PPPOE_INIT);
         }
@@ -946,12 +979,13 @@ bbl_encode_padi(bbl_session_s *session)
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_discovery_s pppoe = {0};
     access_line_s access_line = {0};
+    char access_line_buf[3][SUB_STR_LEN];
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -970,10 +1004,7 @@ bbl_encode_padi(bbl_session_s *session)
     if(g_ctx->config.pppoe_max_payload) {
         pppoe.max_payload = g_ctx->config.pppoe_max_payload;
     }
-    if(session->agent_circuit_id || session->agent_remote_id) {
-        access_line.aci = session->agent_circuit_id;
-        access_line.ari = session->agent_remote_id;
-        access_line.aaci = session->access_aggregation_circuit_id;
+    if(bbl_tx_access_line_strings(session, &access_line, access_line_buf)) {
         access_line.up = session->rate_up;
         access_line.down = session->rate_down;
         access_line.dsl_type = session->dsl_type;
@@ -989,12 +1020,13 @@ bbl_encode_padr(bbl_session_s *session)
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_discovery_s pppoe = {0};
     access_line_s access_line = {0};
+    char access_line_buf[3][SUB_STR_LEN];
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -1014,10 +1046,7 @@ bbl_encode_padr(bbl_session_s *session)
     if(g_ctx->config.pppoe_max_payload) {
         pppoe.max_payload = g_ctx->config.pppoe_max_payload;
     }
-    if(session->agent_circuit_id || session->agent_remote_id) {
-        access_line.aci = session->agent_circuit_id;
-        access_line.ari = session->agent_remote_id;
-        access_line.aaci = session->access_aggregation_circuit_id;
+    if(bbl_tx_access_line_strings(session, &access_line, access_line_buf)) {
         access_line.up = session->rate_up;
         access_line.down = session->rate_down;
         access_line.dsl_type = session->dsl_type;
@@ -1033,11 +1062,11 @@ bbl_encode_padt(bbl_session_s *session)
     bbl_ethernet_header_s eth = {0};
     bbl_pppoe_discovery_s pppoe = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.pppoe_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -1050,11 +1079,11 @@ bbl_encode_padt(bbl_session_s *session)
 
 protocol_error_t
 bbl_tx_encode_packet_discovery(bbl_session_s *session) {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     protocol_error_t result = UNKNOWN_PROTOCOL;
 
-    switch(session->session_state) {
+    switch(session->hot->session_state) {
         case BBL_PPPOE_INIT:
             result = bbl_encode_padi(session);
             timer_add(&g_ctx->timer_root, &session->timer_padi, "PADI timeout", 
@@ -1088,14 +1117,14 @@ bbl_dhcp_timeout(timer_s *timer)
     bbl_session_s *session = timer->data;
     if(!(session->dhcp_state == BBL_DHCP_INIT ||
          session->dhcp_state == BBL_DHCP_BOUND)) {
-        session->access_interface->stats.dhcp_timeout++;
+        session->hot->access_interface->stats.dhcp_timeout++;
         if(session->dhcp_retry < g_ctx->config.dhcp_retry) {
             session->send_requests |= BBL_SEND_DHCP_REQUEST;
             bbl_session_tx_qnode_insert(session);
         } else {
             if(session->dhcp_state == BBL_DHCP_RELEASE) {
                 session->dhcp_state = BBL_DHCP_INIT;
-                if(session->session_state == BBL_TERMINATING) {
+                if(session->hot->session_state == BBL_TERMINATING) {
                     bbl_session_clear(session);
                 }
             } else {
@@ -1108,7 +1137,7 @@ bbl_dhcp_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_dhcp(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_ipv4_s ipv4 = {0};
@@ -1116,6 +1145,8 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
     struct dhcp_header header = {0};
     bbl_dhcp_s dhcp = {0};
     access_line_s access_line = {0};
+    char access_line_buf[3][SUB_STR_LEN];
+    char vendor_class_id[SUB_STR_LEN];
     struct timespec now;
     time_t secs = 0;
 
@@ -1125,10 +1156,10 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
     }
 
     dhcp.header = &header;
-    eth.src = session->client_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.vlan_outer_priority = g_ctx->config.dhcp_vlan_priority;
     eth.vlan_inner_priority = eth.vlan_outer_priority;
@@ -1153,7 +1184,7 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
     if(g_ctx->config.dhcp_broadcast && session->dhcp_state < BBL_DHCP_BOUND) {
         header.flags = htobe16(1 << 15);
     }
-    memcpy(header.chaddr, session->client_mac, ETH_ADDR_LEN);
+    memcpy(header.chaddr, session->hot->client_mac, ETH_ADDR_LEN);
 
     /* The 'secs' field of a BOOTREQUEST message SHOULD represent the
      * elapsed time, in seconds, since the client sent its first
@@ -1168,9 +1199,7 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
         session->dhcp_request_timestamp.tv_sec = now.tv_sec;
     }
 
-    if (session->vendor_class_id) {
-        dhcp.vendor_class_id=session->vendor_class_id;
-    }
+    dhcp.vendor_class_id = bbl_session_string(session, SESSION_STRING_VENDOR_CLASS_ID, vendor_class_id);
 
     /* TR-101 R-124:
      * The Access Node, when performing the function of a 
@@ -1179,10 +1208,7 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
      * sub-options to all DHCP messages sent by the client before 
      * forwarding to the BNG. */
     if(g_ctx->config.dhcp_access_line && 
-       (session->agent_circuit_id || session->agent_remote_id)) {
-        access_line.aci = session->agent_circuit_id;
-        access_line.ari = session->agent_remote_id;
-        access_line.aaci = session->access_aggregation_circuit_id;
+       bbl_tx_access_line_strings(session, &access_line, access_line_buf)) {
         access_line.up = session->rate_up;
         access_line.down = session->rate_down;
         access_line.dsl_type = session->dsl_type;
@@ -1255,7 +1281,7 @@ bbl_tx_encode_packet_dhcp(bbl_session_s *session)
                       g_ctx->config.dhcp_release_interval, 0, session, &bbl_dhcp_timeout);
         } else {
             session->dhcp_state = BBL_DHCP_INIT;
-            if(session->session_state == BBL_TERMINATING) {
+            if(session->hot->session_state == BBL_TERMINATING) {
                 bbl_session_clear(session);
             }
         }
@@ -1280,7 +1306,7 @@ bbl_arp_timeout(timer_s *timer)
 static protocol_error_t
 bbl_tx_encode_packet_arp_request(bbl_session_s *session)
 {
-    bbl_access_interface_s *access_interface = session->access_interface;
+    bbl_access_interface_s *access_interface = session->hot->access_interface;
 
     bbl_ethernet_header_s eth = {0};
     bbl_arp_s arp = {0};
@@ -1289,15 +1315,15 @@ bbl_tx_encode_packet_arp_request(bbl_session_s *session)
         return IGNORED;
     }
 
-    eth.src = session->client_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.type = ETH_TYPE_ARP;
     eth.next = &arp;
     arp.code = ARP_REQUEST;
-    arp.sender = session->client_mac;
+    arp.sender = session->hot->client_mac;
     arp.sender_ip = session->ip_address;
     arp.target_ip = session->peer_ip_address;
 
@@ -1324,21 +1350,21 @@ bbl_tx_encode_packet_arp_reply(bbl_session_s *session)
     bbl_ethernet_header_s eth = {0};
     bbl_arp_s arp = {0};
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.type = ETH_TYPE_ARP;
     eth.next = &arp;
     arp.code = ARP_REPLY;
-    arp.sender = session->client_mac;
+    arp.sender = session->hot->client_mac;
     arp.sender_ip = session->ip_address;
-    arp.target = session->server_mac;
+    arp.target = session->hot->server_mac;
     arp.target_ip = session->peer_ip_address;
 
-    session->access_interface->stats.arp_tx++;
+    session->hot->access_interface->stats.arp_tx++;
     return encode_ethernet(session->write_buf, &session->write_idx, &eth);
 }
 
@@ -1347,12 +1373,13 @@ bbl_tx_encode_packet_cfm_cc(bbl_session_s *session)
 {
     bbl_ethernet_header_s eth = {0};
     bbl_cfm_s cfm = {0};
+    char ma_name[SUB_STR_LEN];
 
-    eth.dst = session->server_mac;
-    eth.src = session->client_mac;
+    eth.dst = session->hot->server_mac;
+    eth.src = session->hot->client_mac;
     eth.qinq = session->access_config->qinq;
-    eth.vlan_outer = session->vlan_key.outer_vlan_id;
-    eth.vlan_inner = session->vlan_key.inner_vlan_id;
+    eth.vlan_outer = session->hot->vlan_key.outer_vlan_id;
+    eth.vlan_inner = session->hot->vlan_key.inner_vlan_id;
     eth.vlan_three = session->access_third_vlan;
     eth.type = ETH_TYPE_CFM;
     eth.next = &cfm;
@@ -1363,12 +1390,12 @@ bbl_tx_encode_packet_cfm_cc(bbl_session_s *session)
     cfm.md_name_format = CMF_MD_NAME_FORMAT_NONE;
     cfm.ma_id = session->cfm_ma_id;
     cfm.ma_name_format = CMF_MA_NAME_FORMAT_STRING;
-    if(session->cfm_ma_name) {
-        cfm.ma_name_len = strlen(session->cfm_ma_name);
-        cfm.ma_name = (uint8_t*)session->cfm_ma_name;
+    cfm.ma_name = (uint8_t*)bbl_session_string(session, SESSION_STRING_CFM_MA_NAME, ma_name);
+    if(cfm.ma_name) {
+        cfm.ma_name_len = strlen((char*)cfm.ma_name);
     }
 
-    session->access_interface->stats.cfm_cc_tx++;
+    session->hot->access_interface->stats.cfm_cc_tx++;
     return encode_ethernet(session->write_buf, &session->write_idx, &eth);
 }
 
@@ -10,24 +10,44 @@
 #include "bbl.h"
 #include "bbl_session.h"
 
+/**
+ * @brief Init TXQ. 
+ *
+ * The ring size is calculated assuming an average packet 
+ * length of BBL_TXQ_SLOT_AVG_LEN per slot, such that mostly 
+ * small control packets do not waste a full size buffer each. 
+ *
+ * @param txq TXQ
+ * @param slots number of slots
+ * @return true if successful
+ */
 bool
-bbl_txq_init(bbl_txq_s *txq, uint16_t size)
+bbl_txq_init(bbl_txq_s *txq, uint16_t slots)
 {
-    txq->ring = calloc(1, size * sizeof(bbl_txq_slot_t));
+    uint32_t size = BBL_TXQ_SLOT_ALIGN;
+    while(size < 4 * BBL_TXQ_SLOT_MAX_LEN || 
+          size < (uint32_t)slots * BBL_TXQ_SLOT_AVG_LEN) {
+        size <<= 1;
+    }
+
+    txq->ring = aligned_alloc(BBL_TXQ_SLOT_ALIGN, size);
     if(!txq->ring) {
         return false;
     }
-    txq->size   = size;
-    txq->read   = 0;
-    txq->write  = 0;
-    txq->next   = 1;
+    txq->size = size;
+    txq->next = 0;
+    txq->read_cache = 0;
+    txq->cursor = 0;
+    txq->write_cache = 0;
+    atomic_store(&txq->write, 0);
+    atomic_store(&txq->read, 0);
     return true;
 }
 
 bool
 bbl_txq_is_empty(bbl_txq_s *txq)
 {
-    if(txq->read == txq->write) {
+    if(txq->cursor == atomic_load_explicit(&txq->write, memory_order_acquire)) {
         return true;
     }
     return false;
@@ -36,7 +56,12 @@ bbl_txq_is_empty(bbl_txq_s *txq)
 bool
 bbl_txq_is_full(bbl_txq_s *txq)
 {
-    if(txq->read == txq->next) {
+    uint32_t pos = txq->next & (txq->size - 1);
+    uint32_t need = BBL_TXQ_SLOT_MAX_LEN;
+    if(txq->size - pos < need) {
+        need += txq->size - pos;
+    }
+    if(txq->next - atomic_load_explicit(&txq->read, memory_order_acquire) + need > txq->size) {
         return true;
     }
     return false;
@@ -54,20 +79,18 @@ uint16_t
 bbl_txq_from_buffer(bbl_txq_s *txq, uint8_t *buf)
 {
     bbl_txq_slot_t *slot;
+    uint16_t len;
 
-    if(txq->read == txq->write) {
+    slot = bbl_txq_read_slot(txq);
+    if(!slot) {
         /* Empty! */
         return 0;
     }
-
-    slot = txq->ring + txq->read;
-    memcpy(buf, slot->packet, slot->packet_len);
-
-    txq->read++;
-    if(txq->read == txq->size) {
-        txq->read = 0;
-    }
-    return slot->packet_len;
+    len = slot->packet_len;
+    memcpy(buf, slot->packet, len);
+    bbl_txq_read_next(txq);
+    bbl_txq_read_commit(txq);
+    return len;
 }
 
 /**
@@ -82,17 +105,14 @@ bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth)
 {
     bbl_txq_slot_t *slot;
 
-    if(txq->read == txq->next) {
-        txq->stats.full++;
+    slot = bbl_txq_write_slot(txq);
+    if(!slot) {
         return BBL_TXQ_FULL;
     }
-    slot = txq->ring + txq->write;
     slot->packet_len = 0;
     if(encode_ethernet(slot->packet, &slot->packet_len, eth) == PROTOCOL_SUCCESS) {
-        txq->write = txq->next++;
-        if(txq->next == txq->size) {
-            txq->next = 0;
-        }
+        bbl_txq_write_next(txq);
+        bbl_txq_write_commit(txq);
         return BBL_TXQ_OK;
     } else {
         txq->stats.encode_error++;
@@ -100,40 +120,117 @@ bbl_txq_to_buffer(bbl_txq_s *txq, bbl_ethernet_header_s *eth)
     }
 }
 
+/**
+ * @brief Get next slot to read or NULL
+ * if TXQ is empty (consumer).
+ *
+ * @param txq TXQ
+ * @return slot
+ */
 bbl_txq_slot_t *
 bbl_txq_read_slot(bbl_txq_s *txq)
 {
-    if(txq->read == txq->write) {
-        return NULL;
+    bbl_txq_slot_t *slot;
+    uint32_t pos;
+
+    while(true) {
+        if(txq->cursor == txq->write_cache) {
+            txq->write_cache = atomic_load_explicit(&txq->write, memory_order_acquire);
+            if(txq->cursor == txq->write_cache) {
+                return NULL;
+            }
+        }
+        pos = txq->cursor & (txq->size - 1);
+        slot = (bbl_txq_slot_t*)(txq->ring + pos);
+        if(slot->slot_len) {
+            return slot;
+        }
+        /* Wrap to ring start. */
+        txq->cursor += txq->size - pos;
     }
-    return txq->ring + txq->read;
 }
 
+/**
+ * @brief Release current read slot, which will 
+ * be returned to the producer with next commit. 
+ *
+ * @param txq TXQ
+ */
 void
 bbl_txq_read_next(bbl_txq_s *txq) 
 {
-    txq->read++;
-    if(txq->read == txq->size) {
-        txq->read = 0;
-    }
+    bbl_txq_slot_t *slot = (bbl_txq_slot_t*)(txq->ring + (txq->cursor & (txq->size - 1)));
+    txq->cursor += slot->slot_len;
 }
 
+/**
+ * @brief Return all released slots to the producer.
+ *
+ * @param txq TXQ
+ */
+void
+bbl_txq_read_commit(bbl_txq_s *txq) 
+{
+    atomic_store_explicit(&txq->read, txq->cursor, memory_order_release);
+}
+
+/**
+ * @brief Reserve next slot to write with space for 
+ * BBL_TXQ_BUFFER_LEN bytes or NULL if TXQ is full (producer).
+ *
+ * @param txq TXQ
+ * @return slot
+ */
 bbl_txq_slot_t *
 bbl_txq_write_slot(bbl_txq_s *txq)
 {
-    if(txq->read == txq->next) {
-        txq->stats.full++;
-        return NULL;
-    }
+    bbl_txq_slot_t *slot;
+    uint32_t pos = txq->next & (txq->size - 1);
+    uint32_t contig = txq->size - pos;
+    uint32_t need = BBL_TXQ_SLOT_MAX_LEN;
 
-    return txq->ring + txq->write;
+    if(contig < need) {
+        /* Slot does not fit into the end of ring. */
+        need += contig;
+    }
+    if(txq->next - txq->read_cache + need > txq->size) {
+        txq->read_cache = atomic_load_explicit(&txq->read, memory_order_acquire);
+        if(txq->next - txq->read_cache + need > txq->size) {
+            txq->stats.full++;
+            return NULL;
+        }
+    }
+    if(contig < BBL_TXQ_SLOT_MAX_LEN) {
+        /* Mark end of ring and wrap to ring start. */
+        slot = (bbl_txq_slot_t*)(txq->ring + pos);
+        slot->slot_len = 0;
+        txq->next += contig;
+        pos = 0;
+    }
+    return (bbl_txq_slot_t*)(txq->ring + pos);
 }
 
+/**
+ * @brief Add current write slot to the batch, which 
+ * will be passed to the consumer with next commit. 
+ *
+ * @param txq TXQ
+ */
 void
 bbl_txq_write_next(bbl_txq_s *txq) 
 {
-    txq->write = txq->next++;
-    if(txq->next == txq->size) {
-        txq->next = 0;
-    }
-}
\ No newline at end of file
+    bbl_txq_slot_t *slot = (bbl_txq_slot_t*)(txq->ring + (txq->next & (txq->size - 1)));
+    slot->slot_len = BBL_TXQ_SLOT_LEN(slot->packet_len);
+    txq->next += slot->slot_len;
+}
+
+/**
+ * @brief Pass all written slots to the consumer.
+ *
+ * @param txq TXQ
+ */
+void
+bbl_txq_write_commit(bbl_txq_s *txq) 
+{
+    atomic_store_explicit(&txq->write, txq->next, memory_order_release);
+}
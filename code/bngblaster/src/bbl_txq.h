@@ -15,6 +15,11 @@
 
 #define BBL_TXQ_DEFAULT_SIZE 4096
 #define BBL_TXQ_BUFFER_LEN 4074
+#define BBL_TXQ_SLOT_ALIGN CACHE_LINE_SIZE
+#define BBL_TXQ_SLOT_AVG_LEN 512 /* used to calculate the ring size */
+#define BBL_TXQ_SLOT_LEN(_packet_len) \
+    ((sizeof(bbl_txq_slot_t) + (_packet_len) + BBL_TXQ_SLOT_ALIGN - 1) & ~(BBL_TXQ_SLOT_ALIGN - 1))
+#define BBL_TXQ_SLOT_MAX_LEN BBL_TXQ_SLOT_LEN(BBL_TXQ_BUFFER_LEN)
 
 typedef enum bbl_ring_result_ {
     BBL_TXQ_OK = 0,
@@ -22,22 +27,34 @@ typedef enum bbl_ring_result_ {
     BBL_TXQ_FULL
 } bbl_txq_result_t;
 
+/* Variable length slot, packed into the 
+ * ring and aligned to BBL_TXQ_SLOT_ALIGN. */
 typedef struct bbl_txq_slot_ {
     struct timespec timestamp;
     uint16_t vlan_tci;
     uint16_t vlan_tpid;
     uint16_t packet_len;
-    uint8_t packet[BBL_TXQ_BUFFER_LEN];
+    uint16_t slot_len; /* zero marks end of ring (wrap) */
+    uint8_t packet[];
 } bbl_txq_slot_t;
 
+/**
+ * The TXQ is a lock-free single producer and single consumer 
+ * ring of variable length slots. Producer and consumer work on 
+ * private positions (next and cursor) which are published to 
+ * the other side with a single atomic store per batch using 
+ * bbl_txq_write_commit and bbl_txq_read_commit. Positions are 
+ * free running byte counters, the ring size is a power of 2.
+ */
 typedef struct bbl_txq_ {
-    bbl_txq_slot_t *ring; /* ring buffer */
-    uint16_t size; /* number of send slots */
+    uint8_t *ring; /* ring buffer */
+    uint32_t size; /* ring buffer size in bytes */
 
     char _pad0 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
-    atomic_uint_least16_t write; /* current write slot */
-    atomic_uint_least16_t next; /* next write slot */
+    atomic_uint_least32_t write; /* published write position */
+    uint32_t next; /* next write position (producer) */
+    uint32_t read_cache; /* last read position seen by producer */
     struct {
         uint32_t full; 
         uint32_t encode_error;
@@ -45,7 +62,9 @@ typedef struct bbl_txq_ {
 
     char _pad1 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
 
-    atomic_uint_least16_t read; /* current read slot */
+    atomic_uint_least32_t read; /* published read position */
+    uint32_t cursor; /* current read position (consumer) */
+    uint32_t write_cache; /* last write position seen by consumer */
 } bbl_txq_s;
 
 bool
@@ -69,10 +88,16 @@ bbl_txq_read_slot(bbl_txq_s *txq);
 void
 bbl_txq_read_next(bbl_txq_s *txq);
 
+void
+bbl_txq_read_commit(bbl_txq_s *txq);
+
 bbl_txq_slot_t *
 bbl_txq_write_slot(bbl_txq_s *txq);
 
 void
 bbl_txq_write_next(bbl_txq_s *txq);
 
+void
+bbl_txq_write_commit(bbl_txq_s *txq);
+
 #endif
\ No newline at end of file
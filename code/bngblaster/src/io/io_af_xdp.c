@@ -0,0 +1,931 @@
+/*
+ * BNG Blaster (BBL) - IO AF_XDP
+ *
+ * AF_XDP sockets (XSK) receive and send packets directly from and to
+ * a user space memory area (UMEM) which is shared with the kernel.
+ * Packets are exchanged via four single producer/consumer rings, where
+ * the fill and RX rings are used for receiving and the TX and completion
+ * rings for sending. In contrast to DPDK, the interface remains visible
+ * to the kernel and packets not redirected by the XDP program are passed
+ * to the regular network stack.
+ *
+ * Each queue has one UMEM which is registered by the RX socket and shared
+ * with the TX socket bound to the same queue. The first part of the UMEM
+ * frames is reserved for the fill ring (RX) and the second part for the
+ * TX ring. This way, the fill ring is exclusively used by the RX handle
+ * and the completion ring by the TX handle, allowing both to run in
+ * different threads without further synchronization.
+ *
+ * https://www.kernel.org/doc/html/latest/networking/af_xdp.html
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "io.h"
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
+
+#define XSK_FRAME_SIZE  4096
+#define XSK_RX_BATCH    64
+
+extern bool g_init_phase;
+extern bool g_traffic;
+
+/* Consumer ring (RX and completion) helpers. */
+
+static inline uint32_t
+xsk_cons_peek(io_xsk_ring_s *r, uint32_t n)
+{
+    uint32_t entries = r->cached_prod - r->cached_cons;
+    if(entries == 0) {
+        r->cached_prod = __atomic_load_n(r->producer, __ATOMIC_ACQUIRE);
+        entries = r->cached_prod - r->cached_cons;
+    }
+    return (entries > n) ? n : entries;
+}
+
+static inline void
+xsk_cons_release(io_xsk_ring_s *r)
+{
+    __atomic_store_n(r->consumer, r->cached_cons, __ATOMIC_RELEASE);
+}
+
+/* Producer ring (fill and TX) helpers. */
+
+static inline uint32_t
+xsk_prod_free(io_xsk_ring_s *r, uint32_t n)
+{
+    uint32_t free_entries = r->cached_cons - r->cached_prod;
+    if(free_entries < n) {
+        r->cached_cons = __atomic_load_n(r->consumer, __ATOMIC_ACQUIRE) + r->size;
+        free_entries = r->cached_cons - r->cached_prod;
+    }
+    return free_entries;
+}
+
+static inline void
+xsk_prod_submit(io_xsk_ring_s *r)
+{
+    __atomic_store_n(r->producer, r->cached_prod, __ATOMIC_RELEASE);
+}
+
+static inline bool
+xsk_need_wakeup(io_xsk_ring_s *r)
+{
+    return *r->flags & XDP_RING_NEED_WAKEUP;
+}
+
+static uint32_t
+xsk_ring_size(uint16_t slots)
+{
+    uint32_t size = 32;
+    while(size < slots) {
+        size <<= 1;
+    }
+    return size;
+}
+
+static int
+bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/**
+ * Verify the number of RX or TX threads against the
+ * interface queues. The number of RX queues must match 
+ * the number of RX threads, because packets received
+ * on a queue without bound XSK are passed to the
+ * kernel and would be silently missed. TX threads 
+ * are bound to the queues with the same index and 
+ * therefore limited by the number of TX queues.
+ */
+static bool
+io_af_xdp_queues_check(io_handle_s *io, uint32_t threads)
+{
+    bbl_interface_s *interface = io->interface;
+    struct ethtool_channels channels = {0};
+    struct ifreq ifr = {0};
+    uint32_t queues = 1;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        return true;
+    }
+    channels.cmd = ETHTOOL_GCHANNELS;
+    ifr.ifr_data = (void*)&channels;
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", interface->name);
+    if(ioctl(fd, SIOCETHTOOL, &ifr) < 0) {
+        /* Drivers without channel support have one queue. */
+        LOG(DEBUG, "AF_XDP: failed to get channels of interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+    } else if(io->direction == IO_INGRESS) {
+        queues = channels.combined_count + channels.rx_count;
+    } else {
+        queues = channels.combined_count + channels.tx_count;
+    }
+    close(fd);
+
+    if(io->direction == IO_INGRESS) {
+        if(queues != threads) {
+            LOG(ERROR, "AF_XDP: interface %s has %u RX queues but %u RX threads, "
+                "change queues with ethtool -L %s combined %u\n",
+                interface->name, queues, threads, interface->name, threads);
+            return false;
+        }
+    } else if(queues < threads) {
+        LOG(ERROR, "AF_XDP: interface %s has %u TX queues but %u TX threads, "
+            "change queues with ethtool -L %s combined %u\n",
+            interface->name, queues, threads, interface->name, threads);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Load and attach the XDP program redirecting
+ * all packets to the XSK bound to the receiving
+ * queue if present or to the kernel otherwise.
+ *
+ * SEC("xdp") int xsk_redirect(struct xdp_md *ctx) {
+ *     return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+ * }
+ */
+static bool
+io_af_xdp_prog_attach(io_handle_s *io, uint32_t queues)
+{
+    bbl_interface_s *interface = io->interface;
+    union bpf_attr attr;
+    char log_buf[256] = {0};
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(int);
+    attr.max_entries = queues;
+    io->xsk_map_fd = bpf(BPF_MAP_CREATE, &attr);
+    if(io->xsk_map_fd < 0) {
+        LOG(ERROR, "AF_XDP: failed to create XSK map for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        return false;
+    }
+
+    struct bpf_insn prog[] = {
+        /* r2 = ctx->rx_queue_index */
+        { .code = BPF_LDX|BPF_MEM|BPF_W, .dst_reg = BPF_REG_2, .src_reg = BPF_REG_1,
+          .off = offsetof(struct xdp_md, rx_queue_index) },
+        /* r1 = xsks_map */
+        { .code = BPF_LD|BPF_DW|BPF_IMM, .dst_reg = BPF_REG_1, .src_reg = BPF_PSEUDO_MAP_FD,
+          .imm = io->xsk_map_fd },
+        { 0 },
+        /* r3 = XDP_PASS */
+        { .code = BPF_ALU64|BPF_MOV|BPF_K, .dst_reg = BPF_REG_3, .imm = XDP_PASS },
+        /* r0 = bpf_redirect_map(r1, r2, r3) */
+        { .code = BPF_JMP|BPF_CALL, .imm = BPF_FUNC_redirect_map },
+        { .code = BPF_JMP|BPF_EXIT },
+    };
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)prog;
+    attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+    attr.license = (uintptr_t)"Dual BSD/GPL";
+    attr.log_buf = (uintptr_t)log_buf;
+    attr.log_size = sizeof(log_buf);
+    attr.log_level = 1;
+    io->xdp_prog_fd = bpf(BPF_PROG_LOAD, &attr);
+    if(io->xdp_prog_fd < 0) {
+        LOG(ERROR, "AF_XDP: failed to load XDP program for interface %s - %s (%d) %s\n",
+            interface->name, strerror(errno), errno, log_buf);
+        return false;
+    }
+
+    /* The XDP program is detached automatically
+     * if the link file descriptor is closed. */
+    memset(&attr, 0x0, sizeof(attr));
+    attr.link_create.prog_fd = io->xdp_prog_fd;
+    attr.link_create.target_ifindex = interface->kernel_index;
+    attr.link_create.attach_type = BPF_XDP;
+    io->xdp_link_fd = bpf(BPF_LINK_CREATE, &attr);
+    if(io->xdp_link_fd < 0) {
+        LOG(ERROR, "AF_XDP: failed to attach XDP program to interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        return false;
+    }
+    LOG(DEBUG, "AF_XDP: attached XDP program to interface %s (%u queues)\n",
+        interface->name, queues);
+    return true;
+}
+
+static bool
+io_af_xdp_map_update(io_handle_s *io, int map_fd)
+{
+    union bpf_attr attr;
+    uint32_t key = io->id;
+    int value = io->fd;
+
+    memset(&attr, 0x0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)&value;
+    if(bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        LOG(ERROR, "AF_XDP: failed to add socket for interface %s queue %u to XSK map - %s (%d)\n",
+            io->interface->name, key, strerror(errno), errno);
+        return false;
+    }
+    return true;
+}
+
+static bool
+io_af_xdp_ring_map(io_handle_s *io, int fd, io_xsk_ring_s *r, struct xdp_ring_offset *off,
+                   uint32_t size, size_t desc_size, off_t pgoff, bool producer)
+{
+    r->map_len = off->desc + size * desc_size;
+    r->map = mmap(NULL, r->map_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, pgoff);
+    if(r->map == MAP_FAILED) {
+        LOG(ERROR, "AF_XDP: failed to map ring for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    r->producer = (uint32_t*)((uint8_t*)r->map + off->producer);
+    r->consumer = (uint32_t*)((uint8_t*)r->map + off->consumer);
+    r->flags = (uint32_t*)((uint8_t*)r->map + off->flags);
+    r->ring = (uint8_t*)r->map + off->desc;
+    r->size = size;
+    r->mask = size - 1;
+    r->cached_prod = *r->producer;
+    r->cached_cons = *r->consumer;
+    if(producer) {
+        r->cached_cons += size;
+    }
+    return true;
+}
+
+/**
+ * Create and register UMEM including
+ * fill and completion ring.
+ */
+static bool
+io_af_xdp_umem_init(io_handle_s *io, uint32_t rx_frames, uint32_t tx_frames)
+{
+    io_xsk_umem_s *umem;
+    struct xdp_umem_reg mr = {0};
+    struct xdp_mmap_offsets off = {0};
+    socklen_t optlen = sizeof(off);
+    uint32_t fill_size = rx_frames ? rx_frames : tx_frames;
+    uint32_t comp_size = tx_frames ? tx_frames : rx_frames;
+    uint32_t i;
+
+    umem = calloc(1, sizeof(io_xsk_umem_s));
+    if(!umem) return false;
+    umem->fd = io->fd;
+    umem->frame_size = XSK_FRAME_SIZE;
+    umem->rx_frames = rx_frames;
+    umem->tx_frames = tx_frames;
+    umem->area_len = (uint64_t)(rx_frames + tx_frames) * umem->frame_size;
+    umem->area = mmap(NULL, umem->area_len, PROT_READ|PROT_WRITE,
+                      MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0);
+    if(umem->area == MAP_FAILED) {
+        LOG(ERROR, "AF_XDP: failed to allocate %lu byte UMEM for interface %s\n",
+            umem->area_len, io->interface->name);
+        free(umem);
+        return false;
+    }
+    io->umem = umem;
+
+    mr.addr = (uintptr_t)umem->area;
+    mr.len = umem->area_len;
+    mr.chunk_size = umem->frame_size;
+    mr.headroom = 0;
+    if(setsockopt(io->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) == -1) {
+        LOG(ERROR, "AF_XDP: failed to register UMEM for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    if(setsockopt(io->fd, SOL_XDP, XDP_UMEM_FILL_RING, &fill_size, sizeof(fill_size)) == -1 ||
+       setsockopt(io->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &comp_size, sizeof(comp_size)) == -1) {
+        LOG(ERROR, "AF_XDP: failed to setup fill/completion ring for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    if(getsockopt(io->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) == -1) {
+        LOG(ERROR, "AF_XDP: failed to get ring offsets for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    if(!io_af_xdp_ring_map(io, io->fd, &umem->fill, &off.fr, fill_size, sizeof(uint64_t),
+                           XDP_UMEM_PGOFF_FILL_RING, true)) {
+        return false;
+    }
+    if(!io_af_xdp_ring_map(io, io->fd, &umem->comp, &off.cr, comp_size, sizeof(uint64_t),
+                           XDP_UMEM_PGOFF_COMPLETION_RING, false)) {
+        return false;
+    }
+
+    /* Hand over all RX frames to the kernel. */
+    for(i = 0; i < rx_frames; i++) {
+        ((uint64_t*)umem->fill.ring)[umem->fill.cached_prod++ & umem->fill.mask] = i * umem->frame_size;
+    }
+    xsk_prod_submit(&umem->fill);
+
+    LOG(DEBUG, "AF_XDP: setup %lu byte UMEM (%u RX and %u TX frames) for interface %s queue %u\n",
+        umem->area_len, rx_frames, tx_frames, io->interface->name, io->id);
+    return true;
+}
+
+static void
+io_af_xdp_tx_complete(io_handle_s *io)
+{
+    io_xsk_ring_s *comp = &io->umem->comp;
+    uint32_t n = xsk_cons_peek(comp, comp->size);
+    while(n--) {
+        io->xsk_frames[io->xsk_frames_free++] = ((uint64_t*)comp->ring)[comp->cached_cons++ & comp->mask];
+    }
+    xsk_cons_release(comp);
+}
+
+static void
+io_af_xdp_tx_kick(io_handle_s *io)
+{
+    io->stats.polled++;
+    if(sendto(io->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0) {
+        if(errno == EAGAIN || errno == EBUSY || errno == ENOBUFS) {
+            return;
+        }
+        LOG(IO, "AF_XDP sendto on interface %s failed with error %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        io->stats.io_errors++;
+    }
+}
+
+static void
+io_af_xdp_rx_kick(io_handle_s *io)
+{
+    if(xsk_need_wakeup(&io->umem->fill)) {
+        io->stats.polled++;
+        recvfrom(io->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+    }
+}
+
+/**
+ * This job is for AF_XDP RX in main thread!
+ */
+void
+io_af_xdp_rx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    bbl_interface_s *interface = io->interface;
+    io_xsk_umem_s *umem = io->umem;
+    io_xsk_ring_s *fill = &umem->fill;
+    io_xsk_ring_s *rx = &io->xsk;
+    struct xdp_desc *desc;
+
+    bbl_ethernet_header_s *eth;
+    uint32_t n;
+
+    protocol_error_t decode_result;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread == NULL);
+
+    n = xsk_cons_peek(rx, XSK_RX_BATCH);
+    if(n == 0) {
+        io_af_xdp_rx_kick(io);
+        return;
+    }
+
+    /* Get RX timestamp */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    while(n) {
+        /* The fill ring is large enough to hold all RX frames. */
+        xsk_prod_free(fill, n);
+        while(n--) {
+            desc = &((struct xdp_desc*)rx->ring)[rx->cached_cons++ & rx->mask];
+            io->buf = umem->area + desc->addr;
+            io->buf_len = desc->len;
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                              interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                bbl_rx_handler(interface, eth);
+            } else {
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                              interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                if(decode_result == UNKNOWN_PROTOCOL) {
+                    io->stats.unknown++;
+                } else {
+                    io->stats.protocol_errors++;
+                }
+            }
+            /* Return frame back to kernel */
+            ((uint64_t*)fill->ring)[fill->cached_prod++ & fill->mask] = desc->addr & ~((uint64_t)umem->frame_size - 1);
+        }
+        xsk_cons_release(rx);
+        xsk_prod_submit(fill);
+        n = xsk_cons_peek(rx, XSK_RX_BATCH);
+    }
+    io_af_xdp_rx_kick(io);
+    if(pcap) {
+        pcapng_fflush();
+    }
+}
+
+/**
+ * This job is for AF_XDP TX in main thread!
+ */
+void
+io_af_xdp_tx_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+    bbl_interface_s *interface = io->interface;
+    io_xsk_ring_s *tx = &io->xsk;
+    struct xdp_desc *desc;
+    uint64_t addr;
+
+    bbl_stream_s *stream = NULL;
+    uint16_t burst = interface->config->io_burst;
+    uint64_t now;
+
+    bool ctrl = true;
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_EGRESS);
+    assert(io->thread == NULL);
+
+    io_af_xdp_tx_complete(io);
+    if(xsk_prod_free(tx, burst) < burst) {
+        burst = tx->cached_cons - tx->cached_prod;
+    }
+
+    /* Get TX timestamp */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    now = timespec_to_nsec(timer->timestamp);
+    while(burst) {
+        if(io->xsk_frames_free == 0) {
+            io->stats.no_buffer++;
+            break;
+        }
+        addr = io->xsk_frames[io->xsk_frames_free-1];
+        io->buf = io->umem->area + addr;
+
+        if(unlikely(ctrl)) {
+            /* First send all control traffic which has higher priority. */
+            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
+                ctrl = false;
+                continue;
+            }
+        } else {
+            if(!(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP)) {
+                bbl_stream_io_stop(io);
+                break;
+            }
+            stream = bbl_stream_io_send_iter(io, now);
+            if(unlikely(stream == NULL)) {
+                break;
+            }
+            memcpy(io->buf, stream->tx_buf, stream->tx_len);
+            io->buf_len = stream->tx_len;
+            stream->tx_packets++;
+            stream->flow_seq++;
+        }
+        io->xsk_frames_free--;
+        desc = &((struct xdp_desc*)tx->ring)[tx->cached_prod++ & tx->mask];
+        desc->addr = addr;
+        desc->len = io->buf_len;
+        desc->options = 0;
+
+        io->queued++;
+        io->stats.packets++;
+        io->stats.bytes += io->buf_len;
+        burst--;
+
+        /* Dump the packet into pcap file. */
+        if(g_ctx->pcap.write_buf && (ctrl || g_ctx->pcap.include_streams)) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
+        }
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+
+    if(io->queued) {
+        xsk_prod_submit(tx);
+        io->queued = 0;
+    }
+    if(xsk_need_wakeup(tx)) {
+        io_af_xdp_tx_kick(io);
+    }
+}
+
+void
+io_af_xdp_thread_rx_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    io_xsk_umem_s *umem = io->umem;
+    io_xsk_ring_s *fill = &umem->fill;
+    io_xsk_ring_s *rx = &io->xsk;
+    struct xdp_desc *desc;
+    uint32_t n;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->thread);
+
+    struct timespec sleep, rem;
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10000; /* 0.01ms */
+
+    io->vlan_tci = 0;
+    io->vlan_tpid = 0;
+    while(thread->active) {
+        n = xsk_cons_peek(rx, XSK_RX_BATCH);
+        if(n == 0) {
+            io_af_xdp_rx_kick(io);
+            nanosleep(&sleep, &rem);
+            continue;
+        }
+
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        xsk_prod_free(fill, n);
+        while(n--) {
+            desc = &((struct xdp_desc*)rx->ring)[rx->cached_cons & rx->mask];
+            io->buf = umem->area + desc->addr;
+            io->buf_len = desc->len;
+            /* Process packet */
+            if(io_thread_rx_handler(thread, io) == IO_FULL) {
+                break;
+            }
+            rx->cached_cons++;
+            /* Return frame back to kernel */
+            ((uint64_t*)fill->ring)[fill->cached_prod++ & fill->mask] = desc->addr & ~((uint64_t)umem->frame_size - 1);
+        }
+        xsk_cons_release(rx);
+        xsk_prod_submit(fill);
+        bbl_txq_write_commit(thread->txq);
+        if(rx->cached_cons == rx->cached_prod) {
+            nanosleep(&sleep, &rem);
+        }
+    }
+}
+
+void
+io_af_xdp_thread_tx_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    bbl_interface_s *interface = io->interface;
+    io_xsk_ring_s *tx = &io->xsk;
+    struct xdp_desc *desc;
+    uint64_t addr;
+
+    bbl_txq_s *txq = thread->txq;
+    bbl_txq_slot_t *slot;
+
+    bbl_stream_s *stream = NULL;
+    uint16_t io_burst = interface->config->io_burst;
+    uint16_t burst = 0;
+    uint32_t free_entries;
+    uint64_t now;
+
+    bool ctrl = true;
+
+    struct timespec sleep, rem;
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+    assert(io->direction == IO_EGRESS);
+    assert(io->thread);
+
+    while(thread->active) {
+        nanosleep(&sleep, &rem);
+        io_thread_stream_msg_process(thread);
+        io_thread_stream_epoch(thread);
+
+        io_af_xdp_tx_complete(io);
+        /* The free count of an empty ring with 65536
+         * entries does not fit into the burst. */
+        free_entries = xsk_prod_free(tx, io_burst);
+        if(free_entries == 0 || io->xsk_frames_free == 0) {
+            /* If no buffer is available kick kernel. */
+            io->stats.no_buffer++;
+            io_af_xdp_tx_kick(io);
+            continue;
+        }
+        burst = free_entries > io_burst ? io_burst : free_entries;
+
+        /* Get TX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+
+        ctrl = true;
+        now = timespec_to_nsec(&io->timestamp);
+        while(burst) {
+            if(io->xsk_frames_free == 0) {
+                io->stats.no_buffer++;
+                break;
+            }
+            addr = io->xsk_frames[io->xsk_frames_free-1];
+            io->buf = io->umem->area + addr;
+
+            if(unlikely(ctrl)) {
+                /* First send all control traffic which has higher priority. */
+                slot = bbl_txq_read_slot(txq);
+                if(slot) {
+                    io->buf_len = slot->packet_len;
+                    memcpy(io->buf, slot->packet, slot->packet_len);
+                    bbl_txq_read_next(txq);
+                } else {
+                    ctrl = false;
+                    continue;
+                }
+            } else {
+                if(!(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP)) {
+                    bbl_stream_io_stop(io);
+                    break;
+                }
+                /* Send traffic streams up to allowed burst. */
+                stream = bbl_stream_io_send_iter(io, now);
+                if(unlikely(stream == NULL)) {
+                    break;
+                }
+                memcpy(io->buf, stream->tx_buf, stream->tx_len);
+                io->buf_len = stream->tx_len;
+                stream->tx_packets++;
+                stream->flow_seq++;
+            }
+            io->xsk_frames_free--;
+            desc = &((struct xdp_desc*)tx->ring)[tx->cached_prod++ & tx->mask];
+            desc->addr = addr;
+            desc->len = io->buf_len;
+            desc->options = 0;
+
+            io->queued++;
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            burst--;
+        }
+        bbl_txq_read_commit(txq);
+
+        if(io->queued) {
+            xsk_prod_submit(tx);
+            io->queued = 0;
+        }
+        if(xsk_need_wakeup(tx)) {
+            io_af_xdp_tx_kick(io);
+        }
+    }
+}
+
+static io_handle_s *
+io_af_xdp_get_rx(io_handle_s *io)
+{
+    io_handle_s *io_rx = io->interface->io.rx;
+    while(io_rx) {
+        if(io_rx->mode == IO_MODE_AF_XDP && io_rx->id == io->id && io_rx->umem) {
+            return io_rx;
+        }
+        io_rx = io_rx->next;
+    }
+    return NULL;
+}
+
+static int
+io_af_xdp_get_map_fd(io_handle_s *io)
+{
+    io_handle_s *io_rx = io->interface->io.rx;
+    while(io_rx) {
+        if(io_rx != io && io_rx->mode == IO_MODE_AF_XDP && io_rx->xsk_map_fd >= 0) {
+            return io_rx->xsk_map_fd;
+        }
+        io_rx = io_rx->next;
+    }
+    return -1;
+}
+
+static bool
+io_af_xdp_bind(io_handle_s *io, io_handle_s *io_shared)
+{
+    struct sockaddr_xdp sxdp = {0};
+
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = io->interface->kernel_index;
+    sxdp.sxdp_queue_id = io->id;
+    if(io_shared) {
+        sxdp.sxdp_flags = XDP_SHARED_UMEM;
+        sxdp.sxdp_shared_umem_fd = io_shared->fd;
+        if(bind(io->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) == 0) {
+            return true;
+        }
+    } else {
+        /* Try zero-copy mode first with fallback to copy mode
+         * for drivers without AF_XDP zero-copy support. */
+        sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP|XDP_ZEROCOPY;
+        if(bind(io->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) == 0) {
+            LOG(DEBUG, "AF_XDP: interface %s queue %u in zero-copy mode\n",
+                io->interface->name, io->id);
+            return true;
+        }
+        sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP|XDP_COPY;
+        if(bind(io->fd, (struct sockaddr*)&sxdp, sizeof(sxdp)) == 0) {
+            LOG(DEBUG, "AF_XDP: interface %s queue %u in copy mode\n",
+                io->interface->name, io->id);
+            return true;
+        }
+    }
+    LOG(ERROR, "AF_XDP: failed to bind socket for interface %s queue %u - %s (%d)\n",
+        io->interface->name, io->id, strerror(errno), errno);
+    return false;
+}
+
+bool
+io_af_xdp_init(io_handle_s *io)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_link_config_s *config = interface->config;
+    io_thread_s *thread = io->thread;
+    io_handle_s *io_rx = NULL;
+
+    struct xdp_mmap_offsets off = {0};
+    socklen_t optlen = sizeof(off);
+    uint32_t rx_size = xsk_ring_size(config->io_slots_rx);
+    uint32_t tx_size = xsk_ring_size(config->io_slots_tx);
+    uint32_t queues;
+    uint32_t i;
+    int map_fd;
+
+    assert(io->mode == IO_MODE_AF_XDP);
+
+    io->xsk_map_fd = -1;
+    io->xdp_prog_fd = -1;
+    io->xdp_link_fd = -1;
+
+    io->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if(io->fd == -1) {
+        LOG(ERROR, "AF_XDP: failed to open socket for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        return false;
+    }
+
+    if(io->direction == IO_INGRESS) {
+        /* Reserve TX frames if a TX handle will be bound to the same queue. */
+        queues = config->tx_threads ? config->tx_threads : 1;
+        if(!io_af_xdp_umem_init(io, rx_size, (uint32_t)io->id < queues ? tx_size : 0)) {
+            return false;
+        }
+        if(setsockopt(io->fd, SOL_XDP, XDP_RX_RING, &rx_size, sizeof(rx_size)) == -1) {
+            LOG(ERROR, "AF_XDP: failed to setup RX ring for interface %s - %s (%d)\n",
+                interface->name, strerror(errno), errno);
+            return false;
+        }
+    } else {
+        io_rx = io_af_xdp_get_rx(io);
+        if(io_rx && io_rx->umem->tx_frames) {
+            io->umem = io_rx->umem;
+        } else {
+            io_rx = NULL;
+            if(!io_af_xdp_umem_init(io, 0, tx_size)) {
+                return false;
+            }
+        }
+        queues = config->tx_threads ? config->tx_threads : 1;
+        if(!io_af_xdp_queues_check(io, queues)) {
+            return false;
+        }
+        if(setsockopt(io->fd, SOL_XDP, XDP_TX_RING, &tx_size, sizeof(tx_size)) == -1) {
+            LOG(ERROR, "AF_XDP: failed to setup TX ring for interface %s - %s (%d)\n",
+                interface->name, strerror(errno), errno);
+            return false;
+        }
+        /* TX frames are located after the RX frames. */
+        io->xsk_frames = calloc(io->umem->tx_frames, sizeof(uint64_t));
+        if(!io->xsk_frames) return false;
+        for(i = 0; i < io->umem->tx_frames; i++) {
+            io->xsk_frames[i] = (uint64_t)(io->umem->rx_frames + i) * io->umem->frame_size;
+        }
+        io->xsk_frames_free = io->umem->tx_frames;
+    }
+
+    if(getsockopt(io->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) == -1) {
+        LOG(ERROR, "AF_XDP: failed to get ring offsets for interface %s - %s (%d)\n",
+            interface->name, strerror(errno), errno);
+        return false;
+    }
+    if(io->direction == IO_INGRESS) {
+        if(!io_af_xdp_ring_map(io, io->fd, &io->xsk, &off.rx, rx_size,
+                               sizeof(struct xdp_desc), XDP_PGOFF_RX_RING, false)) {
+            return false;
+        }
+    } else {
+        if(!io_af_xdp_ring_map(io, io->fd, &io->xsk, &off.tx, tx_size,
+                               sizeof(struct xdp_desc), XDP_PGOFF_TX_RING, true)) {
+            return false;
+        }
+    }
+
+    if(!io_af_xdp_bind(io, io_rx)) {
+        return false;
+    }
+
+    if(io->direction == IO_INGRESS) {
+        /* The XDP program is shared by all RX queues
+         * and loaded with the first RX handle. */
+        map_fd = io_af_xdp_get_map_fd(io);
+        if(map_fd < 0) {
+            queues = config->rx_threads ? config->rx_threads : 1;
+            if(!io_af_xdp_queues_check(io, queues)) {
+                return false;
+            }
+            if(!io_af_xdp_prog_attach(io, queues)) {
+                return false;
+            }
+            map_fd = io->xsk_map_fd;
+        }
+        if(!io_af_xdp_map_update(io, map_fd)) {
+            return false;
+        }
+    }
+
+    if(thread) {
+        if(io->direction == IO_INGRESS) {
+            thread->run_fn = io_af_xdp_thread_rx_run_fn;
+        } else {
+            thread->run_fn = io_af_xdp_thread_tx_run_fn;
+        }
+    } else {
+        if(io->direction == IO_INGRESS) {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0,
+                config->rx_interval, io, &io_af_xdp_rx_job);
+        } else {
+            timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0,
+                config->tx_interval, io, &io_af_xdp_tx_job);
+        }
+    }
+    return true;
+}
+
+/**
+ * io_af_xdp_close
+ *
+ * Detach the XDP program and close all file
+ * descriptors of the handle.
+ *
+ * @param io IO handle
+ */
+void
+io_af_xdp_close(io_handle_s *io)
+{
+    if(io->xdp_link_fd >= 0) {
+        close(io->xdp_link_fd);
+        io->xdp_link_fd = -1;
+    }
+    if(io->xdp_prog_fd >= 0) {
+        close(io->xdp_prog_fd);
+        io->xdp_prog_fd = -1;
+    }
+    if(io->xsk_map_fd >= 0) {
+        close(io->xsk_map_fd);
+        io->xsk_map_fd = -1;
+    }
+    if(io->fd >= 0) {
+        close(io->fd);
+        io->fd = -1;
+    }
+}
+
+void
+io_af_xdp_set_max_stream_len()
+{
+    uint16_t len = XSK_FRAME_SIZE - XDP_PACKET_HEADROOM - BBL_MAX_STREAM_OVERHEAD;
+
+    if(len < g_ctx->config.io_max_stream_len) {
+        LOG(DEBUG, "Set max allowed stream length to %u because of AF_XDP limitations\n", len);
+        g_ctx->config.io_max_stream_len = len;
+    }
+}
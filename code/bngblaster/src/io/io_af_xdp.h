@@ -0,0 +1,19 @@
+/*
+ * BNG Blaster (BBL) - IO AF_XDP
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __BBL_IO_AF_XDP_H__
+#define __BBL_IO_AF_XDP_H__
+
+bool
+io_af_xdp_init(io_handle_s *io);
+
+void
+io_af_xdp_close(io_handle_s *io);
+
+void
+io_af_xdp_set_max_stream_len();
+
+#endif
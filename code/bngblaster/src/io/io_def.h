@@ -10,6 +10,10 @@
 #define __BBL_IO_DEF_H__
 
 #define IO_TOKENS_PER_PACKET 1000
+#define IO_TPACKET_V3_BLOCK_SIZE (1 << 20)
+#define IO_RAW_MMSG_MAX 64
+#define IO_RAW_CTRL_LEN 128
+#define IO_STREAM_MSGQ_SIZE 4096 /* must be a power of 2 */
 
 typedef struct io_handle_ io_handle_s;
 typedef struct io_thread_ io_thread_s;
@@ -40,18 +44,105 @@ typedef enum {
     IO_MODE_AF_XDP              /* AF_XDP */
 } __attribute__ ((__packed__)) io_mode_t;
 
+typedef enum {
+    IO_TIMESTAMP_USER = 0,      /* user space timestamp per RX batch */
+    IO_TIMESTAMP_SOFTWARE,      /* kernel software timestamp per packet */
+    IO_TIMESTAMP_HARDWARE       /* hardware timestamp per packet */
+} __attribute__ ((__packed__)) io_timestamp_t;
+
 typedef struct io_bucket_ {
     double pps;
     uint64_t nsec;
-    uint64_t base;
 
     struct io_bucket_ *next;
 
     bbl_stream_s *stream_head;
-    bbl_stream_s *stream_cur;
     uint32_t stream_count;
 } io_bucket_s;
 
+/* Stream calendar queue (timing wheel) with 
+ * 2^IO_SCHED_SLOT_BITS nanoseconds per slot 
+ * and ~1 second horizon. Streams scheduled 
+ * beyond the horizon are reinserted when 
+ * their slot is visited. */
+#define IO_SCHED_SLOT_BITS      14
+#define IO_SCHED_WHEEL_BITS     16
+#define IO_SCHED_WHEEL_SIZE     (1 << IO_SCHED_WHEEL_BITS)
+#define IO_SCHED_WHEEL_MASK     (IO_SCHED_WHEEL_SIZE - 1)
+
+typedef struct io_sched_ {
+    bbl_stream_s **wheel; /* streams per slot */
+    bbl_stream_s *list; /* streams of the current slot */
+    uint64_t cursor; /* next slot (absolute) */
+    uint64_t list_end; /* end of current slot (nsec) */
+    atomic_bool reset; /* (re)initialize with next iteration */
+} io_sched_s;
+
+/* Stream packet template resident 
+ * in a TX ring frame. */
+typedef struct io_template_ {
+    bbl_stream_s *stream;
+    uint32_t version;
+} io_template_s;
+
+/* Stream control message send from the main 
+ * thread to the TX thread owning the stream. 
+ * The stream packet is built by the main thread
+ * and swapped in by the TX thread. */
+typedef enum {
+    IO_STREAM_MSG_BUILD = 0,    /* replace stream packet */
+    IO_STREAM_MSG_FREE,         /* free stream packet */
+} __attribute__ ((__packed__)) io_stream_msg_type_t;
+
+typedef struct io_stream_msg_ {
+    bbl_stream_s *stream;
+    bbl_stream_packet_s *packet;
+    io_stream_msg_type_t type;
+} io_stream_msg_s;
+
+/* Single producer and single consumer stream 
+ * message ring from main thread to TX thread. */
+typedef struct io_stream_msgq_ {
+    io_stream_msg_s ring[IO_STREAM_MSGQ_SIZE];
+
+    char _pad0 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
+
+    atomic_uint_least32_t write;
+    uint32_t full;
+
+    char _pad1 __attribute__((__aligned__(CACHE_LINE_SIZE))); /* empty cache line */
+
+    atomic_uint_least32_t read;
+} io_stream_msgq_s;
+
+/* AF_XDP single producer/consumer ring 
+ * shared with the kernel. */
+typedef struct io_xsk_ring_ {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *ring; /* descriptors */
+    uint32_t size;
+    uint32_t mask;
+    uint32_t cached_prod;
+    uint32_t cached_cons;
+    void *map;
+    size_t map_len;
+} io_xsk_ring_s;
+
+/* AF_XDP UMEM, shared between the RX and
+ * TX handle bound to the same queue. */
+typedef struct io_xsk_umem_ {
+    uint8_t *area;
+    uint64_t area_len;
+    uint32_t frame_size;
+    uint32_t rx_frames; /* frames reserved for RX (fill ring) */
+    uint32_t tx_frames; /* frames reserved for TX (completion ring) */
+    int fd; /* socket owning the UMEM */
+    io_xsk_ring_s fill;
+    io_xsk_ring_s comp;
+} io_xsk_umem_s;
+
 typedef struct io_handle_ {
     io_mode_t mode;
     io_direction_t direction;
@@ -60,24 +151,51 @@ typedef struct io_handle_ {
     int fd;
     int fanout_id;
     int fanout_type;
-    struct tpacket_req req;
+    int tpacket_version;
+    union {
+        struct tpacket_req req;
+        struct tpacket_req3 req3; /* TPACKET_V3 */
+    };
     struct sockaddr_ll addr;
 
 #ifdef BNGBLASTER_DPDK
     struct rte_eth_dev_tx_buffer *tx_buffer;
     struct rte_mempool *mbuf_pool;
-    struct rte_mbuf *mbuf;
+    double ts_scale; /* nsec per device clock tick (RX timestamp offload) */
+    struct rte_mbuf **tx_mbuf; /* TX burst vector */
+    bbl_stream_s **tx_stream; /* stream per TX burst mbuf or NULL */
+    uint16_t tx_alloc; /* mbufs allocated */
+    uint16_t tx_queued; /* mbufs filled but not sent */
+    uint16_t tx_max;
     uint16_t queue;
 #endif
 
+    /* AF_XDP */
+    io_xsk_umem_s *umem;
+    io_xsk_ring_s xsk; /* RX or TX descriptor ring */
+    uint64_t *xsk_frames; /* free TX frames */
+    uint32_t xsk_frames_free;
+    int xsk_map_fd; /* XSK map (first RX handle) or -1 */
+    int xdp_prog_fd; /* XDP program (first RX handle) or -1 */
+    int xdp_link_fd; /* XDP program attached until closed or -1 */
+
+    /* RAW batched IO (recvmmsg/sendmmsg) */
+    struct mmsghdr *mmsg;
+    struct iovec *iov;
+    bbl_stream_s **mmsg_stream; /* stream per TX message or NULL */
+    uint8_t *mmsg_buf; /* IO_BUFFER_LEN per message */
+    uint8_t *mmsg_ctrl; /* IO_RAW_CTRL_LEN per RX message (timestamps) */
+    uint16_t mmsg_max;
+
     uint8_t *ring; /* ring buffer */
+    io_template_s *tx_template; /* stream template per TX ring frame */
     unsigned int cursor; /* ring buffer cursor */
     unsigned int queued;
 
     io_thread_s *thread;
 
     io_bucket_s *bucket_head;
-    io_bucket_s *bucket_cur;
+    io_sched_s sched;
 
     bbl_interface_s *interface;
     bbl_ethernet_header_s *eth;
@@ -91,6 +209,8 @@ typedef struct io_handle_ {
     double stream_pps;
     
     struct timespec timestamp; /* user space timestamps */
+    io_timestamp_t rx_timestamp; /* RX timestamp source */
+    int64_t timestamp_offset; /* CLOCK_MONOTONIC - CLOCK_REALTIME in nsec */
 
     struct {
         uint64_t packets;
@@ -126,6 +246,9 @@ typedef struct io_thread_ {
 
     io_handle_s *io;
     bbl_txq_s *txq;
+    io_stream_msgq_s *stream_msgq; /* main thread to TX thread */
+    bbl_stream_stats_s *stream_stats; /* stream stats of this thread */
+    time_t stream_epoch; /* last stream stats epoch (seconds) */
 
     struct io_thread_ *next;
 } io_thread_s;
@@ -34,6 +34,7 @@
 #include <rte_version.h>
 #include <rte_ethdev.h>
 #include <rte_malloc.h>
+#include <rte_mbuf_dyn.h>
 
 #define NUM_MBUFS 8192
 #define MBUF_CACHE_SIZE 256
@@ -43,6 +44,10 @@
 extern bool g_init_phase;
 extern bool g_traffic;
 
+/* RX timestamp offload dynamic mbuf field and flag. */
+static int io_dpdk_ts_offset = -1;
+static uint64_t io_dpdk_ts_flag = 0;
+
 static struct rte_eth_conf port_conf = {
     .rxmode = {
         .mq_mode = 0,
@@ -162,6 +167,63 @@ io_dpdk_init()
     return true;
 }
 
+/**
+ * Calibrate device clock used for RX timestamp 
+ * offload against CLOCK_MONOTONIC.
+ *
+ * @param port_id port identifier
+ * @return nsec per device clock tick or 0 if not supported
+ */
+static double
+io_dpdk_clock_scale(uint16_t port_id)
+{
+    struct timespec t0, t1, sleep;
+    uint64_t c0, c1;
+
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 100 * MSEC;
+
+    if(rte_eth_read_clock(port_id, &c0) != 0) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    nanosleep(&sleep, NULL);
+    if(rte_eth_read_clock(port_id, &c1) != 0) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if(c1 <= c0) {
+        return 0;
+    }
+    return (double)(timespec_to_nsec(&t1) - timespec_to_nsec(&t0)) / (c1 - c0);
+}
+
+/**
+ * Set IO timestamp from RX timestamp offload by 
+ * subtracting the packet age in device clock ticks
+ * from the RX batch timestamp. Packets without
+ * RX timestamp get the RX batch timestamp.
+ *
+ * @param io IO handle
+ * @param packet received mbuf
+ * @param clock device clock at RX batch
+ * @param now RX batch timestamp in nsec (CLOCK_MONOTONIC)
+ */
+static inline void
+io_dpdk_rx_timestamp(io_handle_s *io, struct rte_mbuf *packet, uint64_t clock, uint64_t now)
+{
+    rte_mbuf_timestamp_t ts;
+
+    if(packet->ol_flags & io_dpdk_ts_flag) {
+        ts = *RTE_MBUF_DYNFIELD(packet, io_dpdk_ts_offset, rte_mbuf_timestamp_t *);
+        if(ts < clock) {
+            now -= (clock - ts) * io->ts_scale;
+        }
+    }
+    io->timestamp.tv_sec = now / SEC;
+    io->timestamp.tv_nsec = now % SEC;
+}
+
 /**
  * This job is for DPDK RX in main thread!
  */
@@ -177,6 +239,8 @@ io_dpdk_rx_job(timer_s *timer)
     struct rte_mbuf *packet;
     uint16_t nb_rx;
     uint16_t i;
+    uint64_t clock = 0;
+    uint64_t now = 0;
 
     protocol_error_t decode_result;
     bool pcap = false;
@@ -194,9 +258,16 @@ io_dpdk_rx_job(timer_s *timer)
         if(nb_rx == 0) {
             break;
         }
+        if(io->ts_scale) {
+            rte_eth_read_clock(interface->port_id, &clock);
+            now = timespec_to_nsec(timer->timestamp);
+        }
         for(i = 0; i < nb_rx; i++) {
             packet = packet_burst[i];
             rte_prefetch0(rte_pktmbuf_mtod(packet, void *));
+            if(io->ts_scale) {
+                io_dpdk_rx_timestamp(io, packet, clock, now);
+            }
             io->buf = rte_pktmbuf_mtod(packet, uint8_t *);
             io->buf_len = packet->pkt_len;
             io->stats.packets++;
@@ -234,28 +305,128 @@ io_dpdk_rx_job(timer_s *timer)
     }
 }
 
+/**
+ * Send all queued mbufs with as few rte_eth_tx_burst
+ * calls as possible, retrying the unsent tail until 
+ * the TX queue is full. Mbufs not sent are kept at the 
+ * begin of the burst vector to be retried with the 
+ * next call. 
+ *
+ * @param io IO handle
+ * @param pcap dump packets into pcap file (main thread only)
+ * @return true if all mbufs are sent
+ */
 static bool
-io_dpdk_mbuf_alloc(io_handle_s *io)
+io_dpdk_tx_flush(io_handle_s *io, bool pcap)
 {
-    struct rte_mbuf *mbuf = rte_pktmbuf_alloc(io->mbuf_pool);
-    if(!mbuf) {
-        io->stats.no_buffer++;
-        return false;
+    bbl_interface_s *interface = io->interface;
+    bbl_stream_s *stream;
+    struct rte_mbuf *mbuf;
+    bool pcap_flush = false;
+
+    uint16_t index = 0;
+    uint16_t sent;
+    uint16_t i;
+
+    while(index < io->tx_queued) {
+        sent = rte_eth_tx_burst(interface->port_id, io->queue, 
+                                io->tx_mbuf + index, io->tx_queued - index);
+        if(sent == 0) {
+            io->stats.io_errors++;
+            break;
+        }
+        for(i = index; i < index + sent; i++) {
+            mbuf = io->tx_mbuf[i];
+            stream = io->tx_stream[i];
+            if(stream) {
+                stream->tx_packets++;
+            }
+            /* Dump the packet into pcap file. */
+            if(unlikely(pcap && g_ctx->pcap.write_buf && (!stream || g_ctx->pcap.include_streams))) {
+                pcap_flush = true;
+                pcapng_push_packet_header(&io->timestamp, rte_pktmbuf_mtod(mbuf, uint8_t *), mbuf->data_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
+            }
+            io->stats.packets++;
+            io->stats.bytes += mbuf->data_len;
+        }
+        index += sent;
+    }
+    if(unlikely(pcap_flush)) {
+        pcapng_fflush();
+    }
+    if(index) {
+        /* Move unsent and allocated but unused 
+         * mbufs to the begin of the vector. */
+        memmove(io->tx_mbuf, io->tx_mbuf + index, (io->tx_alloc - index) * sizeof(struct rte_mbuf *));
+        memmove(io->tx_stream, io->tx_stream + index, (io->tx_queued - index) * sizeof(bbl_stream_s *));
+        io->tx_alloc -= index;
+        io->tx_queued -= index;
+    }
+    return io->tx_queued == 0;
+}
+
+/**
+ * Ensure that the next mbuf of the burst vector is 
+ * allocated, flushing the vector if full. Mbufs are 
+ * allocated in bulk to fill the whole vector. 
+ *
+ * @param io IO handle
+ * @param pcap dump packets into pcap file (main thread only)
+ * @return true if next mbuf is available
+ */
+static bool
+io_dpdk_tx_alloc(io_handle_s *io, bool pcap)
+{
+    uint16_t count;
+
+    if(io->tx_queued == io->tx_max) {
+        if(!io_dpdk_tx_flush(io, pcap)) {
+            return false;
+        }
     }
-    if(rte_pktmbuf_append(mbuf, 2048) == NULL) {
-        rte_pktmbuf_free(mbuf);
+    if(likely(io->tx_alloc > io->tx_queued)) {
+        return true;
+    }
+    count = io->tx_max - io->tx_alloc;
+    if(rte_pktmbuf_alloc_bulk(io->mbuf_pool, io->tx_mbuf + io->tx_alloc, count) != 0) {
         io->stats.no_buffer++;
         return false;
     }
-    mbuf->data_len = 0;
-    mbuf->next = NULL;
-    
-    io->mbuf = mbuf;
-    io->buf = rte_pktmbuf_mtod(mbuf, uint8_t *);
-    io->buf_len = 0;
+    io->tx_alloc += count;
     return true;
 }
 
+static inline uint8_t *
+io_dpdk_tx_buf(io_handle_s *io)
+{
+    return rte_pktmbuf_mtod(io->tx_mbuf[io->tx_queued], uint8_t *);
+}
+
+/**
+ * Add packet to the burst vector.
+ *
+ * Stream packets are copied into the mbuf and the flow
+ * sequence is incremented here, as mbufs not sent are 
+ * retried and never dropped. 
+ *
+ * @param io IO handle
+ * @param len packet length
+ * @param stream stream or NULL for control traffic
+ */
+static inline void
+io_dpdk_tx_queue(io_handle_s *io, uint16_t len, bbl_stream_s *stream)
+{
+    struct rte_mbuf *mbuf = io->tx_mbuf[io->tx_queued];
+    if(stream) {
+        memcpy(rte_pktmbuf_mtod(mbuf, uint8_t *), stream->tx_buf, len);
+        stream->flow_seq++;
+    }
+    mbuf->data_len = len;
+    mbuf->pkt_len = len;
+    io->tx_stream[io->tx_queued++] = stream;
+}
+
 /*
  * This job is for DPDK TX in main thread!
  */
@@ -267,8 +438,8 @@ io_dpdk_tx_job(timer_s *timer)
 
     bbl_stream_s *stream = NULL;
     uint16_t burst = interface->config->io_burst;
+    uint16_t len;
     uint64_t now;
-    bool pcap = false;
 
     assert(io->mode == IO_MODE_DPDK);
     assert(io->direction == IO_EGRESS);
@@ -279,80 +450,42 @@ io_dpdk_tx_job(timer_s *timer)
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
 
+    /* Mbufs not sent in the last interval are
+     * still queued and count against the burst. */
+    burst = burst > io->tx_queued ? burst - io->tx_queued : 0;
+
+    /* First send all control traffic which has higher priority. */
     while(burst) {
-        if(!io->mbuf) {
-            if(!io_dpdk_mbuf_alloc(io)) {
-                break;
-            }
+        if(!io_dpdk_tx_alloc(io, true)) {
+            return;
         }
-        if(likely(io->buf_len == 0)) {
-            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                io->buf_len = 0;
-                break;
-            }        
-        }
-        /* Transmit the packet. */
-        io->mbuf->data_len = io->buf_len;
-        if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-            /* Dump the packet into pcap file. */
-            if(unlikely(g_ctx->pcap.write_buf != NULL)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-            }
-            io->stats.packets++;
-            io->stats.bytes += io->buf_len;
-            io->mbuf = NULL;
-            io->buf_len = 0;
-            burst--;
-        } else {
-            /* This packet will be retried next interval 
-             * because io->buf_len is not reset to zero. */
-            io->stats.io_errors++;
-            burst = 0;
+        len = 0;
+        if(bbl_tx(interface, io_dpdk_tx_buf(io), &len) != PROTOCOL_SUCCESS) {
+            break;
         }
+        io_dpdk_tx_queue(io, len, NULL);
+        burst--;
     }
+
     if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
         now = timespec_to_nsec(timer->timestamp);
         while(burst) {
-            /* Send traffic streams up to allowed burst. */
-            if(!io->mbuf) {
-                if(!io_dpdk_mbuf_alloc(io)) {
-                    break;
-                }
+            if(!io_dpdk_tx_alloc(io, true)) {
+                return;
             }
+            /* Send traffic streams up to allowed burst. */
             stream = bbl_stream_io_send_iter(io, now);
             if(unlikely(stream == NULL)) {
                 break;
             }
-            /* Transmit the packet. */
-            io->mbuf->data_len = io->buf_len;
-            if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-                /* Dump the packet into pcap file. */
-                if(unlikely(g_ctx->pcap.write_buf && g_ctx->pcap.include_streams)) {
-                    pcap = true;
-                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                            interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-                }
-                stream->tx_packets++;
-                stream->flow_seq++;
-                io->stats.packets++;
-                io->stats.bytes += io->buf_len;
-                io->mbuf = NULL;
-                io->buf_len = 0;
-                burst--;
-            } else {
-                /* This packet will be retried next interval 
-                * because io->buf_len is not reset to zero. */
-                io->stats.io_errors++;
-                burst = 0;
-            }
+            io_dpdk_tx_queue(io, stream->tx_len, stream);
+            burst--;
         }
     } else {
         bbl_stream_io_stop(io);
     }
-    if(pcap) {
-        pcapng_fflush();
+    if(io->tx_queued) {
+        io_dpdk_tx_flush(io, true);
     }
 }
 
@@ -368,6 +501,8 @@ io_dpdk_thread_rx_run_fn(io_thread_s *thread)
     uint16_t port_id = interface->port_id;
     uint16_t nb_rx;
     uint16_t i;
+    uint64_t clock = 0;
+    uint64_t now = 0;
 
     assert(io->mode == IO_MODE_DPDK);
     assert(io->direction == IO_INGRESS);
@@ -385,15 +520,23 @@ io_dpdk_thread_rx_run_fn(io_thread_s *thread)
         }
         /* Get RX timestamp */
         clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->ts_scale) {
+            rte_eth_read_clock(port_id, &clock);
+            now = timespec_to_nsec(&io->timestamp);
+        }
         for(i = 0; i < nb_rx; i++) {
             packet = pkts_burst[i];
             rte_prefetch0(rte_pktmbuf_mtod(packet, void *));
+            if(io->ts_scale) {
+                io_dpdk_rx_timestamp(io, packet, clock, now);
+            }
             io->buf = rte_pktmbuf_mtod(packet, uint8_t *);
             io->buf_len = packet->pkt_len;
             /* Process packet */
             io_thread_rx_handler(thread, io);
             rte_pktmbuf_free(packet);
         }
+        bbl_txq_write_commit(thread->txq);
     }
 }
 
@@ -421,71 +564,49 @@ io_dpdk_thread_tx_run_fn(io_thread_s *thread)
 
     while(thread->active) {
         nanosleep(&sleep, &rem);
-        burst = io_burst;
+        io_thread_stream_msg_process(thread);
+        io_thread_stream_epoch(thread);
+        burst = io_burst > io->tx_queued ? io_burst - io->tx_queued : 0;
 
-        /* First send all control traffic which has higher priority. */
+        /* First send all control traffic which has higher priority. 
+         * The TXQ slots are copied to release them immediately. */
         while((slot = bbl_txq_read_slot(txq))) {
-            /* This packet will be retried next interval 
-             * because slot is not marked as read. */
-            if(!io->mbuf) {
-                if(!io_dpdk_mbuf_alloc(io)) {
-                    break;
-                }
-            }
-            /* Transmit the packet. */
-            io->mbuf->data_len = slot->packet_len;
-            memcpy(io->buf, slot->packet, slot->packet_len);
-            if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-                io->stats.packets++;
-                io->stats.bytes += slot->packet_len;
-                io->mbuf = NULL;
-                bbl_txq_read_next(txq);
-                if(burst) burst--;
-            } else {
-                io->stats.io_errors++;
+            if(!io_dpdk_tx_alloc(io, false)) {
                 burst = 0;
                 break;
             }
+            memcpy(io_dpdk_tx_buf(io), slot->packet, slot->packet_len);
+            io_dpdk_tx_queue(io, slot->packet_len, NULL);
+            bbl_txq_read_next(txq);
+            if(burst) burst--;
         }
+        bbl_txq_read_commit(txq);
 
         /* Get TX timestamp */
         clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
-
         if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
             now = timespec_to_nsec(&io->timestamp);
             while(burst) {
-                /* Send traffic streams up to allowed burst. */
-                if(!io->mbuf) {
-                    if(!io_dpdk_mbuf_alloc(io)) {
-                        break;
-                    }
+                if(!io_dpdk_tx_alloc(io, false)) {
+                    break;
                 }
+                /* Send traffic streams up to allowed burst. */
                 stream = bbl_stream_io_send_iter(io, now);
                 if(unlikely(stream == NULL)) {
                     break;
                 }
-                /* Transmit the packet. */
-                io->mbuf->data_len = stream->tx_len;
-                memcpy(io->buf, stream->tx_buf, stream->tx_len);
-                if(rte_eth_tx_burst(interface->port_id, io->queue, &io->mbuf, 1) != 0) {
-                    stream->tx_packets++;
-                    stream->flow_seq++;
-                    io->stats.packets++;
-                    io->stats.bytes += stream->tx_len;
-                    io->mbuf = NULL;
-                    burst--;
-                } else {
-                    io->stats.io_errors++;
-                    burst = 0;
-                }
+                io_dpdk_tx_queue(io, stream->tx_len, stream);
+                burst--;
             }
         } else {
             bbl_stream_io_stop(io);
         }
+        if(io->tx_queued) {
+            io_dpdk_tx_flush(io, false);
+        }
     }
 }
 
-
 bool
 io_dpdk_add_mbuf_pool(io_handle_s *io)
 {
@@ -517,6 +638,8 @@ io_dpdk_interface_init(bbl_interface_s *interface)
 
     int ret;
     bool found = false;
+    bool timestamp = false;
+    double ts_scale;
 
     uint16_t port_id;
     uint16_t queue;
@@ -568,6 +691,22 @@ io_dpdk_interface_init(bbl_interface_s *interface)
     if(dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) {
         local_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE;
     }
+    if(config->rx_timestamp != IO_TIMESTAMP_USER) {
+        if(dev_info.rx_offload_capa & RTE_ETH_RX_OFFLOAD_TIMESTAMP) {
+            if(io_dpdk_ts_offset < 0) {
+                if(rte_mbuf_dyn_rx_timestamp_register(&io_dpdk_ts_offset, &io_dpdk_ts_flag) < 0) {
+                    LOG(ERROR, "DPDK: interface %s (%u) failed to register RX timestamp field\n",
+                        interface->name, port_id);
+                    return false;
+                }
+            }
+            local_port_conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_TIMESTAMP;
+            timestamp = true;
+        } else {
+            LOG(DPDK, "DPDK: interface %s (%u) RX timestamp offload not supported\n", 
+                interface->name, port_id);
+        }
+    }
 
     local_port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
     local_port_conf.rx_adv_conf.rss_conf.rss_hf =
@@ -643,7 +782,12 @@ io_dpdk_interface_init(bbl_interface_s *interface)
         io->next = interface->io.tx;
         interface->io.tx = io;
         io->interface = interface;
-        io->buf = malloc(IO_BUFFER_LEN);
+        io->tx_max = config->io_burst ? config->io_burst : 1;
+        io->tx_mbuf = calloc(io->tx_max, sizeof(struct rte_mbuf *));
+        io->tx_stream = calloc(io->tx_max, sizeof(bbl_stream_s *));
+        if(!(io->tx_mbuf && io->tx_stream)) {
+            return false;
+        }
         if(config->tx_threads) {
             if(!io_thread_init(io)) {
                 return false;
@@ -711,8 +855,57 @@ io_dpdk_interface_init(bbl_interface_s *interface)
         return false;
     }
 
+    if(timestamp) {
+        ts_scale = io_dpdk_clock_scale(port_id);
+        if(ts_scale > 0) {
+            LOG(DPDK, "DPDK: interface %s (%u) RX timestamp offload enabled (%.3f ns per tick)\n", 
+                interface->name, port_id, ts_scale);
+            io = interface->io.rx;
+            while(io) {
+                io->rx_timestamp = IO_TIMESTAMP_HARDWARE;
+                io->ts_scale = ts_scale;
+                io = io->next;
+            }
+        } else {
+            LOG(DPDK, "DPDK: interface %s (%u) failed to read device clock for RX timestamps\n", 
+                interface->name, port_id);
+        }
+    }
+
     io_dpdk_link_status(port_id);
     return true;
 }
 
-#endif
\ No newline at end of file
+#endif
+
+/**
+ * io_dpdk_close
+ *
+ * Free all mbufs allocated but not sent
+ * and the TX memory of the handle.
+ *
+ * @param io IO handle
+ */
+void
+io_dpdk_close(io_handle_s *io)
+{
+    uint16_t i;
+
+    if(io->tx_mbuf) {
+        for(i = 0; i < io->tx_alloc; i++) {
+            rte_pktmbuf_free(io->tx_mbuf[i]);
+        }
+        io->tx_alloc = 0;
+        io->tx_queued = 0;
+        free(io->tx_mbuf);
+        io->tx_mbuf = NULL;
+    }
+    if(io->tx_stream) {
+        free(io->tx_stream);
+        io->tx_stream = NULL;
+    }
+    if(io->tx_buffer) {
+        rte_free(io->tx_buffer);
+        io->tx_buffer = NULL;
+    }
+}
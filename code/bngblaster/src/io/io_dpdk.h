@@ -15,4 +15,7 @@ io_dpdk_init();
 bool
 io_dpdk_interface_init(bbl_interface_s *interface);
 
+void
+io_dpdk_close(io_handle_s *io);
+
 #endif
\ No newline at end of file
@@ -86,6 +86,7 @@ io_interface_init_rx(bbl_interface_s *interface)
             io->mode = IO_MODE_PACKET_MMAP;
         }
         io->direction = IO_INGRESS;
+        io->rx_timestamp = config->rx_timestamp;
         io->next = interface->io.rx;
         interface->io.rx = io;
         io->interface = interface;
@@ -105,6 +106,11 @@ io_interface_init_rx(bbl_interface_s *interface)
                     return false;
                 }
                 break;
+            case IO_MODE_AF_XDP:
+                if(!io_af_xdp_init(io)) {
+                    return false;
+                }
+                break;
             default:
                 return false;
         }
@@ -135,6 +141,9 @@ io_interface_init_tx(bbl_interface_s *interface)
         io->next = interface->io.tx;
         interface->io.tx = io;
         io->interface = interface;
+        if(!io_stream_sched_alloc(io)) {
+            return false;
+        }
         if(config->tx_threads) {
             if(!io_thread_init(io)) {
                 return false;
@@ -151,6 +160,11 @@ io_interface_init_tx(bbl_interface_s *interface)
                     return false;
                 }
                 break;
+            case IO_MODE_AF_XDP:
+                if(!io_af_xdp_init(io)) {
+                    return false;
+                }
+                break;
             default:
                 return false;
         }
@@ -233,4 +247,40 @@ io_interface_init(bbl_interface_s *interface)
         }
     }
     return true;
-}
\ No newline at end of file
+}
+
+static void
+io_interface_close_handles(io_handle_s *io)
+{
+    while(io) {
+        switch(io->mode) {
+            case IO_MODE_AF_XDP:
+                io_af_xdp_close(io);
+                break;
+#ifdef BNGBLASTER_DPDK
+            case IO_MODE_DPDK:
+                io_dpdk_close(io);
+                break;
+#endif
+            default:
+                break;
+        }
+        io_stream_sched_free(io);
+        io = io->next;
+    }
+}
+
+/**
+ * io_interface_close
+ *
+ * Release the IO resources of the interface,
+ * which requires all IO threads to be stopped.
+ *
+ * @param interface interface.
+ */
+void
+io_interface_close(bbl_interface_s *interface)
+{
+    io_interface_close_handles(interface->io.rx);
+    io_interface_close_handles(interface->io.tx);
+}
@@ -12,4 +12,7 @@
 bool
 io_interface_init(bbl_interface_s *interface);
 
+void
+io_interface_close(bbl_interface_s *interface);
+
 #endif
\ No newline at end of file
@@ -34,6 +34,65 @@ poll_kernel(io_handle_s *io, short events)
     }
 }
 
+/**
+ * Process packet in IO buffer received in main thread.
+ *
+ * @param io IO handle
+ * @param vlan_tci VLAN TCI stripped from header
+ * @param vlan_tpid VLAN TPID stripped from header
+ * @return true if packet was added to pcap buffer
+ */
+static bool
+rx_packet(io_handle_s *io, uint16_t vlan_tci, uint16_t vlan_tpid)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_ethernet_header_s *eth;
+    uint16_t vlan;
+
+    protocol_error_t decode_result;
+    bool pcap = false;
+
+    io->stats.packets++;
+    io->stats.bytes += io->buf_len;
+    decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+    if(decode_result == PROTOCOL_SUCCESS) {
+        vlan = vlan_tci & BBL_ETH_VLAN_ID_MAX;
+        if(vlan && eth->vlan_outer != vlan) {
+            /* The outer VLAN is stripped from header */
+            eth->vlan_inner = eth->vlan_outer;
+            eth->vlan_inner_priority = eth->vlan_outer_priority;
+            eth->vlan_outer = vlan;
+            eth->vlan_outer_priority = vlan_tci >> 13;
+            if(vlan_tpid == ETH_TYPE_QINQ) {
+                eth->qinq = true;
+            }
+        }
+        /* Copy RX timestamp */
+        eth->timestamp.tv_sec = io->timestamp.tv_sec;
+        eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+        /* Dump the packet into pcap file */
+        if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+        }
+        bbl_rx_handler(interface, eth);
+    } else {
+        /* Dump the packet into pcap file */
+        if(g_ctx->pcap.write_buf) {
+            pcap = true;
+            pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                      interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+        }
+        if(decode_result == UNKNOWN_PROTOCOL) {
+            io->stats.unknown++;
+        } else {
+            io->stats.protocol_errors++;
+        }
+    }
+    return pcap;
+}
+
 /**
  * This job is for PACKET_MMAP RX in main thread!
  */
@@ -41,15 +100,10 @@ void
 io_packet_mmap_rx_job(timer_s *timer)
 {
     io_handle_s *io = timer->data;
-    bbl_interface_s *interface = io->interface;
 
     uint8_t *frame_ptr;
     struct tpacket2_hdr *tphdr;
 
-    bbl_ethernet_header_s *eth;
-    uint16_t vlan;
-
-    protocol_error_t decode_result;
     bool pcap = false;
 
     assert(io->mode == IO_MODE_PACKET_MMAP);
@@ -68,48 +122,17 @@ io_packet_mmap_rx_job(timer_s *timer)
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->rx_timestamp) {
+        io_socket_timestamp_offset(io);
+    }
     while(tphdr->tp_status & TP_STATUS_USER) {
         io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
         io->buf_len = tphdr->tp_len;
-        io->stats.packets++;
-        io->stats.bytes += io->buf_len;
-        decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
-        if(decode_result == PROTOCOL_SUCCESS) {
-            vlan = tphdr->tp_vlan_tci & BBL_ETH_VLAN_ID_MAX;
-            if(vlan && eth->vlan_outer != vlan) {
-                /* The outer VLAN is stripped from header */
-                eth->vlan_inner = eth->vlan_outer;
-                eth->vlan_inner_priority = eth->vlan_outer_priority;
-                eth->vlan_outer = vlan;
-                eth->vlan_outer_priority = tphdr->tp_vlan_tci >> 13;
-                if(tphdr->tp_vlan_tpid == ETH_TYPE_QINQ) {
-                    eth->qinq = true;
-                }
-            }
-            /* Copy RX timestamp */
-            //eth->timestamp.tv_sec = tphdr->tp_sec; /* ktime/hw timestamp */
-            //eth->timestamp.tv_nsec = tphdr->tp_nsec; /* ktime/hw timestamp */
-            eth->timestamp.tv_sec = io->timestamp.tv_sec;
-            eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
-            /* Dump the packet into pcap file */
-            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
-            }
-            bbl_rx_handler(interface, eth);
-        } else {
-            /* Dump the packet into pcap file */
-            if(g_ctx->pcap.write_buf) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
-            }
-            if(decode_result == UNKNOWN_PROTOCOL) {
-                io->stats.unknown++;
-            } else {
-                io->stats.protocol_errors++;
-            }
+        if(io->rx_timestamp) {
+            io_socket_timestamp(io, tphdr->tp_sec, tphdr->tp_nsec);
+        }
+        if(rx_packet(io, tphdr->tp_vlan_tci, tphdr->tp_vlan_tpid)) {
+            pcap = true;
         }
         /* Return ownership back to kernel */
         tphdr->tp_status = TP_STATUS_KERNEL; 
@@ -123,6 +146,66 @@ io_packet_mmap_rx_job(timer_s *timer)
     }
 }
 
+/**
+ * This job is for PACKET_MMAP TPACKET_V3 RX in main thread!
+ *
+ * The kernel hands over full blocks containing multiple 
+ * packets, meaning that only the block status must be 
+ * checked instead of the status of each frame.
+ */
+void
+io_packet_mmap_rx_v3_job(timer_s *timer)
+{
+    io_handle_s *io = timer->data;
+
+    struct tpacket_block_desc *block;
+    struct tpacket3_hdr *tphdr;
+    uint32_t packets;
+
+    bool pcap = false;
+
+    assert(io->mode == IO_MODE_PACKET_MMAP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->tpacket_version == TPACKET_V3);
+    assert(io->thread == NULL);
+
+    block = (struct tpacket_block_desc*)(io->ring + (io->cursor * io->req3.tp_block_size));
+    if(!(block->hdr.bh1.block_status & TP_STATUS_USER)) {
+        /* If no block is available poll kernel */
+        poll_kernel(io, POLLIN);
+        return;
+    }
+
+    /* Get RX timestamp, the kernel sets a timestamp for each 
+     * packet in the block, which is used even if per packet 
+     * RX timestamps are not enabled because the block may be 
+     * retired up to tp_retire_blk_tov after the first packet. */
+    io->timestamp.tv_sec = timer->timestamp->tv_sec;
+    io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    io_socket_timestamp_offset(io);
+    while(block->hdr.bh1.block_status & TP_STATUS_USER) {
+        packets = block->hdr.bh1.num_pkts;
+        tphdr = (struct tpacket3_hdr*)((uint8_t*)block + block->hdr.bh1.offset_to_first_pkt);
+        while(packets--) {
+            io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
+            io->buf_len = tphdr->tp_snaplen;
+            io_socket_timestamp(io, tphdr->tp_sec, tphdr->tp_nsec);
+            if(rx_packet(io, tphdr->hv1.tp_vlan_tci, tphdr->hv1.tp_vlan_tpid)) {
+                pcap = true;
+            }
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)tphdr + tphdr->tp_next_offset);
+        }
+        /* Return ownership back to kernel */
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        /* Get next block */
+        io->cursor = (io->cursor + 1) % io->req3.tp_block_nr;
+        block = (struct tpacket_block_desc*)(io->ring + (io->cursor * io->req3.tp_block_size));
+    }
+    if(pcap) {
+        pcapng_fflush();
+    }
+}
+
 /**
  * This job is for PACKET_MMAP TX in main thread!
  */
@@ -168,6 +251,9 @@ io_packet_mmap_tx_job(timer_s *timer)
 
             if(unlikely(ctrl)) {
                 /* First send all control traffic which has higher priority. */
+                if(io->tx_template) {
+                    io->tx_template[io->cursor].stream = NULL;
+                }
                 if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
                     ctrl = false;
                     continue;
@@ -181,7 +267,11 @@ io_packet_mmap_tx_job(timer_s *timer)
                 if(unlikely(stream == NULL)) {
                     break;
                 }
-                memcpy(io->buf, stream->tx_buf, stream->tx_len);
+                if(io->tx_template) {
+                    bbl_stream_tx_template(stream, io->buf, &io->tx_template[io->cursor]);
+                } else {
+                    memcpy(io->buf, stream->tx_buf, stream->tx_len);
+                }
                 io->buf_len = stream->tx_len;
                 stream->tx_packets++;
                 stream->flow_seq++;
@@ -257,9 +347,15 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
 
         /* Get RX timestamp */
         clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->rx_timestamp) {
+            io_socket_timestamp_offset(io);
+        }
         while(tphdr->tp_status & TP_STATUS_USER) {
             io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
             io->buf_len = tphdr->tp_len;
+            if(io->rx_timestamp) {
+                io_socket_timestamp(io, tphdr->tp_sec, tphdr->tp_nsec);
+            }
             io->vlan_tci = tphdr->tp_vlan_tci;
             io->vlan_tpid = tphdr->tp_vlan_tpid;
             /* Process packet */
@@ -273,6 +369,70 @@ io_packet_mmap_thread_rx_run_fn(io_thread_s *thread)
             frame_ptr = ring + (cursor * frame_size);
             tphdr = (struct tpacket2_hdr*)frame_ptr;
         }
+        bbl_txq_write_commit(thread->txq);
+        nanosleep(&sleep, &rem);
+    }
+}
+
+void
+io_packet_mmap_thread_rx_v3_run_fn(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+
+    uint32_t cursor = io->cursor;
+    uint32_t block_size = io->req3.tp_block_size;
+    uint32_t block_nr = io->req3.tp_block_nr;
+    uint32_t packets;
+    uint8_t *ring = io->ring;
+
+    struct tpacket_block_desc *block;
+    struct tpacket3_hdr *tphdr;
+
+    assert(io->mode == IO_MODE_PACKET_MMAP);
+    assert(io->direction == IO_INGRESS);
+    assert(io->tpacket_version == TPACKET_V3);
+    assert(io->thread);
+
+    struct timespec sleep, rem;
+
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10000; /* 0.01ms */
+
+    while(thread->active) {
+        block = (struct tpacket_block_desc*)(ring + (cursor * block_size));
+        if(!(block->hdr.bh1.block_status & TP_STATUS_USER)) {
+            nanosleep(&sleep, &rem);
+            continue;
+        }
+
+        /* Get RX timestamp, the per packet timestamps 
+         * are always used (see io_packet_mmap_rx_v3_job). */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        io_socket_timestamp_offset(io);
+        while(block->hdr.bh1.block_status & TP_STATUS_USER) {
+            packets = block->hdr.bh1.num_pkts;
+            tphdr = (struct tpacket3_hdr*)((uint8_t*)block + block->hdr.bh1.offset_to_first_pkt);
+            while(packets--) {
+                io->buf = (uint8_t*)tphdr + tphdr->tp_mac;
+                io->buf_len = tphdr->tp_snaplen;
+                io_socket_timestamp(io, tphdr->tp_sec, tphdr->tp_nsec);
+                io->vlan_tci = tphdr->hv1.tp_vlan_tci;
+                io->vlan_tpid = tphdr->hv1.tp_vlan_tpid;
+                /* Process packet, the block is owned by this 
+                 * thread until all packets are processed. */
+                while(io_thread_rx_handler(thread, io) == IO_FULL) {
+                    if(!thread->active) return;
+                    nanosleep(&sleep, &rem);
+                }
+                tphdr = (struct tpacket3_hdr*)((uint8_t*)tphdr + tphdr->tp_next_offset);
+            }
+            /* Return ownership back to kernel */
+            block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+            /* Get next block */
+            cursor = (cursor + 1) % block_nr;
+            block = (struct tpacket_block_desc*)(ring + (cursor * block_size));
+        }
+        bbl_txq_write_commit(thread->txq);
         nanosleep(&sleep, &rem);
     }
 }
@@ -306,6 +466,8 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
 
     while(thread->active) {
         nanosleep(&sleep, &rem);
+        io_thread_stream_msg_process(thread);
+        io_thread_stream_epoch(thread);
 
         frame_ptr = io->ring + (io->cursor * io->req.tp_frame_size);
         tphdr = (struct tpacket2_hdr *)frame_ptr;
@@ -337,6 +499,9 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
                     io->buf_len = slot->packet_len;
                     memcpy(io->buf, slot->packet, slot->packet_len);
                     bbl_txq_read_next(txq);
+                    if(io->tx_template) {
+                        io->tx_template[io->cursor].stream = NULL;
+                    }
                 } else {
                     ctrl = false;
                     continue;
@@ -351,7 +516,11 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
                 if(unlikely(stream == NULL)) {
                     break;
                 }
-                memcpy(io->buf, stream->tx_buf, stream->tx_len);
+                if(io->tx_template) {
+                    bbl_stream_tx_template(stream, io->buf, &io->tx_template[io->cursor]);
+                } else {
+                    memcpy(io->buf, stream->tx_buf, stream->tx_len);
+                }
                 io->buf_len = stream->tx_len;
                 stream->tx_packets++;
                 stream->flow_seq++;
@@ -370,6 +539,7 @@ io_packet_mmap_thread_tx_run_fn(io_thread_s *thread)
             frame_ptr = io->ring + (io->cursor * io->req.tp_frame_size);
             tphdr = (struct tpacket2_hdr *)frame_ptr;
         }
+        bbl_txq_read_commit(txq);
 
         if(io->queued) {
             /* Notify kernel. */
@@ -396,16 +566,33 @@ io_packet_mmap_init(io_handle_s *io)
         return false;
     }
 
+    if(io->direction == IO_EGRESS && g_ctx->config.stream_tx_template) {
+        /* Stream templates resident in TX ring frames. */
+        io->tx_template = calloc(io->req.tp_frame_nr, sizeof(io_template_s));
+        if(!io->tx_template) {
+            return false;
+        }
+    }
+
     if(thread) {
         if(io->direction == IO_INGRESS) {
-            thread->run_fn = io_packet_mmap_thread_rx_run_fn;
+            if(io->tpacket_version == TPACKET_V3) {
+                thread->run_fn = io_packet_mmap_thread_rx_v3_run_fn;
+            } else {
+                thread->run_fn = io_packet_mmap_thread_rx_run_fn;
+            }
         } else {
             thread->run_fn = io_packet_mmap_thread_tx_run_fn;
         }
     } else {
         if(io->direction == IO_INGRESS) {
-            timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
-                config->rx_interval, io, &io_packet_mmap_rx_job);
+            if(io->tpacket_version == TPACKET_V3) {
+                timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
+                    config->rx_interval, io, &io_packet_mmap_rx_v3_job);
+            } else {
+                timer_add_periodic(&g_ctx->timer_root, &interface->io.rx_job, "RX", 0, 
+                    config->rx_interval, io, &io_packet_mmap_rx_job);
+            }
         } else {
             timer_add_periodic(&g_ctx->timer_root, &interface->io.tx_job, "TX", 0, 
                 config->tx_interval, io, &io_packet_mmap_tx_job);
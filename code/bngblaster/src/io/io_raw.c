@@ -7,10 +7,41 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "io.h"
+#include <linux/errqueue.h>
 
 extern bool g_init_phase;
 extern bool g_traffic;
 
+/**
+ * Set IO timestamp from the socket timestamp control 
+ * message of the received message and reset the control 
+ * buffer length for the next recvmmsg call. Messages 
+ * without socket timestamp get the batch timestamp.
+ *
+ * @param io IO handle
+ * @param index message index
+ * @param timestamp batch timestamp
+ */
+static void
+io_raw_rx_timestamp(io_handle_s *io, int index, struct timespec *timestamp)
+{
+    struct msghdr *msg = &io->mmsg[index].msg_hdr;
+    struct cmsghdr *cmsg;
+    struct scm_timestamping *ts;
+    int i = io->rx_timestamp == IO_TIMESTAMP_HARDWARE ? 2 : 0;
+
+    io->timestamp.tv_sec = timestamp->tv_sec;
+    io->timestamp.tv_nsec = timestamp->tv_nsec;
+    for(cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            ts = (struct scm_timestamping*)CMSG_DATA(cmsg);
+            io_socket_timestamp(io, ts->ts[i].tv_sec, ts->ts[i].tv_nsec);
+            break;
+        }
+    }
+    msg->msg_controllen = IO_RAW_CTRL_LEN;
+}
+
 /**
  * This job is for RAW RX in main thread!
  */
@@ -20,13 +51,13 @@ io_raw_rx_job(timer_s *timer)
     io_handle_s *io = timer->data;
     bbl_interface_s *interface = io->interface;
 
-    struct sockaddr saddr;
-    int saddr_size = sizeof(saddr);
-
     bbl_ethernet_header_s *eth;
 
     protocol_error_t decode_result;
+    struct timespec timestamp;
     bool pcap = false;
+    int received;
+    int i;
 
     assert(io->mode == IO_MODE_RAW);
     assert(io->direction == IO_INGRESS);
@@ -36,38 +67,57 @@ io_raw_rx_job(timer_s *timer)
     //clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
+    if(io->rx_timestamp) {
+        io_socket_timestamp_offset(io);
+    }
+    timestamp.tv_sec = io->timestamp.tv_sec;
+    timestamp.tv_nsec = io->timestamp.tv_nsec;
     while(true) {
-        io->buf_len = recvfrom(io->fd, io->buf, IO_BUFFER_LEN, 0, &saddr , (socklen_t*)&saddr_size);
-        if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
+        received = recvmmsg(io->fd, io->mmsg, io->mmsg_max, 0, NULL);
+        if(received <= 0) {
             break;
         }
-        io->stats.packets++;
-        io->stats.bytes += io->buf_len;
-        decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
-        if(decode_result == PROTOCOL_SUCCESS) {
-            /* Copy RX timestamp */
-            eth->timestamp.tv_sec = io->timestamp.tv_sec;
-            eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
-            /* Dump the packet into pcap file */
-            if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                        interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+        for(i = 0; i < received; i++) {
+            io->buf = io->iov[i].iov_base;
+            io->buf_len = io->mmsg[i].msg_len;
+            if(io->rx_timestamp) {
+                io_raw_rx_timestamp(io, i, &timestamp);
             }
-            bbl_rx_handler(interface, eth);
-        } else {
-            /* Dump the packet into pcap file */
-            if(g_ctx->pcap.write_buf) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+            if(io->mmsg[i].msg_len < 14 || io->mmsg[i].msg_len > IO_BUFFER_LEN) {
+                continue;
             }
-            if(decode_result == UNKNOWN_PROTOCOL) {
-                io->stats.unknown++;
+            io->stats.packets++;
+            io->stats.bytes += io->buf_len;
+            decode_result = decode_ethernet(io->buf, io->buf_len, g_ctx->sp, SCRATCHPAD_LEN, &eth);
+            if(decode_result == PROTOCOL_SUCCESS) {
+                /* Copy RX timestamp */
+                eth->timestamp.tv_sec = io->timestamp.tv_sec;
+                eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf && (!eth->bbl || g_ctx->pcap.include_streams)) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                            interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                bbl_rx_handler(interface, eth);
             } else {
-                io->stats.protocol_errors++;
+                /* Dump the packet into pcap file */
+                if(g_ctx->pcap.write_buf) {
+                    pcap = true;
+                    pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
+                                              interface->ifindex, PCAPNG_EPB_FLAGS_INBOUND);
+                }
+                if(decode_result == UNKNOWN_PROTOCOL) {
+                    io->stats.unknown++;
+                } else {
+                    io->stats.protocol_errors++;
+                }
             }
         }
+        if(received < io->mmsg_max) {
+            /* Socket drained. */
+            break;
+        }
     }
     if(pcap) {
         pcapng_fflush();
@@ -91,6 +141,121 @@ io_raw_tx_lo_long(io_handle_s *io)
     io->stats.to_long++;
 }
 
+/**
+ * Add packet to the TX message vector.
+ *
+ * Stream packets are copied into the message buffer because
+ * the same stream might be sent multiple times per batch,
+ * overwriting the sequence number in the stream TX buffer.
+ * The flow sequence is therefore incremented here, and
+ * reverted by io_raw_tx_batch if the packet was not sent. 
+ *
+ * @param io IO handle
+ * @param index message index
+ * @param len packet length
+ * @param stream stream or NULL for control traffic
+ */
+static void
+io_raw_tx_queue(io_handle_s *io, uint16_t index, uint16_t len, bbl_stream_s *stream)
+{
+    if(stream) {
+        memcpy(io->mmsg_buf + (index * IO_BUFFER_LEN), stream->tx_buf, len);
+        stream->flow_seq++;
+    }
+    io->iov[index].iov_len = len;
+    io->mmsg_stream[index] = stream;
+}
+
+/**
+ * Send all packets of the TX message vector with 
+ * as few sendmmsg calls as possible. 
+ * 
+ * Control packets which could not be sent are kept at 
+ * the begin of the vector (io->queued) to be retried 
+ * with the next call, similar to a single control packet
+ * in io->buf for the unbatched send. Stream packets not 
+ * sent are rescheduled one interval back. 
+ *
+ * @param io IO handle
+ * @param count number of messages
+ * @param pcap dump packets into pcap file (main thread only)
+ * @return true if all packets are sent or dropped
+ */
+static bool
+io_raw_tx_batch(io_handle_s *io, uint16_t count, bool pcap)
+{
+    bbl_interface_s *interface = io->interface;
+    bbl_stream_s *stream;
+    bool pcap_flush = false;
+
+    uint16_t index = 0;
+    uint16_t queued = 0;
+    uint16_t i;
+    int sent;
+
+    while(index < count) {
+        sent = sendmmsg(io->fd, io->mmsg + index, count - index, 0);
+        if(sent <= 0) {
+            if(errno == EMSGSIZE) {
+                io->buf_len = io->iov[index].iov_len;
+                io_raw_tx_lo_long(io);
+                io->buf_len = 0;
+                index++;
+                continue;
+            }
+            LOG(IO, "RAW sendmmsg on interface %s failed with error %s (%d)\n", 
+                interface->name, strerror(errno), errno);
+            io->stats.io_errors++;
+            break;
+        }
+        for(i = index; i < index + sent; i++) {
+            stream = io->mmsg_stream[i];
+            if(stream) {
+                stream->tx_packets++;
+            }
+            /* Dump the packet into pcap file. */
+            if(unlikely(pcap && g_ctx->pcap.write_buf && (!stream || g_ctx->pcap.include_streams))) {
+                pcap_flush = true;
+                pcapng_push_packet_header(&io->timestamp, io->iov[i].iov_base, io->iov[i].iov_len,
+                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
+            }
+            io->stats.packets++;
+            io->stats.bytes += io->iov[i].iov_len;
+        }
+        index += sent;
+    }
+    if(unlikely(pcap_flush)) {
+        pcapng_fflush();
+    }
+    if(index == count) {
+        io->queued = 0;
+        return true;
+    }
+
+    /* Revert flow sequence and schedule of all stream packets 
+     * not sent and keep control packets for the next attempt. */
+    for(i = count; i > index; i--) {
+        stream = io->mmsg_stream[i-1];
+        if(stream) {
+            stream->flow_seq--;
+            stream->sched_time -= stream->sched_interval;
+        }
+    }
+    for(i = index; i < count; i++) {
+        stream = io->mmsg_stream[i];
+        if(!stream) {
+            if(i != queued) {
+                memmove(io->mmsg_buf + (queued * IO_BUFFER_LEN), io->iov[i].iov_base, io->iov[i].iov_len);
+                io->iov[queued].iov_len = io->iov[i].iov_len;
+                io->mmsg_stream[queued] = NULL;
+            }
+            queued++;
+        }
+    }
+    io->queued = queued;
+    return false;
+}
+
 /**
  * This job is for RAW TX in main thread!
  */
@@ -102,8 +267,9 @@ io_raw_tx_job(timer_s *timer)
 
     bbl_stream_s *stream = NULL;
     uint16_t burst = interface->config->io_burst;
+    uint16_t count = io->queued;
+    uint16_t len;
     uint64_t now;
-    bool pcap = false;
 
     assert(io->mode == IO_MODE_RAW);
     assert(io->direction == IO_EGRESS);
@@ -114,78 +280,48 @@ io_raw_tx_job(timer_s *timer)
     io->timestamp.tv_sec = timer->timestamp->tv_sec;
     io->timestamp.tv_nsec = timer->timestamp->tv_nsec;
 
+    /* Control packets not sent in the last interval
+     * are still queued and count against the burst. */
+    burst = burst > count ? burst - count : 0;
+
+    /* First send all control traffic which has higher priority. */
     while(burst) {
-        if(likely(io->buf_len == 0)) {
-            if(bbl_tx(interface, io->buf, &io->buf_len) != PROTOCOL_SUCCESS) {
-                io->buf_len = 0;
-                break;
+        if(count == io->mmsg_max) {
+            if(!io_raw_tx_batch(io, count, true)) {
+                return;
             }
+            count = 0;
         }
-        if(sendto(io->fd, io->buf, io->buf_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) > 0) {
-            /* Dump the packet into pcap file. */
-            if(unlikely(g_ctx->pcap.write_buf != NULL)) {
-                pcap = true;
-                pcapng_push_packet_header(&io->timestamp, io->buf, io->buf_len,
-                                          interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-            }
-            io->stats.packets++;
-            io->stats.bytes += io->buf_len;
-            io->buf_len = 0;
-            burst--;
-        } else {
-            if(errno == EMSGSIZE) {
-                io_raw_tx_lo_long(io);
-                io->buf_len = 0;
-            } else {
-                /* This packet will be retried next interval 
-                 * because io->buf_len is not reset to zero. */
-                LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                    interface->name, strerror(errno), errno);
-                io->stats.io_errors++;
-                burst = 0;
-            }
+        len = 0;
+        if(bbl_tx(interface, io->iov[count].iov_base, &len) != PROTOCOL_SUCCESS) {
+            break;
         }
+        io_raw_tx_queue(io, count++, len, NULL);
+        burst--;
     }
 
     if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
         now = timespec_to_nsec(timer->timestamp);
         while(burst) {
+            if(count == io->mmsg_max) {
+                if(!io_raw_tx_batch(io, count, true)) {
+                    return;
+                }
+                count = 0;
+            }
             /* Send traffic streams up to allowed burst. */
             stream = bbl_stream_io_send_iter(io, now);
             if(unlikely(stream == NULL)) {
                 break;
             }
-            if(sendto(io->fd, stream->tx_buf, stream->tx_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) > 0) {
-                /* Dump the packet into pcap file. */
-                if(unlikely(g_ctx->pcap.write_buf && g_ctx->pcap.include_streams)) {
-                    pcap = true;
-                    pcapng_push_packet_header(&io->timestamp, stream->tx_buf, stream->tx_len,
-                                              interface->ifindex, PCAPNG_EPB_FLAGS_OUTBOUND);
-                }
-                stream->tx_packets++;
-                stream->flow_seq++;
-                io->stats.packets++;
-                io->stats.bytes += stream->tx_len;
-                burst--;
-            } else {
-                if(errno == EMSGSIZE) {
-                    io->buf_len = stream->tx_len;
-                    io_raw_tx_lo_long(io);
-                    io->buf_len = 0;
-                } else {
-                    LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                        interface->name, strerror(errno), errno);
-                    io->bucket_cur->stream_cur = stream;
-                    io->stats.io_errors++;
-                    burst = 0;
-                }
-            }
+            io_raw_tx_queue(io, count++, stream->tx_len, stream);
+            burst--;
         }
     } else {
         bbl_stream_io_stop(io);
     }
-    if(unlikely(pcap)) {
-        pcapng_fflush();
+    if(count) {
+        io_raw_tx_batch(io, count, true);
     }
 }
 
@@ -194,8 +330,9 @@ io_raw_thread_rx_run_fn(io_thread_s *thread)
 {
     io_handle_s *io = thread->io;
 
-    struct sockaddr saddr;
-    int saddr_size = sizeof(saddr);
+    struct timespec timestamp;
+    int received;
+    int i;
 
     assert(io->direction == IO_INGRESS);
 
@@ -204,16 +341,32 @@ io_raw_thread_rx_run_fn(io_thread_s *thread)
     sleep.tv_nsec = 1000; /* 0.001ms */
 
     while(thread->active) {
-        /* Get RX timestamp */
-        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
         /* Receive from socket */
-        io->buf_len = recvfrom(io->fd, io->buf, IO_BUFFER_LEN, 0, &saddr , (socklen_t*)&saddr_size);
-        if(io->buf_len < 14 || io->buf_len > IO_BUFFER_LEN) {
+        received = recvmmsg(io->fd, io->mmsg, io->mmsg_max, 0, NULL);
+        if(received <= 0) {
             nanosleep(&sleep, &rem);
             continue;
         }
-        /* Process packet */
-        io_thread_rx_handler(thread, io);
+        /* Get RX timestamp */
+        clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
+        if(io->rx_timestamp) {
+            io_socket_timestamp_offset(io);
+        }
+        timestamp.tv_sec = io->timestamp.tv_sec;
+        timestamp.tv_nsec = io->timestamp.tv_nsec;
+        for(i = 0; i < received; i++) {
+            if(io->rx_timestamp) {
+                io_raw_rx_timestamp(io, i, &timestamp);
+            }
+            if(io->mmsg[i].msg_len < 14 || io->mmsg[i].msg_len > IO_BUFFER_LEN) {
+                continue;
+            }
+            io->buf = io->iov[i].iov_base;
+            io->buf_len = io->mmsg[i].msg_len;
+            /* Process packet */
+            io_thread_rx_handler(thread, io);
+        }
+        bbl_txq_write_commit(thread->txq);
     }
 }
 
@@ -229,6 +382,7 @@ io_raw_thread_tx_run_fn(io_thread_s *thread)
     bbl_stream_s *stream = NULL;
     uint16_t io_burst = interface->config->io_burst;
     uint16_t burst = 0;
+    uint16_t count = 0;
     uint64_t now;
 
     struct timespec sleep, rem;
@@ -241,57 +395,55 @@ io_raw_thread_tx_run_fn(io_thread_s *thread)
 
     while(thread->active) {
         nanosleep(&sleep, &rem);
-        burst = io_burst;
+        io_thread_stream_msg_process(thread);
+        io_thread_stream_epoch(thread);
+        count = io->queued;
+        burst = io_burst > count ? io_burst - count : 0;
 
-        /* First send all control traffic which has higher priority. */
+        /* First send all control traffic which has higher priority. 
+         * The TXQ slots are copied to release them immediately. */
         while((slot = bbl_txq_read_slot(txq))) {
-            if(sendto(io->fd, slot->packet, slot->packet_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) >= 0 ) {
-                io->stats.packets++;
-                io->stats.bytes += slot->packet_len;
-                bbl_txq_read_next(txq);
-                if(burst) burst--;
-            } else {
-                LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                    io->interface->name, strerror(errno), errno);
-                io->stats.io_errors++;
-                burst = 0;
-                break;
+            if(count == io->mmsg_max) {
+                if(!io_raw_tx_batch(io, count, false)) {
+                    count = 0;
+                    burst = 0;
+                    break;
+                }
+                count = 0;
             }
+            memcpy(io->iov[count].iov_base, slot->packet, slot->packet_len);
+            io_raw_tx_queue(io, count++, slot->packet_len, NULL);
+            bbl_txq_read_next(txq);
+            if(burst) burst--;
         }
+        bbl_txq_read_commit(txq);
 
         /* Get TX timestamp */
         clock_gettime(CLOCK_MONOTONIC, &io->timestamp);
         if(g_traffic && g_init_phase == false && interface->state == INTERFACE_UP) {
             now = timespec_to_nsec(&io->timestamp);
             while(burst) {
+                if(count == io->mmsg_max) {
+                    if(!io_raw_tx_batch(io, count, false)) {
+                        count = 0;
+                        break;
+                    }
+                    count = 0;
+                }
                 /* Send traffic streams up to allowed burst. */
                 stream = bbl_stream_io_send_iter(io, now);
                 if(unlikely(stream == NULL)) {
                     break;
                 }
-                if(unlikely(sendto(io->fd, stream->tx_buf, stream->tx_len, 0, (struct sockaddr*)&io->addr, sizeof(struct sockaddr_ll)) >=0)) {
-                    stream->tx_packets++;
-                    stream->flow_seq++;
-                    io->stats.packets++;
-                    io->stats.bytes += stream->tx_len;
-                    burst--;
-                } else {
-                    if(errno == EMSGSIZE) {
-                        io->buf_len = stream->tx_len;
-                        io_raw_tx_lo_long(io);
-                        io->buf_len = 0;
-                    } else {
-                        LOG(IO, "RAW sendto on interface %s failed with error %s (%d)\n", 
-                            io->interface->name, strerror(errno), errno);
-                        io->bucket_cur->stream_cur = stream;
-                        io->stats.io_errors++;
-                        burst = 0;
-                    }
-                }
+                io_raw_tx_queue(io, count++, stream->tx_len, stream);
+                burst--;
             }
         } else {
             bbl_stream_io_stop(io);
         }
+        if(count) {
+            io_raw_tx_batch(io, count, false);
+        }
     }
 }
 
@@ -303,7 +455,46 @@ io_raw_init(io_handle_s *io)
     
     io_thread_s *thread = io->thread;
     
-    io->buf = malloc(IO_BUFFER_LEN);
+    uint16_t i;
+
+    /* Message vectors for recvmmsg/sendmmsg limited 
+     * by IO burst, each message with its own buffer. */
+    io->mmsg_max = config->io_burst;
+    if(io->mmsg_max > IO_RAW_MMSG_MAX) {
+        io->mmsg_max = IO_RAW_MMSG_MAX;
+    }
+    io->mmsg = calloc(io->mmsg_max, sizeof(struct mmsghdr));
+    io->iov = calloc(io->mmsg_max, sizeof(struct iovec));
+    io->mmsg_stream = calloc(io->mmsg_max, sizeof(bbl_stream_s*));
+    io->mmsg_buf = malloc(io->mmsg_max * IO_BUFFER_LEN);
+    if(!(io->mmsg && io->iov && io->mmsg_stream && io->mmsg_buf)) {
+        LOG(ERROR, "Failed to allocate RAW message buffers for interface %s\n", interface->name);
+        return false;
+    }
+    for(i = 0; i < io->mmsg_max; i++) {
+        io->iov[i].iov_base = io->mmsg_buf + (i * IO_BUFFER_LEN);
+        io->iov[i].iov_len = IO_BUFFER_LEN;
+        io->mmsg[i].msg_hdr.msg_iov = &io->iov[i];
+        io->mmsg[i].msg_hdr.msg_iovlen = 1;
+        if(io->direction == IO_EGRESS) {
+            io->mmsg[i].msg_hdr.msg_name = &io->addr;
+            io->mmsg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_ll);
+        }
+    }
+    io->buf = io->mmsg_buf;
+
+    if(io->direction == IO_INGRESS && io->rx_timestamp) {
+        /* Control message buffers for socket timestamps. */
+        io->mmsg_ctrl = calloc(io->mmsg_max, IO_RAW_CTRL_LEN);
+        if(!io->mmsg_ctrl) {
+            LOG(ERROR, "Failed to allocate RAW control buffers for interface %s\n", interface->name);
+            return false;
+        }
+        for(i = 0; i < io->mmsg_max; i++) {
+            io->mmsg[i].msg_hdr.msg_control = io->mmsg_ctrl + (i * IO_RAW_CTRL_LEN);
+            io->mmsg[i].msg_hdr.msg_controllen = IO_RAW_CTRL_LEN;
+        }
+    }
 
     if(!io_socket_open(io)) {
         return false;
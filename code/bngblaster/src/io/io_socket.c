@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "io.h"
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
 
 /* Bypass TC_QDISC, such that the kernel is hammered 30% less with 
  * processing packets. Only for the TX FD. */
@@ -33,6 +35,118 @@ set_qdisc_bypass(io_handle_s *io)
     return true;
 }
 
+/**
+ * io_socket_fanout_filter
+ *
+ * Classic BPF fanout program steering BBL stream packets 
+ * by flow identifier. The BBL header is located at the end 
+ * of each stream packet (see packet_is_bbl). The program 
+ * returns the lower 16 bits of the flow identifier for all 
+ * packets with valid BBL magic number and the kernel RX hash 
+ * for all other packets. The kernel selects the socket by 
+ * the returned value modulo number of sockets. 
+ *
+ * The RX hash (skb->hash) is not calculated for classic BPF 
+ * fanout programs and therefore only set by NICs with RSS 
+ * hash offload. Without, the lower 32 bits of the destination 
+ * and source MAC address are used instead, which keeps all 
+ * packets of a session (client MAC address) on one socket. 
+ *
+ * @param code program with IO_SOCKET_FANOUT_FILTER_LEN instructions
+ */
+void
+io_socket_fanout_filter(struct sock_filter *code)
+{
+    struct sock_filter filter[IO_SOCKET_FANOUT_FILTER_LEN] = {
+        BPF_STMT(BPF_LD|BPF_W|BPF_LEN, 0),
+        BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, BBL_HEADER_LEN, 0, 13),
+        BPF_STMT(BPF_ALU|BPF_SUB|BPF_K, BBL_HEADER_LEN),
+        BPF_STMT(BPF_MISC|BPF_TAX, 0),
+        BPF_STMT(BPF_LD|BPF_W|BPF_IND, 0),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, htobe32((uint32_t)BBL_MAGIC_NUMBER), 0, 9),
+        BPF_STMT(BPF_LD|BPF_W|BPF_IND, 4),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, htobe32((uint32_t)(BBL_MAGIC_NUMBER >> 32)), 0, 7),
+        BPF_STMT(BPF_LD|BPF_B|BPF_IND, 25), /* flow-id byte 1 */
+        BPF_STMT(BPF_ALU|BPF_LSH|BPF_K, 8),
+        BPF_STMT(BPF_ST, 0),
+        BPF_STMT(BPF_LD|BPF_B|BPF_IND, 24), /* flow-id byte 0 */
+        BPF_STMT(BPF_LDX|BPF_W|BPF_MEM, 0),
+        BPF_STMT(BPF_ALU|BPF_OR|BPF_X, 0),
+        BPF_STMT(BPF_RET|BPF_A, 0),
+        BPF_STMT(BPF_LD|BPF_W|BPF_ABS, SKF_AD_OFF + SKF_AD_RXHASH),
+        BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0, 1, 0),
+        BPF_STMT(BPF_RET|BPF_A, 0),
+        BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 2), /* destination MAC bytes 2-5 */
+        BPF_STMT(BPF_MISC|BPF_TAX, 0),
+        BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 8), /* source MAC bytes 2-5 */
+        BPF_STMT(BPF_ALU|BPF_XOR|BPF_X, 0),
+        BPF_STMT(BPF_RET|BPF_A, 0),
+    };
+    memcpy(code, filter, sizeof(filter));
+}
+
+/* Set classic BPF fanout program steering BBL stream 
+ * packets by flow identifier. */
+static bool
+set_fanout_flow_steering(io_handle_s *io)
+{
+    struct sock_filter code[IO_SOCKET_FANOUT_FILTER_LEN];
+    struct sock_fprog prog = {
+        .len = IO_SOCKET_FANOUT_FILTER_LEN,
+        .filter = code,
+    };
+    io_socket_fanout_filter(code);
+    if(setsockopt(io->fd, SOL_PACKET, PACKET_FANOUT_DATA, &prog, sizeof(prog)) == -1) {
+        LOG(ERROR, "Failed to set fanout flow steering for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    return true;
+}
+
+/* Enable per packet RX timestamps. */
+static bool
+set_timestamping(io_handle_s *io)
+{
+    struct hwtstamp_config hwconfig = {0};
+    struct ifreq ifr = {0};
+    int flags;
+    int req;
+
+    if(io->rx_timestamp == IO_TIMESTAMP_HARDWARE) {
+        /* Enable hardware timestamps for all received packets. */
+        hwconfig.tx_type = HWTSTAMP_TX_OFF;
+        hwconfig.rx_filter = HWTSTAMP_FILTER_ALL;
+        snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", io->interface->name);
+        ifr.ifr_data = (void*)&hwconfig;
+        if(ioctl(io->fd, SIOCSHWTSTAMP, &ifr) == -1) {
+            LOG(ERROR, "Failed to enable hardware timestamps for interface %s - %s (%d)\n",
+                io->interface->name, strerror(errno), errno);
+            return false;
+        }
+        flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    } else {
+        flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    }
+    if(setsockopt(io->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == -1) {
+        LOG(ERROR, "Failed to set timestamping for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    if(io->mode == IO_MODE_PACKET_MMAP) {
+        /* Select the timestamp reported in the ring frame header, 
+         * which defaults to the software timestamp. */
+        req = io->rx_timestamp == IO_TIMESTAMP_HARDWARE ? SOF_TIMESTAMPING_RAW_HARDWARE : 0;
+        if(setsockopt(io->fd, SOL_PACKET, PACKET_TIMESTAMP, &req, sizeof(req)) == -1) {
+            LOG(ERROR, "Failed to set packet timestamp for interface %s - %s (%d)\n",
+                io->interface->name, strerror(errno), errno);
+            return false;
+        }
+    }
+    io_socket_timestamp_offset(io);
+    return true;
+}
+
 /* Set fanout group. */
 static bool
 set_fanout(io_handle_s *io)
@@ -44,6 +158,9 @@ set_fanout(io_handle_s *io)
                 io->interface->name, strerror(errno), errno);
             return false;    
         }
+        if(io->fanout_type == PACKET_FANOUT_CBPF) {
+            return set_fanout_flow_steering(io);
+        }
     }
     return true;
 }
@@ -60,6 +177,44 @@ set_packet_version(io_handle_s *io, int version)
     return true;
 }
 
+/* Setup TPACKET_V3 RX ringbuffer. */
+static bool
+set_ring_v3(io_handle_s *io, int slots)
+{
+    /* With TPACKET_V3, the kernel fills variable sized frames into 
+     * blocks which are handed over to user space as a whole if full 
+     * or the block retire timeout has expired. The slots are used 
+     * to calculate the number of blocks assuming 2048 byte per packet. */
+    unsigned int ring_size = 0;
+    uint64_t tov = io->interface->config->rx_interval / MSEC;
+
+    io->req3.tp_block_size = IO_TPACKET_V3_BLOCK_SIZE;
+    io->req3.tp_frame_size = TPACKET_ALIGN(2048);
+    io->req3.tp_block_nr = (slots * io->req3.tp_frame_size) / io->req3.tp_block_size;
+    if(io->req3.tp_block_nr < 4) {
+        io->req3.tp_block_nr = 4;
+    }
+    io->req3.tp_frame_nr = (io->req3.tp_block_size / io->req3.tp_frame_size) * io->req3.tp_block_nr;
+    io->req3.tp_retire_blk_tov = tov ? tov : 1; /* ms */
+    io->req3.tp_sizeof_priv = 0;
+    io->req3.tp_feature_req_word = 0;
+
+    ring_size = io->req3.tp_block_nr * io->req3.tp_block_size;
+
+    LOG(DEBUG, "Setup %u byte packet_mmap TPACKET_V3 ringbuffer (%u blocks) for interface %s\n", 
+        ring_size, io->req3.tp_block_nr, io->interface->name);
+    if(setsockopt(io->fd, SOL_PACKET, PACKET_RX_RING, &io->req3, sizeof(struct tpacket_req3)) == -1) {
+        LOG(ERROR, "Allocating ringbuffer error for interface %s - %s (%d)\n",
+            io->interface->name, strerror(errno), errno);
+        return false;
+    }
+    io->ring = mmap(0, ring_size, PROT_READ|PROT_WRITE, MAP_SHARED, io->fd, 0);
+    if(io->ring == NULL || io->ring == MAP_FAILED) {
+        return false;
+    }
+    return true;
+}
+
 /* Setup ringbuffer. */
 static bool
 set_ring(io_handle_s *io, int slots)
@@ -72,13 +227,22 @@ set_ring(io_handle_s *io, int slots)
      * Note that tp_block_size should be chosen to be a power of two 
      * or there will be a waste of memory. */
     unsigned int ring_size = 0;
+    unsigned int frame_len = 0;
     int flag = 0;
+    io->req.tp_block_size = getpagesize(); /* 4096 */
     if(io->direction == IO_INGRESS) {
         flag = PACKET_RX_RING;
     } else {
         flag = PACKET_TX_RING;
+        /* TX frames must fit the max stream length, which is 
+         * limited to page size only with TPACKET_V2 RX rings
+         * (see io_packet_mmap_set_max_stream_len). */
+        frame_len = TPACKET2_HDRLEN - sizeof(struct sockaddr_ll) + 
+                    g_ctx->config.io_max_stream_len + BBL_MAX_STREAM_OVERHEAD;
+        while(io->req.tp_block_size < frame_len) {
+            io->req.tp_block_size += getpagesize();
+        }
     }
-    io->req.tp_block_size = getpagesize(); /* 4096 */
     io->req.tp_frame_size = io->req.tp_block_size;
     io->req.tp_block_nr = slots;
     io->req.tp_frame_nr = slots;
@@ -138,14 +302,30 @@ io_socket_open(io_handle_s *io) {
         }
     }
     if(io->mode == IO_MODE_PACKET_MMAP) {
-        if(!set_packet_version(io, TPACKET_V2)) {
-            return false;
+        if(io->direction == IO_INGRESS && config->io_tpacket_v3) {
+            io->tpacket_version = TPACKET_V3;
+            if(!set_packet_version(io, TPACKET_V3)) {
+                return false;
+            }
+            if(!set_ring_v3(io, slots)) {
+                return false;
+            }
+        } else {
+            io->tpacket_version = TPACKET_V2;
+            if(!set_packet_version(io, TPACKET_V2)) {
+                return false;
+            }
+            if(!set_ring(io, slots)) {
+                return false;
+            }
         }
-        if(!set_ring(io, slots)) {
+    }
+
+    if(io->direction == IO_INGRESS && io->rx_timestamp != IO_TIMESTAMP_USER) {
+        if(!set_timestamping(io)) {
             return false;
         }
     }
-
     if(!set_fanout(io)) {
         return false;
     }
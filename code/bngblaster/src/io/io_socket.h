@@ -9,7 +9,51 @@
 #ifndef __BBL_IO_SOCKET_H__
 #define __BBL_IO_SOCKET_H__
 
+#include <linux/filter.h>
+
+#define IO_SOCKET_FANOUT_FILTER_LEN 23
+
 bool
 io_socket_open(io_handle_s *io);
 
+void
+io_socket_fanout_filter(struct sock_filter *code);
+
+/**
+ * Update offset between CLOCK_MONOTONIC used for BBL 
+ * timestamps and CLOCK_REALTIME used for socket packet 
+ * timestamps. Hardware timestamps are expected to be 
+ * synchronized to CLOCK_REALTIME (e.g. phc2sys). 
+ *
+ * @param io IO handle
+ */
+static inline void
+io_socket_timestamp_offset(io_handle_s *io)
+{
+    struct timespec mono, real;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &real);
+    io->timestamp_offset = ((int64_t)mono.tv_sec - real.tv_sec) * SEC + (mono.tv_nsec - real.tv_nsec);
+}
+
+/**
+ * Set IO timestamp from socket packet timestamp. 
+ * The IO timestamp is not changed if the packet 
+ * timestamp is not set. 
+ *
+ * @param io IO handle
+ * @param sec packet timestamp seconds (CLOCK_REALTIME)
+ * @param nsec packet timestamp nanoseconds
+ */
+static inline void
+io_socket_timestamp(io_handle_s *io, int64_t sec, int64_t nsec)
+{
+    int64_t ts;
+    if(likely(sec)) {
+        ts = sec * SEC + nsec + io->timestamp_offset;
+        io->timestamp.tv_sec = ts / SEC;
+        io->timestamp.tv_nsec = ts % SEC;
+    }
+}
+
 #endif
\ No newline at end of file
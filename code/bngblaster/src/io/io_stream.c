@@ -30,7 +30,6 @@ bucket_new(io_handle_s *io, double pps)
     } else {
         io_bucket->next = io->bucket_head;
         io->bucket_head = io_bucket;
-        io->bucket_cur = io_bucket;
     }
     return io_bucket;
 }
@@ -65,7 +64,6 @@ bucket_shuffle(io_bucket_s *io_bucket)
             }
         }
     }
-    io_bucket->stream_cur = NULL;
 }
 
 static void
@@ -77,8 +75,6 @@ bucket_smear(io_bucket_s *io_bucket)
 
     if(io_bucket && io_bucket->stream_count) {
         step_nsec = io_bucket->nsec / io_bucket->stream_count;
-        io_bucket->base = 0;
-        io_bucket->stream_cur = NULL;
         stream = io_bucket->stream_head;
         while(stream) {
             nsec += step_nsec;
@@ -96,6 +92,20 @@ io_stream_add(io_handle_s *io, bbl_stream_s *stream)
     stream->io = io;
     io->stream_pps += stream->pps;
     io->stream_count++;
+    if(io->thread) {
+        /* Stream packets of threaded IO handles are owned
+         * by the TX thread and (re)build on request of the 
+         * main thread stream control job. */
+        stream->threaded = true;
+        if(!g_ctx->stream_tx_ctrl_job) {
+            timer_add_periodic(&g_ctx->timer_root, &g_ctx->stream_tx_ctrl_job, "Stream TX CTRL", 
+                               0, BBL_STREAM_TX_CTRL_INTERVAL, g_ctx, &bbl_stream_tx_ctrl_job);
+        }
+        bbl_stream_tx_ctrl_update(stream);
+    } else {
+        stream->threaded = false;
+    }
+    atomic_store_explicit(&io->sched.reset, true, memory_order_release);
     while(io_bucket) {
         if(io_bucket->pps == stream->pps) {
             bucket_stream_add(io_bucket, stream);
@@ -114,10 +124,10 @@ io_stream_clear(io_handle_s *io)
     io_bucket_s *io_bucket = io->bucket_head;
     io->stream_pps = 0;
     io->stream_count = 0;
+    atomic_store_explicit(&io->sched.reset, true, memory_order_release);
     while(io_bucket) {
         io_bucket->stream_count = 0;
         io_bucket->stream_head = NULL;
-        io_bucket->stream_cur = NULL;
         io_bucket = io_bucket->next;
     }
 }
@@ -131,6 +141,7 @@ io_stream_smear(io_handle_s *io)
         bucket_smear(io_bucket);
         io_bucket = io_bucket->next;
     }
+    atomic_store_explicit(&io->sched.reset, true, memory_order_release);
 }
 
 void
@@ -145,4 +156,92 @@ io_stream_smear_all()
             io = io->next;
         }
     }
-}
\ No newline at end of file
+}
+/**
+ * io_stream_sched_alloc
+ * 
+ * Allocate the stream calendar queue of the IO handle, 
+ * which must be done before streams are scheduled.
+ *
+ * @param io IO handle
+ * @return true if successful
+ */
+bool
+io_stream_sched_alloc(io_handle_s *io)
+{
+    io->sched.wheel = calloc(IO_SCHED_WHEEL_SIZE, sizeof(bbl_stream_s*));
+    return io->sched.wheel != NULL;
+}
+
+/**
+ * io_stream_sched_free
+ * 
+ * @param io IO handle
+ */
+void
+io_stream_sched_free(io_handle_s *io)
+{
+    free(io->sched.wheel);
+    io->sched.wheel = NULL;
+    io->sched.list = NULL;
+}
+
+/**
+ * io_stream_sched_add
+ * 
+ * Insert stream into the slot of its next TX time 
+ * or the next slot to be visited if already due. 
+ *
+ * @param io IO handle
+ * @param stream stream
+ */
+void
+io_stream_sched_add(io_handle_s *io, bbl_stream_s *stream)
+{
+    io_sched_s *sched = &io->sched;
+    uint64_t slot = stream->sched_time >> IO_SCHED_SLOT_BITS;
+    if(slot < sched->cursor) {
+        slot = sched->cursor;
+    }
+    slot &= IO_SCHED_WHEEL_MASK;
+    stream->sched_next = sched->wheel[slot];
+    sched->wheel[slot] = stream;
+}
+
+/**
+ * io_stream_sched_init
+ * 
+ * (Re)initialize the stream calendar queue with 
+ * all streams of the IO handle, starting now with 
+ * the offset assigned by io_stream_smear. 
+ *
+ * @param io IO handle
+ * @param now nsec timestamp (CLOCK_MONOTONIC)
+ */
+void
+io_stream_sched_init(io_handle_s *io, uint64_t now)
+{
+    io_sched_s *sched = &io->sched;
+    io_bucket_s *io_bucket = io->bucket_head;
+    bbl_stream_s *stream;
+
+    atomic_store_explicit(&sched->reset, false, memory_order_relaxed);
+    if(!sched->wheel) {
+        return;
+    }
+    memset(sched->wheel, 0x0, IO_SCHED_WHEEL_SIZE * sizeof(bbl_stream_s*));
+    sched->list = NULL;
+    sched->list_end = 0;
+    sched->cursor = now >> IO_SCHED_SLOT_BITS;
+
+    while(io_bucket) {
+        stream = io_bucket->stream_head;
+        while(stream) {
+            stream->sched_interval = io_bucket->nsec;
+            stream->sched_time = now + stream->expired;
+            io_stream_sched_add(io, stream);
+            stream = stream->io_next;
+        }
+        io_bucket = io_bucket->next;
+    }
+}
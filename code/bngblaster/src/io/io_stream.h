@@ -21,4 +21,16 @@ io_stream_smear(io_handle_s *io);
 void
 io_stream_smear_all();
 
+bool
+io_stream_sched_alloc(io_handle_s *io);
+
+void
+io_stream_sched_free(io_handle_s *io);
+
+void
+io_stream_sched_init(io_handle_s *io, uint64_t now);
+
+void
+io_stream_sched_add(io_handle_s *io, bbl_stream_s *stream);
+
 #endif
\ No newline at end of file
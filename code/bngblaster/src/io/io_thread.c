@@ -11,7 +11,9 @@
 /** 
  * This function redirects the packet in the
  * IO buffer to the main thread via the TXQ 
- * ring buffer. 
+ * ring buffer. Redirected packets are passed
+ * to the main thread with bbl_txq_write_commit
+ * after each RX burst or if the TXQ is full. 
  * 
  * @param thread thread handle
  * @param io IO handle
@@ -38,6 +40,7 @@ redirect(io_thread_s *thread, io_handle_s *io)
         bbl_txq_write_next(thread->txq);
         return IO_REDIRECT;
     }
+    bbl_txq_write_commit(thread->txq);
     return IO_FULL;
 }
 
@@ -70,7 +73,7 @@ io_thread_rx_handler(io_thread_s *thread, io_handle_s *io)
             eth->timestamp.tv_nsec = io->timestamp.tv_nsec;
 
             vlan = io->vlan_tci & BBL_ETH_VLAN_ID_MAX;
-            if(eth->vlan_outer != vlan) {
+            if(vlan && eth->vlan_outer != vlan) {
                 /* The outer VLAN is stripped from header */
                 eth->vlan_inner = eth->vlan_outer;
                 eth->vlan_inner_priority = eth->vlan_outer_priority;
@@ -81,7 +84,7 @@ io_thread_rx_handler(io_thread_s *thread, io_handle_s *io)
                 }
             }
 
-            if(bbl_rx_thread(io->interface, eth)) {
+            if(bbl_rx_thread(io->interface, eth, &thread->stream_stats)) {
                 return IO_SUCCESS;
             }
         } else if(decode_result == UNKNOWN_PROTOCOL) {
@@ -154,6 +157,7 @@ io_thread_main_rx_job(timer_s *timer)
                 }
                 bbl_txq_read_next(thread->txq);
             }
+            bbl_txq_read_commit(thread->txq);
         }
         io = io->next;
     }
@@ -196,11 +200,81 @@ io_thread_main_tx_job(timer_s *timer)
             break;
         }
     }
+    bbl_txq_write_commit(txq);
     if(pcap) {
         pcapng_fflush();
     }
 }
 
+/** 
+ * Send stream control message from main 
+ * thread to the TX thread owning the stream. 
+ * 
+ * @param thread TX thread handle
+ * @param stream stream
+ * @param type message type
+ * @param packet new stream packet (IO_STREAM_MSG_BUILD)
+ * @return false if message ring is full
+ */
+bool
+io_thread_stream_msg(io_thread_s *thread, bbl_stream_s *stream, io_stream_msg_type_t type, bbl_stream_packet_s *packet)
+{
+    io_stream_msgq_s *msgq = thread->stream_msgq;
+    io_stream_msg_s *msg;
+    uint32_t write = atomic_load_explicit(&msgq->write, memory_order_relaxed);
+
+    if(write - atomic_load_explicit(&msgq->read, memory_order_acquire) >= IO_STREAM_MSGQ_SIZE) {
+        msgq->full++;
+        return false;
+    }
+    msg = &msgq->ring[write & (IO_STREAM_MSGQ_SIZE-1)];
+    msg->stream = stream;
+    msg->packet = packet;
+    msg->type = type;
+    atomic_store_explicit(&msgq->write, write+1, memory_order_release);
+    return true;
+}
+
+/** 
+ * Process all stream control messages 
+ * received from main thread. This function
+ * must be called by the TX thread only. 
+ * 
+ * @param thread TX thread handle
+ */
+void
+io_thread_stream_msg_process(io_thread_s *thread)
+{
+    io_stream_msgq_s *msgq = thread->stream_msgq;
+    io_stream_msg_s *msg;
+    uint32_t read = atomic_load_explicit(&msgq->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&msgq->write, memory_order_acquire);
+
+    while(read != write) {
+        msg = &msgq->ring[read & (IO_STREAM_MSGQ_SIZE-1)];
+        bbl_stream_tx_msg(msg->stream, msg->type, msg->packet);
+        read++;
+    }
+    atomic_store_explicit(&msgq->read, read, memory_order_release);
+}
+
+/** 
+ * Fold TX stream stats once per second (epoch)
+ * into the stream stats of the TX thread. This 
+ * function must be called by the TX thread only. 
+ * 
+ * @param thread TX thread handle
+ */
+void
+io_thread_stream_epoch(io_thread_s *thread)
+{
+    io_handle_s *io = thread->io;
+    if(io->timestamp.tv_sec != thread->stream_epoch) {
+        thread->stream_epoch = io->timestamp.tv_sec;
+        bbl_stream_tx_epoch(io, &thread->stream_stats);
+    }
+}
+
 void *
 io_thread_main(void *thread_data)
 {
@@ -242,7 +316,11 @@ io_thread_init(io_handle_s *io)
     io->thread = thread;
     thread->io = io;
     io->fanout_id = interface->kernel_index;
-    io->fanout_type = PACKET_FANOUT_HASH;
+    if(config->rx_flow_steering) {
+        io->fanout_type = PACKET_FANOUT_CBPF;
+    } else {
+        io->fanout_type = PACKET_FANOUT_HASH;
+    }
 
     /* Allocate thread scratchpad memory */
     thread->sp = malloc(SCRATCHPAD_LEN);
@@ -253,6 +331,14 @@ io_thread_init(io_handle_s *io)
         return false;
     }
 
+    /* Init thread stream message rings */
+    if(io->direction == IO_EGRESS) {
+        thread->stream_msgq = calloc(1, sizeof(io_stream_msgq_s));
+        if(!thread->stream_msgq) {
+            return false;
+        }
+    }
+
     /* Init thread mutex */
     if(pthread_mutex_init(&thread->mutex, NULL) != 0) {
         LOG_NOARG(ERROR, "Failed to init mutex\n");
@@ -18,6 +18,15 @@ io_thread_start_all();
 void
 io_thread_stop_all();
 
+bool
+io_thread_stream_msg(io_thread_s *thread, bbl_stream_s *stream, io_stream_msg_type_t type, bbl_stream_packet_s *packet);
+
+void
+io_thread_stream_msg_process(io_thread_s *thread);
+
+void
+io_thread_stream_epoch(io_thread_s *thread);
+
 io_result_t
 io_thread_rx_handler(io_thread_s *thread, io_handle_s *io);
 
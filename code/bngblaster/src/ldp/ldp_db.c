@@ -60,6 +60,7 @@ ldb_db_add_ipv4(ldp_session_s *session, ipv4_prefix *prefix, uint32_t label)
     entry->prefix.ipv4.len = prefix->len;
     entry->label = label;
     entry->source = session;
+    bbl_stream_ldp_update();
     return true;
 }
 
@@ -108,6 +109,7 @@ ldb_db_add_ipv6(ldp_session_s *session, ipv6_prefix *prefix, uint32_t label)
     entry->prefix.ipv6.len = prefix->len;
     entry->label = label;
     entry->source = session;
+    bbl_stream_ldp_update();
     return true;
 
 }
@@ -0,0 +1,28 @@
+/*
+ * BNG Blaster (BBL) - LwIP Hooks
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef __LWIPHOOKS_H__
+#define __LWIPHOOKS_H__
+
+struct pbuf;
+struct netif;
+struct tcp_hdr;
+struct tcp_pcb;
+
+u32_t *
+bbl_tcp_lwip_out_hook(struct pbuf *p, const struct tcp_pcb *pcb, u32_t *opts);
+
+struct tcp_pcb *
+bbl_tcp_lwip_in_hook(const struct tcp_hdr *hdr, struct netif *inp);
+
+u16_t
+bbl_tcp_lwip_mss_hook(const struct tcp_pcb *pcb, u16_t mss);
+
+#define LWIP_HOOK_TCP_OUT_ADD_TCPOPTS(p, hdr, pcb, opts) bbl_tcp_lwip_out_hook(p, pcb, opts)
+#define LWIP_HOOK_TCP_INPUT_PCB(hdr, inp) bbl_tcp_lwip_in_hook(hdr, inp)
+#define LWIP_HOOK_TCP_EFF_SEND_MSS(pcb, mss) bbl_tcp_lwip_mss_hook(pcb, mss)
+
+#endif /* __LWIPHOOKS_H__ */
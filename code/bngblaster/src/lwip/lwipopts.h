@@ -68,6 +68,13 @@ extern unsigned char debug_flags;
    but are faster that way! */
 #define MEM_ALIGNMENT            4
 
+/* MEM_LIBC_MALLOC: use malloc/free instead of the lwIP heap and
+   MEMP_MEM_MALLOC: allocate pool elements from the heap, so that
+   all pools are sized at runtime. The MEMP_NUM_* values below
+   are no longer limits with this option. */
+#define MEM_LIBC_MALLOC          1
+#define MEMP_MEM_MALLOC          1
+
 /* MEM_SIZE: the size of the heap memory. If the application will send
    a lot of data that needs to be copied, this should be set high. */
 #define MEM_SIZE                 4*1024*1024
@@ -132,11 +139,16 @@ extern unsigned char debug_flags;
    order. Define to 0 if your device is low on memory. */
 #define TCP_QUEUE_OOSEQ          0
 
-/* TCP Maximum segment size. */
-#define TCP_MSS                  1024
+/* TCP Maximum segment size, the effective MSS is
+   reduced to the MTU of the corresponding interface. */
+#define TCP_MSS                  1460
+
+/* TCP window scaling (RFC 7323). */
+#define LWIP_WND_SCALE           1
+#define TCP_RCV_SCALE            2
 
 /* TCP sender buffer space (bytes). */
-#define TCP_SND_BUF              (32 * TCP_MSS)
+#define TCP_SND_BUF              (64 * TCP_MSS)
 
 /* TCP sender buffer space (pbufs). This must be at least = 2 *
    TCP_SND_BUF/TCP_MSS for things to work. */
@@ -148,7 +160,7 @@ extern unsigned char debug_flags;
 #define TCP_SNDLOWAT             (TCP_SND_BUF/2)
 
 /* TCP receive window. */
-#define TCP_WND                  (32 * TCP_MSS)
+#define TCP_WND                  (64 * TCP_MSS)
 
 /* Maximum number of retransmissions of data segments. */
 #define TCP_MAXRTX               12
@@ -159,6 +171,16 @@ extern unsigned char debug_flags;
 #define TCP_LISTEN_BACKLOG       1
 #define LWIP_CALLBACK_API        1
 
+/* One extended argument per PCB, used to demultiplex
+   session TCP connections over a shared interface. */
+#define LWIP_TCP_PCB_NUM_EXT_ARGS 1
+
+/* Session of outgoing pbufs (see bbl_tcp_lwip_out_hook). */
+#define LWIP_PBUF_CUSTOM_DATA    void *session;
+#define LWIP_PBUF_CUSTOM_DATA_INIT(p) (p)->session = NULL
+
+#define LWIP_HOOK_FILENAME       "lwiphooks.h"
+
 /* ---------- ARP options ---------- */
 #define LWIP_ARP                 1
 
@@ -0,0 +1,98 @@
+/*
+ * BNG Blaster (BBL) - Checksum Micro-Benchmark
+ *
+ * Compare the previous 16 bit word loop with the scalar
+ * and SIMD Internet checksum implementations for typical
+ * packet sizes and the IPv4 UDP checksum used by streams.
+ *
+ * Usage: bench-checksum [iterations]
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <bbl_def.h>
+#include <bbl_protocols.h>
+#include <checksum.h>
+
+static volatile uint32_t g_result = 0;
+
+static uint32_t
+bench_checksum_word(const void *buf, size_t len)
+{
+    uint32_t result = 0;
+    const uint16_t *cur = buf;
+    while(len > 1) {
+        result += *cur++;
+        len -= 2;
+    }
+    if(len) {
+        result += *(const uint8_t*)cur;
+    }
+    while(result >> 16) {
+        result = (result & 0xffff) + (result >> 16);
+    }
+    return result;
+}
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_checksum(uint32_t (*fn)(const void *buf, size_t len),
+               uint8_t *buf, size_t len, uint32_t iterations)
+{
+    double start = bench_cpu_time();
+    uint32_t i;
+
+    for(i = 0; i < iterations; i++) {
+        g_result += fn(buf, len);
+    }
+    return (bench_cpu_time() - start) * 1e9 / iterations;
+}
+
+static double
+bench_udp_checksum(uint8_t *buf, uint16_t len, uint32_t iterations)
+{
+    double start = bench_cpu_time();
+    uint32_t i;
+
+    for(i = 0; i < iterations; i++) {
+        g_result += bbl_ipv4_udp_checksum(0x0100000a, 0x0200000a, buf, len);
+    }
+    return (bench_cpu_time() - start) * 1e9 / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    uint16_t sizes[] = { 64, 128, 256, 512, 1500, 9000 };
+    uint32_t iterations = 1000000;
+    uint8_t *buf;
+    size_t i;
+
+    if(argc > 1) iterations = strtoul(argv[1], NULL, 10);
+    if(!iterations) iterations = 1;
+
+    buf = malloc(UINT16_MAX);
+    if(!buf) {
+        exit(1);
+    }
+    for(i = 0; i < UINT16_MAX; i++) {
+        buf[i] = rand();
+    }
+
+    printf("%u iterations, checksum_sum using %s\n", iterations, checksum_sum_name());
+    printf("%6s %12s %12s %12s %12s\n", "bytes", "word ns", "generic ns", "simd ns", "udp ns");
+    for(i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        printf("%6u %12.1f %12.1f %12.1f %12.1f\n", sizes[i],
+               bench_checksum(bench_checksum_word, buf, sizes[i], iterations),
+               bench_checksum(checksum_sum_generic, buf, sizes[i], iterations),
+               bench_checksum(checksum_sum, buf, sizes[i], iterations),
+               bench_udp_checksum(buf, sizes[i], iterations));
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * BNG Blaster (BBL) - IO Socket Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <io/io.h>
+
+/* Globals of bbl.c and bbl_interactive.c used for logging. */
+bbl_ctx_s *g_ctx = NULL;
+bool g_interactive = false;
+uint8_t g_log_buf_cur = 0;
+char *g_log_buf = NULL;
+WINDOW *log_win = NULL;
+
+keyval_t log_names[] = {
+    { 0, NULL}
+};
+
+#define FRAME_LEN 128
+#define FRAME_MIN_LEN (14 + 20 + 8 + BBL_HEADER_LEN)
+
+/* Minimal classic BPF interpreter for the instructions
+ * used by the fanout program, following the kernel
+ * semantics (network byte order loads, return 0 for
+ * loads beyond the packet). */
+static uint32_t
+cbpf_load(const uint8_t *pkt, uint32_t len, uint32_t offset, uint16_t size, uint32_t rxhash, bool *valid)
+{
+    uint32_t value = 0;
+    uint16_t i;
+
+    if(offset == (uint32_t)(SKF_AD_OFF + SKF_AD_RXHASH) && size == 4) {
+        return rxhash;
+    }
+    if(offset + size > len) {
+        *valid = false;
+        return 0;
+    }
+    for(i = 0; i < size; i++) {
+        value = (value << 8) | pkt[offset + i];
+    }
+    return value;
+}
+
+static uint32_t
+cbpf_run(const struct sock_filter *code, uint16_t code_len,
+         const uint8_t *pkt, uint32_t len, uint32_t rxhash)
+{
+    uint32_t A = 0, X = 0;
+    uint32_t mem[BPF_MEMWORDS] = {0};
+    uint16_t size;
+    uint16_t pc = 0;
+    bool valid = true;
+    const struct sock_filter *f;
+
+    while(pc < code_len) {
+        f = &code[pc++];
+        switch(BPF_CLASS(f->code)) {
+            case BPF_LD:
+                size = BPF_SIZE(f->code) == BPF_W ? 4 : BPF_SIZE(f->code) == BPF_H ? 2 : 1;
+                switch(BPF_MODE(f->code)) {
+                    case BPF_LEN: A = len; break;
+                    case BPF_ABS: A = cbpf_load(pkt, len, f->k, size, rxhash, &valid); break;
+                    case BPF_IND: A = cbpf_load(pkt, len, X + f->k, size, rxhash, &valid); break;
+                    case BPF_MEM: A = mem[f->k]; break;
+                    default: fail();
+                }
+                if(!valid) return 0;
+                break;
+            case BPF_LDX:
+                assert_int_equal(BPF_MODE(f->code), BPF_MEM);
+                X = mem[f->k];
+                break;
+            case BPF_ST:
+                mem[f->k] = A;
+                break;
+            case BPF_ALU:
+                switch(BPF_OP(f->code)) {
+                    case BPF_SUB: A -= BPF_SRC(f->code) == BPF_X ? X : f->k; break;
+                    case BPF_LSH: A <<= BPF_SRC(f->code) == BPF_X ? X : f->k; break;
+                    case BPF_OR: A |= BPF_SRC(f->code) == BPF_X ? X : f->k; break;
+                    case BPF_XOR: A ^= BPF_SRC(f->code) == BPF_X ? X : f->k; break;
+                    default: fail();
+                }
+                break;
+            case BPF_JMP:
+                switch(BPF_OP(f->code)) {
+                    case BPF_JA: pc += f->k; break;
+                    case BPF_JEQ: pc += (A == f->k) ? f->jt : f->jf; break;
+                    case BPF_JGE: pc += (A >= f->k) ? f->jt : f->jf; break;
+                    default: fail();
+                }
+                break;
+            case BPF_RET:
+                return BPF_RVAL(f->code) == BPF_A ? A : f->k;
+            case BPF_MISC:
+                assert_int_equal(BPF_MISCOP(f->code), BPF_TAX);
+                X = A;
+                break;
+            default:
+                fail();
+        }
+    }
+    fail();
+    return 0;
+}
+
+/* Ethernet/IPv4/UDP frame with stream source and destination
+ * MAC address and BBL header at the end of the payload. */
+static void
+frame_init(uint8_t *frame, uint16_t len, uint64_t flow_id)
+{
+    uint8_t *bbl = frame + len - BBL_HEADER_LEN;
+
+    memset(frame, 0x0, len);
+    memcpy(frame, (uint8_t[]){0x02, 0x00, 0x00, 0x01, 0x00, 0x07}, ETH_ADDR_LEN);
+    memcpy(frame+6, (uint8_t[]){0x02, 0x00, 0xbb, 0xbb, 0x00, 0x01}, ETH_ADDR_LEN);
+    *(uint16_t*)(frame+12) = htobe16(ETH_TYPE_IPV4);
+    frame[14] = 0x45;
+    frame[23] = PROTOCOL_IPV4_UDP;
+
+    /* Same layout as encode_bbl. */
+    *(uint64_t*)bbl = BBL_MAGIC_NUMBER;
+    bbl[8] = BBL_TYPE_UNICAST;
+    *(uint64_t*)(bbl+24) = flow_id;
+}
+
+static void
+test_io_socket_fanout_bbl(void **unused) {
+    (void) unused;
+
+    struct sock_filter code[IO_SOCKET_FANOUT_FILTER_LEN];
+    uint8_t frame[FRAME_LEN];
+    uint64_t flow_ids[] = { 1, 2, 255, 256, 0x1234, 0xffff, 0x10000, 0x123456789a };
+    uint16_t len;
+    size_t i;
+
+    io_socket_fanout_filter(code);
+    for(i = 0; i < sizeof(flow_ids)/sizeof(flow_ids[0]); i++) {
+        for(len = FRAME_MIN_LEN; len <= FRAME_LEN; len += 19) {
+            frame_init(frame, len, flow_ids[i]);
+            assert_true(packet_is_bbl(frame, len));
+            /* BBL frames are steered by flow-id independent
+             * of the RX hash. */
+            assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, len, 0), flow_ids[i] & 0xffff);
+            assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, len, 0xdeadbeef), flow_ids[i] & 0xffff);
+        }
+    }
+}
+
+static void
+test_io_socket_fanout_other(void **unused) {
+    (void) unused;
+
+    struct sock_filter code[IO_SOCKET_FANOUT_FILTER_LEN];
+    uint8_t frame[FRAME_LEN];
+    uint32_t hash;
+
+    io_socket_fanout_filter(code);
+
+    /* Invalid BBL magic number. */
+    frame_init(frame, FRAME_LEN, 7);
+    frame[FRAME_LEN-BBL_HEADER_LEN+3] ^= 0xff;
+    assert_false(packet_is_bbl(frame, FRAME_LEN));
+
+    /* RX hash is used if set by the NIC ... */
+    assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, FRAME_LEN, 0xdeadbeef), 0xdeadbeef);
+
+    /* ... otherwise destination and source MAC address. */
+    hash = be32toh(*(uint32_t*)(frame+2)) ^ be32toh(*(uint32_t*)(frame+8));
+    assert_int_not_equal(hash, 0);
+    assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, FRAME_LEN, 0), hash);
+
+    /* Packets of different sessions (client MAC address)
+     * are distributed over multiple sockets. */
+    frame[5] = 0x08;
+    assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, FRAME_LEN, 0) % 2, (hash + 1) % 2);
+
+    /* Frames shorter than the BBL header. */
+    assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, 14, 0x1234), 0x1234);
+    assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, 14, 0), hash ^ 0x0f);
+
+    /* Truncated frames are steered to the first socket. */
+    assert_int_equal(cbpf_run(code, IO_SOCKET_FANOUT_FILTER_LEN, frame, 10, 0), 0);
+}
+
+static void
+test_io_socket_fanout_kernel(void **unused) {
+    (void) unused;
+
+    struct sock_filter code[IO_SOCKET_FANOUT_FILTER_LEN];
+    struct sock_fprog prog = {
+        .len = IO_SOCKET_FANOUT_FILTER_LEN,
+        .filter = code,
+    };
+    int fd;
+
+    /* The kernel verifies the program when attached,
+     * which does not require privileges for socket
+     * filters (unlike fanout groups). */
+    io_socket_fanout_filter(code);
+    fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    assert_true(fd >= 0);
+    assert_int_equal(setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)), 0);
+    close(fd);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_io_socket_fanout_bbl),
+        cmocka_unit_test(test_io_socket_fanout_other),
+        cmocka_unit_test(test_io_socket_fanout_kernel),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
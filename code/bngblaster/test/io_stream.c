@@ -0,0 +1,165 @@
+/*
+ * BNG Blaster (BBL) - IO Stream Scheduler Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <bbl.h>
+
+#define SLOT_NSEC (1ULL << IO_SCHED_SLOT_BITS)
+
+/* Symbols used by io_stream.c for threaded IO
+ * handles only, which are not tested here. */
+bbl_ctx_s *g_ctx = NULL;
+
+void
+timer_add_periodic(timer_root_s *root, timer_s **ptimer, char *name,
+                   time_t sec, long nsec, void *data, void (*cb)(timer_s *))
+{
+    (void) root; (void) ptimer; (void) name;
+    (void) sec; (void) nsec; (void) data; (void) cb;
+}
+
+void
+bbl_stream_tx_ctrl_update(bbl_stream_s *stream)
+{
+    (void) stream;
+}
+
+void
+bbl_stream_tx_ctrl_job(timer_s *timer)
+{
+    (void) timer;
+}
+
+static uint32_t
+sched_slot_count(io_handle_s *io, uint32_t slot)
+{
+    bbl_stream_s *stream = io->sched.wheel[slot];
+    uint32_t count = 0;
+    while(stream) {
+        count++;
+        stream = stream->sched_next;
+    }
+    return count;
+}
+
+static void
+test_io_stream_sched_add(void **unused) {
+    (void) unused;
+
+    io_handle_s io = {0};
+    bbl_stream_s stream[4] = {0};
+    uint64_t now = 1000ULL * SEC + 123;
+    uint64_t cursor = now >> IO_SCHED_SLOT_BITS;
+
+    assert_true(io_stream_sched_alloc(&io));
+    assert_non_null(io.sched.wheel);
+    io_stream_sched_init(&io, now);
+    assert_false(atomic_load(&io.sched.reset));
+    assert_int_equal(io.sched.cursor, cursor);
+
+    /* Stream due in 3 slots. */
+    stream[0].sched_time = now + 3 * SLOT_NSEC;
+    io_stream_sched_add(&io, &stream[0]);
+    assert_ptr_equal(io.sched.wheel[(cursor + 3) & IO_SCHED_WHEEL_MASK], &stream[0]);
+
+    /* Stream already due is added to the current slot. */
+    stream[1].sched_time = now - 10 * SLOT_NSEC;
+    io_stream_sched_add(&io, &stream[1]);
+    assert_ptr_equal(io.sched.wheel[cursor & IO_SCHED_WHEEL_MASK], &stream[1]);
+
+    /* Stream beyond the horizon shares the slot
+     * of the next rotation (wrap). */
+    stream[2].sched_time = now + (IO_SCHED_WHEEL_SIZE + 3) * SLOT_NSEC;
+    io_stream_sched_add(&io, &stream[2]);
+    assert_ptr_equal(io.sched.wheel[(cursor + 3) & IO_SCHED_WHEEL_MASK], &stream[2]);
+    assert_ptr_equal(stream[2].sched_next, &stream[0]);
+    assert_int_equal(sched_slot_count(&io, (cursor + 3) & IO_SCHED_WHEEL_MASK), 2);
+
+    io_stream_sched_free(&io);
+}
+
+static void
+test_io_stream_sched_wrap(void **unused) {
+    (void) unused;
+
+    io_handle_s io = {0};
+    bbl_stream_s stream[2] = {0};
+    uint64_t cursor = 5ULL * IO_SCHED_WHEEL_SIZE - 1;
+    uint64_t now = cursor << IO_SCHED_SLOT_BITS;
+
+    /* Cursor at the last slot of the wheel. */
+    assert_true(io_stream_sched_alloc(&io));
+    io_stream_sched_init(&io, now);
+    assert_int_equal(io.sched.cursor & IO_SCHED_WHEEL_MASK, IO_SCHED_WHEEL_MASK);
+
+    stream[0].sched_time = now;
+    io_stream_sched_add(&io, &stream[0]);
+    assert_ptr_equal(io.sched.wheel[IO_SCHED_WHEEL_MASK], &stream[0]);
+
+    stream[1].sched_time = now + 2 * SLOT_NSEC;
+    io_stream_sched_add(&io, &stream[1]);
+    assert_ptr_equal(io.sched.wheel[1], &stream[1]);
+
+    io_stream_sched_free(&io);
+}
+
+static void
+test_io_stream_sched_init(void **unused) {
+    (void) unused;
+
+    io_handle_s io = {0};
+    bbl_stream_s stream[3] = {0};
+    uint64_t now = 42ULL * SEC;
+    uint64_t cursor = now >> IO_SCHED_SLOT_BITS;
+    int i;
+
+    assert_true(io_stream_sched_alloc(&io));
+    for(i = 0; i < 3; i++) {
+        stream[i].pps = 1000;
+        io_stream_add(&io, &stream[i]);
+        assert_ptr_equal(stream[i].io, &io);
+        assert_false(stream[i].threaded);
+    }
+    assert_int_equal(io.stream_count, 3);
+    assert_true(atomic_load(&io.sched.reset));
+
+    /* Smear streams over the bucket interval. */
+    io_stream_smear(&io);
+    assert_true(atomic_load(&io.sched.reset));
+
+    io_stream_sched_init(&io, now);
+    assert_false(atomic_load(&io.sched.reset));
+    for(i = 0; i < 3; i++) {
+        assert_int_equal(stream[i].sched_interval, SEC / 1000);
+        assert_int_equal(stream[i].sched_time, now + stream[i].expired);
+        assert_true(sched_slot_count(&io, (stream[i].sched_time >> IO_SCHED_SLOT_BITS) & IO_SCHED_WHEEL_MASK) > 0);
+    }
+    assert_int_equal(io.sched.cursor, cursor);
+
+    /* Reinitialize after the stream list was cleared. */
+    io_stream_clear(&io);
+    assert_true(atomic_load(&io.sched.reset));
+    io_stream_sched_init(&io, now);
+    for(i = 0; i < IO_SCHED_WHEEL_SIZE; i++) {
+        assert_null(io.sched.wheel[i]);
+    }
+
+    io_stream_sched_free(&io);
+    free(io.bucket_head);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_io_stream_sched_add),
+        cmocka_unit_test(test_io_stream_sched_wrap),
+        cmocka_unit_test(test_io_stream_sched_init),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,210 @@
+/*
+ * BNG Blaster (BBL) - Session Identifier Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <bbl.h>
+
+#define SESSIONS 8
+
+/* Globals of bbl.c and bbl_interactive.c used for logging. */
+bbl_ctx_s *g_ctx = NULL;
+bool g_interactive = false;
+uint8_t g_log_buf_cur = 0;
+char *g_log_buf = NULL;
+WINDOW *log_win = NULL;
+
+keyval_t log_names[] = {
+    { 0, NULL}
+};
+
+static bbl_ctx_s ctx;
+static bbl_session_s session_list[SESSIONS];
+static bbl_session_hot_s session_hot[SESSIONS];
+static bbl_access_interface_s access_interface[2];
+
+static void
+session_id_setup(void) {
+    memset(&ctx, 0x0, sizeof(ctx));
+    memset(session_list, 0x0, sizeof(session_list));
+    memset(session_hot, 0x0, sizeof(session_hot));
+    memset(access_interface, 0x0, sizeof(access_interface));
+    g_ctx = &ctx;
+    g_ctx->config.session_id_bits = BBL_SESSION_ID_BITS;
+    g_ctx->config.sessions = SESSIONS;
+    g_ctx->sessions = SESSIONS;
+    g_ctx->session_list = session_list;
+    g_ctx->session_hot = session_hot;
+}
+
+static void
+session_id_teardown(void) {
+    free(access_interface[0].session_list);
+    free(access_interface[1].session_list);
+    free(g_ctx->access_interface_index);
+    g_ctx = NULL;
+}
+
+static void
+sessions_add(void) {
+    uint32_t i;
+
+    assert_true(bbl_session_id_init());
+    for(i = 0; i < SESSIONS; i++) {
+        session_list[i].session_id = i+1;
+        session_list[i].hot = &session_hot[i];
+        session_list[i].hot->access_interface = &access_interface[i & 1];
+        assert_true(bbl_session_id_add(&session_list[i]));
+    }
+}
+
+static void
+test_session_id_global(void **unused) {
+    (void) unused;
+
+    uint8_t mac[ETH_ADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x03};
+
+    session_id_setup();
+    g_ctx->config.mac_modifier = 0xab;
+    sessions_add();
+    assert_int_equal(g_ctx->session_id_mask, 0x00ffffff);
+
+    /* Default scheme with MAC modifier in byte 2. */
+    assert_int_equal(session_list[2].hot->client_mac[0], 0x02);
+    assert_int_equal(session_list[2].hot->client_mac[1], 0x00);
+    assert_int_equal(session_list[2].hot->client_mac[2], 0xab);
+    assert_int_equal(session_list[2].hot->client_mac[3], 0x00);
+    assert_int_equal(session_list[2].hot->client_mac[4], 0x00);
+    assert_int_equal(session_list[2].hot->client_mac[5], 0x03);
+
+    /* The MAC modifier is ignored for lookups. */
+    assert_ptr_equal(bbl_session_get_by_mac(NULL, session_list[2].hot->client_mac), &session_list[2]);
+    assert_ptr_equal(bbl_session_get_by_mac(&access_interface[1], mac), &session_list[2]);
+    mac[5] = SESSIONS+1;
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+    mac[5] = 0;
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+
+    session_id_teardown();
+}
+
+static void
+test_session_id_bits(void **unused) {
+    (void) unused;
+
+    uint8_t mac[ETH_ADDR_LEN] = {0x02, 0x00, 0x01, 0x00, 0x00, 0x05};
+
+    session_id_setup();
+    /* 28 bits keep the upper nibble of the MAC modifier. */
+    g_ctx->config.session_id_bits = 28;
+    g_ctx->config.mac_modifier = 0xab;
+    sessions_add();
+    assert_int_equal(g_ctx->session_id_mask, 0x0fffffff);
+    assert_int_equal(session_list[4].hot->client_mac[2], 0xa0);
+    assert_int_equal(session_list[4].hot->client_mac[5], 0x05);
+    assert_ptr_equal(bbl_session_get_by_mac(NULL, session_list[4].hot->client_mac), &session_list[4]);
+
+    /* MAC byte 2 is part of the session-id. */
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+
+    session_id_teardown();
+}
+
+static void
+test_session_id_bits_32(void **unused) {
+    (void) unused;
+
+    uint8_t mac[ETH_ADDR_LEN] = {0x02, 0x00, 0x01, 0x00, 0x00, 0x01};
+
+    session_id_setup();
+    /* 32 bits replace the MAC modifier. */
+    g_ctx->config.session_id_bits = 32;
+    g_ctx->config.mac_modifier = 0xff;
+    sessions_add();
+    assert_int_equal(g_ctx->session_id_mask, 0xffffffff);
+    assert_int_equal(session_list[0].hot->client_mac[2], 0x00);
+    assert_int_equal(session_list[0].hot->client_mac[5], 0x01);
+    assert_ptr_equal(bbl_session_get_by_mac(NULL, session_list[0].hot->client_mac), &session_list[0]);
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+
+    /* Session-id 0 wraps around. */
+    memset(mac+2, 0x0, 4);
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+
+    session_id_teardown();
+}
+
+static void
+test_session_id_sessions_max(void **unused) {
+    (void) unused;
+
+    session_id_setup();
+    g_ctx->config.sessions = 1 << 24;
+    assert_false(bbl_session_id_init());
+    g_ctx->config.session_id_bits = 25;
+    assert_true(bbl_session_id_init());
+
+    session_id_teardown();
+}
+
+static void
+test_session_id_interface(void **unused) {
+    (void) unused;
+
+    uint8_t mac[ETH_ADDR_LEN] = {0x02, 0x01, 0x00, 0x00, 0x00, 0x02};
+
+    session_id_setup();
+    g_ctx->config.session_id_interface = true;
+    g_ctx->config.mac_modifier = 0xab;
+    sessions_add();
+    assert_int_equal(g_ctx->access_interfaces, 2);
+    assert_int_equal(access_interface[0].index, 0);
+    assert_int_equal(access_interface[1].index, 1);
+    assert_int_equal(access_interface[0].sessions, SESSIONS/2);
+    assert_int_equal(access_interface[1].sessions, SESSIONS/2);
+
+    /* Sessions 4 and 5 are the third session of each interface. */
+    assert_int_equal(session_list[4].hot->client_mac[1], 0);
+    assert_int_equal(session_list[4].hot->client_mac[2], 0xab);
+    assert_int_equal(session_list[4].hot->client_mac[5], 3);
+    assert_int_equal(session_list[5].hot->client_mac[1], 1);
+    assert_int_equal(session_list[5].hot->client_mac[5], 3);
+
+    /* The receiving access interface selects the session-id space. */
+    assert_ptr_equal(bbl_session_get_by_mac(&access_interface[0], session_list[4].hot->client_mac), &session_list[4]);
+    assert_ptr_equal(bbl_session_get_by_mac(&access_interface[1], session_list[4].hot->client_mac), &session_list[5]);
+
+    /* Without interface (A10NSP), MAC byte 1 selects the interface. */
+    assert_ptr_equal(bbl_session_get_by_mac(NULL, session_list[4].hot->client_mac), &session_list[4]);
+    assert_ptr_equal(bbl_session_get_by_mac(NULL, session_list[5].hot->client_mac), &session_list[5]);
+    assert_ptr_equal(bbl_session_get_by_mac(NULL, mac), &session_list[3]);
+    mac[1] = 2;
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+
+    /* Session-id 0 wraps around and fails the range check. */
+    mac[1] = 1;
+    mac[5] = 0;
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+    assert_null(bbl_session_get_by_mac(&access_interface[0], mac));
+    mac[5] = SESSIONS/2+1;
+    assert_null(bbl_session_get_by_mac(NULL, mac));
+
+    session_id_teardown();
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_session_id_global),
+        cmocka_unit_test(test_session_id_bits),
+        cmocka_unit_test(test_session_id_bits_32),
+        cmocka_unit_test(test_session_id_sessions_max),
+        cmocka_unit_test(test_session_id_interface),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,191 @@
+/*
+ * BNG Blaster (BBL) - RX Session Demux Micro-Benchmark
+ *
+ * Measure the cost to recover the session from the client
+ * MAC address of received packets for 1M and 16M sessions
+ * with the different session-id schemes. The legacy decode
+ * of the last 3 bytes is included as reference. Packets hit
+ * 256K sessions spread over the full range in random order
+ * (cache misses) or a hot set of 4K sessions.
+ *
+ * The session records are mapped with MAP_NORESERVE, such
+ * that only the records of the hit sessions use memory.
+ *
+ * Usage: bench-session-id [lookups]
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <sys/mman.h>
+#include <bbl.h>
+
+#define BENCH_INTERFACES 4
+
+/* Globals of bbl.c and bbl_interactive.c used for logging. */
+bbl_ctx_s *g_ctx = NULL;
+bool g_interactive = false;
+uint8_t g_log_buf_cur = 0;
+char *g_log_buf = NULL;
+WINDOW *log_win = NULL;
+
+keyval_t log_names[] = {
+    { 0, NULL}
+};
+
+static volatile uint64_t g_result = 0;
+
+typedef enum {
+    BENCH_LEGACY,
+    BENCH_GLOBAL,
+    BENCH_INTERFACE,
+} bench_scheme_t;
+
+static const char *bench_scheme_names[] = {
+    [BENCH_LEGACY] = "legacy",
+    [BENCH_GLOBAL] = "global",
+    [BENCH_INTERFACE] = "interface",
+};
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_session_id_run(uint8_t (*macs)[ETH_ADDR_LEN], uint32_t lookups,
+                     bench_scheme_t scheme, bbl_access_interface_s *interfaces)
+{
+    bbl_session_s *session;
+    uint32_t session_id;
+    uint64_t hits = 0;
+    double start;
+    uint32_t i;
+
+    start = bench_cpu_time();
+    for(i = 0; i < lookups; i++) {
+        switch(scheme) {
+            case BENCH_LEGACY:
+                session_id = macs[i][5];
+                session_id |= macs[i][4] << 8;
+                session_id |= macs[i][3] << 16;
+                session = bbl_session_get(session_id);
+                break;
+            case BENCH_INTERFACE:
+                session = bbl_session_get_by_mac(&interfaces[macs[i][1]], macs[i]);
+                break;
+            default:
+                session = bbl_session_get_by_mac(NULL, macs[i]);
+                break;
+        }
+        if(session && session->hot->session_state == BBL_ESTABLISHED) {
+            session->hot->packets_rx++;
+            hits++;
+        }
+    }
+    start = (bench_cpu_time() - start) * 1e9 / lookups;
+    if(hits != lookups) {
+        fprintf(stderr, "Error: %lu of %u lookups failed\n", lookups - hits, lookups);
+        exit(1);
+    }
+    g_result += hits;
+    return start;
+}
+
+static void
+bench_session_id(uint32_t sessions, uint8_t bits, bench_scheme_t scheme, uint32_t lookups)
+{
+    bbl_ctx_s ctx = {0};
+    bbl_access_interface_s interfaces[BENCH_INTERFACES] = {0};
+    uint8_t (*macs)[ETH_ADDR_LEN];
+    uint32_t targets[] = { 256*1024, 4*1024 };
+    double ns[2];
+    size_t size, hot_size;
+    uint32_t session_id;
+    uint32_t i, t, s;
+
+    g_ctx = &ctx;
+    g_ctx->config.sessions = sessions;
+    g_ctx->config.session_id_bits = bits;
+    g_ctx->config.session_id_interface = scheme == BENCH_INTERFACE;
+    if(!bbl_session_id_init()) {
+        exit(1);
+    }
+    size = (size_t)sessions * sizeof(bbl_session_s);
+    g_ctx->session_list = mmap(NULL, size, PROT_READ|PROT_WRITE,
+                               MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    hot_size = (size_t)sessions * sizeof(bbl_session_hot_s);
+    g_ctx->session_hot = mmap(NULL, hot_size, PROT_READ|PROT_WRITE,
+                              MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    macs = calloc(lookups, ETH_ADDR_LEN);
+    if(g_ctx->session_list == MAP_FAILED || g_ctx->session_hot == MAP_FAILED || !macs) {
+        exit(1);
+    }
+    g_ctx->sessions = sessions;
+
+    /* Sessions are assigned round robin to the interfaces
+     * as with multiple access interfaces per configuration. */
+    if(scheme == BENCH_INTERFACE) {
+        for(i = 0; i < BENCH_INTERFACES; i++) {
+            interfaces[i].index = i;
+            interfaces[i].sessions = sessions / BENCH_INTERFACES;
+            interfaces[i].session_list = calloc(interfaces[i].sessions, sizeof(bbl_session_s*));
+            if(!interfaces[i].session_list) {
+                exit(1);
+            }
+            g_ctx->access_interface_index[i] = &interfaces[i];
+        }
+        for(s = 0; s < sessions; s++) {
+            interfaces[s % BENCH_INTERFACES].session_list[s / BENCH_INTERFACES] = &g_ctx->session_list[s];
+        }
+    }
+
+    for(t = 0; t < 2; t++) {
+        for(i = 0; i < lookups; i++) {
+            s = (rand() % targets[t]) * (sessions / targets[t]);
+            g_ctx->session_list[s].hot = &g_ctx->session_hot[s];
+            g_ctx->session_hot[s].session_state = BBL_ESTABLISHED;
+            session_id = s + 1;
+            if(scheme == BENCH_INTERFACE) {
+                session_id = s / BENCH_INTERFACES + 1;
+                macs[i][1] = s % BENCH_INTERFACES;
+            }
+            macs[i][0] = 0x02;
+            macs[i][2] = session_id >> 24;
+            macs[i][3] = session_id >> 16;
+            macs[i][4] = session_id >> 8;
+            macs[i][5] = session_id;
+        }
+        ns[t] = bench_session_id_run(macs, lookups, scheme, interfaces);
+    }
+
+    printf("%9u %10s %5u %10.1f %10.1f\n", sessions,
+           bench_scheme_names[scheme], bits, ns[0], ns[1]);
+
+    for(i = 0; i < BENCH_INTERFACES; i++) {
+        free(interfaces[i].session_list);
+    }
+    free(g_ctx->access_interface_index);
+    free(macs);
+    munmap(g_ctx->session_list, size);
+    munmap(g_ctx->session_hot, hot_size);
+    g_ctx = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t lookups = 4000000;
+
+    if(argc > 1) lookups = strtoul(argv[1], NULL, 10);
+    if(!lookups) lookups = 1;
+
+    printf("%u lookups, ns per packet (random = 256K sessions, hot = 4K sessions)\n", lookups);
+    printf("%9s %10s %5s %10s %10s\n", "sessions", "scheme", "bits", "random", "hot");
+    bench_session_id(1 << 20, 24, BENCH_LEGACY, lookups);
+    bench_session_id(1 << 20, 24, BENCH_GLOBAL, lookups);
+    bench_session_id(1 << 20, 24, BENCH_INTERFACE, lookups);
+    bench_session_id(1 << 24, 32, BENCH_GLOBAL, lookups);
+    bench_session_id(1 << 24, 24, BENCH_INTERFACE, lookups);
+    return 0;
+}
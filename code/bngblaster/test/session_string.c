@@ -0,0 +1,205 @@
+/*
+ * BNG Blaster (BBL) - Session String Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <bbl.h>
+
+bbl_ctx_s *g_ctx = NULL;
+
+static char *
+session_string(bbl_access_config_s *access_config, bbl_session_s *session,
+               char *username, char *buf)
+{
+    access_config->username = username;
+    assert_true(bbl_session_templates_compile(access_config));
+    session->access_config = access_config;
+    return bbl_session_string(session, SESSION_STRING_USERNAME, buf);
+}
+
+static void
+test_session_string_variables(void **unused) {
+    (void) unused;
+
+    bbl_access_config_s access_config = {0};
+    bbl_session_hot_s hot = {0};
+    bbl_session_s session = { .hot = &hot };
+    char buf[SUB_STR_LEN];
+
+    session.session_id = 7;
+    session.access_config_session_id = 3;
+    session.hot->vlan_key.outer_vlan_id = 10;
+    session.hot->vlan_key.inner_vlan_id = 4094;
+    access_config.i1 = 100;
+    access_config.i1_step = 2;
+    access_config.i2 = 5;
+    access_config.i2_step = 10;
+
+    assert_string_equal(session_string(&access_config, &session,
+        "{session-global}:{session}:{i1}:{i2}:{outer-vlan}:{inner-vlan}", buf),
+        "7:3:104:25:10:4094");
+    assert_int_equal(access_config.string[SESSION_STRING_USERNAME].tokens, 11);
+    bbl_session_templates_free(&access_config);
+
+    /* Literals before and after variables. */
+    assert_string_equal(session_string(&access_config, &session,
+        "user{session-global}@rtbrick.com", buf), "user7@rtbrick.com");
+    bbl_session_templates_free(&access_config);
+}
+
+static void
+test_session_string_adjacent(void **unused) {
+    (void) unused;
+
+    bbl_access_config_s access_config = {0};
+    bbl_session_hot_s hot = {0};
+    bbl_session_s session = { .hot = &hot };
+    char buf[SUB_STR_LEN];
+
+    session.session_id = 1;
+    session.access_config_session_id = 1;
+    session.hot->vlan_key.outer_vlan_id = 1;
+    session.hot->vlan_key.inner_vlan_id = 2;
+
+    assert_string_equal(session_string(&access_config, &session,
+        "{outer-vlan}{inner-vlan}", buf), "12");
+    assert_int_equal(access_config.string[SESSION_STRING_USERNAME].tokens, 2);
+    bbl_session_templates_free(&access_config);
+
+    assert_string_equal(session_string(&access_config, &session,
+        "{session}{session}{session-global}", buf), "111");
+    bbl_session_templates_free(&access_config);
+}
+
+static void
+test_session_string_unknown(void **unused) {
+    (void) unused;
+
+    bbl_access_config_s access_config = {0};
+    bbl_session_hot_s hot = {0};
+    bbl_session_s session = { .hot = &hot };
+    char buf[SUB_STR_LEN];
+
+    session.session_id = 1;
+    session.access_config_session_id = 2;
+
+    /* Unknown or incomplete variables are kept as literal. */
+    assert_string_equal(session_string(&access_config, &session,
+        "user{foo}@{session}", buf), "user{foo}@2");
+    bbl_session_templates_free(&access_config);
+    assert_string_equal(session_string(&access_config, &session,
+        "{{session}}", buf), "{2}");
+    bbl_session_templates_free(&access_config);
+    assert_string_equal(session_string(&access_config, &session,
+        "{session", buf), "{session");
+    bbl_session_templates_free(&access_config);
+    assert_string_equal(session_string(&access_config, &session,
+        "{SESSION}{i3}{", buf), "{SESSION}{i3}{");
+    bbl_session_templates_free(&access_config);
+
+    /* Strings without variables are not rendered. */
+    access_config.username = "user";
+    assert_true(bbl_session_templates_compile(&access_config));
+    assert_ptr_equal(bbl_session_string(&session, SESSION_STRING_USERNAME, buf), access_config.username);
+    assert_true(access_config.string[SESSION_STRING_USERNAME].literal);
+
+    /* Not configured */
+    assert_null(bbl_session_string(&session, SESSION_STRING_PASSWORD, buf));
+    assert_null(bbl_session_string(&session, SESSION_STRING_MAX, buf));
+    bbl_session_templates_free(&access_config);
+}
+
+static void
+test_session_string_truncate(void **unused) {
+    (void) unused;
+
+    bbl_access_config_s access_config = {0};
+    bbl_session_hot_s hot = {0};
+    bbl_session_s session = { .hot = &hot };
+    char source[SUB_STR_LEN+32];
+    char buf[SUB_STR_LEN+1];
+    size_t len;
+
+    session.session_id = 123456;
+    session.access_config_session_id = 1;
+
+    /* Literal longer than the buffer. */
+    memset(source, 'a', SUB_STR_LEN+16);
+    strcpy(source+SUB_STR_LEN+16, "{session}");
+    memset(buf, 'x', sizeof(buf));
+    assert_ptr_equal(session_string(&access_config, &session, source, buf), buf);
+    assert_int_equal(strlen(buf), SUB_STR_LEN-1);
+    assert_int_equal(buf[SUB_STR_LEN], 'x');
+    bbl_session_templates_free(&access_config);
+
+    /* Variable truncated at the end of the buffer. */
+    len = SUB_STR_LEN-4;
+    memset(source, 'a', len);
+    strcpy(source+len, "{session-global}");
+    memset(buf, 'x', sizeof(buf));
+    session_string(&access_config, &session, source, buf);
+    assert_int_equal(strlen(buf), SUB_STR_LEN-1);
+    assert_string_equal(buf+len, "123");
+    assert_int_equal(buf[SUB_STR_LEN], 'x');
+    bbl_session_templates_free(&access_config);
+
+    /* Exactly filling the buffer. */
+    len = SUB_STR_LEN-7;
+    strcpy(source+len, "{session-global}");
+    session_string(&access_config, &session, source, buf);
+    assert_int_equal(strlen(buf), SUB_STR_LEN-1);
+    assert_string_equal(buf+len, "123456");
+    bbl_session_templates_free(&access_config);
+}
+
+static void
+test_session_string_iterator(void **unused) {
+    (void) unused;
+
+    bbl_access_config_s access_config = {0};
+    bbl_session_hot_s hot = {0};
+    bbl_session_s session = { .hot = &hot };
+    char buf[SUB_STR_LEN];
+
+    access_config.i1 = 1;
+    access_config.i1_step = 1;
+    access_config.i2 = 1000;
+    access_config.i2_step = 0;
+
+    /* The first session of the access configuration
+     * starts with the configured values. */
+    session.access_config_session_id = 1;
+    assert_string_equal(session_string(&access_config, &session, "{i1}-{i2}", buf), "1-1000");
+    session.access_config_session_id = 2;
+    assert_string_equal(bbl_session_string(&session, SESSION_STRING_USERNAME, buf), "2-1000");
+    session.access_config_session_id = 1000;
+    assert_string_equal(bbl_session_string(&session, SESSION_STRING_USERNAME, buf), "1000-1000");
+
+    /* Steps are applied per session of the access
+     * configuration, independent of the global session. */
+    access_config.i1 = 10;
+    access_config.i1_step = 10;
+    access_config.i2 = 4294967295;
+    access_config.i2_step = 1;
+    session.session_id = 100;
+    session.access_config_session_id = 5;
+    assert_string_equal(bbl_session_string(&session, SESSION_STRING_USERNAME, buf), "50-3");
+    bbl_session_templates_free(&access_config);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_session_string_variables),
+        cmocka_unit_test(test_session_string_adjacent),
+        cmocka_unit_test(test_session_string_unknown),
+        cmocka_unit_test(test_session_string_truncate),
+        cmocka_unit_test(test_session_string_iterator),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,232 @@
+/*
+ * BNG Blaster (BBL) - Stream TX Update Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <bbl.h>
+#include <bbl_stream.h>
+
+#define L3_OFFSET   (14 + 40) /* Ethernet + IPv6 */
+#define L4_LEN_MAX  1500
+
+bbl_ctx_s *g_ctx = NULL;
+
+static bbl_ctx_s ctx;
+static uint8_t tx_buf[L3_OFFSET + L4_LEN_MAX];
+
+/* Stream TX buffer with L4 header and payload
+ * ending with the BBL header. */
+static uint8_t *
+stream_init(bbl_stream_s *stream, bbl_stream_packet_s *packet, bool tcp, bool ipv6, uint16_t l4_len)
+{
+    uint16_t hdr_len = tcp ? TCP_HDR_LEN_MIN : UDP_HDR_LEN;
+    uint8_t *l4 = tx_buf + L3_OFFSET;
+    uint8_t *bbl = l4 + l4_len - BBL_HEADER_LEN;
+    uint16_t i;
+
+    memset(&ctx, 0x0, sizeof(ctx));
+    ctx.config.stream_udp_checksum = true;
+    g_ctx = &ctx;
+
+    memset(stream, 0x0, sizeof(bbl_stream_s));
+    memset(packet, 0x0, sizeof(bbl_stream_packet_s));
+    packet->ipv6 = ipv6;
+    packet->ipv4_src = htobe32(0x0a000001);
+    packet->ipv4_dst = htobe32(0xc0a80102);
+    for(i = 0; i < IPV6_ADDR_LEN; i++) {
+        packet->ipv6_src[i] = 0x20 + i;
+        packet->ipv6_dst[i] = 0xfe - i;
+    }
+
+    for(i = 0; i < l4_len; i++) {
+        l4[i] = i * 7;
+    }
+    *(uint16_t*)l4 = htobe16(BBL_UDP_PORT);
+    *(uint16_t*)(l4+2) = htobe16(BBL_UDP_PORT);
+    if(tcp) {
+        l4[12] = 0x50; /* data offset */
+        l4[13] = 0x10; /* ACK */
+        *(uint16_t*)(l4+16) = 0;
+    } else {
+        *(uint16_t*)(l4+4) = htobe16(l4_len);
+        *(uint16_t*)(l4+6) = 0;
+    }
+    *(uint64_t*)bbl = BBL_MAGIC_NUMBER;
+
+    stream->tcp = tcp;
+    stream->flow_seq = 1;
+    stream->tx_packet = packet;
+    stream->tx_buf = tx_buf;
+    stream->tx_len = L3_OFFSET + l4_len;
+    stream->tx_bbl_hdr_len = l4_len - hdr_len;
+    stream->tx_version = 1;
+    return l4;
+}
+
+/* Checksum calculated over the full L4 header and payload. */
+static uint16_t
+checksum_full(bbl_stream_s *stream, uint8_t *l4, uint16_t l4_len)
+{
+    bbl_stream_packet_s *packet = stream->tx_packet;
+    uint8_t copy[L4_LEN_MAX];
+    uint16_t offset = stream->tcp ? 16 : 6;
+
+    memcpy(copy, l4, l4_len);
+    *(uint16_t*)(copy+offset) = 0;
+    if(stream->tcp) {
+        if(packet->ipv6) {
+            return bbl_ipv6_tcp_checksum(packet->ipv6_src, packet->ipv6_dst, copy, l4_len);
+        }
+        return bbl_ipv4_tcp_checksum(packet->ipv4_src, packet->ipv4_dst, copy, l4_len);
+    }
+    if(packet->ipv6) {
+        return bbl_ipv6_udp_checksum(packet->ipv6_src, packet->ipv6_dst, copy, l4_len);
+    }
+    return bbl_ipv4_udp_checksum(packet->ipv4_src, packet->ipv4_dst, copy, l4_len);
+}
+
+static void
+assert_checksum(bbl_stream_s *stream, uint8_t *l4, uint16_t l4_len)
+{
+    uint16_t checksum = *(uint16_t*)(l4 + (stream->tcp ? 16 : 6));
+    uint16_t expected = checksum_full(stream, l4, l4_len);
+
+    /* 0x0000 and 0xffff are equal in ones' complement. */
+    if(checksum == 0xffff) checksum = 0;
+    if(expected == 0xffff) expected = 0;
+    assert_int_equal(checksum, expected);
+}
+
+/* Send packets with changing sequence and timestamp. */
+static void
+stream_send(bbl_stream_s *stream, uint8_t *l4, uint16_t l4_len, uint16_t packets)
+{
+    struct timespec timestamp = { .tv_sec = 1700000000, .tv_nsec = 999999000 };
+    uint8_t *bbl = l4 + l4_len - BBL_HEADER_LEN;
+
+    while(packets--) {
+        bbl_stream_tx_update(stream, &timestamp);
+        assert_int_equal(*(uint64_t*)(bbl+32), stream->flow_seq);
+        assert_int_equal(*(uint32_t*)(bbl+40), timestamp.tv_sec);
+        assert_int_equal(*(uint32_t*)(bbl+44), timestamp.tv_nsec);
+        assert_int_equal(stream->tx_checksum_version, stream->tx_version);
+        assert_checksum(stream, l4, l4_len);
+
+        stream->flow_seq += 0xff01;
+        timestamp.tv_nsec += 333333;
+        if(timestamp.tv_nsec >= SEC) {
+            timestamp.tv_nsec -= SEC;
+            timestamp.tv_sec++;
+        }
+    }
+}
+
+static void
+test_stream_update_udp(void **unused) {
+    (void) unused;
+
+    bbl_stream_s stream;
+    bbl_stream_packet_s packet;
+    uint8_t *l4;
+    uint16_t l4_len;
+    int ipv6;
+
+    for(ipv6 = 0; ipv6 < 2; ipv6++) {
+        for(l4_len = UDP_HDR_LEN + BBL_HEADER_LEN; l4_len <= L4_LEN_MAX; l4_len++) {
+            l4 = stream_init(&stream, &packet, false, ipv6, l4_len);
+            /* The first packet calculates the full checksum,
+             * followed by incremental updates. */
+            stream_send(&stream, l4, l4_len, 4);
+        }
+    }
+}
+
+static void
+test_stream_update_udp_disabled(void **unused) {
+    (void) unused;
+
+    bbl_stream_s stream;
+    bbl_stream_packet_s packet;
+    struct timespec timestamp = { .tv_sec = 1, .tv_nsec = 2 };
+    uint8_t *l4;
+
+    l4 = stream_init(&stream, &packet, false, false, 1500);
+    g_ctx->config.stream_udp_checksum = false;
+    bbl_stream_tx_update(&stream, &timestamp);
+    assert_int_equal(*(uint16_t*)(l4+6), 0);
+    assert_int_equal(stream.tx_checksum_version, 0);
+}
+
+static void
+test_stream_update_tcp(void **unused) {
+    (void) unused;
+
+    bbl_stream_s stream;
+    bbl_stream_packet_s packet;
+    uint8_t *l4;
+    uint16_t l4_len;
+    int ipv6;
+
+    for(ipv6 = 0; ipv6 < 2; ipv6++) {
+        for(l4_len = TCP_HDR_LEN_MIN + BBL_HEADER_LEN; l4_len <= L4_LEN_MAX; l4_len++) {
+            l4 = stream_init(&stream, &packet, true, ipv6, l4_len);
+            stream_send(&stream, l4, l4_len, 2);
+            assert_int_equal(l4[13], 0x10);
+
+            /* TCP flags set with full checksum. */
+            l4 = stream_init(&stream, &packet, true, ipv6, l4_len);
+            stream.tcp_flags = 0x12;
+            stream_send(&stream, l4, l4_len, 2);
+            assert_int_equal(l4[12], 0x50);
+            assert_int_equal(l4[13], 0x12);
+
+            /* TCP flags changed with incremental checksum. */
+            stream.tcp_flags = 0x04;
+            stream_send(&stream, l4, l4_len, 2);
+            assert_int_equal(l4[12], 0x50);
+            assert_int_equal(l4[13], 0x04);
+        }
+    }
+}
+
+static void
+test_stream_update_rebuild(void **unused) {
+    (void) unused;
+
+    bbl_stream_s stream;
+    bbl_stream_packet_s packet;
+    uint8_t *l4;
+    uint16_t l4_len;
+    int tcp;
+
+    for(tcp = 0; tcp < 2; tcp++) {
+        for(l4_len = 100; l4_len <= L4_LEN_MAX; l4_len += 100) {
+            l4 = stream_init(&stream, &packet, tcp, false, l4_len);
+            stream_send(&stream, l4, l4_len, 2);
+
+            /* A new TX buffer (e.g. changed session addresses)
+             * invalidates the checksum, which must be calculated
+             * over the full L4 header and payload again. */
+            packet.ipv4_src = htobe32(0x0a000002);
+            l4[l4_len/2]++;
+            stream.tx_version++;
+            stream_send(&stream, l4, l4_len, 2);
+        }
+    }
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_stream_update_udp),
+        cmocka_unit_test(test_stream_update_udp_disabled),
+        cmocka_unit_test(test_stream_update_tcp),
+        cmocka_unit_test(test_stream_update_rebuild),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
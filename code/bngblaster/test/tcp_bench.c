@@ -0,0 +1,440 @@
+/*
+ * BNG Blaster (BBL) - TCP Micro-Benchmark
+ *
+ * Measure how many concurrent TCP connections and how much
+ * goodput a single core sustains with the BNG Blaster LwIP
+ * configuration. All client connections share one interface
+ * and are demultiplexed by the session stored in the PCB
+ * extended argument (TX) and by the session of the received
+ * packet (RX) as done for session TCP connections. 
+ * Packets are exchanged with a server interface through an
+ * in-memory wire, both running on the same core.
+ *
+ * The RX demultiplexing by session can be disabled (demux 0)
+ * to measure the LwIP search of all active connections.
+ *
+ * Usage: bench-tcp [connections] [bytes per connection] [demux]
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/init.h"
+#include "lwip/ip.h"
+#include "lwip/netif.h"
+#include "lwip/tcp.h"
+#include "lwip/timeouts.h"
+#include "lwip/priv/tcp_priv.h"
+
+#define BENCH_SERVER_ADDRESS 0x0a000001 /* 10.0.0.1 */
+#define BENCH_CLIENT_ADDRESS 0x0b000000 /* 11.0.0.0 */
+#define BENCH_SERVER_PORT 80
+#define BENCH_CLIENT_PORT 49152
+#define BENCH_MTU 1500
+
+typedef struct bench_frame_ {
+    struct netif *netif;
+    struct bench_frame_ *next;
+    uint16_t len;
+    uint8_t data[];
+} bench_frame_s;
+
+typedef struct bench_session_ {
+    uint32_t id;
+    struct tcp_pcb *pcb;
+    struct tcp_pcb *server_pcb;
+    uint32_t offset;
+    bool connected;
+} bench_session_s;
+
+static struct {
+    struct netif client;
+    struct netif server;
+    uint8_t session_arg_id;
+
+    bench_frame_s *head;
+    bench_frame_s *tail;
+
+    bench_session_s *sessions;
+    bench_session_s *session_rx;
+    uint32_t connections;
+    bool demux;
+    uint32_t bytes;
+    uint8_t *buf;
+
+    uint32_t connected;
+    uint32_t accepted;
+    uint32_t completed;
+    uint64_t bytes_rx;
+    uint64_t packets;
+    uint64_t client_packets;
+    uint64_t client_nsec;
+    uint64_t demux_failed;
+    uint64_t errors;
+} g_bench = {0};
+
+/* Session demultiplexing as in bbl_tcp.c */
+u32_t *
+bbl_tcp_lwip_out_hook(struct pbuf *p, const struct tcp_pcb *pcb, u32_t *opts)
+{
+    if(pcb) {
+        p->session = tcp_ext_arg_get(pcb, g_bench.session_arg_id);
+    }
+    return opts;
+}
+
+static bool
+bench_pcb_match(struct tcp_pcb *pcb, const struct tcp_hdr *hdr)
+{
+    return pcb && pcb->state != CLOSED && pcb->state != LISTEN && pcb->state != TIME_WAIT &&
+           pcb->remote_port == hdr->src &&
+           pcb->local_port == hdr->dest &&
+           ip_addr_eq(&pcb->remote_ip, ip_current_src_addr()) &&
+           ip_addr_eq(&pcb->local_ip, ip_current_dest_addr());
+}
+
+/* Connections of the receiving session as in bbl_tcp.c, 
+ * the server connections are indexed by client address. 
+ * Only the SYN received by the server is demultiplexed by 
+ * LwIP (listen), which is not the case with BNG Blaster 
+ * where the server is the device under test. */
+struct tcp_pcb *
+bbl_tcp_lwip_in_hook(const struct tcp_hdr *hdr, struct netif *inp)
+{
+    bench_session_s *session = g_bench.session_rx;
+    struct tcp_pcb *pcb;
+
+    if(!(g_bench.demux && session)) {
+        return NULL;
+    }
+    pcb = (inp == &g_bench.client) ? session->pcb : session->server_pcb;
+    if(bench_pcb_match(pcb, hdr)) {
+        return pcb;
+    }
+    return NULL;
+}
+
+static bench_session_s *
+bench_session(uint32_t address)
+{
+    uint32_t id = lwip_ntohl(address) - BENCH_CLIENT_ADDRESS;
+    if(id && id <= g_bench.connections) {
+        return &g_bench.sessions[id-1];
+    }
+    return NULL;
+}
+
+/* Also called for new server connections (SYN-RCVD), which 
+ * are used for the server side demultiplexing before accepted. */
+u16_t
+bbl_tcp_lwip_mss_hook(const struct tcp_pcb *pcb, u16_t mss)
+{
+    bench_session_s *session;
+
+    if(pcb->state == SYN_RCVD) {
+        session = bench_session(ip_2_ip4(&pcb->remote_ip)->addr);
+        if(session) {
+            session->server_pcb = (struct tcp_pcb*)pcb;
+        }
+    }
+    return mss;
+}
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t
+bench_time_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static err_t
+bench_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    bench_frame_s *frame;
+    (void) ipaddr;
+
+    if(netif == &g_bench.client && !p->session) {
+        g_bench.demux_failed++;
+        return ERR_RTE;
+    }
+    frame = malloc(sizeof(bench_frame_s) + p->tot_len);
+    if(!frame) {
+        return ERR_MEM;
+    }
+    frame->netif = (netif == &g_bench.client) ? &g_bench.server : &g_bench.client;
+    frame->next = NULL;
+    frame->len = pbuf_copy_partial(p, frame->data, p->tot_len, 0);
+    if(g_bench.tail) {
+        g_bench.tail->next = frame;
+    } else {
+        g_bench.head = frame;
+    }
+    g_bench.tail = frame;
+    return ERR_OK;
+}
+
+static err_t
+bench_netif_init(struct netif *netif)
+{
+    netif->output = bench_output;
+    netif->mtu = BENCH_MTU;
+    netif_set_up(netif);
+    return ERR_OK;
+}
+
+/* Deliver frame to TCP as done in bbl_tcp_ipv4_rx. */
+static void
+bench_deliver(bench_frame_s *frame)
+{
+    struct ip_hdr *iphdr = (struct ip_hdr*)frame->data;
+    uint16_t hlen = IPH_HL_BYTES(iphdr);
+    struct pbuf *p;
+    uint64_t start = bench_time_nsec();
+
+    ip_data.current_netif = frame->netif;
+    ip_data.current_input_netif = frame->netif;
+    ip_data.current_iphdr_dest.type = IPADDR_TYPE_V4;
+    ip_data.current_iphdr_dest.u_addr.ip4.addr = iphdr->dest.addr;
+    ip_data.current_iphdr_src.type = IPADDR_TYPE_V4;
+    ip_data.current_iphdr_src.u_addr.ip4.addr = iphdr->src.addr;
+
+    if(frame->netif == &g_bench.client) {
+        g_bench.session_rx = bench_session(iphdr->dest.addr);
+    } else {
+        g_bench.session_rx = bench_session(iphdr->src.addr);
+    }
+
+    p = pbuf_alloc_reference(frame->data + hlen, frame->len - hlen, PBUF_ROM);
+    tcp_input(p, frame->netif);
+    g_bench.session_rx = NULL;
+    g_bench.packets++;
+    if(frame->netif == &g_bench.client) {
+        /* Receive path of BNG Blaster */
+        g_bench.client_nsec += bench_time_nsec() - start;
+        g_bench.client_packets++;
+    }
+}
+
+static bool
+bench_run()
+{
+    bench_frame_s *frame;
+    bool work = false;
+
+    while(g_bench.head) {
+        frame = g_bench.head;
+        g_bench.head = frame->next;
+        if(!g_bench.head) {
+            g_bench.tail = NULL;
+        }
+        bench_deliver(frame);
+        free(frame);
+        work = true;
+    }
+    sys_check_timeouts();
+    return work;
+}
+
+static void
+bench_send(bench_session_s *session)
+{
+    uint32_t tx;
+
+    while(session->offset < g_bench.bytes) {
+        tx = tcp_sndbuf(session->pcb);
+        if(!tx) break;
+        if(tx > 16384) tx = 16384;
+        if(tx > g_bench.bytes - session->offset) {
+            tx = g_bench.bytes - session->offset;
+        }
+        if(tcp_write(session->pcb, g_bench.buf + session->offset, tx, 0) != ERR_OK) {
+            break;
+        }
+        session->offset += tx;
+    }
+    tcp_output(session->pcb);
+}
+
+static err_t
+bench_client_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
+{
+    bench_session_s *session = arg;
+    (void) tpcb;
+    (void) len;
+
+    if(session->offset < g_bench.bytes) {
+        bench_send(session);
+    } else if(!(tpcb->unacked || tpcb->unsent)) {
+        g_bench.completed++;
+    }
+    return ERR_OK;
+}
+
+static err_t
+bench_client_connected(void *arg, struct tcp_pcb *tpcb, err_t err)
+{
+    bench_session_s *session = arg;
+    (void) tpcb;
+    (void) err;
+
+    session->connected = true;
+    g_bench.connected++;
+    return ERR_OK;
+}
+
+static void
+bench_client_error(void *arg, err_t err)
+{
+    bench_session_s *session = arg;
+    (void) err;
+
+    session->pcb = NULL;
+    g_bench.errors++;
+}
+
+static err_t
+bench_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+    (void) arg;
+    (void) err;
+
+    if(p) {
+        g_bench.bytes_rx += p->tot_len;
+        tcp_recved(tpcb, p->tot_len);
+        pbuf_free(p);
+    }
+    return ERR_OK;
+}
+
+static err_t
+bench_server_accept(void *arg, struct tcp_pcb *tpcb, err_t err)
+{
+    (void) arg;
+    if(err != ERR_OK || !tpcb) {
+        return ERR_VAL;
+    }
+    tcp_recv(tpcb, bench_server_recv);
+    g_bench.accepted++;
+    return ERR_OK;
+}
+
+int main(int argc, char *argv[]) {
+    ip4_addr_t addr, mask, gw;
+    ip_addr_t local, remote;
+    struct tcp_pcb *pcb;
+    bench_session_s *session;
+    double start, connect, transfer;
+    uint32_t i;
+
+    g_bench.connections = 10000;
+    g_bench.bytes = 65536;
+    g_bench.demux = true;
+    if(argc > 1) g_bench.connections = strtoul(argv[1], NULL, 10);
+    if(argc > 2) g_bench.bytes = strtoul(argv[2], NULL, 10);
+    if(argc > 3) g_bench.demux = strtoul(argv[3], NULL, 10);
+    if(!g_bench.connections) g_bench.connections = 1;
+
+    g_bench.sessions = calloc(g_bench.connections, sizeof(bench_session_s));
+    g_bench.buf = malloc(g_bench.bytes + 1);
+    if(!(g_bench.sessions && g_bench.buf)) {
+        exit(1);
+    }
+    memset(g_bench.buf, 'x', g_bench.bytes);
+
+    lwip_init();
+    g_bench.session_arg_id = tcp_ext_arg_alloc_id();
+
+    ip4_addr_set_zero(&gw);
+    ip4_addr_set_zero(&mask);
+    ip4_addr_set_zero(&addr);
+    netif_add(&g_bench.client, &addr, &mask, &gw, NULL, bench_netif_init, ip_input);
+    addr.addr = lwip_htonl(BENCH_SERVER_ADDRESS);
+    netif_add(&g_bench.server, &addr, &mask, &gw, NULL, bench_netif_init, ip_input);
+
+    /* Server */
+    pcb = tcp_new();
+    tcp_bind_netif(pcb, &g_bench.server);
+    tcp_bind(pcb, IP4_ADDR_ANY, BENCH_SERVER_PORT);
+    pcb = tcp_listen_with_backlog(pcb, 255);
+    tcp_accept(pcb, bench_server_accept);
+
+    /* Clients */
+    printf("%u connections, %u bytes per connection, %s demux\n", g_bench.connections, g_bench.bytes,
+           g_bench.demux ? "session" : "linear");
+    remote = (ip_addr_t)IPADDR4_INIT(lwip_htonl(BENCH_SERVER_ADDRESS));
+    start = bench_cpu_time();
+    for(i = 0; i < g_bench.connections; i++) {
+        session = &g_bench.sessions[i];
+        session->id = i+1;
+        session->pcb = tcp_new();
+        if(!session->pcb) {
+            g_bench.errors++;
+            continue;
+        }
+        tcp_bind_netif(session->pcb, &g_bench.client);
+        tcp_ext_arg_set(session->pcb, g_bench.session_arg_id, session);
+        tcp_arg(session->pcb, session);
+        tcp_err(session->pcb, bench_client_error);
+        tcp_sent(session->pcb, bench_client_sent);
+        tcp_nagle_disable(session->pcb);
+        local = (ip_addr_t)IPADDR4_INIT(lwip_htonl(BENCH_CLIENT_ADDRESS + session->id));
+        /* Bind without address-in-use check as in bbl_tcp_session_bind. */
+        ip_addr_set(&session->pcb->local_ip, &local);
+        session->pcb->local_port = BENCH_CLIENT_PORT;
+        TCP_REG(&tcp_bound_pcbs, session->pcb);
+        if(tcp_connect(session->pcb, &remote, BENCH_SERVER_PORT, bench_client_connected) != ERR_OK) {
+            g_bench.errors++;
+        }
+        /* Stay below the listen backlog. */
+        if((i & 0x7f) == 0x7f) {
+            bench_run();
+        }
+    }
+    while(bench_run());
+    connect = bench_cpu_time() - start;
+    printf("connect  %8.3fs  %u connected, %u accepted, %.1f us/connection, client rx %.0f ns/packet\n",
+           connect, g_bench.connected, g_bench.accepted,
+           g_bench.connected ? connect * 1e6 / g_bench.connected : 0,
+           g_bench.client_packets ? (double)g_bench.client_nsec / g_bench.client_packets : 0);
+
+    /* Transfer */
+    g_bench.packets = 0;
+    g_bench.client_packets = 0;
+    g_bench.client_nsec = 0;
+    start = bench_cpu_time();
+    for(i = 0; i < g_bench.connections; i++) {
+        session = &g_bench.sessions[i];
+        if(session->pcb && session->connected) {
+            bench_send(session);
+        }
+        if((i & 0xff) == 0xff) {
+            bench_run();
+        }
+    }
+    while(bench_run() || g_bench.bytes_rx < (uint64_t)g_bench.connected * g_bench.bytes) {
+        if(g_bench.errors) break;
+    }
+    transfer = bench_cpu_time() - start;
+    printf("transfer %8.3fs  %lu bytes, %lu packets, %.1f Mbit/s goodput, %.0f packets/s, client rx %.0f ns/packet\n",
+           transfer, g_bench.bytes_rx, g_bench.packets,
+           transfer > 0 ? g_bench.bytes_rx * 8 / transfer / 1e6 : 0,
+           transfer > 0 ? g_bench.packets / transfer : 0,
+           g_bench.client_packets ? (double)g_bench.client_nsec / g_bench.client_packets : 0);
+    printf("%lu errors, %lu demux failed\n", g_bench.errors, g_bench.demux_failed);
+    return 0;
+}
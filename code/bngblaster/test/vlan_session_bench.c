@@ -0,0 +1,165 @@
+/*
+ * BNG Blaster (BBL) - VLAN Session Lookup Micro-Benchmark
+ *
+ * Compare the previous libdict hashtable with the open
+ * addressing table used for VLAN to session lookups.
+ * Sessions are spread over 4 interfaces with 1:1 VLAN.
+ * Lookups hit sessions in random order or miss them
+ * (unknown VLAN) as for multicast and broadcast traffic.
+ *
+ * Usage: bench-vlan-session [lookups]
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <bbl_def.h>
+#include <hash64.h>
+
+typedef struct bench_vlan_key_ {
+    uint32_t ifindex;
+    uint16_t outer_vlan_id;
+    uint16_t inner_vlan_id;
+} __attribute__ ((__packed__)) bench_vlan_key_t;
+
+static volatile uintptr_t g_result = 0;
+
+static int
+bench_compare_key64(void *key1, void *key2)
+{
+    const uint64_t a = *(const uint64_t*)key1;
+    const uint64_t b = *(const uint64_t*)key2;
+    return (a > b) - (a < b);
+}
+
+static uint32_t
+bench_key64_hash(const void* k)
+{
+    uint32_t hash = 2166136261U;
+    hash ^= *(uint32_t *)k;
+    hash ^= *(uint16_t *)((uint8_t*)k+4) << 12;
+    hash ^= *(uint16_t *)((uint8_t*)k+6);
+    return hash;
+}
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t
+bench_key64(bench_vlan_key_t *key)
+{
+    uint64_t key64;
+    memcpy(&key64, key, sizeof(key64));
+    return key64;
+}
+
+static void
+bench_vlan_key(bench_vlan_key_t *key, uint32_t i)
+{
+    key->ifindex = i & 3;
+    key->outer_vlan_id = 1 + ((i >> 2) / 4094);
+    key->inner_vlan_id = 1 + ((i >> 2) % 4094);
+}
+
+static void
+bench_vlan_session(uint32_t sessions, uint32_t lookups)
+{
+    bench_vlan_key_t *keys;
+    uint64_t *lookup_keys;
+    dict *dict;
+    dict_insert_result result;
+    hash64_s table;
+    void **value;
+    bool inserted;
+    double start, dict_insert_ns, table_insert_ns;
+    double dict_hit_ns, table_hit_ns, dict_miss_ns, table_miss_ns;
+    uint32_t i;
+
+    keys = calloc(sessions, sizeof(bench_vlan_key_t));
+    lookup_keys = calloc(lookups, sizeof(uint64_t));
+    if(!(keys && lookup_keys)) {
+        exit(1);
+    }
+    for(i = 0; i < sessions; i++) {
+        bench_vlan_key(&keys[i], i);
+    }
+
+    /* Insert */
+    dict = hashtable_dict_new((dict_compare_func)bench_compare_key64, bench_key64_hash, BBL_SESSION_HASHTABLE_SIZE);
+    start = bench_cpu_time();
+    for(i = 0; i < sessions; i++) {
+        result = dict_insert(dict, &keys[i]);
+        *result.datum_ptr = &keys[i];
+    }
+    dict_insert_ns = (bench_cpu_time() - start) * 1e9 / sessions;
+
+    hash64_init(&table, 0);
+    start = bench_cpu_time();
+    for(i = 0; i < sessions; i++) {
+        value = hash64_insert(&table, bench_key64(&keys[i]), &inserted);
+        *value = &keys[i];
+    }
+    table_insert_ns = (bench_cpu_time() - start) * 1e9 / sessions;
+
+    /* Lookup existing sessions in random order */
+    for(i = 0; i < lookups; i++) {
+        lookup_keys[i] = bench_key64(&keys[rand() % sessions]);
+    }
+    start = bench_cpu_time();
+    for(i = 0; i < lookups; i++) {
+        value = dict_search(dict, &lookup_keys[i]);
+        g_result += (uintptr_t)*value;
+    }
+    dict_hit_ns = (bench_cpu_time() - start) * 1e9 / lookups;
+    start = bench_cpu_time();
+    for(i = 0; i < lookups; i++) {
+        value = hash64_search(&table, lookup_keys[i]);
+        g_result += (uintptr_t)*value;
+    }
+    table_hit_ns = (bench_cpu_time() - start) * 1e9 / lookups;
+
+    /* Lookup unknown VLAN (interface index 4) */
+    for(i = 0; i < lookups; i++) {
+        lookup_keys[i] |= 4;
+    }
+    start = bench_cpu_time();
+    for(i = 0; i < lookups; i++) {
+        g_result += (uintptr_t)dict_search(dict, &lookup_keys[i]);
+    }
+    dict_miss_ns = (bench_cpu_time() - start) * 1e9 / lookups;
+    start = bench_cpu_time();
+    for(i = 0; i < lookups; i++) {
+        g_result += (uintptr_t)hash64_search(&table, lookup_keys[i]);
+    }
+    table_miss_ns = (bench_cpu_time() - start) * 1e9 / lookups;
+
+    printf("%9u %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", sessions,
+           dict_insert_ns, table_insert_ns, dict_hit_ns, table_hit_ns,
+           dict_miss_ns, table_miss_ns);
+
+    dict_free(dict, NULL);
+    hash64_destroy(&table);
+    free(lookup_keys);
+    free(keys);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t sessions[] = { 1000, 64000, 256000, 1000000, 4000000 };
+    uint32_t lookups = 4000000;
+    size_t i;
+
+    if(argc > 1) lookups = strtoul(argv[1], NULL, 10);
+    if(!lookups) lookups = 1;
+
+    printf("%u lookups, ns per operation (dict = libdict hashtable, table = hash64)\n", lookups);
+    printf("%9s %10s %10s %10s %10s %10s %10s\n", "sessions",
+           "dict ins", "table ins", "dict hit", "table hit", "dict miss", "table miss");
+    for(i = 0; i < sizeof(sessions)/sizeof(sessions[0]); i++) {
+        bench_vlan_session(sessions[i], lookups);
+    }
+    return 0;
+}
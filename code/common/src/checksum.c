@@ -9,86 +9,515 @@
  */
 #include "checksum.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHECKSUM_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CHECKSUM_NEON
+#endif
+
+/* Buffers smaller than this are summed without SIMD. */
+#define CHECKSUM_SIMD_MIN_LEN 64
+
+/* Max SIMD blocks before 32 bit lanes are reduced,
+ * each lane adding two 16 bit words per block. */
+#define CHECKSUM_SIMD_MAX_BLOCKS 16384
+
+static inline uint32_t
+checksum_fold(uint64_t sum)
+{
+    while(sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum;
+}
+
+static inline uint64_t
+checksum_sum_tail(const uint8_t *pptr, size_t len, uint64_t sum)
+{
+    uint16_t word;
+    while(len > 1) {
+        memcpy(&word, pptr, sizeof(word));
+        sum += word;
+        pptr += 2;
+        len -= 2;
+    }
+    /* Add left-over byte, if any. */
+    if(len) {
+        sum += *pptr;
+    }
+    return sum;
+}
+
 /**
- * @brief validate_fletcher_checksum
- * 
- * Fletcher checksum verification. should return 0 if embedded checksum is correct.
- * Only used for debug purposes here.
+ * @brief checksum_sum_generic
+ *
+ * Internet checksum (RFC 1071) one's complement sum of 16 bit words 
+ * in host byte order, folded to 16 bits. The sum is built from 32 bit 
+ * words in a 64 bit accumulator, which is equal after folding. 
  */
-uint16_t
-validate_fletcher_checksum(const uint8_t *pptr, uint length)
+uint32_t
+checksum_sum_generic(const void *buf, size_t len)
 {
+    const uint8_t *pptr = buf;
+    uint64_t sum0 = 0, sum1 = 0;
+    uint32_t word0, word1;
 
-    uint64_t c0, c1;
-    uint idx;
+    while(len >= 8) {
+        memcpy(&word0, pptr, sizeof(word0));
+        memcpy(&word1, pptr+4, sizeof(word1));
+        sum0 += word0;
+        sum1 += word1;
+        pptr += 8;
+        len -= 8;
+    }
+    return checksum_fold(checksum_sum_tail(pptr, len, sum0 + sum1));
+}
+
+#if defined(CHECKSUM_X86)
+__attribute__((target("sse2")))
+static uint32_t
+checksum_sum_sse2(const void *buf, size_t len)
+{
+    const uint8_t *pptr = buf;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc, v;
+    uint32_t lanes[4];
+    uint64_t sum = 0;
+    size_t blocks;
+
+    while(len >= 16) {
+        blocks = len / 16;
+        if(blocks > CHECKSUM_SIMD_MAX_BLOCKS) {
+            blocks = CHECKSUM_SIMD_MAX_BLOCKS;
+        }
+        len -= blocks * 16;
+        acc = zero;
+        while(blocks--) {
+            v = _mm_loadu_si128((const __m128i*)pptr);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+            pptr += 16;
+        }
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return checksum_fold(checksum_sum_tail(pptr, len, sum));
+}
+
+__attribute__((target("avx2")))
+static uint32_t
+checksum_sum_avx2(const void *buf, size_t len)
+{
+    const uint8_t *pptr = buf;
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc, v;
+    uint32_t lanes[8];
+    uint64_t sum = 0;
+    size_t blocks;
+    int i;
+
+    while(len >= 32) {
+        blocks = len / 32;
+        if(blocks > CHECKSUM_SIMD_MAX_BLOCKS) {
+            blocks = CHECKSUM_SIMD_MAX_BLOCKS;
+        }
+        len -= blocks * 32;
+        acc = zero;
+        while(blocks--) {
+            v = _mm256_loadu_si256((const __m256i*)pptr);
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+            pptr += 32;
+        }
+        _mm256_storeu_si256((__m256i*)lanes, acc);
+        for(i = 0; i < 8; i++) {
+            sum += lanes[i];
+        }
+    }
+    return checksum_fold(checksum_sum_tail(pptr, len, sum));
+}
+#endif
+
+#if defined(CHECKSUM_NEON)
+static uint32_t
+checksum_sum_neon(const void *buf, size_t len)
+{
+    const uint8_t *pptr = buf;
+    uint32x4_t acc;
+    uint32_t lanes[4];
+    uint64_t sum = 0;
+    size_t blocks;
+
+    while(len >= 16) {
+        blocks = len / 16;
+        if(blocks > CHECKSUM_SIMD_MAX_BLOCKS) {
+            blocks = CHECKSUM_SIMD_MAX_BLOCKS;
+        }
+        len -= blocks * 16;
+        acc = vdupq_n_u32(0);
+        while(blocks--) {
+            acc = vpadalq_u16(acc, vreinterpretq_u16_u8(vld1q_u8(pptr)));
+            pptr += 16;
+        }
+        vst1q_u32(lanes, acc);
+        sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return checksum_fold(checksum_sum_tail(pptr, len, sum));
+}
+#endif
+
+/*
+ * Fletcher checksum sums over a buffer, continuing
+ * with c0 (sum of bytes) and c1 (sum of c0 after
+ * each byte). The SIMD versions process blocks of
+ * bytes with c1 += B * c0 + sum((B - i) * b[i]).
+ * Both sums are reduced modulo 255, which does not
+ * change the final checksum.
+ */
+static inline void
+checksum_fletcher_tail(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    uint64_t s0 = *c0;
+    uint64_t s1 = *c1;
+
+    while(len--) {
+        s0 += *pptr++;
+        s1 += s0;
+    }
+    *c0 = s0 % 255;
+    *c1 = s1 % 255;
+}
+
+static void
+checksum_fletcher_generic(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    uint64_t s0 = *c0;
+    uint64_t s1 = *c1;
+    size_t chunk;
+
+    while(len >= 10) {
+        /* Reduce after max 4000 bytes. */
+        chunk = len > 4000 ? 4000 : len - (len % 10);
+        len -= chunk;
+        /* 10x loop unrolling */
+        while(chunk) {
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            s0 += *pptr++;
+            s1 += s0;
+            chunk -= 10;
+        }
+        s0 %= 255;
+        s1 %= 255;
+    }
+    *c0 = s0;
+    *c1 = s1;
+    /* remainder */
+    checksum_fletcher_tail(pptr, len, c0, c1);
+}
+
+/* Max Fletcher SIMD blocks before 32 bit lanes are reduced. */
+#define CHECKSUM_FLETCHER_MAX_BLOCKS 1024
+
+#if defined(CHECKSUM_X86)
+__attribute__((target("sse2")))
+static void
+checksum_fletcher_sse2(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w_lo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i w_hi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+    __m128i vs0, vs1, vps, v;
+    uint32_t lanes[4];
+    uint64_t s0, s1, ps;
+    size_t blocks, n;
+
+    while(len >= 16) {
+        blocks = len / 16;
+        if(blocks > CHECKSUM_FLETCHER_MAX_BLOCKS) {
+            blocks = CHECKSUM_FLETCHER_MAX_BLOCKS;
+        }
+        len -= blocks * 16;
+        vs0 = vs1 = vps = zero;
+        for(n = 0; n < blocks; n++) {
+            v = _mm_loadu_si128((const __m128i*)pptr);
+            vps = _mm_add_epi32(vps, vs0);
+            vs0 = _mm_add_epi32(vs0, _mm_sad_epu8(v, zero));
+            vs1 = _mm_add_epi32(vs1, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), w_lo));
+            vs1 = _mm_add_epi32(vs1, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), w_hi));
+            pptr += 16;
+        }
+        _mm_storeu_si128((__m128i*)lanes, vs0);
+        s0 = (uint64_t)lanes[0] + lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, vps);
+        ps = (uint64_t)lanes[0] + lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, vs1);
+        s1 = (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        *c1 = (*c1 + *c0 * blocks * 16 + ps * 16 + s1) % 255;
+        *c0 = (*c0 + s0) % 255;
+    }
+    checksum_fletcher_tail(pptr, len, c0, c1);
+}
+
+__attribute__((target("avx2")))
+static void
+checksum_fletcher_avx2(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i w = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17,
+                                       16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    __m256i vs0, vs1, vps, v;
+    uint32_t lanes[8];
+    uint64_t s0, s1, ps;
+    size_t blocks, n;
+    int i;
+
+    while(len >= 32) {
+        blocks = len / 32;
+        if(blocks > CHECKSUM_FLETCHER_MAX_BLOCKS) {
+            blocks = CHECKSUM_FLETCHER_MAX_BLOCKS;
+        }
+        len -= blocks * 32;
+        vs0 = vs1 = vps = zero;
+        for(n = 0; n < blocks; n++) {
+            v = _mm256_loadu_si256((const __m256i*)pptr);
+            vps = _mm256_add_epi32(vps, vs0);
+            vs0 = _mm256_add_epi32(vs0, _mm256_sad_epu8(v, zero));
+            vs1 = _mm256_add_epi32(vs1, _mm256_madd_epi16(_mm256_maddubs_epi16(v, w), ones));
+            pptr += 32;
+        }
+        s0 = s1 = ps = 0;
+        _mm256_storeu_si256((__m256i*)lanes, vs0);
+        for(i = 0; i < 8; i += 2) {
+            s0 += lanes[i];
+        }
+        _mm256_storeu_si256((__m256i*)lanes, vps);
+        for(i = 0; i < 8; i += 2) {
+            ps += lanes[i];
+        }
+        _mm256_storeu_si256((__m256i*)lanes, vs1);
+        for(i = 0; i < 8; i++) {
+            s1 += lanes[i];
+        }
+        *c1 = (*c1 + *c0 * blocks * 32 + ps * 32 + s1) % 255;
+        *c0 = (*c0 + s0) % 255;
+    }
+    checksum_fletcher_tail(pptr, len, c0, c1);
+}
+#endif
+
+#if defined(CHECKSUM_NEON)
+static void
+checksum_fletcher_neon(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    static const uint8_t weights[16] = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+    const uint8x8_t w_lo = vld1_u8(weights);
+    const uint8x8_t w_hi = vld1_u8(weights+8);
+    uint32x4_t vs0, vs1, vps;
+    uint16x8_t t;
+    uint8x16_t v;
+    uint32_t lanes[4];
+    uint64_t s0, s1, ps;
+    size_t blocks, n;
+
+    while(len >= 16) {
+        blocks = len / 16;
+        if(blocks > CHECKSUM_FLETCHER_MAX_BLOCKS) {
+            blocks = CHECKSUM_FLETCHER_MAX_BLOCKS;
+        }
+        len -= blocks * 16;
+        vs0 = vs1 = vps = vdupq_n_u32(0);
+        for(n = 0; n < blocks; n++) {
+            v = vld1q_u8(pptr);
+            vps = vaddq_u32(vps, vs0);
+            vs0 = vpadalq_u16(vs0, vpaddlq_u8(v));
+            t = vmull_u8(vget_low_u8(v), w_lo);
+            t = vmlal_u8(t, vget_high_u8(v), w_hi);
+            vs1 = vpadalq_u16(vs1, t);
+            pptr += 16;
+        }
+        vst1q_u32(lanes, vs0);
+        s0 = (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        vst1q_u32(lanes, vps);
+        ps = (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        vst1q_u32(lanes, vs1);
+        s1 = (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        *c1 = (*c1 + *c0 * blocks * 16 + ps * 16 + s1) % 255;
+        *c0 = (*c0 + s0) % 255;
+    }
+    checksum_fletcher_tail(pptr, len, c0, c1);
+}
+#endif
+
+typedef uint32_t (*checksum_sum_fn)(const void *buf, size_t len);
+typedef void (*checksum_fletcher_fn)(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1);
+
+static uint32_t
+checksum_sum_resolve(const void *buf, size_t len);
+
+static void
+checksum_fletcher_resolve(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1);
+
+static checksum_sum_fn g_checksum_sum = checksum_sum_resolve;
+static checksum_fletcher_fn g_checksum_fletcher = checksum_fletcher_resolve;
+static const char *g_checksum_name = "generic";
 
-    c0 = 0;
-    c1 = 0;
+/**
+ * Select the fastest implementations supported
+ * by the CPU with the first call.
+ */
+static void
+checksum_resolve()
+{
+#if defined(CHECKSUM_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        g_checksum_name = "avx2";
+        g_checksum_fletcher = checksum_fletcher_avx2;
+        g_checksum_sum = checksum_sum_avx2;
+    } else if(__builtin_cpu_supports("sse2")) {
+        g_checksum_name = "sse2";
+        g_checksum_fletcher = checksum_fletcher_sse2;
+        g_checksum_sum = checksum_sum_sse2;
+    } else {
+        g_checksum_fletcher = checksum_fletcher_generic;
+        g_checksum_sum = checksum_sum_generic;
+    }
+#elif defined(CHECKSUM_NEON)
+    g_checksum_name = "neon";
+    g_checksum_fletcher = checksum_fletcher_neon;
+    g_checksum_sum = checksum_sum_neon;
+#else
+    g_checksum_fletcher = checksum_fletcher_generic;
+    g_checksum_sum = checksum_sum_generic;
+#endif
+}
+
+static uint32_t
+checksum_sum_resolve(const void *buf, size_t len)
+{
+    checksum_resolve();
+    return g_checksum_sum(buf, len);
+}
+
+static void
+checksum_fletcher_resolve(const uint8_t *pptr, size_t len, uint64_t *c0, uint64_t *c1)
+{
+    checksum_resolve();
+    g_checksum_fletcher(pptr, len, c0, c1);
+}
 
-    for(idx = 0; idx < length; idx++) {
-        c0 = c0 + *(pptr++);
-        c1 += c0;
+/**
+ * @brief checksum_sum
+ *
+ * Internet checksum one's complement sum folded to 16 bits 
+ * (see checksum_sum_generic) using SIMD if supported. Sums of 
+ * multiple buffers can be added and folded again, the final 
+ * checksum is the one's complement of the folded sum.
+ */
+uint32_t
+checksum_sum(const void *buf, size_t len)
+{
+    if(len < CHECKSUM_SIMD_MIN_LEN) {
+        return checksum_sum_generic(buf, len);
     }
+    return g_checksum_sum(buf, len);
+}
 
-    c0 = c0 % 255;
-    c1 = c1 % 255;
+/**
+ * @brief checksum_sum_name
+ *
+ * Name of the SIMD implementation selected 
+ * by checksum_sum and the Fletcher checksum.
+ */
+const char *
+checksum_sum_name()
+{
+    if(g_checksum_sum == checksum_sum_resolve) {
+        checksum_resolve();
+    }
+    return g_checksum_name;
+}
 
+static void
+checksum_fletcher(const uint8_t *pptr, uint length, uint64_t *c0, uint64_t *c1, bool simd)
+{
+    *c0 = 0;
+    *c1 = 0;
+    if(simd && length >= CHECKSUM_SIMD_MIN_LEN) {
+        g_checksum_fletcher(pptr, length, c0, c1);
+    } else {
+        checksum_fletcher_generic(pptr, length, c0, c1);
+    }
+}
+
+static uint16_t
+validate_fletcher_checksum_simd(const uint8_t *pptr, uint length, bool simd)
+{
+    uint64_t c0, c1;
+
+    checksum_fletcher(pptr, length, &c0, &c1, simd);
     return (c1 << 8 | c0);
 }
 
 /**
- * @brief calculate_fletcher_checksum
+ * @brief validate_fletcher_checksum
  * 
- * Creates the OSI Fletcher checksum. See 8473-1, Appendix C, section C.3.
- * The checksum field of the passed PDU does not need to be reset to zero.
+ * Fletcher checksum verification. should return 0 if embedded checksum is correct.
+ * Only used for debug purposes here.
  */
 uint16_t
-calculate_fletcher_checksum(uint8_t *pptr, uint checksum_offset, uint length)
+validate_fletcher_checksum(const uint8_t *pptr, uint length)
 {
-    int64_t c0, c1;
-    int tlen;
+    return validate_fletcher_checksum_simd(pptr, length, true);
+}
+
+/**
+ * @brief validate_fletcher_checksum_generic
+ * 
+ * Scalar version of validate_fletcher_checksum.
+ */
+uint16_t
+validate_fletcher_checksum_generic(const uint8_t *pptr, uint length)
+{
+    return validate_fletcher_checksum_simd(pptr, length, false);
+}
 
-    c0 = 0;
-    c1 = 0;
+static uint16_t
+calculate_fletcher_checksum_simd(uint8_t *pptr, uint checksum_offset, uint length, bool simd)
+{
+    uint64_t sum0, sum1;
+    int64_t c0, c1;
 
     /* reset checksum field */
     *(pptr + checksum_offset) = 0;
     *(pptr + checksum_offset + 1) = 0;
 
-    /* 10x loop unrolling */
-    tlen = length;
-    while(tlen >= 10) {
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-        c0 += *pptr++;
-        c1 += c0;
-
-        tlen -= 10;
-    }
+    checksum_fletcher(pptr, length, &sum0, &sum1, simd);
+    c0 = sum0;
+    c1 = sum1;
 
-    /* remainder */
-    while (--tlen >= 0) {
-        c0 += *pptr++;
-        c1 += c0;
-    }
-
-    c0 = c0 % 255;
     c1 = (c1 - (length - checksum_offset) * c0) % 255;
     if (c1 <= 0) {
         c1 += 255;
@@ -101,3 +530,26 @@ calculate_fletcher_checksum(uint8_t *pptr, uint checksum_offset, uint length)
 
     return (c0 << 8 | c1);
 }
+
+/**
+ * @brief calculate_fletcher_checksum
+ * 
+ * Creates the OSI Fletcher checksum. See 8473-1, Appendix C, section C.3.
+ * The checksum field of the passed PDU does not need to be reset to zero.
+ */
+uint16_t
+calculate_fletcher_checksum(uint8_t *pptr, uint checksum_offset, uint length)
+{
+    return calculate_fletcher_checksum_simd(pptr, checksum_offset, length, true);
+}
+
+/**
+ * @brief calculate_fletcher_checksum_generic
+ * 
+ * Scalar version of calculate_fletcher_checksum.
+ */
+uint16_t
+calculate_fletcher_checksum_generic(uint8_t *pptr, uint checksum_offset, uint length)
+{
+    return calculate_fletcher_checksum_simd(pptr, checksum_offset, length, false);
+}
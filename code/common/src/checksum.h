@@ -12,10 +12,25 @@
 #define __COMMON_CHECKSUM_H__
 #include "common.h"
 
+uint32_t
+checksum_sum_generic(const void *buf, size_t len);
+
+uint32_t
+checksum_sum(const void *buf, size_t len);
+
+const char *
+checksum_sum_name();
+
 uint16_t
 validate_fletcher_checksum(const uint8_t *pptr, uint length);
 
+uint16_t
+validate_fletcher_checksum_generic(const uint8_t *pptr, uint length);
+
 uint16_t
 calculate_fletcher_checksum(uint8_t *pptr, uint checksum_offset, uint length);
 
+uint16_t
+calculate_fletcher_checksum_generic(uint8_t *pptr, uint checksum_offset, uint length);
+
 #endif
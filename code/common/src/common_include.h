@@ -16,5 +16,8 @@
 #include "logging.h"
 #include "timer.h"
 #include "checksum.h"
+#include "hist.h"
+#include "slab.h"
+#include "hash64.h"
 
 #endif
\ No newline at end of file
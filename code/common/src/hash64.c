@@ -0,0 +1,166 @@
+/*
+ * Open Addressing Hash Table Library
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "hash64.h"
+
+/* Fibonacci hashing, the upper bits of the
+ * product select the slot. */
+#define HASH64_SLOT(_table, _key) \
+    (uint32_t)(((_key) * 0x9E3779B97F4A7C15ULL) >> (_table)->shift)
+
+static bool
+hash64_alloc(hash64_s *table, uint32_t size)
+{
+    uint32_t i;
+
+    table->entries = malloc(size * sizeof(hash64_entry_s));
+    if(!table->entries) {
+        return false;
+    }
+    for(i = 0; i < size; i++) {
+        table->entries[i].key = HASH64_EMPTY;
+        table->entries[i].value = NULL;
+    }
+    table->size = size;
+    table->shift = 64 - __builtin_ctz(size);
+    return true;
+}
+
+/**
+ * hash64_init
+ *
+ * @param table table to be initialised
+ * @param size expected number of entries
+ * @return true if successful
+ */
+bool
+hash64_init(hash64_s *table, uint32_t size)
+{
+    uint32_t slots = HASH64_MIN_SIZE;
+
+    memset(table, 0x0, sizeof(hash64_s));
+    while(slots < size * 2ULL && slots < (1U << 31)) {
+        slots <<= 1;
+    }
+    return hash64_alloc(table, slots);
+}
+
+static bool
+hash64_grow(hash64_s *table)
+{
+    hash64_entry_s *entries = table->entries;
+    hash64_entry_s *entry;
+    uint32_t size = table->size;
+    uint32_t i, slot;
+
+    if(size >= (1U << 31)) {
+        return false;
+    }
+    if(!hash64_alloc(table, size << 1)) {
+        table->entries = entries;
+        return false;
+    }
+    for(i = 0; i < size; i++) {
+        if(entries[i].key == HASH64_EMPTY) continue;
+        slot = HASH64_SLOT(table, entries[i].key);
+        while(true) {
+            entry = &table->entries[slot];
+            if(entry->key == HASH64_EMPTY) {
+                *entry = entries[i];
+                break;
+            }
+            slot = (slot + 1) & (table->size - 1);
+        }
+    }
+    free(entries);
+    return true;
+}
+
+/**
+ * hash64_insert
+ *
+ * The returned value pointer is valid until
+ * the next insert, which may resize the table.
+ *
+ * @param table table
+ * @param key key (HASH64_EMPTY is reserved)
+ * @param inserted set to true if inserted or
+ * false if key was already present
+ * @return pointer to value or NULL if failed
+ */
+void **
+hash64_insert(hash64_s *table, uint64_t key, bool *inserted)
+{
+    hash64_entry_s *entry;
+    uint32_t slot;
+
+    *inserted = false;
+    if(key == HASH64_EMPTY) {
+        return NULL;
+    }
+    if((table->count + 1) * 2 > table->size) {
+        if(!hash64_grow(table)) {
+            return NULL;
+        }
+    }
+    slot = HASH64_SLOT(table, key);
+    while(true) {
+        entry = &table->entries[slot];
+        if(entry->key == key) {
+            return &entry->value;
+        }
+        if(entry->key == HASH64_EMPTY) {
+            entry->key = key;
+            entry->value = NULL;
+            table->count++;
+            *inserted = true;
+            return &entry->value;
+        }
+        slot = (slot + 1) & (table->size - 1);
+    }
+}
+
+/**
+ * hash64_search
+ *
+ * @param table table
+ * @param key key
+ * @return pointer to value or NULL if not found
+ */
+void **
+hash64_search(hash64_s *table, uint64_t key)
+{
+    hash64_entry_s *entry;
+    uint32_t slot;
+
+    slot = HASH64_SLOT(table, key);
+    while(true) {
+        entry = &table->entries[slot];
+        if(entry->key == key) {
+            /* Searching for HASH64_EMPTY
+             * ends at the first empty slot. */
+            return key == HASH64_EMPTY ? NULL : &entry->value;
+        }
+        if(entry->key == HASH64_EMPTY) {
+            return NULL;
+        }
+        slot = (slot + 1) & (table->size - 1);
+    }
+}
+
+/**
+ * hash64_destroy
+ *
+ * @param table table
+ */
+void
+hash64_destroy(hash64_s *table)
+{
+    if(table->entries) {
+        free(table->entries);
+    }
+    memset(table, 0x0, sizeof(hash64_s));
+}
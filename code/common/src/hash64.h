@@ -0,0 +1,45 @@
+/*
+ * Open Addressing Hash Table Library
+ *
+ * Hash table with 64-bit keys and pointer values
+ * stored inline in one power of two sized array
+ * using linear probing. The table doubles when
+ * half full. Entries can't be removed, all
+ * entries are released with hash64_destroy.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __COMMON_HASH64_H__
+#define __COMMON_HASH64_H__
+#include "common.h"
+
+#define HASH64_EMPTY        UINT64_MAX /* reserved key */
+#define HASH64_MIN_SIZE     64
+
+typedef struct hash64_entry_ {
+    uint64_t key;
+    void *value;
+} hash64_entry_s;
+
+typedef struct hash64_ {
+    hash64_entry_s *entries;
+    uint32_t size; /* power of two */
+    uint32_t count;
+    uint8_t shift; /* 64 - log2(size) */
+} hash64_s;
+
+bool
+hash64_init(hash64_s *table, uint32_t size);
+
+void **
+hash64_insert(hash64_s *table, uint64_t key, bool *inserted);
+
+void **
+hash64_search(hash64_s *table, uint64_t key);
+
+void
+hash64_destroy(hash64_s *table);
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Log-Linear Histogram Library
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "hist.h"
+
+void
+hist_reset(hist_s *hist)
+{
+    memset(hist, 0x0, sizeof(hist_s));
+}
+
+/**
+ * hist_merge
+ * 
+ * Add all counters of source histogram
+ * to destination histogram.
+ * 
+ * @param dst destination histogram
+ * @param src source histogram
+ */
+void
+hist_merge(hist_s *dst, hist_s *src)
+{
+    uint32_t i;
+
+    if(!src->count) return;
+
+    for(i = 0; i < HIST_BUCKETS; i++) {
+        dst->bucket[i] += src->bucket[i];
+    }
+    dst->count += src->count;
+    dst->overflow += src->overflow;
+    if(src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+/**
+ * hist_bucket_max
+ * 
+ * @param index bucket index
+ * @return highest value counted in bucket
+ */
+uint64_t
+hist_bucket_max(uint32_t index)
+{
+    uint32_t shift;
+    uint64_t sub;
+
+    if(index < (HIST_SUB_COUNT << 1)) {
+        return index;
+    }
+    shift = (index >> HIST_SUB_BITS) - 1;
+    sub = HIST_SUB_COUNT + (index & (HIST_SUB_COUNT - 1));
+    return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * hist_percentile
+ * 
+ * Returns the highest value of the bucket containing
+ * the requested percentile, limited to the highest 
+ * value added to the histogram.
+ * 
+ * @param hist histogram
+ * @param percentile percentile (0 - 100)
+ * @return value or 0 if histogram is empty
+ */
+uint64_t
+hist_percentile(hist_s *hist, double percentile)
+{
+    uint64_t target;
+    uint64_t count = 0;
+    uint64_t value;
+    uint32_t i;
+
+    if(!hist->count) return 0;
+
+    target = (percentile / 100.0) * hist->count + 0.5;
+    if(target < 1) target = 1;
+    if(target > hist->count) target = hist->count;
+
+    for(i = 0; i < HIST_BUCKETS; i++) {
+        count += hist->bucket[i];
+        if(count >= target) {
+            value = hist_bucket_max(i);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+    /* Percentile is in overflow. */
+    return hist->max;
+}
@@ -0,0 +1,75 @@
+/*
+ * Log-Linear Histogram Library
+ *
+ * Compact HDR-style histogram with 2^HIST_SUB_BITS linear
+ * sub-buckets per power of two, resulting in a fixed
+ * relative error of less than 1/2^HIST_SUB_BITS (12.5%)
+ * for values below 2^HIST_MAX_BITS. Larger values are
+ * counted separately as overflow. Histograms of equal
+ * layout can be merged by adding bucket counters.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __COMMON_HIST_H__
+#define __COMMON_HIST_H__
+#include "common.h"
+
+#define HIST_SUB_BITS   3
+#define HIST_SUB_COUNT  (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS   22
+#define HIST_BUCKETS    ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+#define HIST_OVERFLOW   HIST_BUCKETS /* index of values >= 2^HIST_MAX_BITS */
+
+typedef struct hist_ {
+    uint64_t count;
+    uint64_t overflow;
+    uint64_t max;
+    uint32_t bucket[HIST_BUCKETS];
+} hist_s;
+
+static inline uint32_t
+hist_index(uint64_t value)
+{
+    uint32_t exp;
+
+    if(value < (HIST_SUB_COUNT << 1)) {
+        return value;
+    }
+    exp = 63 - __builtin_clzll(value);
+    if(exp >= HIST_MAX_BITS) {
+        return HIST_OVERFLOW;
+    }
+    return ((exp - HIST_SUB_BITS) << HIST_SUB_BITS) + (value >> (exp - HIST_SUB_BITS));
+}
+
+static inline void
+hist_add(hist_s *hist, uint64_t value)
+{
+    uint32_t index = hist_index(value);
+
+    if(likely(index < HIST_BUCKETS)) {
+        hist->bucket[index]++;
+    } else {
+        hist->overflow++;
+    }
+    hist->count++;
+    if(value > hist->max) {
+        hist->max = value;
+    }
+}
+
+void
+hist_reset(hist_s *hist);
+
+void
+hist_merge(hist_s *dst, hist_s *src);
+
+uint64_t
+hist_bucket_max(uint32_t index);
+
+uint64_t
+hist_percentile(hist_s *hist, double percentile);
+
+#endif
@@ -9,6 +9,12 @@
  */
 #include "logging.h"
 
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <sys/types.h>
+
 /* Globals */
 
 struct log_id_ log_id[LOG_ID_MAX];
@@ -73,6 +79,7 @@ log_open()
 void
 log_close()
 {
+    log_async_stop();
     if(g_log_fp) {
         fclose(g_log_fp);
         g_log_fp = NULL;
@@ -95,4 +102,722 @@ log_usage()
         ptr++;
     }
     return buf;
-}
\ No newline at end of file
+}
+
+/*
+ * Asynchronous Logging
+ *
+ * Each thread records log messages into its own single
+ * producer/consumer ring without taking any lock. A record
+ * holds the format string, a raw monotonic timestamp and
+ * the arguments. Strings are copied as they may point to
+ * static or stack buffers. The writer thread merges all
+ * rings by timestamp, formats the messages and writes them
+ * to the log file and console. Messages are dropped and
+ * counted if the ring of a thread is full.
+ */
+
+bool g_log_async = false;
+
+typedef struct log_record_ {
+    const char *fmt;
+    struct timespec timestamp;
+    uint16_t len; /* length of arguments */
+    uint8_t id;
+    bool truncated;
+    uint8_t args[LOG_ASYNC_ARGS_LEN];
+} log_record_s;
+
+typedef struct log_ring_ {
+    struct log_ring_ *next;
+    atomic_uint_fast64_t head; /* written by producer */
+    atomic_uint_fast64_t drops; /* written by producer */
+    atomic_uint_fast64_t tail __attribute__((aligned(CACHE_LINE_SIZE))); /* written by writer */
+    uint64_t drops_reported; /* written by writer */
+    log_record_s records[LOG_ASYNC_RING_SIZE];
+} log_ring_s;
+
+/* Conversion specification length modifiers. */
+typedef enum {
+    LOG_LENGTH_NONE,
+    LOG_LENGTH_HH,
+    LOG_LENGTH_H,
+    LOG_LENGTH_L,
+    LOG_LENGTH_LL,
+    LOG_LENGTH_LD,
+    LOG_LENGTH_J,
+    LOG_LENGTH_Z,
+    LOG_LENGTH_T,
+} log_length_t;
+
+typedef struct log_spec_ {
+    size_t len; /* length of the conversion specification */
+    size_t prefix; /* length of flags, width and precision */
+    log_length_t length;
+    char conversion;
+    bool width; /* width passed as argument */
+    bool precision; /* precision passed as argument */
+    int precision_value; /* explicit precision or -1 */
+} log_spec_s;
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t mutex; /* protects rings */
+    log_ring_s *rings;
+    atomic_bool active;
+    atomic_uint_fast64_t drops; /* ring allocation failures */
+    uint64_t drops_reported;
+    struct timespec offset; /* realtime minus monotonic */
+    time_t sec; /* cached timestamp prefix */
+    char prefix[sizeof("Jun 19 08:07:13")];
+
+    pthread_mutex_t console_mutex; /* protects console buffer */
+    atomic_bool console_window;
+    char *console;
+    uint32_t console_cur;
+    uint32_t console_count;
+} g_log = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .console_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* Rings are never freed as threads keep a pointer to their ring. */
+static _Thread_local log_ring_s *g_log_ring = NULL;
+
+static log_ring_s *
+log_async_ring()
+{
+    log_ring_s *ring = g_log_ring;
+    if(likely(ring != NULL)) {
+        return ring;
+    }
+    ring = calloc(1, sizeof(log_ring_s));
+    if(!ring) {
+        return NULL;
+    }
+    pthread_mutex_lock(&g_log.mutex);
+    ring->next = g_log.rings;
+    g_log.rings = ring;
+    pthread_mutex_unlock(&g_log.mutex);
+    g_log_ring = ring;
+    return ring;
+}
+
+/*
+ * Parse a printf conversion specification starting at '%'.
+ */
+static const char *
+log_spec_parse(const char *fmt, log_spec_s *spec)
+{
+    const char *cur = fmt + 1;
+
+    memset(spec, 0x0, sizeof(log_spec_s));
+    spec->precision_value = -1;
+
+    while(*cur && strchr("-+ #0'", *cur)) cur++;
+    if(*cur == '*') {
+        spec->width = true;
+        cur++;
+    } else {
+        while(*cur >= '0' && *cur <= '9') cur++;
+    }
+    if(*cur == '.') {
+        cur++;
+        if(*cur == '*') {
+            spec->precision = true;
+            cur++;
+        } else {
+            spec->precision_value = 0;
+            while(*cur >= '0' && *cur <= '9') {
+                spec->precision_value = spec->precision_value * 10 + (*cur - '0');
+                cur++;
+            }
+        }
+    }
+    spec->prefix = cur - fmt;
+    switch(*cur) {
+        case 'h':
+            cur++;
+            spec->length = LOG_LENGTH_H;
+            if(*cur == 'h') {
+                spec->length = LOG_LENGTH_HH;
+                cur++;
+            }
+            break;
+        case 'l':
+            cur++;
+            spec->length = LOG_LENGTH_L;
+            if(*cur == 'l') {
+                spec->length = LOG_LENGTH_LL;
+                cur++;
+            }
+            break;
+        case 'L': spec->length = LOG_LENGTH_LD; cur++; break;
+        case 'j': spec->length = LOG_LENGTH_J; cur++; break;
+        case 'z': spec->length = LOG_LENGTH_Z; cur++; break;
+        case 't': spec->length = LOG_LENGTH_T; cur++; break;
+        default: break;
+    }
+    spec->conversion = *cur;
+    if(*cur) cur++;
+    spec->len = cur - fmt;
+    return cur;
+}
+
+static bool
+log_async_put(log_record_s *record, const void *value, size_t len)
+{
+    if(record->len + len > LOG_ASYNC_ARGS_LEN) {
+        record->truncated = true;
+        return false;
+    }
+    memcpy(record->args + record->len, value, len);
+    record->len += len;
+    return true;
+}
+
+static bool
+log_async_get(const log_record_s *record, uint16_t *offset, void *value, size_t len)
+{
+    if(*offset + len > record->len) {
+        return false;
+    }
+    memcpy(value, record->args + *offset, len);
+    *offset += len;
+    return true;
+}
+
+static bool
+log_async_put_string(log_record_s *record, const char *s, int precision)
+{
+    size_t available = LOG_ASYNC_ARGS_LEN - record->len;
+    size_t len;
+
+    if(!s) s = "(null)";
+    len = precision < 0 ? strlen(s) : strnlen(s, precision);
+    if(!available) {
+        record->truncated = true;
+        return false;
+    }
+    if(len >= available) {
+        len = available - 1;
+        record->truncated = true;
+    }
+    memcpy(record->args + record->len, s, len);
+    record->args[record->len+len] = 0;
+    record->len += len + 1;
+    return !record->truncated;
+}
+
+/*
+ * Store all arguments of the format string into the record.
+ * Integers are stored as 64 bit values already converted
+ * to the type selected by the length modifier.
+ */
+static void
+log_async_encode(log_record_s *record, const char *fmt, va_list ap)
+{
+    log_spec_s spec;
+    long long i;
+    unsigned long long u;
+    double d;
+    long double ld;
+    void *p;
+    int width;
+    int precision;
+
+    record->len = 0;
+    record->truncated = false;
+
+    while((fmt = strchr(fmt, '%'))) {
+        fmt = log_spec_parse(fmt, &spec);
+        if(spec.conversion == '%') {
+            continue;
+        }
+        precision = spec.precision_value;
+        if(spec.width) {
+            width = va_arg(ap, int);
+            if(!log_async_put(record, &width, sizeof(width))) return;
+        }
+        if(spec.precision) {
+            precision = va_arg(ap, int);
+            if(!log_async_put(record, &precision, sizeof(precision))) return;
+        }
+        switch(spec.conversion) {
+            case 'd':
+            case 'i':
+                switch(spec.length) {
+                    case LOG_LENGTH_HH: i = (signed char)va_arg(ap, int); break;
+                    case LOG_LENGTH_H: i = (short)va_arg(ap, int); break;
+                    case LOG_LENGTH_L: i = va_arg(ap, long); break;
+                    case LOG_LENGTH_LL: i = va_arg(ap, long long); break;
+                    case LOG_LENGTH_J: i = va_arg(ap, intmax_t); break;
+                    case LOG_LENGTH_Z: i = va_arg(ap, ssize_t); break;
+                    case LOG_LENGTH_T: i = va_arg(ap, ptrdiff_t); break;
+                    default: i = va_arg(ap, int); break;
+                }
+                if(!log_async_put(record, &i, sizeof(i))) return;
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                switch(spec.length) {
+                    case LOG_LENGTH_HH: u = (unsigned char)va_arg(ap, unsigned int); break;
+                    case LOG_LENGTH_H: u = (unsigned short)va_arg(ap, unsigned int); break;
+                    case LOG_LENGTH_L: u = va_arg(ap, unsigned long); break;
+                    case LOG_LENGTH_LL: u = va_arg(ap, unsigned long long); break;
+                    case LOG_LENGTH_J: u = va_arg(ap, uintmax_t); break;
+                    case LOG_LENGTH_Z: u = va_arg(ap, size_t); break;
+                    case LOG_LENGTH_T: u = va_arg(ap, ptrdiff_t); break;
+                    default: u = va_arg(ap, unsigned int); break;
+                }
+                if(!log_async_put(record, &u, sizeof(u))) return;
+                break;
+            case 'c':
+                if(spec.length != LOG_LENGTH_NONE) goto UNSUPPORTED;
+                i = va_arg(ap, int);
+                if(!log_async_put(record, &i, sizeof(i))) return;
+                break;
+            case 'e': case 'E':
+            case 'f': case 'F':
+            case 'g': case 'G':
+            case 'a': case 'A':
+                if(spec.length == LOG_LENGTH_LD) {
+                    ld = va_arg(ap, long double);
+                    if(!log_async_put(record, &ld, sizeof(ld))) return;
+                } else {
+                    d = va_arg(ap, double);
+                    if(!log_async_put(record, &d, sizeof(d))) return;
+                }
+                break;
+            case 's':
+                if(spec.length != LOG_LENGTH_NONE) goto UNSUPPORTED;
+                if(!log_async_put_string(record, va_arg(ap, const char *), precision)) return;
+                break;
+            case 'p':
+                p = va_arg(ap, void *);
+                if(!log_async_put(record, &p, sizeof(p))) return;
+                break;
+            case 'n':
+                /* Ignore, nothing is written. */
+                p = va_arg(ap, void *);
+                break;
+            default:
+                goto UNSUPPORTED;
+        }
+    }
+    return;
+
+UNSUPPORTED:
+    record->truncated = true;
+}
+
+/*
+ * Format the record the same way as printf would have
+ * done with the original arguments.
+ */
+static size_t
+log_async_format(const log_record_s *record, char *buf, size_t size)
+{
+    const char *fmt = record->fmt;
+    const char *next;
+    const char *cur;
+    log_spec_s spec;
+    char spec_str[64];
+    size_t spec_len;
+    size_t len = 0;
+    uint16_t offset = 0;
+    long long i;
+    unsigned long long u;
+    double d;
+    long double ld;
+    void *p;
+    int value;
+    int res = 0;
+
+    while(*fmt && len < size - 1) {
+        if(*fmt != '%') {
+            next = strchr(fmt, '%');
+            spec_len = next ? (size_t)(next - fmt) : strlen(fmt);
+            if(spec_len > size - 1 - len) spec_len = size - 1 - len;
+            memcpy(buf+len, fmt, spec_len);
+            len += spec_len;
+            fmt += spec_len;
+            continue;
+        }
+        next = log_spec_parse(fmt, &spec);
+        if(spec.conversion == '%') {
+            buf[len++] = '%';
+            fmt = next;
+            continue;
+        }
+        /* Rebuild specification with width and precision
+         * arguments resolved and the length modifier of the
+         * stored value. */
+        spec_len = 0;
+        for(cur = fmt; cur < fmt + spec.prefix && spec_len < sizeof(spec_str) - 16; cur++) {
+            if(*cur == '*') {
+                if(!log_async_get(record, &offset, &value, sizeof(value))) goto TRUNCATED;
+                spec_len += snprintf(spec_str+spec_len, sizeof(spec_str)-spec_len, "%d", value);
+            } else {
+                spec_str[spec_len++] = *cur;
+            }
+        }
+        if(cur < fmt + spec.prefix) goto TRUNCATED;
+        fmt = next;
+
+        switch(spec.conversion) {
+            case 'd': case 'i':
+            case 'o': case 'u':
+            case 'x': case 'X':
+                spec_str[spec_len++] = 'l';
+                spec_str[spec_len++] = 'l';
+                break;
+            case 'e': case 'E':
+            case 'f': case 'F':
+            case 'g': case 'G':
+            case 'a': case 'A':
+                if(spec.length == LOG_LENGTH_LD) {
+                    spec_str[spec_len++] = 'L';
+                }
+                break;
+            case 'n':
+                continue;
+            default:
+                break;
+        }
+        spec_str[spec_len++] = spec.conversion;
+        spec_str[spec_len] = 0;
+
+        switch(spec.conversion) {
+            case 'd':
+            case 'i':
+                if(!log_async_get(record, &offset, &i, sizeof(i))) goto TRUNCATED;
+                res = snprintf(buf+len, size-len, spec_str, i);
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                if(!log_async_get(record, &offset, &u, sizeof(u))) goto TRUNCATED;
+                res = snprintf(buf+len, size-len, spec_str, u);
+                break;
+            case 'c':
+                if(!log_async_get(record, &offset, &i, sizeof(i))) goto TRUNCATED;
+                res = snprintf(buf+len, size-len, spec_str, (int)i);
+                break;
+            case 'e': case 'E':
+            case 'f': case 'F':
+            case 'g': case 'G':
+            case 'a': case 'A':
+                if(spec.length == LOG_LENGTH_LD) {
+                    if(!log_async_get(record, &offset, &ld, sizeof(ld))) goto TRUNCATED;
+                    res = snprintf(buf+len, size-len, spec_str, ld);
+                } else {
+                    if(!log_async_get(record, &offset, &d, sizeof(d))) goto TRUNCATED;
+                    res = snprintf(buf+len, size-len, spec_str, d);
+                }
+                break;
+            case 's':
+                if(offset >= record->len) goto TRUNCATED;
+                cur = (const char *)record->args + offset;
+                offset += strlen(cur) + 1;
+                res = snprintf(buf+len, size-len, spec_str, cur);
+                break;
+            case 'p':
+                if(!log_async_get(record, &offset, &p, sizeof(p))) goto TRUNCATED;
+                res = snprintf(buf+len, size-len, spec_str, p);
+                break;
+            default:
+                goto TRUNCATED;
+        }
+        if(res > 0) {
+            len += res;
+            if(len > size - 1) len = size - 1;
+        }
+    }
+    buf[len] = 0;
+    if(record->truncated) {
+        goto TRUNCATED;
+    }
+    return len;
+
+TRUNCATED:
+    if(len > size - sizeof("...\n")) {
+        len = size - sizeof("...\n");
+    }
+    len += snprintf(buf+len, size-len, "...\n");
+    return len;
+}
+
+/*
+ * Format a monotonic timestamp as realtime log timestamp.
+ */
+static size_t
+log_async_timestamp(const struct timespec *timestamp, char *buf, size_t size)
+{
+    struct timespec now;
+    struct tm tm;
+
+    now.tv_sec = timestamp->tv_sec + g_log.offset.tv_sec;
+    now.tv_nsec = timestamp->tv_nsec + g_log.offset.tv_nsec;
+    if(now.tv_nsec >= 1000000000) {
+        now.tv_sec++;
+        now.tv_nsec -= 1000000000;
+    }
+    if(now.tv_sec != g_log.sec) {
+        localtime_r(&now.tv_sec, &tm);
+        strftime(g_log.prefix, sizeof(g_log.prefix), "%b %d %H:%M:%S", &tm);
+        g_log.sec = now.tv_sec;
+    }
+    return snprintf(buf, size, "%s.%06lu ", g_log.prefix, now.tv_nsec / 1000);
+}
+
+static void
+log_async_write(const char *line)
+{
+    char *console;
+
+    if(g_log_fp) {
+        fputs(line, g_log_fp);
+    }
+    if(g_log.console) {
+        pthread_mutex_lock(&g_log.console_mutex);
+        console = g_log.console + (g_log.console_cur * LOG_ASYNC_LINE_LEN);
+        strncpy(console, line, LOG_ASYNC_LINE_LEN-1);
+        console[LOG_ASYNC_LINE_LEN-1] = 0;
+        g_log.console_cur = (g_log.console_cur + 1) % LOG_ASYNC_CONSOLE_LINES;
+        if(g_log.console_count < LOG_ASYNC_CONSOLE_LINES) {
+            g_log.console_count++;
+        }
+        pthread_mutex_unlock(&g_log.console_mutex);
+    }
+    if(!atomic_load_explicit(&g_log.console_window, memory_order_relaxed)) {
+        fputs(line, stdout);
+    }
+}
+
+static void
+log_async_write_drops(uint64_t drops)
+{
+    char line[128];
+    struct timespec now;
+    size_t len;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    len = log_async_timestamp(&now, line, sizeof(line));
+    snprintf(line+len, sizeof(line)-len, "Logging dropped %lu messages\n", drops);
+    log_async_write(line);
+}
+
+/*
+ * Write all pending records of all rings ordered by timestamp.
+ */
+static uint64_t
+log_async_drain()
+{
+    char line[LOG_ASYNC_LINE_LEN];
+    log_ring_s *ring;
+    log_ring_s *oldest;
+    log_record_s *record;
+    log_record_s *oldest_record = NULL;
+    uint64_t tail;
+    uint64_t drops;
+    uint64_t count = 0;
+    size_t len;
+
+    pthread_mutex_lock(&g_log.mutex);
+    while(true) {
+        oldest = NULL;
+        for(ring = g_log.rings; ring; ring = ring->next) {
+            tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            if(tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+                continue;
+            }
+            record = &ring->records[tail & (LOG_ASYNC_RING_SIZE-1)];
+            if(!oldest ||
+               record->timestamp.tv_sec < oldest_record->timestamp.tv_sec ||
+               (record->timestamp.tv_sec == oldest_record->timestamp.tv_sec &&
+                record->timestamp.tv_nsec < oldest_record->timestamp.tv_nsec)) {
+                oldest = ring;
+                oldest_record = record;
+            }
+        }
+        if(!oldest) {
+            break;
+        }
+        len = log_async_timestamp(&oldest_record->timestamp, line, sizeof(line));
+        log_async_format(oldest_record, line+len, sizeof(line)-len);
+        log_async_write(line);
+        tail = atomic_load_explicit(&oldest->tail, memory_order_relaxed);
+        atomic_store_explicit(&oldest->tail, tail+1, memory_order_release);
+        count++;
+    }
+    drops = atomic_load_explicit(&g_log.drops, memory_order_relaxed);
+    for(ring = g_log.rings; ring; ring = ring->next) {
+        drops += atomic_load_explicit(&ring->drops, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&g_log.mutex);
+
+    if(drops > g_log.drops_reported) {
+        log_async_write_drops(drops - g_log.drops_reported);
+        g_log.drops_reported = drops;
+        count++;
+    }
+    if(count) {
+        if(g_log_fp) fflush(g_log_fp);
+        fflush(stdout);
+    }
+    return count;
+}
+
+static void *
+log_async_thread(void *thread_data)
+{
+    struct timespec sleep, rem;
+    bool active;
+    UNUSED(thread_data);
+
+    sleep.tv_sec = 0;
+    sleep.tv_nsec = 10 * 1000000; /* 10ms */
+
+    while(true) {
+        active = atomic_load(&g_log.active);
+        if(!log_async_drain()) {
+            if(!active) {
+                break;
+            }
+            nanosleep(&sleep, &rem);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Record a log message for the writer thread.
+ */
+void
+log_async(int id, const char *fmt, ...)
+{
+    log_ring_s *ring = log_async_ring();
+    log_record_s *record;
+    uint64_t head;
+    va_list ap;
+
+    if(unlikely(!ring)) {
+        atomic_fetch_add_explicit(&g_log.drops, 1, memory_order_relaxed);
+        return;
+    }
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if(head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= LOG_ASYNC_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->drops, 1, memory_order_relaxed);
+        return;
+    }
+    record = &ring->records[head & (LOG_ASYNC_RING_SIZE-1)];
+    clock_gettime(CLOCK_MONOTONIC, &record->timestamp);
+    record->fmt = fmt;
+    record->id = id;
+    va_start(ap, fmt);
+    log_async_encode(record, fmt, ap);
+    va_end(ap);
+    atomic_store_explicit(&ring->head, head+1, memory_order_release);
+}
+
+/*
+ * Start the writer thread and enable asynchronous logging.
+ * With console buffer enabled, the last console lines are
+ * kept to be read by the interactive window.
+ */
+bool
+log_async_start(bool console_buffer)
+{
+    struct timespec realtime;
+    struct timespec monotonic;
+
+    if(g_log_async) {
+        return true;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    g_log.offset.tv_sec = realtime.tv_sec - monotonic.tv_sec;
+    g_log.offset.tv_nsec = realtime.tv_nsec - monotonic.tv_nsec;
+    if(g_log.offset.tv_nsec < 0) {
+        g_log.offset.tv_sec--;
+        g_log.offset.tv_nsec += 1000000000;
+    }
+    g_log.sec = 0;
+
+    if(console_buffer) {
+        g_log.console = calloc(LOG_ASYNC_CONSOLE_LINES, LOG_ASYNC_LINE_LEN);
+        if(!g_log.console) {
+            return false;
+        }
+        g_log.console_cur = 0;
+        g_log.console_count = 0;
+    }
+    atomic_store(&g_log.console_window, false);
+    atomic_store(&g_log.active, true);
+    if(pthread_create(&g_log.thread, NULL, log_async_thread, NULL) != 0) {
+        free(g_log.console);
+        g_log.console = NULL;
+        return false;
+    }
+    g_log_async = true;
+    return true;
+}
+
+/*
+ * Disable asynchronous logging and stop the writer
+ * thread after all pending messages are written.
+ */
+void
+log_async_stop()
+{
+    if(!g_log_async) {
+        return;
+    }
+    g_log_async = false;
+    atomic_store(&g_log.active, false);
+    pthread_join(g_log.thread, NULL);
+
+    pthread_mutex_lock(&g_log.console_mutex);
+    free(g_log.console);
+    g_log.console = NULL;
+    pthread_mutex_unlock(&g_log.console_mutex);
+    atomic_store(&g_log.console_window, false);
+}
+
+/*
+ * Stop writing console lines to stdout if
+ * they are displayed in the interactive window.
+ */
+void
+log_async_console(bool window)
+{
+    atomic_store(&g_log.console_window, window);
+}
+
+/*
+ * Pass all buffered console lines to the callback
+ * and return the number of lines.
+ */
+int
+log_async_console_read(void (*cb)(const char *line))
+{
+    uint32_t i;
+    uint32_t start;
+    int count;
+
+    pthread_mutex_lock(&g_log.console_mutex);
+    count = g_log.console_count;
+    if(g_log.console) {
+        start = (g_log.console_cur + LOG_ASYNC_CONSOLE_LINES - g_log.console_count) % LOG_ASYNC_CONSOLE_LINES;
+        for(i = 0; i < g_log.console_count; i++) {
+            cb(g_log.console + (((start + i) % LOG_ASYNC_CONSOLE_LINES) * LOG_ASYNC_LINE_LEN));
+        }
+    }
+    g_log.console_count = 0;
+    pthread_mutex_unlock(&g_log.console_mutex);
+    return count;
+}
@@ -17,6 +17,18 @@ extern char *g_log_file;
 extern FILE *g_log_fp;
 extern keyval_t log_names[];
 
+/*
+ * Asynchronous logging records the format string, a raw monotonic
+ * timestamp and the arguments into a lock-free per-thread ring.
+ * Formatting and writing is done by a background thread.
+ */
+extern bool g_log_async;
+
+#define LOG_ASYNC_RING_SIZE     4096 /* records per thread, power of 2 */
+#define LOG_ASYNC_ARGS_LEN      224  /* bytes of arguments per record */
+#define LOG_ASYNC_LINE_LEN      1024
+#define LOG_ASYNC_CONSOLE_LINES 128
+
 /*
  * List of log-ids.
  */
@@ -70,6 +82,12 @@ extern uint8_t g_log_buf_cur;
 
 #define LOG(log_id_, fmt_, ...) \
     do { \
+        if(g_log_async) { \
+            if (log_id[log_id_].enable) { \
+                log_async(log_id_, fmt_, ##__VA_ARGS__); \
+            } \
+            break; \
+        } \
         if(g_log_fp) { \
             if (log_id[log_id_].enable) { \
                 fprintf(g_log_fp, "%s "fmt_, log_format_timestamp(), ##__VA_ARGS__); \
@@ -95,6 +113,12 @@ extern uint8_t g_log_buf_cur;
 
 #define LOG_NOARG(log_id_, fmt_) \
     do { \
+        if(g_log_async) { \
+            if (log_id[log_id_].enable) { \
+                log_async(log_id_, fmt_); \
+            } \
+            break; \
+        } \
         if(g_log_fp) { \
             if (log_id[log_id_].enable) { \
                 fprintf(g_log_fp, "%s "fmt_, log_format_timestamp()); \
@@ -121,6 +145,12 @@ extern uint8_t g_log_buf_cur;
 #else 
 #define LOG(log_id_, fmt_, ...) \
     do { \
+        if(g_log_async) { \
+            if (log_id[log_id_].enable) { \
+                log_async(log_id_, fmt_, ##__VA_ARGS__); \
+            } \
+            break; \
+        } \
         if(g_log_fp) { \
             if (log_id[log_id_].enable) { \
                 fprintf(g_log_fp, "%s "fmt_, log_format_timestamp(), ##__VA_ARGS__); \
@@ -134,6 +164,12 @@ extern uint8_t g_log_buf_cur;
 
 #define LOG_NOARG(log_id_, fmt_) \
     do { \
+        if(g_log_async) { \
+            if (log_id[log_id_].enable) { \
+                log_async(log_id_, fmt_); \
+            } \
+            break; \
+        } \
         if(g_log_fp) { \
             if (log_id[log_id_].enable) { \
                 fprintf(g_log_fp, "%s "fmt_, log_format_timestamp()); \
@@ -166,4 +202,19 @@ log_format_timestamp(void);
 char *
 log_usage();
 
+void
+log_async(int id, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+bool
+log_async_start(bool console_buffer);
+
+void
+log_async_stop();
+
+void
+log_async_console(bool window);
+
+int
+log_async_console_read(void (*cb)(const char *line));
+
 #endif
\ No newline at end of file
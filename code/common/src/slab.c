@@ -0,0 +1,128 @@
+/*
+ * Slab Allocator Library
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "slab.h"
+
+#define SLAB_CHUNK_HEADER ((sizeof(slab_chunk_s) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1))
+
+/**
+ * slab_init
+ * 
+ * @param slab slab to be initialised
+ * @param name name used for reporting
+ * @param size object size
+ */
+void
+slab_init(slab_s *slab, const char *name, size_t size)
+{
+    memset(slab, 0x0, sizeof(slab_s));
+    if(size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    slab->name = name;
+    slab->size = (size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+}
+
+static bool
+slab_grow(slab_s *slab)
+{
+    slab_chunk_s *chunk;
+    uint8_t *object;
+    uint32_t i;
+
+    chunk = malloc(SLAB_CHUNK_HEADER + (slab->size * SLAB_CHUNK_OBJECTS));
+    if(!chunk) {
+        return false;
+    }
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+    slab->chunk_count++;
+
+    /* Link objects in address order to the free list. */
+    object = (uint8_t*)chunk + SLAB_CHUNK_HEADER;
+    for(i = SLAB_CHUNK_OBJECTS; i > 0; i--) {
+        *(void**)(object + (i-1) * slab->size) = slab->free;
+        slab->free = object + (i-1) * slab->size;
+    }
+    return true;
+}
+
+/**
+ * slab_alloc
+ * 
+ * @param slab slab
+ * @return zeroed object or NULL
+ */
+void *
+slab_alloc(slab_s *slab)
+{
+    void *object;
+
+    if(!slab->free) {
+        if(!slab_grow(slab)) {
+            return NULL;
+        }
+    }
+    object = slab->free;
+    slab->free = *(void**)object;
+    slab->objects++;
+    memset(object, 0x0, slab->size);
+    return object;
+}
+
+/**
+ * slab_free
+ * 
+ * Return object to the free list of the slab.
+ * 
+ * @param slab slab
+ * @param object object allocated from this slab
+ */
+void
+slab_free(slab_s *slab, void *object)
+{
+    if(!object) return;
+    *(void**)object = slab->free;
+    slab->free = object;
+    slab->objects--;
+}
+
+/**
+ * slab_destroy
+ * 
+ * Free all chunks. All objects
+ * become invalid.
+ * 
+ * @param slab slab
+ */
+void
+slab_destroy(slab_s *slab)
+{
+    slab_chunk_s *chunk = slab->chunks;
+    slab_chunk_s *next;
+
+    while(chunk) {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    slab->chunks = NULL;
+    slab->free = NULL;
+    slab->chunk_count = 0;
+    slab->objects = 0;
+}
+
+/**
+ * slab_memory
+ * 
+ * @param slab slab
+ * @return bytes allocated for chunks
+ */
+size_t
+slab_memory(slab_s *slab)
+{
+    return slab->chunk_count * (SLAB_CHUNK_HEADER + (slab->size * SLAB_CHUNK_OBJECTS));
+}
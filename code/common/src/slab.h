@@ -0,0 +1,49 @@
+/*
+ * Slab Allocator Library
+ *
+ * Fixed size objects are allocated from chunks of
+ * SLAB_CHUNK_OBJECTS objects and returned to a free
+ * list. This avoids the per-allocation overhead of
+ * malloc for many small objects of the same type.
+ * Chunks are released with slab_destroy only.
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __COMMON_SLAB_H__
+#define __COMMON_SLAB_H__
+#include "common.h"
+
+#define SLAB_CHUNK_OBJECTS  1024
+#define SLAB_ALIGN          16
+
+typedef struct slab_chunk_ {
+    struct slab_chunk_ *next;
+} slab_chunk_s;
+
+typedef struct slab_ {
+    const char *name;
+    size_t size; /* object size including alignment */
+    slab_chunk_s *chunks;
+    void *free; /* list of free objects */
+    uint64_t chunk_count;
+    uint64_t objects; /* objects in use */
+} slab_s;
+
+void
+slab_init(slab_s *slab, const char *name, size_t size);
+
+void *
+slab_alloc(slab_s *slab);
+
+void
+slab_free(slab_s *slab, void *object);
+
+void
+slab_destroy(slab_s *slab);
+
+size_t
+slab_memory(slab_s *slab);
+
+#endif
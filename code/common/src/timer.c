@@ -9,6 +9,20 @@
 #include "timer.h"
 #include "logging.h"
 
+/**
+ * Get the current time from the external 
+ * clock if set or CLOCK_MONOTONIC.
+ */
+static inline void
+timer_clock(timer_root_s *root, struct timespec *now)
+{
+    if(root->clock) {
+        *now = *root->clock;
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, now);
+    }
+}
+
 /**
  * Set timer expiration.
  */
@@ -143,18 +157,86 @@ timer_change(timer_s *timer)
     timer->on_change_list = true;
 }
 
+static inline uint32_t
+timer_bucket_hash(time_t sec, long nsec)
+{
+    /* Fibonacci hashing of the interval in nanoseconds. */
+    return (((uint64_t)sec * SEC + nsec) * 0x9e3779b97f4a7c15ULL) >> (64 - TIMER_BUCKET_HASH_BITS);
+}
+
+static inline uint64_t
+timer_nsec(struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * SEC + ts->tv_nsec;
+}
+
+static inline uint64_t
+timer_wheel_tick(struct timespec *ts)
+{
+    return timer_nsec(ts) >> TIMER_WHEEL_TICK_BITS;
+}
+
+/**
+ * Enqueue a timer into the timing wheel slot
+ * matching the timer expiration.
+ */
+static void
+timer_wheel_enqueue(timer_root_s *root, timer_s *timer)
+{
+    timer_slot_s *timer_slot;
+    uint64_t nsec = timer_nsec(&timer->expire);
+    uint64_t expire = nsec >> TIMER_WHEEL_TICK_BITS;
+    uint64_t delta;
+    int level = 0;
+
+    if(expire < root->wheel_tick) {
+        /* Already expired, add to current slot. */
+        expire = root->wheel_tick;
+    }
+    delta = expire - root->wheel_tick;
+    if(delta >> (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) {
+        /* Out of range, add to the last slot 
+         * of the last level and re-evaluate. */
+        expire = root->wheel_tick + (1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1;
+        delta = expire - root->wheel_tick;
+    }
+    while(delta >> ((level + 1) * TIMER_WHEEL_BITS)) {
+        level++;
+    }
+    if(level == 0 && nsec < root->wheel_slot_min[expire & TIMER_WHEEL_MASK]) {
+        /* The slot minimum is not updated if timers are removed,
+         * which might cause an early but harmless wakeup. */
+        root->wheel_slot_min[expire & TIMER_WHEEL_MASK] = nsec;
+    }
+
+    timer_slot = &root->wheel_slot[level][(expire >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK];
+    CIRCLEQ_INSERT_TAIL(timer_slot, timer, timer_slot_qnode);
+    timer->timer_slot = timer_slot;
+}
+
+static void
+timer_wheel_dequeue(timer_s *timer)
+{
+    if(timer->timer_slot) {
+        CIRCLEQ_REMOVE(timer->timer_slot, timer, timer_slot_qnode);
+        timer->timer_slot = NULL;
+    }
+}
+
 static void
 timer_enqueue_bucket(timer_root_s *root, timer_s *timer, time_t sec, long nsec)
 {
     timer_bucket_s *timer_bucket;
+    uint32_t hash = timer_bucket_hash(sec, nsec);
 
     /* Find the bucket for insertion. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
-        if(timer_bucket->sec != sec ||  timer_bucket->nsec != nsec) {
-            continue;
+    timer_bucket = root->bucket_hash[hash];
+    while(timer_bucket) {
+        if(timer_bucket->sec == sec && timer_bucket->nsec == nsec) {
+            /* Found it! */
+            goto INSERT;
         }
-        /* Found it! */
-        goto INSERT;
+        timer_bucket = timer_bucket->hash_next;
     }
 
     /* No bucket found that matches the timer values. 
@@ -169,6 +251,8 @@ timer_enqueue_bucket(timer_root_s *root, timer_s *timer, time_t sec, long nsec)
     timer_bucket->sec = sec;
     timer_bucket->nsec = nsec;
     timer_bucket->timer_root = root;
+    timer_bucket->hash_next = root->bucket_hash[hash];
+    root->bucket_hash[hash] = timer_bucket;
     root->buckets++;
 
 #ifdef BNGBLASTER_TIMER_LOGGING
@@ -180,6 +264,9 @@ timer_enqueue_bucket(timer_root_s *root, timer_s *timer, time_t sec, long nsec)
     timer->timer_bucket = timer_bucket;
     CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
     timer_bucket->timers++;
+    if(root->wheel) {
+        timer_wheel_enqueue(root, timer);
+    }
 }
 
 /**
@@ -190,6 +277,7 @@ timer_dequeue_bucket(timer_s *timer)
 {
     timer_root_s *timer_root;
     timer_bucket_s *timer_bucket;
+    timer_bucket_s **hash_ptr;
 
     timer_bucket = timer->timer_bucket;
     timer_root = timer_bucket->timer_root;
@@ -197,11 +285,17 @@ timer_dequeue_bucket(timer_s *timer)
     CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
     timer_bucket->timers--;
     timer->timer_bucket = NULL;
+    timer_wheel_dequeue(timer);
 
     /* If the last timer of a bucket is gone, 
      * remove the bucket as well. */
     if(!timer_bucket->timers) {
         CIRCLEQ_REMOVE(&timer_root->timer_bucket_qhead, timer_bucket, timer_bucket_qnode);
+        hash_ptr = &timer_root->bucket_hash[timer_bucket_hash(timer_bucket->sec, timer_bucket->nsec)];
+        while(*hash_ptr != timer_bucket) {
+            hash_ptr = &(*hash_ptr)->hash_next;
+        }
+        *hash_ptr = timer_bucket->hash_next;
 
 #ifdef BNGBLASTER_TIMER_LOGGING
         LOG(TIMER_DETAIL, "  Delete timer bucket %lu.%06lus\n",
@@ -231,6 +325,10 @@ timer_requeue(timer_s *timer, time_t sec, long nsec)
     if(timer_bucket->sec == sec && timer_bucket->nsec == nsec) {
         CIRCLEQ_REMOVE(&timer_bucket->timer_qhead, timer, timer_qnode);
         CIRCLEQ_INSERT_TAIL(&timer_bucket->timer_qhead, timer, timer_qnode);
+        if(timer_root->wheel) {
+            timer_wheel_dequeue(timer);
+            timer_wheel_enqueue(timer_root, timer);
+        }
     } else {
         timer_dequeue_bucket(timer);
         timer_enqueue_bucket(timer_root, timer, sec, nsec);
@@ -254,7 +352,7 @@ timer_smear_bucket_internal(timer_bucket_s *timer_bucket)
      * between now and last timer. */
     last_timer = CIRCLEQ_LAST(&timer_bucket->timer_qhead);
     if(timer_bucket->timers > 1 && last_timer) {
-        clock_gettime(CLOCK_MONOTONIC, &now);
+        timer_clock(timer_bucket->timer_root, &now);
         timespec_sub(&diff, &last_timer->expire, &now);
         step_nsec = (diff.tv_sec * 1e9 + diff.tv_nsec) / (timer_bucket->timers); /* calculate smear step */
         step.tv_sec = step_nsec / 1e9;
@@ -272,6 +370,10 @@ timer_smear_bucket_internal(timer_bucket_s *timer_bucket)
         CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
             timespec_add(&timer->expire, &now, &step);
             now = timer->expire;
+            if(timer_bucket->timer_root->wheel && timer->timer_slot) {
+                timer_wheel_dequeue(timer);
+                timer_wheel_enqueue(timer_bucket->timer_root, timer);
+            }
 #ifdef BNGBLASTER_TIMER_LOGGING
             LOG(TIMER_DETAIL, "  Smear %s -> expire %lu.%06lus\n", timer->name,
                 timer->expire.tv_sec, timer->expire.tv_nsec / 1000);
@@ -290,12 +392,13 @@ timer_smear_bucket(timer_root_s *root, time_t sec, long nsec)
     timer_bucket_s *timer_bucket;
 
     /* Find the bucket for smearing. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
-        if(timer_bucket->sec != sec ||  timer_bucket->nsec != nsec) {
-            continue;
+    timer_bucket = root->bucket_hash[timer_bucket_hash(sec, nsec)];
+    while(timer_bucket) {
+        if(timer_bucket->sec == sec && timer_bucket->nsec == nsec) {
+            timer_smear_bucket_internal(timer_bucket);
+            return;
         }
-        timer_smear_bucket_internal(timer_bucket);
-        return;
+        timer_bucket = timer_bucket->hash_next;
     }
 }
 
@@ -360,7 +463,7 @@ timer_process_changes(timer_root_s *root)
     timer_bucket_s *timer_bucket;
 
     struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    timer_clock(root, &now);
 
     while(!CIRCLEQ_EMPTY(&root->timer_change_qhead)) {
         timer = CIRCLEQ_FIRST(&root->timer_change_qhead);
@@ -403,7 +506,7 @@ timer_add(timer_root_s *root, timer_s **ptimer, char *name,
 
     /* This timer already is enqueued. Requeue. */
     if(timer) {
-        clock_gettime(CLOCK_MONOTONIC, &timer->expire);
+        timer_clock(root, &timer->expire);
         timer_requeue(timer, sec, nsec);
         /* Update data and cb if there was a change.
          * Do the reformatting of name only during a change. */
@@ -434,7 +537,7 @@ timer_add(timer_root_s *root, timer_s **ptimer, char *name,
     strncpy(timer->name, name, sizeof(timer->name)-1);
     timer->data = data;
     timer->cb = cb;
-    clock_gettime(CLOCK_MONOTONIC, &timer->expire);
+    timer_clock(root, &timer->expire);
     timer_set_expire(timer, sec, nsec);
     timer->ptimer = ptimer;
     *ptimer = timer;
@@ -463,6 +566,124 @@ timer_add_periodic(timer_root_s *root, timer_s **ptimer, char *name,
     }
 }
 
+/**
+ * Execute the callback of an expired timer.
+ */
+static void
+timer_fire(timer_s *timer, struct timespec *now)
+{
+    /* Everything from here one is expired. */
+    timer->expired = true;
+
+    /* Execute callback. */
+    if(timer->cb) {
+        timer->timestamp = now;
+        (*timer->cb)(timer);
+#ifdef BNGBLASTER_TIMER_LOGGING
+        LOG(TIMER_DETAIL, "  Firing %s timer\n", timer->name);
+#endif
+    }
+    if(timer->periodic) {
+        /* Periodic timers are simple de-queued and
+         * re-inserted at the tail of this buckets queue. */
+        timer_change(timer);
+    } else if(timer->expired) {
+        /* Timers restarted in callback will not be expired anymore.
+         * Those timer gets deleted. */
+        timer_del(timer);
+    }
+}
+
+/**
+ * Advance the timing wheel up to now and execute
+ * the callbacks of all expired timers.
+ */
+static void
+timer_wheel_walk(timer_root_s *root, struct timespec *now)
+{
+    timer_slot_s *timer_slot;
+    timer_s *timer;
+    uint64_t now_tick = timer_wheel_tick(now);
+    uint32_t slot;
+    int level;
+
+    while(true) {
+        /* Move all timers of the current slot to the pending list first,
+         * as callbacks might add new timers to the current slot. */
+        slot = root->wheel_tick & TIMER_WHEEL_MASK;
+        timer_slot = &root->wheel_slot[0][slot];
+        if(!CIRCLEQ_EMPTY(timer_slot)) {
+            root->wheel_slot_min[slot] = UINT64_MAX;
+            while(!CIRCLEQ_EMPTY(timer_slot)) {
+                timer = CIRCLEQ_FIRST(timer_slot);
+                timer_wheel_dequeue(timer);
+                if(timespec_compare(&timer->expire, now) == 1) {
+                    /* Timer expires later within the current tick,
+                     * move to pending list and requeue after the slot
+                     * is processed, as callbacks might add new 
+                     * timers to the current slot. */
+                    CIRCLEQ_INSERT_TAIL(&root->wheel_pending, timer, timer_slot_qnode);
+                    timer->timer_slot = &root->wheel_pending;
+                    continue;
+                }
+                /* Expired timers are not linked to any slot 
+                 * until requeued or deleted by change processing. */
+                timer_fire(timer, now);
+            }
+            while(!CIRCLEQ_EMPTY(&root->wheel_pending)) {
+                timer = CIRCLEQ_FIRST(&root->wheel_pending);
+                timer_wheel_dequeue(timer);
+                timer_wheel_enqueue(root, timer);
+            }
+        }
+
+        if(root->wheel_tick >= now_tick) {
+            break;
+        }
+        root->wheel_tick++;
+
+        /* Cascade timers from the next level slot 
+         * if all lower level slots have been passed. */
+        for(level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if(root->wheel_tick & ((1ULL << (level * TIMER_WHEEL_BITS)) - 1)) {
+                break;
+            }
+            timer_slot = &root->wheel_slot[level][(root->wheel_tick >> (level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK];
+            while(!CIRCLEQ_EMPTY(timer_slot)) {
+                timer = CIRCLEQ_FIRST(timer_slot);
+                timer_wheel_dequeue(timer);
+                timer_wheel_enqueue(root, timer);
+            }
+        }
+    }
+}
+
+/**
+ * Figure out the next expiration from the timing wheel, 
+ * which is either the earliest timer of the next non-empty 
+ * slot or the start of the next cascade.
+ */
+static void
+timer_wheel_min(timer_root_s *root, struct timespec *min)
+{
+    uint64_t tick = root->wheel_tick;
+    uint64_t nsec;
+
+    do {
+        nsec = root->wheel_slot_min[tick & TIMER_WHEEL_MASK];
+        if(nsec != UINT64_MAX) {
+            break;
+        }
+        tick++;
+    } while(tick & TIMER_WHEEL_MASK);
+
+    if(nsec == UINT64_MAX) {
+        nsec = tick << TIMER_WHEEL_TICK_BITS;
+    }
+    min->tv_sec = nsec / SEC;
+    min->tv_nsec = nsec % SEC;
+}
+
 /**
  * Process the timer queue.
  *
@@ -481,7 +702,7 @@ timer_walk(timer_root_s *root)
         return;
     }
 
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    timer_clock(root, &now);
 
 #ifdef BNGBLASTER_TIMER_LOGGING
     LOG(TIMER_DETAIL, "Walk timer queue, now %lu.%06lus\n",
@@ -491,77 +712,67 @@ timer_walk(timer_root_s *root)
     min.tv_sec = 0;
     min.tv_nsec = 0;
 
-    /* Walk all buckets. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
+    if(root->wheel) {
+        timer_wheel_walk(root, &now);
+
+        /* Process all changes from the last timer run. */
+        timer_process_changes(root);
+
+        timer_wheel_min(root, &min);
+    } else {
+        /* Walk all buckets. */
+        CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
 
 #ifdef BNGBLASTER_TIMER_LOGGING
-        LOG(TIMER_DETAIL, "  Checking timer bucket %lu.%06lus\n",
-            timer_bucket->sec, timer_bucket->nsec/1000);
+            LOG(TIMER_DETAIL, "  Checking timer bucket %lu.%06lus\n",
+                timer_bucket->sec, timer_bucket->nsec/1000);
 #endif
 
-        /* First pass. Call into expired nodes. */
-        CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
-
-            /* Hitting the first non-expired timer means
-             * we're done processing this buckets queue. */
-            if(timespec_compare(&timer->expire, &now) == 1) {
-                break;
-            }
+            /* First pass. Call into expired nodes. */
+            CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
 
-            /* Everything from here one is expired. */
-            timer->expired = true;
+                /* Hitting the first non-expired timer means
+                 * we're done processing this buckets queue. */
+                if(timespec_compare(&timer->expire, &now) == 1) {
+                    break;
+                }
 
-            /* Execute callback. */
-            if(timer->cb) {
-                timer->timestamp = &now;
-                (*timer->cb)(timer);
-#ifdef BNGBLASTER_TIMER_LOGGING
-                LOG(TIMER_DETAIL, "  Firing %s timer\n", timer->name);
-#endif
-            }
-            if(timer->periodic) {
-                /* Periodic timers are simple de-queued and
-                 * re-inserted at the tail of this buckets queue. */
-                timer_change(timer);
-            } else if(timer->expired) {
-                /* Timers restarted in callback will not be expired anymore.
-                 * Those timer gets deleted. */
-                timer_del(timer);
+                timer_fire(timer, &now);
             }
         }
-    }
 
-    /* Process all changes from the last timer run. */
-    timer_process_changes(root);
+        /* Process all changes from the last timer run. */
+        timer_process_changes(root);
 
-    /* Second pass. Figure out min sleep time. */
-    CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
-        CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
+        /* Second pass. Figure out min sleep time. */
+        CIRCLEQ_FOREACH(timer_bucket, &root->timer_bucket_qhead, timer_bucket_qnode) {
+            CIRCLEQ_FOREACH(timer, &timer_bucket->timer_qhead, timer_qnode) {
 
-            /* Ignore deleted timers that wait for change processing. */
-            if(timer->delete) {
-                continue;
-            }
+                /* Ignore deleted timers that wait for change processing. */
+                if(timer->delete) {
+                    continue;
+                }
 
-            /* First timer in the queue becomes the actual minimum. */
-            if(min.tv_sec == 0 && min.tv_nsec == 0) {
-                min.tv_sec = timer->expire.tv_sec;
-                min.tv_nsec = timer->expire.tv_nsec;
-            }
+                /* First timer in the queue becomes the actual minimum. */
+                if(min.tv_sec == 0 && min.tv_nsec == 0) {
+                    min.tv_sec = timer->expire.tv_sec;
+                    min.tv_nsec = timer->expire.tv_nsec;
+                }
 
-            /* Find the min timer. */
-            if(timespec_compare(&timer->expire, &min) == -1) {
-                min.tv_sec = timer->expire.tv_sec;
-                min.tv_nsec = timer->expire.tv_nsec;
+                /* Find the min timer. */
+                if(timespec_compare(&timer->expire, &min) == -1) {
+                    min.tv_sec = timer->expire.tv_sec;
+                    min.tv_nsec = timer->expire.tv_nsec;
 #ifdef BNGBLASTER_TIMER_LOGGING
-                LOG(TIMER_DETAIL, "New minimum sleep (%s) timer, found %lu.%06lus\n",
-                    timer->name, min.tv_sec, min.tv_nsec / 1000);
+                    LOG(TIMER_DETAIL, "New minimum sleep (%s) timer, found %lu.%06lus\n",
+                        timer->name, min.tv_sec, min.tv_nsec / 1000);
 #endif
-            }
-            /* Hitting the first non-expired timer means
-             * we're done processing this buckets queue. */
-            if(timespec_compare(&timer->expire, &now) == 1) {
-                break;
+                }
+                /* Hitting the first non-expired timer means
+                 * we're done processing this buckets queue. */
+                if(timespec_compare(&timer->expire, &now) == 1) {
+                    break;
+                }
             }
         }
     }
@@ -571,6 +782,10 @@ timer_walk(timer_root_s *root)
     LOG(TIMER_DETAIL, "  Now %lu.%06lus\n", now.tv_sec, now.tv_nsec / 1000);
     LOG(TIMER_DETAIL, "  Min %lu.%06lus\n", min.tv_sec, min.tv_nsec / 1000);
 #endif
+    if(root->clock) {
+        /* Time is advanced by the owner of the external clock. */
+        return;
+    }
     clock_gettime(CLOCK_MONOTONIC, &now);
     if(timespec_compare(&now, &min) == -1) {
         timespec_sub(&sleep, &min, &now);
@@ -598,9 +813,62 @@ timer_walk(timer_root_s *root)
 void
 timer_init_root(timer_root_s *timer_root)
 {
+    struct timespec now;
+    int level, slot;
+
     CIRCLEQ_INIT(&timer_root->timer_bucket_qhead);
     CIRCLEQ_INIT(&timer_root->timer_gc_qhead);
     CIRCLEQ_INIT(&timer_root->timer_change_qhead);
+    memset(timer_root->bucket_hash, 0x0, sizeof(timer_root->bucket_hash));
+
+    for(level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for(slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            CIRCLEQ_INIT(&timer_root->wheel_slot[level][slot]);
+        }
+    }
+    memset(timer_root->wheel_slot_min, 0xff, sizeof(timer_root->wheel_slot_min));
+    CIRCLEQ_INIT(&timer_root->wheel_pending);
+    timer_root->clock = NULL;
+    timer_clock(timer_root, &now);
+    timer_root->wheel_tick = timer_wheel_tick(&now);
+#ifdef BNGBLASTER_TIMER_WHEEL
+    timer_root->wheel = true;
+#else
+    timer_root->wheel = false;
+#endif
+}
+
+/**
+ * Init a timer root using the timing wheel, 
+ * independent of the build default.
+ *
+ * @param root timer root
+ */
+void
+timer_init_root_wheel(timer_root_s *timer_root)
+{
+    timer_init_root(timer_root);
+    timer_root->wheel = true;
+}
+
+/**
+ * Use an external clock instead of CLOCK_MONOTONIC,
+ * which allows to drive the timers with explicit 
+ * timestamps (e.g. for testing). The timer walk
+ * does not sleep with an external clock. This 
+ * function must be called before adding timers.
+ *
+ * @param root timer root
+ * @param clock external clock or NULL
+ */
+void
+timer_set_clock(timer_root_s *timer_root, struct timespec *clock)
+{
+    struct timespec now;
+
+    timer_root->clock = clock;
+    timer_clock(timer_root, &now);
+    timer_root->wheel_tick = timer_wheel_tick(&now);
 }
 
 /**
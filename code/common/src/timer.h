@@ -14,6 +14,23 @@
 #define MSEC 1000000 /* 1 million nanoseconds == 1 msec */
 #define SEC 1000000000 /* 1 billion nanoseconds == 1 sec */
 
+#define TIMER_BUCKET_HASH_BITS 10
+#define TIMER_BUCKET_HASH_SIZE (1 << TIMER_BUCKET_HASH_BITS)
+
+/* Hashed hierarchical timing wheel with 4 levels of 256 slots 
+ * and a tick of 2^16 nanoseconds (65.536us), covering 2^48 
+ * nanoseconds (~78 hours). Timers beyond are re-evaluated 
+ * when cascaded from the last level. */
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_TICK_BITS 16
+
+/* List of timers in a timing wheel slot. */
+CIRCLEQ_HEAD(timer_slot_, timer_ );
+typedef struct timer_slot_ timer_slot_s;
+
 /*  Top level data structure for timers. */
 typedef struct timer_root_
 {
@@ -21,9 +38,21 @@ typedef struct timer_root_
     CIRCLEQ_HEAD(timer_gc_root_, timer_ ) timer_gc_qhead; /* Garbage collection list */
     CIRCLEQ_HEAD(timer_change_root_, timer_ ) timer_change_qhead; /* Change timers list */
 
+    struct timer_bucket_ *bucket_hash[TIMER_BUCKET_HASH_SIZE]; /* Bucket lookup */
+
     uint32_t buckets; /* # of buckets hanging off */
     uint32_t gc; /* # of timers waiting for GC */
 
+    struct timespec *clock; /* external clock (see timer_set_clock) */
+
+    /* Timing wheel, replaces the walk over all 
+     * buckets to find expired timers if enabled. */
+    bool wheel;
+    uint64_t wheel_tick; /* current tick */
+    timer_slot_s wheel_slot[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t wheel_slot_min[TIMER_WHEEL_SLOTS]; /* earliest expiration of level 0 slots (nsec) */
+    timer_slot_s wheel_pending; /* timers taken from current slot */
+
 } timer_root_s;
 
 /* Group each like timers (e.g. all 100ms, 1s, 5s timers) into a timer bucket.
@@ -36,6 +65,7 @@ typedef struct timer_bucket_
     CIRCLEQ_ENTRY(timer_bucket_) timer_bucket_qnode; /* node in bucket list */
 
     struct timer_root_ *timer_root; /* back pointer */
+    struct timer_bucket_ *hash_next; /* next bucket in hash chain */
 
     time_t sec;
     long nsec;
@@ -48,6 +78,8 @@ typedef struct timer_
 {
     CIRCLEQ_ENTRY(timer_) timer_qnode;
     CIRCLEQ_ENTRY(timer_) timer_change_qnode;
+    CIRCLEQ_ENTRY(timer_) timer_slot_qnode; /* node in timing wheel slot */
+    timer_slot_s *timer_slot; /* timing wheel slot back pointer (NULL if expired) */
     struct timespec expire; /* expiration interval */
     struct timespec *timestamp;
     struct timer_bucket_ *timer_bucket; /* back pointer */
@@ -98,6 +130,12 @@ timer_walk(timer_root_s *root);
 void
 timer_init_root(timer_root_s *timer_root);
 
+void
+timer_init_root_wheel(timer_root_s *timer_root);
+
+void
+timer_set_clock(timer_root_s *timer_root, struct timespec *clock);
+
 void
 timer_flush_root(timer_root_s *timer_root);
 
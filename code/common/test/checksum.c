@@ -34,9 +34,101 @@ test_calculate_fletcher_checksum(void **unused) {
     assert_int_equal(checksum, pdu1_checksum);
 }
 
+static void
+test_fletcher_checksum_corpus(void **unused) {
+    (void) unused;
+
+    uint8_t pdu[9000+8];
+    uint8_t scalar[sizeof(pdu)];
+    uint8_t simd[sizeof(pdu)];
+    uint16_t checksum;
+    size_t len, offset;
+    int pattern;
+
+    srand(1);
+    for(pattern = 0; pattern < 3; pattern++) {
+        for(len = 0; len < sizeof(pdu); len++) {
+            switch(pattern) {
+                case 0: pdu[len] = rand(); break;
+                case 1: pdu[len] = 0xff; break;
+                default: pdu[len] = (len & 1) ? 0xff : 0; break;
+            }
+        }
+        for(offset = 0; offset < 4; offset++) {
+            for(len = 14; len <= 9000; len += (len < 512) ? 1 : 97) {
+                memcpy(scalar, pdu, sizeof(pdu));
+                memcpy(simd, pdu, sizeof(pdu));
+                checksum = calculate_fletcher_checksum_generic(scalar+offset, 12, len);
+                assert_int_equal(calculate_fletcher_checksum(simd+offset, 12, len), checksum);
+                assert_int_equal(validate_fletcher_checksum(pdu+offset, len), 
+                                 validate_fletcher_checksum_generic(pdu+offset, len));
+
+                /* Validate PDU with checksum. */
+                simd[offset+12] = checksum >> 8;
+                simd[offset+13] = checksum & 0xff;
+                assert_int_equal(validate_fletcher_checksum(simd+offset, len), 0);
+            }
+        }
+    }
+}
+
+static uint32_t
+test_checksum_sum_reference(const uint8_t *buf, size_t len)
+{
+    uint64_t sum = 0;
+    uint16_t word;
+    while(len > 1) {
+        memcpy(&word, buf, sizeof(word));
+        sum += word;
+        buf += 2;
+        len -= 2;
+    }
+    if(len) {
+        sum += *buf;
+    }
+    while(sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum;
+}
+
+static void
+test_checksum_sum(void **unused) {
+    (void) unused;
+
+    uint8_t buf[4096+8];
+    size_t len, offset;
+
+    srand(1);
+    for(len = 0; len < sizeof(buf); len++) {
+        buf[len] = rand();
+    }
+    for(offset = 0; offset < 8; offset++) {
+        for(len = 0; len <= 4096; len += (len < 256) ? 1 : 61) {
+            assert_int_equal(checksum_sum(buf+offset, len), test_checksum_sum_reference(buf+offset, len));
+            assert_int_equal(checksum_sum_generic(buf+offset, len), test_checksum_sum_reference(buf+offset, len));
+        }
+    }
+
+    /* All ones must not overflow the SIMD lanes. */
+    memset(buf, 0xff, sizeof(buf));
+    assert_int_equal(checksum_sum(buf, 4096), 0xffff);
+    assert_int_equal(checksum_sum(buf, 4095), test_checksum_sum_reference(buf, 4095));
+
+    /* Buffers larger than the SIMD block limit. */
+    len = 1024*1024+3;
+    uint8_t *large = malloc(len);
+    assert_non_null(large);
+    memset(large, 0xff, len);
+    assert_int_equal(checksum_sum(large, len), test_checksum_sum_reference(large, len));
+    free(large);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_calculate_fletcher_checksum),
+        cmocka_unit_test(test_fletcher_checksum_corpus),
+        cmocka_unit_test(test_checksum_sum),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
\ No newline at end of file
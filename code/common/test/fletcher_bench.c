@@ -0,0 +1,64 @@
+/*
+ * Fletcher Checksum Micro-Benchmark
+ *
+ * Compare the scalar and SIMD OSI Fletcher checksum
+ * for typical IS-IS LSP sizes.
+ *
+ * Usage: bench-fletcher [iterations]
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <checksum.h>
+
+static volatile uint32_t g_result = 0;
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_fletcher(uint16_t (*fn)(uint8_t *pptr, uint checksum_offset, uint length),
+               uint8_t *buf, uint len, uint32_t iterations)
+{
+    double start = bench_cpu_time();
+    uint32_t i;
+
+    for(i = 0; i < iterations; i++) {
+        g_result += fn(buf, 12, len);
+    }
+    return (bench_cpu_time() - start) * 1e9 / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    uint sizes[] = { 64, 256, 512, 1492, 4096, 9000 };
+    uint32_t iterations = 1000000;
+    double scalar, simd;
+    uint8_t *buf;
+    size_t i;
+
+    if(argc > 1) iterations = strtoul(argv[1], NULL, 10);
+    if(!iterations) iterations = 1;
+
+    buf = malloc(UINT16_MAX);
+    if(!buf) {
+        exit(1);
+    }
+    for(i = 0; i < UINT16_MAX; i++) {
+        buf[i] = rand();
+    }
+
+    printf("%u iterations, fletcher checksum using %s\n", iterations, checksum_sum_name());
+    printf("%6s %12s %12s %8s\n", "bytes", "scalar ns", "simd ns", "speedup");
+    for(i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        scalar = bench_fletcher(calculate_fletcher_checksum_generic, buf, sizes[i], iterations);
+        simd = bench_fletcher(calculate_fletcher_checksum, buf, sizes[i], iterations);
+        printf("%6u %12.1f %12.1f %7.1fx\n", sizes[i], scalar, simd, simd > 0 ? scalar / simd : 0);
+    }
+    free(buf);
+    return 0;
+}
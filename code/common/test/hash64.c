@@ -0,0 +1,73 @@
+/*
+ * Open Addressing Hash Table Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <hash64.h>
+
+static void
+test_hash64(void **unused) {
+    (void) unused;
+
+    hash64_s table;
+    uint64_t count = 100000;
+    uint64_t key;
+    void **value;
+    bool inserted;
+
+    assert_true(hash64_init(&table, 10));
+    assert_int_equal(table.size, HASH64_MIN_SIZE);
+    assert_null(hash64_search(&table, 0));
+    assert_null(hash64_search(&table, HASH64_EMPTY));
+    assert_null(hash64_insert(&table, HASH64_EMPTY, &inserted));
+    assert_false(inserted);
+
+    /* Keys with equal lower bits (ifindex) and zero. */
+    for(key = 0; key < count; key++) {
+        value = hash64_insert(&table, key << 32, &inserted);
+        assert_non_null(value);
+        assert_true(inserted);
+        *value = (void*)(uintptr_t)(key+1);
+    }
+    assert_int_equal(table.count, count);
+    assert_true(table.count * 2 <= table.size);
+    assert_int_equal(table.size & (table.size - 1), 0);
+
+    for(key = 0; key < count; key++) {
+        value = hash64_search(&table, key << 32);
+        assert_non_null(value);
+        assert_int_equal((uintptr_t)*value, key+1);
+        assert_null(hash64_search(&table, (key << 32) | 1));
+    }
+
+    /* Duplicate insert returns existing value. */
+    value = hash64_insert(&table, 42ULL << 32, &inserted);
+    assert_non_null(value);
+    assert_false(inserted);
+    assert_int_equal((uintptr_t)*value, 43);
+    assert_int_equal(table.count, count);
+
+    /* NULL values are stored as well. */
+    value = hash64_insert(&table, 1, &inserted);
+    assert_true(inserted);
+    assert_null(*value);
+    value = hash64_search(&table, 1);
+    assert_non_null(value);
+    assert_null(*value);
+
+    hash64_destroy(&table);
+    assert_null(table.entries);
+    assert_int_equal(table.count, 0);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_hash64),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
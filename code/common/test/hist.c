@@ -0,0 +1,93 @@
+/*
+ * Log-Linear Histogram Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <hist.h>
+
+static void
+test_hist_index(void **unused) {
+    (void) unused;
+
+    uint64_t value;
+    uint32_t index;
+    uint32_t last = 0;
+
+    for(value = 0; value < (1ULL << HIST_MAX_BITS); value++) {
+        index = hist_index(value);
+        assert_true(index < HIST_BUCKETS);
+        assert_true(index >= last);
+        assert_true(index <= last + 1);
+        assert_true(value <= hist_bucket_max(index));
+        if(index) {
+            assert_true(value > hist_bucket_max(index-1));
+        }
+        /* Relative error is bound by sub-buckets. */
+        assert_true((hist_bucket_max(index) - value) * HIST_SUB_COUNT <= value);
+        last = index;
+    }
+    assert_int_equal(last, HIST_BUCKETS - 1);
+    assert_int_equal(hist_index(1ULL << HIST_MAX_BITS), HIST_OVERFLOW);
+    assert_int_equal(hist_index(UINT64_MAX), HIST_OVERFLOW);
+}
+
+static void
+test_hist_percentile(void **unused) {
+    (void) unused;
+
+    hist_s hist = {0};
+    hist_s merged = {0};
+    uint64_t value;
+
+    assert_int_equal(hist_percentile(&hist, 50), 0);
+
+    for(value = 1; value <= 1000; value++) {
+        hist_add(&hist, value);
+    }
+    assert_int_equal(hist.count, 1000);
+    assert_int_equal(hist.max, 1000);
+    value = hist_percentile(&hist, 50);
+    assert_true(value >= 500 && value <= 500 + 500/HIST_SUB_COUNT);
+    value = hist_percentile(&hist, 99);
+    assert_true(value >= 990 && value <= 1000);
+    assert_int_equal(hist_percentile(&hist, 100), 1000);
+    assert_int_equal(hist_percentile(&hist, 0), 1);
+
+    hist_merge(&merged, &hist);
+    hist_merge(&merged, &hist);
+    assert_int_equal(merged.count, 2000);
+    assert_int_equal(hist_percentile(&merged, 50), hist_percentile(&hist, 50));
+
+    hist_add(&merged, 1ULL << 40);
+    assert_int_equal(merged.overflow, 1);
+    assert_int_equal(merged.count, 2001);
+    assert_int_equal(merged.bucket[HIST_BUCKETS - 1], 0);
+    assert_int_equal(hist_percentile(&merged, 100), 1ULL << 40);
+    assert_int_equal(hist_percentile(&merged, 50), hist_percentile(&hist, 50));
+
+    /* Largest value below overflow. */
+    hist_add(&merged, (1ULL << HIST_MAX_BITS) - 1);
+    assert_int_equal(merged.overflow, 1);
+    assert_int_equal(merged.bucket[HIST_BUCKETS - 1], 1);
+
+    hist_merge(&hist, &merged);
+    assert_int_equal(hist.overflow, 1);
+
+    hist_reset(&merged);
+    assert_int_equal(merged.count, 0);
+    assert_int_equal(merged.overflow, 0);
+    assert_int_equal(hist_percentile(&merged, 99), 0);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_hist_index),
+        cmocka_unit_test(test_hist_percentile),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
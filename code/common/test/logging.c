@@ -0,0 +1,174 @@
+/*
+ * Logging Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <cmocka.h>
+#include <logging.h>
+
+keyval_t log_names[] = {
+    { INFO, "info" },
+    { 0, NULL}
+};
+
+static char *
+test_log_read(FILE *fp)
+{
+    static char buf[1024*1024];
+    size_t len;
+
+    fflush(fp);
+    rewind(fp);
+    len = fread(buf, 1, sizeof(buf)-1, fp);
+    buf[len] = 0;
+    return buf;
+}
+
+/* Return the line without timestamp. */
+static char *
+test_log_line(char **cur)
+{
+    char *line = strchr(*cur, '\n');
+    char *msg;
+
+    assert_non_null(line);
+    *line = 0;
+    msg = strchr(*cur, '.'); /* skip "Jun 19 08:07:13.711541 " */
+    assert_non_null(msg);
+    msg += 8;
+    *cur = line + 1;
+    return msg;
+}
+
+static void
+test_log_async_format(void **unused) {
+    (void) unused;
+    char str[] = "string";
+    char *cur;
+
+    g_log_fp = tmpfile();
+    assert_non_null(g_log_fp);
+    log_enable("info");
+    assert_true(log_async_start(false));
+    log_async_console(true);
+    assert_true(g_log_async);
+
+    LOG_NOARG(INFO, "no arguments 100%%\n");
+    LOG(INFO, "int %d %i %u %x %05X %o\n", -1, 2, 3u, 255, 0xabc, 8);
+    LOG(INFO, "length %hhd %hu %ld %lu %lld %llx %zu %zd\n",
+        (signed char)-2, (unsigned short)65535, -3L, 4UL, -5LL, 0xdeadbeefcafeULL, (size_t)6, (ssize_t)-7);
+    LOG(INFO, "width %-4d| %*d| %.*s| %.3s|\n", 1, 5, 2, 3, "abcdef", "uvwxyz");
+    LOG(INFO, "float %.2f %e %Lg\n", 1.5, 100.0, (long double)0.25);
+    LOG(INFO, "char %c string %s\n", 'x', str);
+    memset(str, 'X', sizeof(str)-1); /* copied at record time */
+    log_async_stop();
+    assert_false(g_log_async);
+
+    cur = test_log_read(g_log_fp);
+    assert_string_equal(test_log_line(&cur), "no arguments 100%");
+    assert_string_equal(test_log_line(&cur), "int -1 2 3 ff 00ABC 10");
+    assert_string_equal(test_log_line(&cur), "length -2 65535 -3 4 -5 deadbeefcafe 6 -7");
+    assert_string_equal(test_log_line(&cur), "width 1   |     2| abc| uvw|");
+    assert_string_equal(test_log_line(&cur), "float 1.50 1.000000e+02 0.25");
+    assert_string_equal(test_log_line(&cur), "char x string string");
+    assert_string_equal(cur, "");
+
+    fclose(g_log_fp);
+    g_log_fp = NULL;
+}
+
+static void
+test_log_async_truncated(void **unused) {
+    (void) unused;
+    char str[LOG_ASYNC_ARGS_LEN*2];
+    char *cur;
+    char *line;
+
+    memset(str, 'a', sizeof(str)-1);
+    str[sizeof(str)-1] = 0;
+
+    g_log_fp = tmpfile();
+    assert_non_null(g_log_fp);
+    assert_true(log_async_start(false));
+    log_async_console(true);
+    LOG(INFO, "%d %s %d\n", 1, str, 2);
+    log_async_stop();
+
+    cur = test_log_read(g_log_fp);
+    line = test_log_line(&cur);
+    assert_int_equal(strncmp(line, "1 aaaa", 6), 0);
+    assert_int_equal(strlen(line), strlen("1 ") + LOG_ASYNC_ARGS_LEN - sizeof(int64_t) - 1 + strlen(" ..."));
+    assert_string_equal(line + strlen(line) - 3, "...");
+
+    fclose(g_log_fp);
+    g_log_fp = NULL;
+}
+
+static void *
+test_log_async_thread(void *arg)
+{
+    uintptr_t id = (uintptr_t)arg;
+    int i;
+    for(i = 0; i < 1000; i++) {
+        LOG(INFO, "thread %lu message %d\n", (unsigned long)id, i);
+    }
+    return NULL;
+}
+
+static void
+test_log_async_threads(void **unused) {
+    (void) unused;
+    pthread_t threads[4];
+    int next[4] = {0};
+    unsigned long id;
+    char *cur;
+    char *line;
+    int i;
+    int msg;
+    int lines = 0;
+
+    g_log_fp = tmpfile();
+    assert_non_null(g_log_fp);
+    assert_true(log_async_start(true));
+    log_async_console(true);
+    for(i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, test_log_async_thread, (void*)(uintptr_t)i);
+    }
+    for(i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    log_async_stop();
+
+    /* Messages of each thread are written in order, 
+     * either all or counted as dropped. */
+    cur = test_log_read(g_log_fp);
+    while(*cur) {
+        line = test_log_line(&cur);
+        if(strncmp(line, "Logging dropped", 15) == 0) {
+            continue;
+        }
+        assert_int_equal(sscanf(line, "thread %lu message %d", &id, &msg), 2);
+        assert_true(id < 4);
+        assert_true(msg >= next[id]);
+        next[id] = msg + 1;
+        lines++;
+    }
+    assert_true(lines > 0);
+
+    fclose(g_log_fp);
+    g_log_fp = NULL;
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_log_async_format),
+        cmocka_unit_test(test_log_async_truncated),
+        cmocka_unit_test(test_log_async_threads),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,75 @@
+/*
+ * Slab Allocator Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <slab.h>
+
+typedef struct test_object_ {
+    uint64_t id;
+    uint8_t data[100];
+} test_object_s;
+
+static void
+test_slab(void **unused) {
+    (void) unused;
+
+    slab_s slab;
+    test_object_s **objects;
+    test_object_s *object;
+    uint32_t count = SLAB_CHUNK_OBJECTS * 3 + 1;
+    uint32_t i, i2;
+
+    slab_init(&slab, "test", sizeof(test_object_s));
+    assert_int_equal(slab.size % SLAB_ALIGN, 0);
+    assert_true(slab.size >= sizeof(test_object_s));
+
+    objects = calloc(count, sizeof(test_object_s*));
+    assert_non_null(objects);
+    for(i = 0; i < count; i++) {
+        object = slab_alloc(&slab);
+        assert_non_null(object);
+        assert_int_equal((uintptr_t)object % SLAB_ALIGN, 0);
+        for(i2 = 0; i2 < sizeof(object->data); i2++) {
+            assert_int_equal(object->data[i2], 0);
+        }
+        object->id = i;
+        memset(object->data, 0xff, sizeof(object->data));
+        objects[i] = object;
+    }
+    assert_int_equal(slab.objects, count);
+    assert_int_equal(slab.chunk_count, 4);
+    for(i = 0; i < count; i++) {
+        assert_int_equal(objects[i]->id, i);
+    }
+
+    /* Free objects are reused before growing. */
+    slab_free(&slab, objects[10]);
+    slab_free(&slab, objects[20]);
+    assert_int_equal(slab.objects, count - 2);
+    object = slab_alloc(&slab);
+    assert_true(object == objects[20]);
+    assert_int_equal(object->id, 0);
+    object = slab_alloc(&slab);
+    assert_true(object == objects[10]);
+    assert_int_equal(slab.chunk_count, 4);
+    assert_int_equal(slab_memory(&slab), slab.chunk_count * (16 + slab.size * SLAB_CHUNK_OBJECTS));
+
+    slab_destroy(&slab);
+    assert_int_equal(slab.objects, 0);
+    assert_int_equal(slab.chunk_count, 0);
+    assert_int_equal(slab_memory(&slab), 0);
+    free(objects);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_slab),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,151 @@
+/*
+ * Timer Tests
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <timer.h>
+#include <logging.h>
+
+keyval_t log_names[] = {
+    { 0, NULL}
+};
+
+typedef struct test_timer_ {
+    timer_s *timer;
+    uint32_t fired;
+} test_timer_s;
+
+static void
+test_timer_cb(timer_s *timer)
+{
+    test_timer_s *test = timer->data;
+    test->fired++;
+}
+
+static void
+test_timer_restart_cb(timer_s *timer)
+{
+    test_timer_s *test = timer->data;
+    test->fired++;
+    if(test->fired < 3) {
+        timer_add(timer->timer_bucket->timer_root, &test->timer, "restart", 0, MSEC, test, &test_timer_restart_cb);
+    }
+}
+
+/* Advance the external clock in steps of 100us 
+ * up to msec milliseconds and walk the timers 
+ * with every step. */
+static void
+test_timer_run(timer_root_s *root, struct timespec *clock, uint32_t msec)
+{
+    uint32_t step;
+
+    for(step = 0; step < msec * 10; step++) {
+        clock->tv_nsec += 100000;
+        if(clock->tv_nsec >= SEC) {
+            clock->tv_nsec -= SEC;
+            clock->tv_sec++;
+        }
+        timer_walk(root);
+    }
+}
+
+static void
+test_timer(timer_root_s *root)
+{
+    struct timespec clock = { .tv_sec = 1000, .tv_nsec = 999000000 };
+    test_timer_s oneshot = {0};
+    test_timer_s periodic = {0};
+    test_timer_s deleted = {0};
+    test_timer_s restart = {0};
+    test_timer_s later = {0};
+    test_timer_s cascade = {0};
+    test_timer_s many[64] = {0};
+    int i;
+
+    timer_set_clock(root, &clock);
+
+    timer_add(root, &oneshot.timer, "oneshot", 0, 5 * MSEC, &oneshot, &test_timer_cb);
+    timer_add_periodic(root, &periodic.timer, "periodic", 0, 10 * MSEC, &periodic, &test_timer_cb);
+    timer_add(root, &deleted.timer, "deleted", 0, 20 * MSEC, &deleted, &test_timer_cb);
+    timer_add(root, &restart.timer, "restart", 0, MSEC, &restart, &test_timer_restart_cb);
+    timer_add(root, &later.timer, "later", 100, 0, &later, &test_timer_cb);
+    timer_add(root, &cascade.timer, "cascade", 2, 500 * MSEC, &cascade, &test_timer_cb);
+    for(i = 0; i < 64; i++) {
+        timer_add(root, &many[i].timer, "many", 0, (i+1) * MSEC, &many[i], &test_timer_cb);
+    }
+    timer_del(deleted.timer);
+
+    test_timer_run(root, &clock, 4);
+    assert_int_equal(oneshot.fired, 0);
+    assert_int_equal(restart.fired, 3);
+    assert_null(restart.timer);
+    for(i = 0; i < 64; i++) {
+        assert_int_equal(many[i].fired, i < 4 ? 1 : 0);
+    }
+
+    test_timer_run(root, &clock, 101);
+    assert_int_equal(oneshot.fired, 1);
+    assert_null(oneshot.timer);
+    assert_int_equal(deleted.fired, 0);
+    assert_null(deleted.timer);
+    assert_int_equal(later.fired, 0);
+    assert_non_null(later.timer);
+    for(i = 0; i < 64; i++) {
+        assert_int_equal(many[i].fired, 1);
+        assert_null(many[i].timer);
+    }
+    assert_int_equal(periodic.fired, 10);
+
+    /* Deleted timers are removed with the next walk. */
+    timer_del(periodic.timer);
+    test_timer_run(root, &clock, 30);
+    assert_int_equal(periodic.fired, 10);
+    assert_null(periodic.timer);
+
+    /* Timers beyond the first wheel level are cascaded. */
+    test_timer_run(root, &clock, 2364);
+    assert_int_equal(cascade.fired, 0);
+    test_timer_run(root, &clock, 1);
+    assert_int_equal(cascade.fired, 1);
+    assert_null(cascade.timer);
+    assert_int_equal(later.fired, 0);
+
+    timer_flush_root(root);
+    assert_null(later.timer);
+    assert_int_equal(root->buckets, 0);
+}
+
+static void
+test_timer_buckets(void **unused) {
+    (void) unused;
+
+    timer_root_s *root = calloc(1, sizeof(timer_root_s));
+    timer_init_root(root);
+    root->wheel = false;
+    test_timer(root);
+    free(root);
+}
+
+static void
+test_timer_wheel(void **unused) {
+    (void) unused;
+
+    timer_root_s *root = calloc(1, sizeof(timer_root_s));
+    timer_init_root_wheel(root);
+    test_timer(root);
+    free(root);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_timer_buckets),
+        cmocka_unit_test(test_timer_wheel),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
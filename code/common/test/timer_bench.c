@@ -0,0 +1,123 @@
+/*
+ * Timer Micro-Benchmark
+ *
+ * Compare the bucket list and timing wheel backends
+ * with periodic timers spread over many intervals.
+ *
+ * The timers are driven by an external clock, which
+ * is advanced by a fixed step with every walk, such
+ * that only the CPU time of the timer library is
+ * measured (no sleep and no system calls).
+ *
+ * Usage: bench-timer [timers] [intervals] [seconds] [step-usec]
+ *
+ * Copyright (C) 2020-2025, RtBrick, Inc.
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include <timer.h>
+#include <logging.h>
+
+keyval_t log_names[] = {
+    { 0, NULL}
+};
+
+static uint64_t g_fired = 0;
+
+static void
+bench_timer_cb(timer_s *timer)
+{
+    (void) timer;
+    g_fired++;
+}
+
+static double
+bench_cpu_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_timer(const char *name, bool wheel, bool smear, uint32_t timers,
+            uint32_t intervals, uint32_t seconds, uint32_t step)
+{
+    timer_root_s *root = calloc(1, sizeof(timer_root_s));
+    timer_s **timer = calloc(timers, sizeof(timer_s*));
+    struct timespec clock = { .tv_sec = 1000, .tv_nsec = 0 };
+    uint64_t walks = 0;
+    uint64_t steps;
+    double start, add, walk, flush;
+    uint32_t i;
+
+    if(!(root && timer)) {
+        exit(1);
+    }
+
+    if(wheel) {
+        timer_init_root_wheel(root);
+    } else {
+        timer_init_root(root);
+        root->wheel = false;
+    }
+    timer_set_clock(root, &clock);
+    g_fired = 0;
+
+    /* Add periodic timers with intervals from 1s
+     * in steps of 1ms, creating one bucket per interval. */
+    start = bench_cpu_time();
+    for(i = 0; i < timers; i++) {
+        timer_add_periodic(root, &timer[i], "bench", 1 + (i % intervals) / 1000, 
+                           ((i % intervals) % 1000) * MSEC, NULL, &bench_timer_cb);
+        /* Timers are added over the first second. */
+        if(smear) {
+            clock.tv_nsec = (uint64_t)i * SEC / timers;
+        }
+    }
+    add = bench_cpu_time() - start;
+
+    steps = (uint64_t)seconds * SEC / (step * 1000ULL);
+    start = bench_cpu_time();
+    while(walks < steps) {
+        clock.tv_nsec += step * 1000;
+        if(clock.tv_nsec >= SEC) {
+            clock.tv_nsec -= SEC;
+            clock.tv_sec++;
+        }
+        timer_walk(root);
+        walks++;
+    }
+    walk = bench_cpu_time() - start;
+
+    start = bench_cpu_time();
+    timer_flush_root(root);
+    flush = bench_cpu_time() - start;
+
+    printf("%-8s %-9s add %7.3fs  walk %7.3fs (%lu fired, %6.1f ns/fired, %8.1f ns/walk)  flush %7.3fs\n",
+           name, smear ? "spread" : "clustered", add, walk, g_fired,
+           g_fired ? walk * 1e9 / g_fired : 0, walk * 1e9 / walks, flush);
+
+    free(timer);
+    free(root);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t timers = 1000000;
+    uint32_t intervals = 1000;
+    uint32_t seconds = 10;
+    uint32_t step = 100;
+
+    if(argc > 1) timers = strtoul(argv[1], NULL, 10);
+    if(argc > 2) intervals = strtoul(argv[2], NULL, 10);
+    if(argc > 3) seconds = strtoul(argv[3], NULL, 10);
+    if(argc > 4) step = strtoul(argv[4], NULL, 10);
+    if(!intervals) intervals = 1;
+    if(!step) step = 1;
+
+    printf("%u timers, %u intervals, %u seconds, %u usec per walk\n", timers, intervals, seconds, step);
+    bench_timer("buckets", false, false, timers, intervals, seconds, step);
+    bench_timer("wheel", true, false, timers, intervals, seconds, step);
+    bench_timer("buckets", false, true, timers, intervals, seconds, step);
+    bench_timer("wheel", true, true, timers, intervals, seconds, step);
+    return 0;
+}
@@ -97,20 +97,13 @@ lspgen_gen_packet_header(lsdb_ctx_t *ctx, lsdb_node_t *node, lsdb_packet_t *pack
     }
 }
 
-static uint32_t
+static inline uint32_t
 _checksum(void *buf, ssize_t len)
 {
-    uint32_t result = 0;
-    uint16_t *cur = buf;
-    while (len > 1) {
-        result += *cur++;
-        len -= 2;
-    }
-    /*  Add left-over byte, if any */
-    if(len) {
-        result += *(uint8_t*)cur;
+    if(len <= 0) {
+        return 0;
     }
-    return result;
+    return checksum_sum(buf, len);
 }
 
 static uint32_t
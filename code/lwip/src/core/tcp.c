@@ -1161,6 +1161,9 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   pcb->mss = INITIAL_MSS;
 #if TCP_CALCULATE_EFF_SEND_MSS
   pcb->mss = tcp_eff_send_mss_netif(pcb->mss, netif, &pcb->remote_ip);
+#ifdef LWIP_HOOK_TCP_EFF_SEND_MSS
+  pcb->mss = LWIP_HOOK_TCP_EFF_SEND_MSS(pcb, pcb->mss);
+#endif /* LWIP_HOOK_TCP_EFF_SEND_MSS */
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
   pcb->cwnd = 1;
 #if LWIP_CALLBACK_API
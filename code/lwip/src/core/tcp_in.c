@@ -247,6 +247,12 @@ tcp_input(struct pbuf *p, struct netif *inp)
      for an active connection. */
   prev = NULL;
 
+#ifdef LWIP_HOOK_TCP_INPUT_PCB
+  /* Demultiplex by hook (e.g. per session) before
+     searching the list of all active connections. */
+  pcb = LWIP_HOOK_TCP_INPUT_PCB(tcphdr, inp);
+  if (pcb == NULL)
+#endif /* LWIP_HOOK_TCP_INPUT_PCB */
   for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
     LWIP_ASSERT("tcp_input: active pcb->state != CLOSED", pcb->state != CLOSED);
     LWIP_ASSERT("tcp_input: active pcb->state != TIME-WAIT", pcb->state != TIME_WAIT);
@@ -711,6 +717,9 @@ tcp_listen_input(struct tcp_pcb_listen *pcb)
 
 #if TCP_CALCULATE_EFF_SEND_MSS
     npcb->mss = tcp_eff_send_mss(npcb->mss, &npcb->local_ip, &npcb->remote_ip);
+#ifdef LWIP_HOOK_TCP_EFF_SEND_MSS
+    npcb->mss = LWIP_HOOK_TCP_EFF_SEND_MSS(npcb, npcb->mss);
+#endif /* LWIP_HOOK_TCP_EFF_SEND_MSS */
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
 
     MIB2_STATS_INC(mib2.tcppassiveopens);
@@ -882,6 +891,9 @@ tcp_process(struct tcp_pcb *pcb)
 
 #if TCP_CALCULATE_EFF_SEND_MSS
         pcb->mss = tcp_eff_send_mss(pcb->mss, &pcb->local_ip, &pcb->remote_ip);
+#ifdef LWIP_HOOK_TCP_EFF_SEND_MSS
+        pcb->mss = LWIP_HOOK_TCP_EFF_SEND_MSS(pcb, pcb->mss);
+#endif /* LWIP_HOOK_TCP_EFF_SEND_MSS */
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
 
         pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
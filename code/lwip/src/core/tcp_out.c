@@ -1502,6 +1502,9 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     u16_t mss;
 #if TCP_CALCULATE_EFF_SEND_MSS
     mss = tcp_eff_send_mss_netif(TCP_MSS, netif, &pcb->remote_ip);
+#ifdef LWIP_HOOK_TCP_EFF_SEND_MSS
+    mss = LWIP_HOOK_TCP_EFF_SEND_MSS(pcb, mss);
+#endif /* LWIP_HOOK_TCP_EFF_SEND_MSS */
 #else /* TCP_CALCULATE_EFF_SEND_MSS */
     mss = TCP_MSS;
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
@@ -2895,6 +2895,45 @@
 #define LWIP_HOOK_TCP_INPACKET_PCB(pcb, hdr, optlen, opt1len, opt2, p)
 #endif
 
+/**
+ * LWIP_HOOK_TCP_INPUT_PCB:
+ * Hook for demultiplexing incoming segments to an active connection before
+ * the list of all active connections is searched.
+ * Signature:\code{.c}
+ * struct tcp_pcb *my_hook_tcp_input_pcb(const struct tcp_hdr *hdr, struct netif *inp);
+ * \endcode
+ * Arguments:
+ * - hdr: pointer to tcp header (ports already converted to host byte order)
+ * - inp: network interface on which the segment was received
+ * Return value:
+ * - active tcp_pcb matching the connection 4-tuple of the segment
+ * - NULL: continue with the lookup in the list of all connections
+ *
+ * ATTENTION: the returned pcb must be in the list of active connections
+ * (not CLOSED, LISTEN or TIME_WAIT)!
+ */
+#ifdef __DOXYGEN__
+#define LWIP_HOOK_TCP_INPUT_PCB(hdr, inp)
+#endif
+
+/**
+ * LWIP_HOOK_TCP_EFF_SEND_MSS:
+ * Hook for limiting the effective send MSS of a connection, calculated
+ * from the MTU of the outgoing interface, e.g. if multiple connections with
+ * different path MTU share one interface.
+ * Signature:\code{.c}
+ * u16_t my_hook_tcp_eff_send_mss(const struct tcp_pcb *pcb, u16_t mss);
+ * \endcode
+ * Arguments:
+ * - pcb: tcp_pcb of the connection
+ * - mss: effective send MSS calculated by the stack
+ * Return value:
+ * - effective send MSS (<= mss)
+ */
+#ifdef __DOXYGEN__
+#define LWIP_HOOK_TCP_EFF_SEND_MSS(pcb, mss)
+#endif
+
 /**
  * LWIP_HOOK_TCP_OUT_TCPOPT_LENGTH:
  * Hook for increasing the size of the options allocated with a tcp header.